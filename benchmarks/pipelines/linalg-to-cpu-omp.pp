@@ -0,0 +1,32 @@
+// linalg dialect to cpu lowering pipeline running parallel loops on OpenMP
+// threads
+builtin.module(imex-specialize-shapes
+    convert-tensor-to-linalg
+    arith-bufferize
+    func.func(empty-tensor-to-alloc-tensor
+          // eliminate-empty-tensors
+          scf-bufferize
+          shape-bufferize
+          linalg-bufferize
+          bufferization-bufferize
+          tensor-bufferize)
+    func-bufferize
+    func.func(finalizing-bufferize
+          convert-linalg-to-parallel-loops)
+    convert-scf-to-openmp
+    convert-scf-to-cf
+    convert-linalg-to-llvm
+    convert-cf-to-llvm
+    convert-arith-to-llvm
+    convert-math-to-llvm
+    convert-math-to-libm
+    convert-complex-to-llvm
+    convert-index-to-llvm
+    expand-strided-metadata
+    lower-affine
+    finalize-memref-to-llvm
+    lower-affine
+    convert-openmp-to-llvm
+    convert-func-to-llvm
+    reconcile-unrealized-casts)
+// End
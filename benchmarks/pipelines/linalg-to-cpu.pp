@@ -1,5 +1,6 @@
 // linalg dialect to gpu dialect lowering pipeline
-builtin.module(convert-tensor-to-linalg
+builtin.module(imex-specialize-shapes
+    convert-tensor-to-linalg
     arith-bufferize
     func.func(empty-tensor-to-alloc-tensor
           // eliminate-empty-tensors
@@ -13,8 +13,13 @@ builtin.module(convert-tensor-to-linalg
     func.func(finalizing-bufferize
           convert-linalg-to-parallel-loops
           imex-add-outer-parallel-loop
+// imex-tune-launch-config{work-per-thread=2 vector-width=4} gives the
+// relu.tile.seq*.simd* variants of benchmarks/spirv
+          imex-tune-launch-config
           gpu-map-parallel-loops
           convert-parallel-loops-to-gpu)
+// imex-fuse-gpu-launches after convert-parallel-loops-to-gpu fuses the
+// kernels of elementwise chains, it assumes function arguments don't alias
 // insert-gpu-allocs pass can have client-api = opencl or vulkan args
     func.func(insert-gpu-allocs{client-api=opencl})
     canonicalize
@@ -27,7 +32,8 @@ builtin.module(convert-tensor-to-linalg
     cse
 // The following set-spirv-* passes can have client-api = opencl or vulkan args
     set-spirv-capabilities{client-api=opencl}
-    gpu.module(set-spirv-abi-attrs{client-api=opencl})
+    gpu.module(set-spirv-abi-attrs{client-api=opencl}
+               imex-subgroup-block-io)
     canonicalize
     fold-memref-alias-ops
     imex-convert-gpu-to-spirv
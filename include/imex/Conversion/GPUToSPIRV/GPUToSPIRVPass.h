@@ -35,6 +35,18 @@ namespace imex {
 void populateGPUPrintfToSPIRVPatterns(mlir::SPIRVTypeConverter &typeConverter,
                                       mlir::RewritePatternSet &patterns);
 
+/// Populate patterns lowering 1-D vector.load/vector.store on memrefs with
+/// identity layout to wide SPIR-V loads/stores.
+void populateVectorLoadStoreToSPIRVPatterns(
+    mlir::SPIRVTypeConverter &typeConverter,
+    mlir::RewritePatternSet &patterns);
+
+/// Populate patterns lowering memref.load/memref.store marked by
+/// imex-subgroup-block-io to the Intel subgroup block instructions.
+void populateSubgroupBlockIOToSPIRVPatterns(
+    mlir::SPIRVTypeConverter &typeConverter,
+    mlir::RewritePatternSet &patterns);
+
 /// Create a pass
 std::unique_ptr<::mlir::OperationPass<::mlir::ModuleOp>>
 createConvertGPUXToSPIRVPass(bool mapMemorySpace = true);
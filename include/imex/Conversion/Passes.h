@@ -23,6 +23,7 @@
 #include <imex/Conversion/GPUToSPIRV/GPUToSPIRVPass.h>
 #include <imex/Conversion/GPUXToLLVM/GPUXToLLVMPass.h>
 #include <imex/Conversion/NDArrayToLinalg/NDArrayToLinalg.h>
+#include <imex/Conversion/XeGPUToCPU/XeGPUToCPU.h>
 #include <imex/Conversion/XeGPUToSPIRV/XeGPUToSPIRV.h>
 #include <imex/Conversion/XeTileToXeGPU/XeTileToXeGPU.h>
 
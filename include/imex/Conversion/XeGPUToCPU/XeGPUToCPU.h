@@ -0,0 +1,34 @@
+//===- XeGPUToCPU.h - XeGPUToCPU conversion  -------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file defines the XeGPUToCPU conversion, lowering GPU kernels written
+/// with the XeGPU dialect to host code which emulates them on the CPU.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef _XeGPUToCPU_H_INCLUDED_
+#define _XeGPUToCPU_H_INCLUDED_
+
+#include <memory>
+
+namespace mlir {
+class ModuleOp;
+template <typename T> class OperationPass;
+} // namespace mlir
+
+namespace imex {
+
+/// Create a pass to emulate XeGPU kernels on the CPU.
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
+createConvertXeGPUToCPUPass();
+
+} // namespace imex
+
+#endif // _XeGPUToCPU_H_INCLUDED_
@@ -27,6 +27,9 @@ namespace imex {
 /// Create a RegionBufferize pass
 std::unique_ptr<::mlir::Pass> createRegionBufferizePass();
 
+/// Create a RegionCoalesce pass
+std::unique_ptr<::mlir::Pass> createRegionCoalescePass();
+
 //===----------------------------------------------------------------------===//
 // Registration
 //===----------------------------------------------------------------------===//
@@ -34,6 +34,7 @@ namespace imex {
 
 std::unique_ptr<::mlir::Pass> createXeGPUToSPIRVWithVCIntrinsicsPass();
 std::unique_ptr<::mlir::Pass> createXeGPUToSPIRVWithJointMatrixPass();
+std::unique_ptr<::mlir::Pass> createXeGPUPerfModelPass();
 
 /// Populate the given list with patterns that eliminate XeGPU ops
 void populateXeGPUToSPIRVWithVCIntrinsicsPatterns(
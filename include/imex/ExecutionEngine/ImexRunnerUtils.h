@@ -84,4 +84,7 @@ extern "C" IMEX_RUNNERUTILS_EXPORT void
 _mlir_ciface_printAllcloseF32(UnrankedMemRefType<float> *M,
                               UnrankedMemRefType<float> *N);
 
+extern "C" IMEX_RUNNERUTILS_EXPORT void
+_mlir_ciface_printXeGPUProfile(UnrankedMemRefType<int64_t> *counters);
+
 #endif // IMEX_EXECUTIONENGINE_IMEXRUNNERUTILS_H
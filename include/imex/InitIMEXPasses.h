@@ -23,6 +23,7 @@
 #include <imex/Dialect/Region/Transforms/Passes.h>
 // #include <imex/Dialect/*/Transforms/Passes.h>
 #include "imex/Transforms/Passes.h"
+#include <imex/Dialect/XeGPU/Transforms/Passes.h>
 #include <imex/Dialect/XeTile/Transforms/Passes.h>
 
 #include <cstdlib>
@@ -49,6 +50,7 @@ inline void registerAllPasses() {
   registerDistRuntimePasses();
   registerRegionPasses();
   registerXeTilePasses();
+  registerXeGPUPasses();
   // register*Passes();
 
   // Dialect pipelines
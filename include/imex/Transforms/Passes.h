@@ -22,12 +22,20 @@ namespace imex {
 //===----------------------------------------------------------------------===//
 std::unique_ptr<mlir::Pass> createSerializeSPIRVPass();
 std::unique_ptr<mlir::Pass> createInsertGPUAllocsPass();
+std::unique_ptr<mlir::Pass> createGPUBufferResidencyPass();
 std::unique_ptr<mlir::Pass> createSetSPIRVCapabilitiesPass();
 std::unique_ptr<mlir::Pass> createSetSPIRVAbiAttributePass();
 std::unique_ptr<mlir::Pass> createAddOuterParallelLoopPass();
+std::unique_ptr<mlir::Pass> createTuneLaunchConfigPass();
+std::unique_ptr<mlir::Pass> createSubgroupBlockIOPass();
+std::unique_ptr<mlir::Pass> createPromoteToSLMPass();
+std::unique_ptr<mlir::Pass> createFuseGPULaunchesPass();
 std::unique_ptr<mlir::Pass> createLowerMemRefCopyPass();
 std::unique_ptr<mlir::Pass> createBF16ToGPUPass();
 std::unique_ptr<mlir::Pass> createRemoveTemporariesPass();
+std::unique_ptr<mlir::Pass> createPlanBufferReusePass();
+std::unique_ptr<mlir::Pass> createSpecializeShapesPass();
+std::unique_ptr<mlir::Pass> createStreamChunksPass();
 std::unique_ptr<mlir::Pass> createVectorLinearizePass();
 
 #define GEN_PASS_DECL
@@ -56,6 +56,21 @@ struct LoadStore2DConfig {
   GRFSize GRFDataSize;                 // Max GRF Data for load and store
 };
 
+/// Throughput numbers of a platform, used by the analytical performance model
+/// (xegpu-perf-model) to turn op counts into a roofline-style time estimate.
+struct XeuArchThroughput {
+  double frequency = 0;     // GPU clock in GHz
+  int numXVE = 0;           // # of vector engines
+  double memBandwidth = 0;  // device memory bandwidth in GB/s
+  int dpasCycles = 0;       // cycles of a dpas with the full repeat count
+  int load2dCycles = 0;     // issue cycles of a 2D block load message
+  int store2dCycles = 0;    // issue cycles of a 2D block store message
+  int prefetch2dCycles = 0; // issue cycles of a 2D block prefetch message
+  int gatherCycles = 0;     // issue cycles of a gather/scatter message
+  int atomicCycles = 0;     // issue cycles of an atomic message
+  int barrierCycles = 0;    // cost of a (named) barrier wait
+};
+
 /// This Base class provides uArch interface for defining HW supported configs
 /// that is used to verify XeGPU dialect operations. This gets inherited to
 /// platform specific classes that defines HW specific restrictions.
@@ -89,6 +104,10 @@ public:
   virtual mlir::FailureOr<LoadStore2DConfig>
   get2DStoreConfig(int element_data_size) = 0;
 
+  virtual XeuArchThroughput getThroughput() = 0;
+
+  unsigned int getRepeatCount() const { return repeatCount; }
+
   mlir::LogicalResult verify2dBlockRestriction(mlir::Operation *op, int width,
                                                int height, int array_len,
                                                int elemTyByteWidth,
@@ -170,6 +189,8 @@ public:
 
   virtual mlir::FailureOr<LoadStore2DConfig>
   get2DStoreConfig(int element_data_size) override;
+
+  virtual XeuArchThroughput getThroughput() override;
 };
 
 } // namespace imex
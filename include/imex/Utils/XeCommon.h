@@ -52,6 +52,13 @@ void markDefChainValues(mlir::Value value, imex::OperandType type,
 void markUseChainValues(mlir::Value value, imex::OperandType type,
                         imex::ValueAttributeMap &map);
 
+/**
+ * assignCacheHints sets the cache_hint attribute of the load_tile, store_tile
+ * and prefetch_tile ops nested in root that do not carry one yet, based on the
+ * reuse of the accessed tile by the subgroup. Explicit hints are kept.
+ */
+void assignCacheHints(mlir::Operation *root);
+
 mlir::ValueRange buildUnrealizedCast(mlir::OpBuilder &builder,
                                      mlir::TypeRange resultTypes,
                                      mlir::ValueRange inputs);
@@ -317,6 +317,191 @@ struct ReductionOpConverter
   }
 };
 
+/// Rewrite ::imex::ndarray::MatMulOp on distributed 2d arrays (SUMMA).
+/// Arrays are split in the first dimension, so each process computes the rows
+/// of the result matching its locally owned rows of lhs. rhs is broadcasted
+/// one panel, i.e. the rows owned by one process, at a time: every process
+/// first learns the row offset and count of all panels, then a loop over the
+/// processes allreduces the panel of the current owner into a buffer of the
+/// panel's size and accumulates its product with the matching columns of the
+/// local rows of lhs into the local result. With transpose_rhs the rows of
+/// rhs are columns of the result, each panel then gives a column block of
+/// the local result instead of a partial sum.
+/// Batched and lhs-transposed products need other partitionings and are
+/// reported as errors.
+/// op gets replaced with global distributed array
+struct MatMulOpConverter
+    : public ::mlir::OpConversionPattern<::imex::ndarray::MatMulOp> {
+  using ::mlir::OpConversionPattern<
+      ::imex::ndarray::MatMulOp>::OpConversionPattern;
+
+  ::mlir::LogicalResult
+  matchAndRewrite(::imex::ndarray::MatMulOp op,
+                  ::imex::ndarray::MatMulOp::Adaptor adaptor,
+                  ::mlir::ConversionPatternRewriter &rewriter) const override {
+    auto lhs = op.getLhs();
+    auto rhs = op.getRhs();
+    auto lhsDistTyp = lhs.getType().dyn_cast<::imex::ndarray::NDArrayType>();
+    auto rhsDistTyp = rhs.getType().dyn_cast<::imex::ndarray::NDArrayType>();
+    // nothing to do if not distributed
+    if (!lhsDistTyp || !rhsDistTyp || !isDist(lhsDistTyp) ||
+        !isDist(rhsDistTyp))
+      return ::mlir::failure();
+    if (lhsDistTyp.getRank() != 2 || op.getTransposeLhs())
+      return op.emitOpError("distributed operands must be 2d and lhs must "
+                            "not be transposed");
+
+    auto loc = op.getLoc();
+    auto zero = createIndex(loc, rewriter, 0);
+    auto one = createIndex(loc, rewriter, 1);
+    auto two = createIndex(loc, rewriter, 2);
+    auto team = getDistEnv(rhsDistTyp).getTeam();
+    auto nProcs = createNProcs(loc, rewriter, team);
+    auto pRank = createPRank(loc, rewriter, team);
+    auto add = [&](::mlir::OpBuilder &builder, ::mlir::Value a,
+                   ::mlir::Value b) {
+      return builder.createOrFold<::mlir::arith::AddIOp>(loc, a, b);
+    };
+    auto dim = [&](::mlir::Value ary, int64_t d) {
+      return rewriter.createOrFold<::imex::ndarray::DimOp>(loc, ary, d);
+    };
+
+    // the locally owned part and the global index of its first row; arrays
+    // with halos have 3 parts, the owned one is in the middle
+    auto getOwnPart = [&](::mlir::Value ary) {
+      auto parts = createPartsOf(loc, rewriter, ary);
+      auto offs = createLocalOffsetsOf(loc, rewriter, ary);
+      unsigned ownPartIdx = parts.size() == 1 ? 0 : 1;
+      auto row = ownPartIdx ? add(rewriter, offs[0], dim(parts[0], 0))
+                            : offs[0];
+      return std::make_pair(parts[ownPartIdx], row);
+    };
+    ::mlir::Value rOwn, rRow, lOwn, lRow;
+    std::tie(rOwn, rRow) = getOwnPart(rhs);
+    std::tie(lOwn, lRow) = getOwnPart(lhs);
+    auto rRows = dim(rOwn, 0);
+    auto rCols = dim(rOwn, 1);
+    auto lRows = dim(lOwn, 0);
+
+    // the row offset and count of the rhs panel of every process
+    auto i64Typ = rewriter.getI64Type();
+    auto zeroI64 = rewriter.create<::mlir::arith::ConstantOp>(
+        loc, i64Typ, rewriter.getZeroAttr(i64Typ));
+    auto panels = rewriter.create<::imex::ndarray::CreateOp>(
+        loc,
+        ::imex::ValVec{
+            rewriter.createOrFold<::mlir::arith::MulIOp>(loc, nProcs, two)},
+        ::imex::ndarray::I64, zeroI64);
+    auto ownIdx = rewriter.createOrFold<::mlir::arith::MulIOp>(loc, pRank, two);
+    for (auto [i, val] : llvm::enumerate(::imex::ValVec{rRow, rRows})) {
+      auto elem = rewriter.create<::imex::ndarray::CreateOp>(
+          loc, ::imex::ValVec{one}, ::imex::ndarray::I64,
+          rewriter.createOrFold<::mlir::arith::IndexCastOp>(loc, i64Typ, val));
+      (void)rewriter.create<::imex::ndarray::InsertSliceOp>(
+          loc, panels, elem,
+          ::imex::ValVec{add(rewriter, ownIdx, createIndex(loc, rewriter, i))},
+          ::imex::ValVec{one}, ::imex::ValVec{one});
+    }
+    (void)createAllReduce(loc, rewriter,
+                          rewriter.getI32IntegerAttr(::imex::ndarray::SUM),
+                          panels);
+    auto loadPanel = [&](::mlir::OpBuilder &builder, ::mlir::Value p,
+                         int64_t field) {
+      auto idx = add(builder,
+                     builder.createOrFold<::mlir::arith::MulIOp>(loc, p, two),
+                     createIndex(loc, builder, field));
+      auto val = builder.create<::imex::ndarray::LoadOp>(
+          loc, panels, ::mlir::ValueRange{idx});
+      return builder.createOrFold<::mlir::arith::IndexCastOp>(
+          loc, builder.getIndexType(), val);
+    };
+
+    // the columns of the local result
+    auto transposeRhs = op.getTransposeRhs();
+    ::mlir::Value resCols = rCols;
+    if (transposeRhs) {
+      resCols = rewriter
+                    .create<::mlir::scf::ForOp>(
+                        loc, zero, nProcs, one, ::mlir::ValueRange{zero},
+                        [&](::mlir::OpBuilder &builder, ::mlir::Location loc,
+                            ::mlir::Value p, ::mlir::ValueRange args) {
+                          builder.create<::mlir::scf::YieldOp>(
+                              loc, add(builder, args[0],
+                                       loadPanel(builder, p, 1)));
+                        })
+                    .getResult(0);
+    }
+
+    auto retDistTyp = op.getType().cast<::imex::ndarray::NDArrayType>();
+    auto resTyp = cloneAsDynNonDist(retDistTyp);
+    auto elType = retDistTyp.getElementType();
+    auto zeroEl = rewriter.create<::mlir::arith::ConstantOp>(
+        loc, elType, rewriter.getZeroAttr(elType));
+    auto res = rewriter.create<::imex::ndarray::CreateOp>(
+        loc, ::imex::ValVec{lRows, resCols}, ::imex::ndarray::fromMLIR(elType),
+        zeroEl, getNonDistEnvs(retDistTyp));
+
+    // broadcast one panel after the other and accumulate its product
+    auto rElType = rhsDistTyp.getElementType();
+    auto rZeroEl = rewriter.create<::mlir::arith::ConstantOp>(
+        loc, rElType, rewriter.getZeroAttr(rElType));
+    auto loop = rewriter.create<::mlir::scf::ForOp>(
+        loc, zero, nProcs, one, ::mlir::ValueRange{res.getResult()},
+        [&](::mlir::OpBuilder &builder, ::mlir::Location loc, ::mlir::Value p,
+            ::mlir::ValueRange args) {
+          auto pOff = loadPanel(builder, p, 0);
+          auto pRows = loadPanel(builder, p, 1);
+          // the owner contributes its rows, all others none
+          auto isOwner = builder.createOrFold<::mlir::arith::CmpIOp>(
+              loc, ::mlir::arith::CmpIPredicate::eq, p, pRank);
+          auto ownRows = builder.createOrFold<::mlir::arith::SelectOp>(
+              loc, isOwner, pRows, zero);
+          auto panel = builder.create<::imex::ndarray::CreateOp>(
+              loc, ::imex::ValVec{pRows, rCols},
+              ::imex::ndarray::fromMLIR(rElType), rZeroEl,
+              getNonDistEnvs(rhsDistTyp));
+          auto ownPart = builder.create<::imex::ndarray::SubviewOp>(
+              loc, rOwn, ::imex::ValVec{zero, zero},
+              ::imex::ValVec{ownRows, rCols}, ::imex::ValVec{one, one});
+          (void)builder.create<::imex::ndarray::InsertSliceOp>(
+              loc, panel, ownPart, ::imex::ValVec{zero, zero},
+              ::imex::ValVec{ownRows, rCols}, ::imex::ValVec{one, one});
+          (void)createAllReduce(
+              loc, builder, builder.getI32IntegerAttr(::imex::ndarray::SUM),
+              panel);
+
+          ::mlir::Value acc = args[0];
+          if (transposeRhs) {
+            auto prod = builder.create<::imex::ndarray::MatMulOp>(
+                loc, resTyp, lOwn, panel,
+                /*transpose_lhs=*/false, /*transpose_rhs=*/true);
+            acc = builder.create<::imex::ndarray::ImmutableInsertSliceOp>(
+                loc, acc, prod, ::imex::ValVec{zero, pOff},
+                ::imex::ValVec{lRows, pRows}, ::imex::ValVec{one, one});
+          } else {
+            auto lCols = builder.create<::imex::ndarray::SubviewOp>(
+                loc, lOwn, ::imex::ValVec{zero, pOff},
+                ::imex::ValVec{lRows, pRows}, ::imex::ValVec{one, one});
+            auto prod = builder.create<::imex::ndarray::MatMulOp>(
+                loc, resTyp, lCols, panel,
+                /*transpose_lhs=*/false, /*transpose_rhs=*/false);
+            acc = builder.create<::imex::ndarray::EWBinOp>(
+                loc, acc.getType(),
+                builder.getI32IntegerAttr(::imex::ndarray::ADD), acc, prod);
+          }
+          builder.create<::mlir::scf::YieldOp>(loc, acc);
+        });
+
+    // init our new dist array
+    rewriter.replaceOp(op, createDistArray(loc, rewriter,
+                                           getDistEnv(lhsDistTyp).getTeam(),
+                                           retDistTyp.getShape(),
+                                           ::imex::ValVec{lRow, zero},
+                                           loop.getResult(0)));
+    return ::mlir::success();
+  }
+};
+
 /// Rewriting ::imex::ndarray::ToTensorOp
 /// Get NDArray from distributed array and apply to ToTensorOp.
 struct ToTensorOpConverter
@@ -1699,7 +1884,7 @@ struct ConvertDistToStandardPass
         ::imex::ndarray::CreateOp, ::imex::ndarray::CopyOp,
         ::imex::ndarray::ReductionOp, ::imex::ndarray::ToTensorOp,
         ::imex::ndarray::DeleteOp, ::imex::ndarray::CastElemTypeOp,
-        ::imex::region::EnvironmentRegionOp,
+        ::imex::ndarray::MatMulOp, ::imex::region::EnvironmentRegionOp,
         ::imex::region::EnvironmentRegionYieldOp>(
         [&](::mlir::Operation *op) { return typeConverter.isLegal(op); });
     target.addLegalOp<::imex::dist::InitDistArrayOp>();
@@ -1715,7 +1900,8 @@ struct ConvertDistToStandardPass
                 LocalCoreOpConverter, RePartitionOpConverter,
                 ReshapeOpConverter, LocalTargetOfSliceOpConverter,
                 DefaultPartitionOpConverter, LocalOffsetsOfOpConverter,
-                PartsOfOpConverter, DeleteOpConverter, CastElemTypeOpConverter>(
+                PartsOfOpConverter, DeleteOpConverter, CastElemTypeOpConverter,
+                MatMulOpConverter>(
             typeConverter, &ctxt);
     mlir::scf::populateSCFStructuralTypeConversionsAndLegality(
         typeConverter, patterns, target);
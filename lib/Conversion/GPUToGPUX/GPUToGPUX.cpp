@@ -21,14 +21,18 @@
 #include <mlir/Dialect/GPU/IR/GPUDialect.h>
 
 #include <mlir/IR/BuiltinOps.h>
+#include <mlir/Interfaces/SideEffectInterfaces.h>
 
 namespace imex {
 
 // This function creates a temporary stream if a stream is already not created
 // in the function. If a stream is already present, it will just return that
 // temporary stream to queue gpu operations on.
+// With moduleStream, the stream of the module is requested instead; it is
+// neither created nor destroyed by the function.
 
-static mlir::Value getGpuStream(mlir::OpBuilder &builder, mlir::Operation *op) {
+static mlir::Value getGpuStream(mlir::OpBuilder &builder, mlir::Operation *op,
+                                bool moduleStream) {
   assert(op);
   auto func = op->getParentOfType<mlir::func::FuncOp>();
   if (!func)
@@ -45,24 +49,43 @@ static mlir::Value getGpuStream(mlir::OpBuilder &builder, mlir::Operation *op) {
   mlir::OpBuilder::InsertionGuard g(builder);
   builder.setInsertionPointToStart(&block);
   auto loc = builder.getUnknownLoc();
-  auto stream =
-      builder
-          .create<imex::gpux::CreateStreamOp>(loc, mlir::Value{}, mlir::Value{})
-          .getResult();
+  auto stream = builder
+                    .create<imex::gpux::CreateStreamOp>(
+                        loc, mlir::Value{}, mlir::Value{}, moduleStream)
+                    .getResult();
+  if (moduleStream)
+    return stream;
+
   builder.setInsertionPoint(block.getTerminator());
   builder.create<imex::gpux::DestroyStreamOp>(loc, stream);
   return stream;
 }
 
+// Base class of the patterns below, which queue the gpu operation on the
+// stream returned by getGpuStream.
+template <typename OpTy>
+struct ConvertWithStreamPattern : public mlir::OpRewritePattern<OpTy> {
+  ConvertWithStreamPattern(mlir::MLIRContext *ctx, bool moduleStream)
+      : mlir::OpRewritePattern<OpTy>(ctx), moduleStream(moduleStream) {}
+
+protected:
+  mlir::Value getStream(mlir::OpBuilder &builder, mlir::Operation *op) const {
+    return getGpuStream(builder, op, moduleStream);
+  }
+
+private:
+  bool moduleStream;
+};
+
 // This pattern converts the gpu.alloc operation to gpux.alloc
 // and adds a stream argument to it.
-struct ConvertAllocOp : public mlir::OpRewritePattern<mlir::gpu::AllocOp> {
-  using OpRewritePattern::OpRewritePattern;
+struct ConvertAllocOp : public ConvertWithStreamPattern<mlir::gpu::AllocOp> {
+  using ConvertWithStreamPattern::ConvertWithStreamPattern;
 
   mlir::LogicalResult
   matchAndRewrite(mlir::gpu::AllocOp op,
                   mlir::PatternRewriter &rewriter) const override {
-    auto stream = getGpuStream(rewriter, op);
+    auto stream = getStream(rewriter, op);
     if (!stream)
       return mlir::failure();
 
@@ -79,13 +102,14 @@ struct ConvertAllocOp : public mlir::OpRewritePattern<mlir::gpu::AllocOp> {
 
 // This pattern converts the gpu.dealloc operation to gpux.dealloc
 // and adds a stream argument to it.
-struct ConvertDeallocOp : public mlir::OpRewritePattern<mlir::gpu::DeallocOp> {
-  using OpRewritePattern::OpRewritePattern;
+struct ConvertDeallocOp
+    : public ConvertWithStreamPattern<mlir::gpu::DeallocOp> {
+  using ConvertWithStreamPattern::ConvertWithStreamPattern;
 
   mlir::LogicalResult
   matchAndRewrite(mlir::gpu::DeallocOp op,
                   mlir::PatternRewriter &rewriter) const override {
-    auto stream = getGpuStream(rewriter, op);
+    auto stream = getStream(rewriter, op);
     if (!stream)
       return mlir::failure();
 
@@ -101,8 +125,8 @@ struct ConvertDeallocOp : public mlir::OpRewritePattern<mlir::gpu::DeallocOp> {
 // This pattern converts the gpu.launch_func operation to gpux.launch_func
 // and adds a stream argument to it.
 struct ConvertLaunchOp
-    : public mlir::OpRewritePattern<mlir::gpu::LaunchFuncOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public ConvertWithStreamPattern<mlir::gpu::LaunchFuncOp> {
+  using ConvertWithStreamPattern::ConvertWithStreamPattern;
 
   mlir::LogicalResult
   matchAndRewrite(mlir::gpu::LaunchFuncOp op,
@@ -122,7 +146,7 @@ struct ConvertLaunchOp
     if (!gpuKernel)
       return mlir::failure();
 
-    auto stream = getGpuStream(rewriter, op);
+    auto stream = getStream(rewriter, op);
     if (!stream)
       return mlir::failure();
 
@@ -140,13 +164,13 @@ struct ConvertLaunchOp
 
 // This pattern converts the gpu.wait operation to gpux.wait
 // and adds a stream argument to it.
-struct ConvertWaitOp : public mlir::OpRewritePattern<mlir::gpu::WaitOp> {
-  using OpRewritePattern::OpRewritePattern;
+struct ConvertWaitOp : public ConvertWithStreamPattern<mlir::gpu::WaitOp> {
+  using ConvertWithStreamPattern::ConvertWithStreamPattern;
 
   mlir::LogicalResult
   matchAndRewrite(mlir::gpu::WaitOp op,
                   mlir::PatternRewriter &rewriter) const override {
-    auto stream = getGpuStream(rewriter, op);
+    auto stream = getStream(rewriter, op);
     if (!stream)
       return mlir::failure();
 
@@ -161,13 +185,13 @@ struct ConvertWaitOp : public mlir::OpRewritePattern<mlir::gpu::WaitOp> {
 
 // This pattern converts the gpu.memcpy operation to gpux.memcpy
 // and adds a stream argument to it.
-struct ConvertMemcpyOp : public mlir::OpRewritePattern<mlir::gpu::MemcpyOp> {
-  using OpRewritePattern::OpRewritePattern;
+struct ConvertMemcpyOp : public ConvertWithStreamPattern<mlir::gpu::MemcpyOp> {
+  using ConvertWithStreamPattern::ConvertWithStreamPattern;
 
   mlir::LogicalResult
   matchAndRewrite(mlir::gpu::MemcpyOp op,
                   mlir::PatternRewriter &rewriter) const override {
-    auto stream = getGpuStream(rewriter, op);
+    auto stream = getStream(rewriter, op);
     if (!stream)
       return mlir::failure();
 
@@ -182,13 +206,13 @@ struct ConvertMemcpyOp : public mlir::OpRewritePattern<mlir::gpu::MemcpyOp> {
 
 // This pattern converts the gpu.memset operation to gpux.memset
 // and adds a stream argument to it.
-struct ConvertMemsetOp : public mlir::OpRewritePattern<mlir::gpu::MemsetOp> {
-  using OpRewritePattern::OpRewritePattern;
+struct ConvertMemsetOp : public ConvertWithStreamPattern<mlir::gpu::MemsetOp> {
+  using ConvertWithStreamPattern::ConvertWithStreamPattern;
 
   mlir::LogicalResult
   matchAndRewrite(mlir::gpu::MemsetOp op,
                   mlir::PatternRewriter &rewriter) const override {
-    auto stream = getGpuStream(rewriter, op);
+    auto stream = getStream(rewriter, op);
     if (!stream)
       return mlir::failure();
 
@@ -202,6 +226,52 @@ struct ConvertMemsetOp : public mlir::OpRewritePattern<mlir::gpu::MemsetOp> {
   }
 };
 
+// Returns true for the ops which may be recorded into a command graph.
+static bool isCapturable(mlir::Operation *op) {
+  if (!mlir::isa<imex::gpux::LaunchFuncOp, imex::gpux::MemcpyOp>(op))
+    return false;
+  auto asyncOp = mlir::cast<mlir::gpu::AsyncOpInterface>(op);
+  return !asyncOp.getAsyncToken() && asyncOp.getAsyncDependencies().empty();
+}
+
+static mlir::Value getCaptureStream(mlir::Operation *op) {
+  if (auto launch = mlir::dyn_cast<imex::gpux::LaunchFuncOp>(op))
+    return launch.getGpuxStream();
+  return mlir::cast<imex::gpux::MemcpyOp>(op).getGpuxStream();
+}
+
+// Encloses the runs of at least two capturable ops on the same stream in
+// capture_begin/capture_end. Side effect free ops may be interleaved with
+// the run, they are still executed by the host each time.
+static void captureLaunchSequences(mlir::Block &block) {
+  llvm::SmallVector<mlir::Operation *> run;
+  auto flush = [&]() {
+    if (run.size() > 1) {
+      auto stream = getCaptureStream(run.front());
+      mlir::OpBuilder builder(run.front());
+      builder.create<imex::gpux::CaptureBeginOp>(run.front()->getLoc(),
+                                                 stream);
+      builder.setInsertionPointAfter(run.back());
+      builder.create<imex::gpux::CaptureEndOp>(run.back()->getLoc(), stream);
+    }
+    run.clear();
+  };
+
+  for (auto &op : block) {
+    if (isCapturable(&op)) {
+      if (!run.empty() &&
+          getCaptureStream(run.front()) != getCaptureStream(&op))
+        flush();
+      run.push_back(&op);
+      continue;
+    }
+    if (op.getNumRegions() == 0 && mlir::isMemoryEffectFree(&op))
+      continue;
+    flush();
+  }
+  flush();
+}
+
 // This pass converts the GPU dialect ops to our custom GPUX dialect ops
 // which add a stream to the gpu dialect ops. These ops are then lowered
 // LLVM dialect and eventually to stcl/l0 runtime calls.
@@ -212,10 +282,19 @@ struct GPUToGPUXPass : public ::imex::ConvertGPUToGPUXBase<GPUToGPUXPass> {
     mlir::RewritePatternSet patterns(ctx);
 
     patterns.insert<ConvertAllocOp, ConvertDeallocOp, ConvertLaunchOp,
-                    ConvertWaitOp, ConvertMemcpyOp, ConvertMemsetOp>(ctx);
+                    ConvertWaitOp, ConvertMemcpyOp, ConvertMemsetOp>(
+        ctx, moduleStream);
 
     (void)mlir::applyPatternsAndFoldGreedily(getOperation(),
                                              std::move(patterns));
+
+    if (captureLaunches) {
+      llvm::SmallVector<mlir::Block *> blocks;
+      getOperation()->walk(
+          [&](mlir::Block *block) { blocks.push_back(block); });
+      for (auto *block : blocks)
+        captureLaunchSequences(*block);
+    }
   }
 }; // namespace imex
 
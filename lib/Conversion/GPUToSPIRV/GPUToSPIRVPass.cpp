@@ -31,10 +31,12 @@
 #include <mlir/Conversion/VectorToSPIRV/VectorToSPIRV.h>
 #include <mlir/Dialect/Arith/IR/Arith.h>
 #include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
 #include <mlir/Dialect/SPIRV/IR/SPIRVDialect.h>
 #include <mlir/Dialect/SPIRV/IR/SPIRVOps.h>
 #include <mlir/Dialect/SPIRV/IR/SPIRVTypes.h>
 #include <mlir/Dialect/SPIRV/Transforms/SPIRVConversion.h>
+#include <mlir/Dialect/Vector/IR/VectorOps.h>
 #include <mlir/IR/BuiltinOps.h>
 #include <mlir/IR/Matchers.h>
 #include <mlir/Support/LLVM.h>
@@ -173,6 +175,239 @@ void populateGPUPrintfToSPIRVPatterns(mlir::SPIRVTypeConverter &typeConverter,
   patterns.add<PrintfOpPattern>(typeConverter, patterns.getContext());
 }
 
+/// Returns the pointer to the vector of vecType starting at indices of a
+/// memref, or a null value if the access can't be lowered to a single
+/// vector access.
+static mlir::Value
+getVectorPtr(const mlir::SPIRVTypeConverter &typeConverter,
+             mlir::MemRefType memrefType, mlir::VectorType vecType,
+             mlir::Value basePtr, mlir::ValueRange indices, mlir::Location loc,
+             mlir::ConversionPatternRewriter &rewriter) {
+  if (vecType.getRank() != 1 || !memrefType.getLayout().isIdentity())
+    return {};
+  auto convertedType = typeConverter.convertType(vecType);
+  if (!convertedType || !mlir::isa<mlir::VectorType>(convertedType))
+    return {};
+
+  auto elemPtr = mlir::spirv::getElementPtr(typeConverter, memrefType, basePtr,
+                                            indices, loc, rewriter);
+  if (!elemPtr)
+    return {};
+  auto ptrType = mlir::cast<mlir::spirv::PointerType>(elemPtr.getType());
+  auto vecPtrType =
+      mlir::spirv::PointerType::get(convertedType, ptrType.getStorageClass());
+  return rewriter.create<mlir::spirv::BitcastOp>(loc, vecPtrType, elemPtr);
+}
+
+/// Lowers 1-D vector.load/vector.store, as created by imex-tune-launch-config
+/// for vector-width > 1, to a single aligned SPIR-V load/store of the vector
+/// type. The access is only aligned to the element size, the alignment of the
+/// vector itself isn't known.
+class VectorLoadOpPattern
+    : public mlir::OpConversionPattern<mlir::vector::LoadOp> {
+public:
+  using mlir::OpConversionPattern<mlir::vector::LoadOp>::OpConversionPattern;
+  mlir::LogicalResult
+  matchAndRewrite(mlir::vector::LoadOp loadOp, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    auto &typeConverter = *getTypeConverter<mlir::SPIRVTypeConverter>();
+    auto memrefType = loadOp.getMemRefType();
+    auto vecPtr = getVectorPtr(typeConverter, memrefType,
+                               loadOp.getVectorType(), adaptor.getBase(),
+                               adaptor.getIndices(), loadOp.getLoc(), rewriter);
+    if (!vecPtr)
+      return rewriter.notifyMatchFailure(loadOp, "unsupported vector load");
+
+    auto align = memrefType.getElementTypeBitWidth() / 8;
+    rewriter.replaceOpWithNewOp<mlir::spirv::LoadOp>(
+        loadOp, vecPtr,
+        mlir::spirv::MemoryAccessAttr::get(rewriter.getContext(),
+                                           mlir::spirv::MemoryAccess::Aligned),
+        rewriter.getI32IntegerAttr(align));
+    return mlir::success();
+  }
+};
+
+class VectorStoreOpPattern
+    : public mlir::OpConversionPattern<mlir::vector::StoreOp> {
+public:
+  using mlir::OpConversionPattern<mlir::vector::StoreOp>::OpConversionPattern;
+  mlir::LogicalResult
+  matchAndRewrite(mlir::vector::StoreOp storeOp, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    auto &typeConverter = *getTypeConverter<mlir::SPIRVTypeConverter>();
+    auto memrefType = storeOp.getMemRefType();
+    auto vecPtr = getVectorPtr(typeConverter, memrefType,
+                               storeOp.getVectorType(), adaptor.getBase(),
+                               adaptor.getIndices(), storeOp.getLoc(),
+                               rewriter);
+    if (!vecPtr)
+      return rewriter.notifyMatchFailure(storeOp, "unsupported vector store");
+
+    auto align = memrefType.getElementTypeBitWidth() / 8;
+    rewriter.replaceOpWithNewOp<mlir::spirv::StoreOp>(
+        storeOp, vecPtr, adaptor.getValueToStore(),
+        mlir::spirv::MemoryAccessAttr::get(rewriter.getContext(),
+                                           mlir::spirv::MemoryAccess::Aligned),
+        rewriter.getI32IntegerAttr(align));
+    return mlir::success();
+  }
+};
+
+/// Lowers vector.broadcast of a scalar, used for loop invariant operands of
+/// vectorized elementwise kernels.
+class VectorSplatPattern
+    : public mlir::OpConversionPattern<mlir::vector::BroadcastOp> {
+public:
+  using mlir::OpConversionPattern<
+      mlir::vector::BroadcastOp>::OpConversionPattern;
+  mlir::LogicalResult
+  matchAndRewrite(mlir::vector::BroadcastOp op, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    if (mlir::isa<mlir::VectorType>(op.getSourceType()) ||
+        op.getResultVectorType().getRank() != 1)
+      return mlir::failure();
+    auto resType = getTypeConverter()->convertType(op.getResultVectorType());
+    if (!resType || !mlir::isa<mlir::VectorType>(resType))
+      return mlir::failure();
+    llvm::SmallVector<mlir::Value> elems(
+        op.getResultVectorType().getNumElements(), adaptor.getSource());
+    rewriter.replaceOpWithNewOp<mlir::spirv::CompositeConstructOp>(op, resType,
+                                                                   elems);
+    return mlir::success();
+  }
+};
+
+void populateVectorLoadStoreToSPIRVPatterns(
+    mlir::SPIRVTypeConverter &typeConverter,
+    mlir::RewritePatternSet &patterns) {
+  patterns.add<VectorLoadOpPattern, VectorStoreOpPattern, VectorSplatPattern>(
+      typeConverter, patterns.getContext());
+}
+
+/// Returns the SubgroupLocalInvocationId builtin of the current lane.
+static mlir::Value
+getSubgroupLocalId(mlir::Location loc, mlir::Type type,
+                   mlir::ConversionPatternRewriter &rewriter) {
+  auto moduleOp = rewriter.getBlock()
+                      ->getParent()
+                      ->getParentOfType<mlir::spirv::ModuleOp>();
+  const char varName[] = "__builtin_var_SubgroupLocalInvocationId__";
+  auto i32Type = rewriter.getI32Type();
+  auto varOp = moduleOp.lookupSymbol<mlir::spirv::GlobalVariableOp>(varName);
+  if (!varOp) {
+    mlir::ConversionPatternRewriter::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPointToStart(moduleOp.getBody());
+    varOp = rewriter.create<mlir::spirv::GlobalVariableOp>(
+        loc,
+        mlir::spirv::PointerType::get(i32Type,
+                                      mlir::spirv::StorageClass::Input),
+        varName, mlir::spirv::BuiltIn::SubgroupLocalInvocationId);
+  }
+  mlir::Value ptr = rewriter.create<mlir::spirv::AddressOfOp>(loc, varOp);
+  mlir::Value id = rewriter.create<mlir::spirv::LoadOp>(loc, ptr);
+  return rewriter.create<mlir::spirv::UConvertOp>(loc, type, id);
+}
+
+/// Returns the pointer of the first lane of the subgroup for an access
+/// marked by imex-subgroup-block-io, as a pointer to an integer of the
+/// element size, or a null value if the access isn't supported.
+static mlir::Value
+getSubgroupBlockPtr(const mlir::SPIRVTypeConverter &typeConverter,
+                    mlir::Operation *op, mlir::MemRefType memrefType,
+                    mlir::Value basePtr, mlir::ValueRange indices,
+                    mlir::ConversionPatternRewriter &rewriter) {
+  if (!op->hasAttr("imex.subgroup_block_io") || indices.empty() ||
+      !typeConverter.getTargetEnv().allows(
+          mlir::spirv::Capability::SubgroupBufferBlockIOINTEL))
+    return {};
+  auto elemType = typeConverter.convertType(memrefType.getElementType());
+  if (!elemType || !elemType.isIntOrFloat())
+    return {};
+
+  // All lanes access consecutive elements, the block access starts at the
+  // one of lane 0.
+  auto loc = op->getLoc();
+  llvm::SmallVector<mlir::Value> blockIndices(indices);
+  auto laneId = getSubgroupLocalId(loc, indices.back().getType(), rewriter);
+  blockIndices.back() =
+      rewriter.create<mlir::spirv::ISubOp>(loc, indices.back(), laneId);
+  auto elemPtr = mlir::spirv::getElementPtr(typeConverter, memrefType, basePtr,
+                                            blockIndices, loc, rewriter);
+  if (!elemPtr)
+    return {};
+  auto ptrType = mlir::cast<mlir::spirv::PointerType>(elemPtr.getType());
+  auto intType = rewriter.getIntegerType(elemType.getIntOrFloatBitWidth());
+  if (elemType == intType)
+    return elemPtr;
+  return rewriter.create<mlir::spirv::BitcastOp>(
+      loc, mlir::spirv::PointerType::get(intType, ptrType.getStorageClass()),
+      elemPtr);
+}
+
+/// Lowers memref.load marked by imex-subgroup-block-io to
+/// spirv.INTEL.SubgroupBlockRead. Takes precedence over the upstream
+/// memref.load lowering.
+class SubgroupBlockLoadPattern
+    : public mlir::OpConversionPattern<mlir::memref::LoadOp> {
+public:
+  using mlir::OpConversionPattern<mlir::memref::LoadOp>::OpConversionPattern;
+  mlir::LogicalResult
+  matchAndRewrite(mlir::memref::LoadOp loadOp, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    auto &typeConverter = *getTypeConverter<mlir::SPIRVTypeConverter>();
+    auto ptr = getSubgroupBlockPtr(typeConverter, loadOp,
+                                   loadOp.getMemRefType(), adaptor.getMemref(),
+                                   adaptor.getIndices(), rewriter);
+    if (!ptr)
+      return rewriter.notifyMatchFailure(loadOp, "no subgroup block read");
+
+    auto loc = loadOp.getLoc();
+    auto elemType = typeConverter.convertType(loadOp.getType());
+    auto ptrType = mlir::cast<mlir::spirv::PointerType>(ptr.getType());
+    mlir::Value value = rewriter.create<mlir::spirv::INTELSubgroupBlockReadOp>(
+        loc, ptrType.getPointeeType(), ptr);
+    if (value.getType() != elemType)
+      value = rewriter.create<mlir::spirv::BitcastOp>(loc, elemType, value);
+    rewriter.replaceOp(loadOp, value);
+    return mlir::success();
+  }
+};
+
+/// Lowers memref.store marked by imex-subgroup-block-io to
+/// spirv.INTEL.SubgroupBlockWrite.
+class SubgroupBlockStorePattern
+    : public mlir::OpConversionPattern<mlir::memref::StoreOp> {
+public:
+  using mlir::OpConversionPattern<mlir::memref::StoreOp>::OpConversionPattern;
+  mlir::LogicalResult
+  matchAndRewrite(mlir::memref::StoreOp storeOp, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    auto &typeConverter = *getTypeConverter<mlir::SPIRVTypeConverter>();
+    auto ptr = getSubgroupBlockPtr(typeConverter, storeOp,
+                                   storeOp.getMemRefType(), adaptor.getMemref(),
+                                   adaptor.getIndices(), rewriter);
+    if (!ptr)
+      return rewriter.notifyMatchFailure(storeOp, "no subgroup block write");
+
+    auto ptrType = mlir::cast<mlir::spirv::PointerType>(ptr.getType());
+    mlir::Value value = adaptor.getValue();
+    if (value.getType() != ptrType.getPointeeType())
+      value = rewriter.create<mlir::spirv::BitcastOp>(
+          storeOp.getLoc(), ptrType.getPointeeType(), value);
+    rewriter.replaceOpWithNewOp<mlir::spirv::INTELSubgroupBlockWriteOp>(
+        storeOp, ptr, value);
+    return mlir::success();
+  }
+};
+
+void populateSubgroupBlockIOToSPIRVPatterns(
+    mlir::SPIRVTypeConverter &typeConverter,
+    mlir::RewritePatternSet &patterns) {
+  patterns.add<SubgroupBlockLoadPattern, SubgroupBlockStorePattern>(
+      typeConverter, patterns.getContext(), /*benefit=*/2);
+}
+
 void GPUXToSPIRVPass::runOnOperation() {
   mlir::MLIRContext *context = &getContext();
   mlir::ModuleOp module = getOperation();
@@ -373,6 +608,8 @@ void GPUXToSPIRVPass::runOnOperation() {
     mlir::cf::populateControlFlowToSPIRVPatterns(typeConverter, patterns);
     mlir::populateMathToSPIRVPatterns(typeConverter, patterns);
     imex::populateGPUPrintfToSPIRVPatterns(typeConverter, patterns);
+    imex::populateVectorLoadStoreToSPIRVPatterns(typeConverter, patterns);
+    imex::populateSubgroupBlockIOToSPIRVPatterns(typeConverter, patterns);
 
     if (this->enableVCIntrinsic)
       imex::populateXeGPUToVCIntrinsicsPatterns(typeConverter, patterns);
@@ -46,6 +46,7 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/Interfaces/DataLayoutInterfaces.h"
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Error.h"
@@ -54,6 +55,15 @@
 namespace {
 
 static constexpr const char *kGpuBinaryStorageSuffix = "_spirv_binary";
+static constexpr const char *kModuleStreamGlobalName =
+    "imex_gpux_module_stream";
+static constexpr const char *kModuleStreamGetterName =
+    "imex_gpux_get_module_stream";
+static constexpr const char *kModuleStreamDtorName =
+    "imex_gpux_module_stream_dtor";
+static constexpr int32_t kModuleStreamDtorPriority = 65535;
+static constexpr uint64_t kPointerAlignment = 8;
+static constexpr const char *kCaptureSitePrefix = "imex_gpux_capture_site_";
 
 struct FunctionCallBuilder {
   FunctionCallBuilder(mlir::StringRef functionName, mlir::Type returnType,
@@ -105,10 +115,6 @@ protected:
   mlir::Type llvmIndexType = mlir::IntegerType::get(
       context, this->getTypeConverter()->getPointerBitwidth(0));
 
-  mlir::Type llvmRangeType = mlir::LLVM::LLVMStructType::getLiteral(
-      context, {llvmPointerType, llvmIndexType});
-  mlir::Type llvmRangePointerType = mlir::LLVM::LLVMPointerType::get(context);
-
   FunctionCallBuilder moduleLoadCallBuilder = {
       "gpuModuleLoad",
       llvmPointerType /* void *module */,
@@ -135,19 +141,20 @@ protected:
       }};
 
   FunctionCallBuilder launchKernelCallBuilder = {
-      "gpuLaunchKernel",
+      "gpuLaunchKernelPacked",
       llvmVoidType,
       {
-          llvmPointerType,     /* void* stream */
-          llvmPointerType,     /* void* func */
-          llvmIndexType,       /* intptr_t gridXDim */
-          llvmIndexType,       /* intptr_t gridyDim */
-          llvmIndexType,       /* intptr_t gridZDim */
-          llvmIndexType,       /* intptr_t blockXDim */
-          llvmIndexType,       /* intptr_t blockYDim */
-          llvmIndexType,       /* intptr_t blockZDim */
-          llvmInt32Type,       /* unsigned int sharedMemBytes */
-          llvmRangePointerType /* Params */
+          llvmPointerType, /* void* stream */
+          llvmPointerType, /* void* func */
+          llvmIndexType,   /* intptr_t gridXDim */
+          llvmIndexType,   /* intptr_t gridyDim */
+          llvmIndexType,   /* intptr_t gridZDim */
+          llvmIndexType,   /* intptr_t blockXDim */
+          llvmIndexType,   /* intptr_t blockYDim */
+          llvmIndexType,   /* intptr_t blockZDim */
+          llvmInt32Type,   /* unsigned int sharedMemBytes */
+          llvmPointerType, /* void *params */
+          llvmPointerType  /* const int64_t *layout */
       }};
 
   FunctionCallBuilder streamCreateCallBuilder = {
@@ -188,6 +195,104 @@ protected:
           llvmPointerType, /* void *stream */
           llvmPointerType  /* void *ptr */
       }};
+
+  FunctionCallBuilder memcpyCallBuilder = {
+      "gpuMemcpy",
+      llvmVoidType,
+      {
+          llvmPointerType, /* void *stream */
+          llvmPointerType, /* void *dst */
+          llvmPointerType, /* void *src */
+          llvmIndexType    /* intptr_t size */
+      }};
+
+  FunctionCallBuilder asyncStreamCreateCallBuilder = {
+      "gpuCreateAsyncStream",
+      llvmPointerType, /* void *stream */
+      {
+          llvmPointerType, /* void *device */
+          llvmPointerType  /* void *context */
+      }};
+
+  FunctionCallBuilder eventRecordCallBuilder = {
+      "gpuEventRecord",
+      llvmPointerType, /* void *event */
+      {
+          llvmPointerType /* void *stream */
+      }};
+
+  FunctionCallBuilder streamWaitEventCallBuilder = {
+      "gpuStreamWaitEvent",
+      llvmVoidType,
+      {
+          llvmPointerType, /* void *stream */
+          llvmPointerType  /* void *event */
+      }};
+
+  FunctionCallBuilder eventSynchronizeCallBuilder = {
+      "gpuEventSynchronize",
+      llvmVoidType,
+      {
+          llvmPointerType /* void *event */
+      }};
+
+  FunctionCallBuilder eventDestroyCallBuilder = {
+      "gpuEventDestroy",
+      llvmVoidType,
+      {
+          llvmPointerType /* void *event */
+      }};
+
+  FunctionCallBuilder captureBeginCallBuilder = {
+      "gpuCaptureBegin",
+      llvmVoidType,
+      {
+          llvmPointerType, /* void *stream */
+          llvmPointerType  /* void *site */
+      }};
+
+  FunctionCallBuilder captureEndCallBuilder = {
+      "gpuCaptureEnd",
+      llvmVoidType,
+      {
+          llvmPointerType /* void *stream */
+      }};
+
+  // Async tokens are lowered to runtime events. Makes the work queued on the
+  // stream from now on wait for the events of the given tokens.
+  void streamWaitEvents(mlir::Location loc, mlir::OpBuilder &builder,
+                        mlir::Value stream, mlir::ValueRange tokens,
+                        mlir::ValueRange events) const {
+    for (auto event : events)
+      streamWaitEventCallBuilder.create(loc, builder, {stream, event});
+    releaseEvents(loc, builder, tokens, events);
+  }
+
+  // Blocks the host until the events of the given tokens have completed.
+  void synchronizeEvents(mlir::Location loc, mlir::OpBuilder &builder,
+                         mlir::ValueRange tokens,
+                         mlir::ValueRange events) const {
+    for (auto event : events)
+      eventSynchronizeCallBuilder.create(loc, builder, event);
+    releaseEvents(loc, builder, tokens, events);
+  }
+
+  // Releases the events of the tokens used by the converted op only. The
+  // runtime reuses an event once the work waiting on it has completed, so
+  // this may happen right after queueing the wait.
+  void releaseEvents(mlir::Location loc, mlir::OpBuilder &builder,
+                     mlir::ValueRange tokens, mlir::ValueRange events) const {
+    for (auto [token, event] : llvm::zip(tokens, events))
+      if (token.hasOneUse())
+        eventDestroyCallBuilder.create(loc, builder, event);
+  }
+
+  // Returns an event which completes once the work queued on the stream so
+  // far has.
+  mlir::Value recordEvent(mlir::Location loc, mlir::OpBuilder &builder,
+                          mlir::Value stream) const {
+    return eventRecordCallBuilder.create(loc, builder, stream)->getResult(0);
+  }
 };
 
 /// A rewrite pattern to convert gpux.alloc operations into a GPU runtime
@@ -214,6 +319,9 @@ private:
     bool isShared = allocOp.getHostShared();
 
     auto loc = allocOp.getLoc();
+    streamWaitEvents(loc, rewriter, adaptor.getGpuxStream(),
+                     allocOp.getAsyncDependencies(),
+                     adaptor.getAsyncDependencies());
 
     // Get shape of the memref as values: static sizes are constant
     // values and dynamic sizes are passed to 'alloc' as operands.
@@ -260,7 +368,12 @@ private:
     }
 
     mlir::Value resMemref = memrefDesc;
-    rewriter.replaceOp(allocOp, resMemref);
+    if (allocOp.getAsyncToken()) {
+      auto event = recordEvent(loc, rewriter, adaptor.getGpuxStream());
+      rewriter.replaceOp(allocOp, {resMemref, event});
+    } else {
+      rewriter.replaceOp(allocOp, resMemref);
+    }
 
     return mlir::success();
   }
@@ -282,13 +395,20 @@ private:
                   mlir::ConversionPatternRewriter &rewriter) const override {
     mlir::Location loc = deallocOp.getLoc();
 
+    // The memory may only be freed once the work using it has completed.
+    synchronizeEvents(loc, rewriter, deallocOp.getAsyncDependencies(),
+                      adaptor.getAsyncDependencies());
     mlir::Value pointer =
         mlir::MemRefDescriptor(adaptor.getMemref()).allocatedPtr(rewriter, loc);
     auto casted =
         rewriter.create<mlir::LLVM::BitcastOp>(loc, llvmPointerType, pointer);
     auto res = deallocCallBuilder.create(loc, rewriter,
                                          {adaptor.getGpuxStream(), casted});
-    rewriter.replaceOp(deallocOp, res.getResults());
+    if (deallocOp.getAsyncToken())
+      rewriter.replaceOp(deallocOp,
+                         recordEvent(loc, rewriter, adaptor.getGpuxStream()));
+    else
+      rewriter.replaceOp(deallocOp, res.getResults());
     return mlir::success();
   }
 };
@@ -303,7 +423,13 @@ private:
 /// * launchKernel      -- launches the kernel on a stream
 /// * gpuWait           -- waits for operations on the stream to finish
 ///
-/// Intermediate data structures are allocated on the stack.
+/// An async launch makes the stream wait for the events of its dependencies
+/// before the launch and returns an event recorded after it instead of
+/// waiting for the stream.
+///
+/// The kernel parameters are packed into a single struct allocated on the
+/// stack, its layout is a constant global shared by all launches of the
+/// kernel.
 class ConvertLaunchFuncOpToGpuRuntimeCallPattern
     : public ConvertOpToGpuRuntimeCallPattern<imex::gpux::LaunchFuncOp> {
 public:
@@ -343,6 +469,52 @@ private:
         mlir::LLVM::Linkage::Internal);
   }
 
+  // Returns the layout of the packed parameters of the kernel, creating it
+  // on the first launch:
+  //
+  // llvm.mlir.global internal constant @<module>_<kernel>_kernel_args(
+  //     [NumParameters, offset_0, size_0, offset_1, size_1, ...])
+  //
+  // Offsets and sizes are in bytes and follow the data layout of the module.
+  mlir::LLVM::GlobalOp
+  getOrCreateArgLayout(imex::gpux::LaunchFuncOp launchOp,
+                       llvm::ArrayRef<mlir::Type> paramTypes,
+                       mlir::OpBuilder &builder) const {
+    auto mod = launchOp->getParentOfType<mlir::ModuleOp>();
+    assert(mod && "expected a module");
+
+    std::string globalName = std::string(llvm::formatv(
+        "{0}_{1}_kernel_args", launchOp.getKernelModuleName().getValue(),
+        launchOp.getKernelName().getValue()));
+    if (auto global = mod.lookupSymbol<mlir::LLVM::GlobalOp>(globalName))
+      return global;
+
+    mlir::DataLayout dataLayout(mod);
+    llvm::SmallVector<int64_t> layout;
+    layout.push_back(static_cast<int64_t>(paramTypes.size()));
+    uint64_t offset = 0;
+    for (auto type : paramTypes) {
+      offset = llvm::alignTo(offset, dataLayout.getTypeABIAlignment(type));
+      auto size = dataLayout.getTypeSize(type);
+      layout.push_back(static_cast<int64_t>(offset));
+      layout.push_back(static_cast<int64_t>(size));
+      offset += size;
+    }
+
+    auto layoutType =
+        mlir::LLVM::LLVMArrayType::get(llvmInt64Type, layout.size());
+    auto value = mlir::DenseElementsAttr::get(
+        mlir::RankedTensorType::get({static_cast<int64_t>(layout.size())},
+                                    llvmInt64Type),
+        llvm::ArrayRef(layout));
+
+    mlir::OpBuilder::InsertionGuard g(builder);
+    builder.setInsertionPointToStart(mod.getBody());
+    return builder.create<mlir::LLVM::GlobalOp>(
+        launchOp.getLoc(), layoutType, /*isConstant=*/true,
+        mlir::LLVM::Linkage::Internal, globalName, value);
+  }
+
   mlir::LogicalResult
   matchAndRewrite(imex::gpux::LaunchFuncOp launchOp, OpAdaptor adaptor,
                   mlir::ConversionPatternRewriter &rewriter) const override {
@@ -389,113 +561,63 @@ private:
         loc, rewriter,
         {adaptor.getGpuxStream(), module->getResult(0), kernelName});
 
+    streamWaitEvents(loc, rewriter, adaptor.getGpuxStream(),
+                     launchOp.getAsyncDependencies(),
+                     adaptor.getAsyncDependencies());
+
     /////////////////////////////////////////////////////////////////////////
-    // Create an array of struct containing all kernel parameters and inserts
-    // these type-erased pointers to the fields of the struct. The array of
-    // struct is then passed to Runtime wrapper Kernel launch call. Generated
-    // code is essentially as follows:
+    // Pack the values of all kernel parameters into a single struct and pass
+    // it to the runtime together with its layout, a constant global emitted
+    // once per kernel (see getOrCreateArgLayout). Generated code is
+    // essentially as follows:
     //
-    // 1. %struct = alloca(sizeof(struct { Parameters... }))
-    // 2. %array = alloca(NumParameters * sizeof(void *))
-    // 3.  for (i : [0, NumParameters))
-    //    %fieldPtr = llvm.getelementptr %struct[0, i]
-    // 4. llvm.store parameters[i], %fieldPtr
-    //    %elementPtr = llvm.getelementptr %array[i]
-    // 5. llvm.store %fieldPtr, %elementPtr
+    // 1. %blob = alloca(sizeof(struct { Parameters... }))
+    // 2. for (i : [0, NumParameters))
+    //      %fieldPtr = llvm.getelementptr %blob[0, i]
+    //      llvm.store parameters[i], %fieldPtr
+    // 3. %layout = llvm.mlir.addressof @<module>_<kernel>_kernel_args
 
-    imex::AllocaInsertionPoint allocaHelper(launchOp);
     auto kernelParams = adaptor.getKernelOperands();
     auto paramsCount = static_cast<unsigned>(kernelParams.size());
-    auto paramsArrayType =
-        mlir::LLVM::LLVMArrayType::get(llvmRangeType, paramsCount + 1);
-
-    auto getKernelParamType = [&](unsigned i) -> mlir::Type {
-      if (launchOp.getKernelOperands()[i].getType().isa<mlir::MemRefType>()) {
-        mlir::MemRefDescriptor desc(kernelParams[i]);
-        return desc.getElementPtrType();
-      }
+    // The last operand of a launch with dynamic shared local memory stands
+    // for that memory, it is sized by the runtime and not an argument value.
+    if (adaptor.getDynamicSharedMemorySize()) {
+      assert(paramsCount && "expected the shared local memory operand");
+      --paramsCount;
+    }
 
-      return kernelParams[i].getType();
-    };
+    llvm::SmallVector<mlir::Value> paramValues;
+    llvm::SmallVector<mlir::Type> paramTypes;
+    for (auto i : llvm::seq(0u, paramsCount)) {
+      mlir::Value param = kernelParams[i];
+      if (launchOp.getKernelOperands()[i].getType().isa<mlir::MemRefType>())
+        param = mlir::MemRefDescriptor(param).alignedPtr(rewriter, loc);
+      paramValues.push_back(param);
+      paramTypes.push_back(param.getType());
+    }
+    auto blobType = mlir::LLVM::LLVMStructType::getLiteral(context, paramTypes);
+    auto layout = getOrCreateArgLayout(launchOp, paramTypes, rewriter);
 
-    llvm::SmallVector<mlir::Value> paramsStorage(paramsCount);
-    auto paramsArrayPtr = allocaHelper.insert(rewriter, [&]() {
+    imex::AllocaInsertionPoint allocaHelper(launchOp);
+    auto blob = allocaHelper.insert(rewriter, [&]() {
       auto size = rewriter.create<mlir::LLVM::ConstantOp>(
           loc, llvmInt64Type, rewriter.getI64IntegerAttr(1));
-      for (auto i : llvm::seq(0u, paramsCount)) {
-        paramsStorage[i] = rewriter.create<mlir::LLVM::AllocaOp>(
-            loc, llvmPointerType, getKernelParamType(i), size, 0);
-      }
       return rewriter.create<mlir::LLVM::AllocaOp>(loc, llvmPointerType,
-                                                   paramsArrayType, size, 0);
+                                                   blobType, size, 0);
     });
 
-    mlir::Value one = rewriter.create<mlir::LLVM::ConstantOp>(
-        loc, llvmInt32Type, rewriter.getI32IntegerAttr(1));
-    auto computeTypeSize = [&](mlir::Type type) -> mlir::Value {
-      auto nullPtr = rewriter.create<mlir::LLVM::ZeroOp>(loc, type);
-      auto gep = rewriter.create<mlir::LLVM::GEPOp>(loc, type, llvmPointerType,
-                                                    nullPtr, one);
-      return rewriter.create<mlir::LLVM::PtrToIntOp>(loc, llvmIndexType, gep);
-    };
-
-    auto getKernelParam =
-        [&](unsigned i) -> std::pair<mlir::Value, mlir::Value> {
-      auto memrefType = launchOp.getKernelOperands()[i]
-                            .getType()
-                            .dyn_cast<mlir::MemRefType>();
-      auto paramType = paramsStorage[i].getType();
-      if (memrefType) {
-        mlir::MemRefDescriptor desc(kernelParams[i]);
-        auto size = computeTypeSize(paramType);
-        return {size, desc.alignedPtr(rewriter, loc)};
-      }
-
-      auto size = computeTypeSize(paramType);
-      return {size, kernelParams[i]};
-    };
-
-    mlir::Value paramsArray =
-        rewriter.create<mlir::LLVM::UndefOp>(loc, paramsArrayType);
-
     for (auto i : llvm::seq(0u, paramsCount)) {
-      auto param = getKernelParam(i);
-      rewriter.create<mlir::LLVM::StoreOp>(loc, param.second, paramsStorage[i]);
-      auto ptr = rewriter.create<mlir::LLVM::BitcastOp>(loc, llvmPointerType,
-                                                        paramsStorage[i]);
-
-      auto typeSize = param.first;
-
-      mlir::Value range =
-          rewriter.create<mlir::LLVM::UndefOp>(loc, llvmRangeType);
-      range = rewriter.create<mlir::LLVM::InsertValueOp>(loc, range, ptr, 0);
-      range =
-          rewriter.create<mlir::LLVM::InsertValueOp>(loc, range, typeSize, 1);
-
-      paramsArray = rewriter.create<mlir::LLVM::InsertValueOp>(loc, paramsArray,
-                                                               range, i);
+      auto fieldPtr = rewriter.create<mlir::LLVM::GEPOp>(
+          loc, llvmPointerType, blobType, blob,
+          llvm::ArrayRef<mlir::LLVM::GEPArg>{0, static_cast<int32_t>(i)});
+      rewriter.create<mlir::LLVM::StoreOp>(loc, paramValues[i], fieldPtr);
     }
 
-    auto nullPtr = rewriter.create<mlir::LLVM::ZeroOp>(loc, llvmPointerType);
-    auto nullRange = [&]() {
-      auto zero = rewriter.create<mlir::LLVM::ConstantOp>(
-          loc, llvmIndexType, rewriter.getIntegerAttr(llvmIndexType, 0));
-      mlir::Value range =
-          rewriter.create<mlir::LLVM::UndefOp>(loc, llvmRangeType);
-      range =
-          rewriter.create<mlir::LLVM::InsertValueOp>(loc, range, nullPtr, 0);
-      range = rewriter.create<mlir::LLVM::InsertValueOp>(loc, range, zero, 1);
-      return range;
-    }();
-    paramsArray = rewriter.create<mlir::LLVM::InsertValueOp>(
-        loc, paramsArray, nullRange, paramsCount);
-    rewriter.create<mlir::LLVM::StoreOp>(loc, paramsArray, paramsArrayPtr);
+    auto layoutPtr = rewriter.create<mlir::LLVM::AddressOfOp>(loc, layout);
 
     /////////////////////////////////////////////////////////////////////
 
-    // Get pointer to array of kernel parameters and call launch kernel
-    auto paramsArrayVoidPtr = rewriter.create<mlir::LLVM::BitcastOp>(
-        loc, llvmRangePointerType, paramsArrayPtr);
+    // Call launch kernel with the packed parameters
     auto zero = rewriter.create<mlir::LLVM::ConstantOp>(
         loc, llvmInt32Type, rewriter.getI32IntegerAttr(0));
     mlir::Value dynamicSharedMemorySize =
@@ -507,7 +629,13 @@ private:
         {adaptor.getGpuxStream(), function->getResult(0),
          adaptor.getGridSizeX(), adaptor.getGridSizeY(), adaptor.getGridSizeZ(),
          adaptor.getBlockSizeX(), adaptor.getBlockSizeY(),
-         adaptor.getBlockSizeZ(), dynamicSharedMemorySize, paramsArrayVoidPtr});
+         adaptor.getBlockSizeZ(), dynamicSharedMemorySize, blob, layoutPtr});
+
+    if (launchOp.getAsyncToken()) {
+      rewriter.replaceOp(launchOp,
+                         recordEvent(loc, rewriter, adaptor.getGpuxStream()));
+      return mlir::success();
+    }
 
     // waits for operations on the stream to finish
 
@@ -517,6 +645,109 @@ private:
   }
 };
 
+/// A rewrite pattern to convert gpux.wait operations into GPU runtime calls.
+/// A blocking wait synchronizes the host with (and releases) the events of
+/// its dependencies, or with the whole stream if it has none. An async wait
+/// returns an event completing after all of its dependencies.
+class ConvertWaitOpToGpuRuntimeCallPattern
+    : public ConvertOpToGpuRuntimeCallPattern<imex::gpux::WaitOp> {
+public:
+  ConvertWaitOpToGpuRuntimeCallPattern(mlir::LLVMTypeConverter &typeConverter)
+      : ConvertOpToGpuRuntimeCallPattern<imex::gpux::WaitOp>(typeConverter) {}
+
+private:
+  mlir::LogicalResult
+  matchAndRewrite(imex::gpux::WaitOp waitOp, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    auto loc = waitOp.getLoc();
+    auto stream = adaptor.getGpuxStream();
+    auto deps = adaptor.getAsyncDependencies();
+
+    if (waitOp.getAsyncToken()) {
+      streamWaitEvents(loc, rewriter, stream, waitOp.getAsyncDependencies(),
+                       deps);
+      rewriter.replaceOp(waitOp, recordEvent(loc, rewriter, stream));
+      return mlir::success();
+    }
+
+    if (deps.empty())
+      waitCallBuilder.create(loc, rewriter, stream);
+    else
+      synchronizeEvents(loc, rewriter, waitOp.getAsyncDependencies(), deps);
+    rewriter.eraseOp(waitOp);
+    return mlir::success();
+  }
+};
+
+/// A rewrite pattern to convert gpux.memcpy operations of contiguous memrefs
+/// into a GPU runtime call. A synchronous copy waits for the stream.
+class ConvertMemcpyOpToGpuRuntimeCallPattern
+    : public ConvertOpToGpuRuntimeCallPattern<imex::gpux::MemcpyOp> {
+public:
+  ConvertMemcpyOpToGpuRuntimeCallPattern(
+      mlir::LLVMTypeConverter &typeConverter)
+      : ConvertOpToGpuRuntimeCallPattern<imex::gpux::MemcpyOp>(typeConverter) {
+  }
+
+private:
+  mlir::LogicalResult
+  matchAndRewrite(imex::gpux::MemcpyOp memcpyOp, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    auto memRefType = memcpyOp.getSrc().getType().cast<mlir::MemRefType>();
+    auto dstType = memcpyOp.getDst().getType().cast<mlir::MemRefType>();
+    if (!memRefType.getLayout().isIdentity() ||
+        !dstType.getLayout().isIdentity())
+      return mlir::failure();
+
+    auto elementType =
+        getTypeConverter()->convertType(memRefType.getElementType());
+    if (!elementType)
+      return mlir::failure();
+
+    auto loc = memcpyOp.getLoc();
+    auto stream = adaptor.getGpuxStream();
+    mlir::MemRefDescriptor srcDesc(adaptor.getSrc());
+    mlir::MemRefDescriptor dstDesc(adaptor.getDst());
+
+    mlir::Value numElements;
+    if (memRefType.hasStaticShape()) {
+      numElements = rewriter.create<mlir::LLVM::ConstantOp>(
+          loc, llvmIndexType,
+          rewriter.getIntegerAttr(llvmIndexType, memRefType.getNumElements()));
+    } else {
+      numElements = rewriter.create<mlir::LLVM::MulOp>(
+          loc, srcDesc.stride(rewriter, loc, 0),
+          srcDesc.size(rewriter, loc, 0));
+    }
+    auto nullPtr = rewriter.create<mlir::LLVM::ZeroOp>(loc, llvmPointerType);
+    auto sizeGep = rewriter.create<mlir::LLVM::GEPOp>(
+        loc, llvmPointerType, elementType, nullPtr, numElements);
+    auto sizeBytes =
+        rewriter.create<mlir::LLVM::PtrToIntOp>(loc, llvmIndexType, sizeGep);
+
+    auto getDataPtr = [&](mlir::MemRefDescriptor &desc) -> mlir::Value {
+      return rewriter.create<mlir::LLVM::GEPOp>(
+          loc, llvmPointerType, elementType, desc.alignedPtr(rewriter, loc),
+          desc.offset(rewriter, loc));
+    };
+    auto dst = getDataPtr(dstDesc);
+    auto src = getDataPtr(srcDesc);
+
+    streamWaitEvents(loc, rewriter, stream, memcpyOp.getAsyncDependencies(),
+                     adaptor.getAsyncDependencies());
+    memcpyCallBuilder.create(loc, rewriter, {stream, dst, src, sizeBytes});
+
+    if (memcpyOp.getAsyncToken()) {
+      rewriter.replaceOp(memcpyOp, recordEvent(loc, rewriter, stream));
+      return mlir::success();
+    }
+
+    waitCallBuilder.create(loc, rewriter, stream);
+    rewriter.eraseOp(memcpyOp);
+    return mlir::success();
+  }
+};
+
 /// A rewrite pattern to convert gpux.create_stream operations into a GPU
 /// runtime call.
 class ConvertGpuStreamCreatePattern
@@ -537,15 +768,163 @@ private:
 
     auto loc = op.getLoc();
 
+    if (op.getModuleLifetime()) {
+      auto getter = getOrCreateModuleStreamGetter(mod, loc);
+      auto res = rewriter.create<mlir::LLVM::CallOp>(loc, getter,
+                                                     mlir::ValueRange{});
+      rewriter.replaceOp(op, res.getResults());
+      return mlir::success();
+    }
+
     // TODO: Pass nullptrs now for the current workflow where user is
     // not passing device and context. Add different streambuilders
     // later.
     auto device = rewriter.create<mlir::LLVM::ZeroOp>(loc, llvmPointerType);
     auto context = rewriter.create<mlir::LLVM::ZeroOp>(loc, llvmPointerType);
-    auto res = streamCreateCallBuilder.create(loc, rewriter, {device, context});
+
+    // Streams used by async ops may execute their work out of order with
+    // the host, the runtime orders it through the events of the tokens.
+    auto isAsync = llvm::any_of(op->getUsers(), [](mlir::Operation *user) {
+      auto asyncOp = mlir::dyn_cast<mlir::gpu::AsyncOpInterface>(user);
+      return asyncOp && (asyncOp.getAsyncToken() ||
+                         !asyncOp.getAsyncDependencies().empty());
+    });
+    auto &callBuilder =
+        isAsync ? asyncStreamCreateCallBuilder : streamCreateCallBuilder;
+    auto res = callBuilder.create(loc, rewriter, {device, context});
     rewriter.replaceOp(op, res.getResults());
     return mlir::success();
   }
+
+  // Loads the stream pointer at addr with acquire ordering, pairing with the
+  // cmpxchg publishing it.
+  mlir::Value createAtomicLoad(mlir::OpBuilder &builder, mlir::Location loc,
+                               mlir::Value addr) const {
+    auto load = builder.create<mlir::LLVM::LoadOp>(loc, llvmPointerType, addr);
+    load.setOrdering(mlir::LLVM::AtomicOrdering::acquire);
+    load.setAlignment(kPointerAlignment);
+    return load;
+  }
+
+  // Returns the function returning the stream shared by all module_lifetime
+  // create_stream ops of the module, creating it on the first call:
+  //
+  // llvm.mlir.global internal @imex_gpux_module_stream() : !llvm.ptr
+  // llvm.func internal @imex_gpux_get_module_stream() -> !llvm.ptr {
+  //   %stream = llvm.load @imex_gpux_module_stream
+  //   if (!%stream) {
+  //     %new = llvm.call @gpuCreateStream(null, null)
+  //     %stream = llvm.cmpxchg @imex_gpux_module_stream, null, %new
+  //     if (!%stream.success)
+  //       llvm.call @gpuStreamDestroy(%new)
+  //   }
+  //   llvm.return %stream
+  // }
+  // llvm.mlir.global_dtors {@imex_gpux_module_stream_dtor}
+  //
+  // The destructor destroys the stream when the module is unloaded. The
+  // global is only accessed atomically: loads acquire, the cmpxchg is
+  // acq_rel/acquire and the store of the destructor releases.
+  mlir::LLVM::LLVMFuncOp
+  getOrCreateModuleStreamGetter(mlir::ModuleOp mod, mlir::Location loc) const {
+    if (auto getter =
+            mod.lookupSymbol<mlir::LLVM::LLVMFuncOp>(kModuleStreamGetterName))
+      return getter;
+
+    auto builder = mlir::OpBuilder::atBlockEnd(mod.getBody());
+    auto global = builder.create<mlir::LLVM::GlobalOp>(
+        loc, llvmPointerType, /*isConstant=*/false,
+        mlir::LLVM::Linkage::Internal, kModuleStreamGlobalName,
+        mlir::Attribute{});
+    {
+      mlir::OpBuilder::InsertionGuard g(builder);
+      builder.createBlock(&global.getInitializerRegion());
+      mlir::Value null =
+          builder.create<mlir::LLVM::ZeroOp>(loc, llvmPointerType);
+      builder.create<mlir::LLVM::ReturnOp>(loc, null);
+    }
+
+    auto getter = builder.create<mlir::LLVM::LLVMFuncOp>(
+        loc, kModuleStreamGetterName,
+        mlir::LLVM::LLVMFunctionType::get(llvmPointerType, {}),
+        mlir::LLVM::Linkage::Internal);
+    {
+      mlir::OpBuilder::InsertionGuard g(builder);
+      auto *entry = getter.addEntryBlock();
+      auto *create = builder.createBlock(&getter.getBody());
+      auto *lost = builder.createBlock(&getter.getBody());
+      auto *done = builder.createBlock(&getter.getBody(), {}, llvmPointerType,
+                                       loc);
+
+      builder.setInsertionPointToStart(entry);
+      auto addr = builder.create<mlir::LLVM::AddressOfOp>(loc, global);
+      mlir::Value stream = createAtomicLoad(builder, loc, addr);
+      mlir::Value null =
+          builder.create<mlir::LLVM::ZeroOp>(loc, llvmPointerType);
+      auto isNull = builder.create<mlir::LLVM::ICmpOp>(
+          loc, mlir::LLVM::ICmpPredicate::eq, stream, null);
+      builder.create<mlir::LLVM::CondBrOp>(loc, isNull, create,
+                                           mlir::ValueRange{}, done, stream);
+
+      // Another thread may have created the stream in the meantime, in
+      // which case ours is dropped.
+      builder.setInsertionPointToStart(create);
+      auto newStream =
+          streamCreateCallBuilder.create(loc, builder, {null, null})
+              ->getResult(0);
+      auto pair = builder.create<mlir::LLVM::AtomicCmpXchgOp>(
+          loc, addr, null, newStream, mlir::LLVM::AtomicOrdering::acq_rel,
+          mlir::LLVM::AtomicOrdering::acquire);
+      auto success = builder.create<mlir::LLVM::ExtractValueOp>(loc, pair, 1);
+      builder.create<mlir::LLVM::CondBrOp>(loc, success, done, newStream, lost,
+                                           mlir::ValueRange{});
+
+      builder.setInsertionPointToStart(lost);
+      streamDestroyCallBuilder.create(loc, builder, newStream);
+      mlir::Value current =
+          builder.create<mlir::LLVM::ExtractValueOp>(loc, pair, 0);
+      builder.create<mlir::LLVM::BrOp>(loc, current, done);
+
+      builder.setInsertionPointToStart(done);
+      builder.create<mlir::LLVM::ReturnOp>(loc, done->getArgument(0));
+    }
+
+    auto dtor = builder.create<mlir::LLVM::LLVMFuncOp>(
+        loc, kModuleStreamDtorName,
+        mlir::LLVM::LLVMFunctionType::get(llvmVoidType, {}),
+        mlir::LLVM::Linkage::Internal);
+    {
+      mlir::OpBuilder::InsertionGuard g(builder);
+      auto *entry = dtor.addEntryBlock();
+      auto *destroy = builder.createBlock(&dtor.getBody());
+      auto *done = builder.createBlock(&dtor.getBody());
+
+      builder.setInsertionPointToStart(entry);
+      auto addr = builder.create<mlir::LLVM::AddressOfOp>(loc, global);
+      mlir::Value stream = createAtomicLoad(builder, loc, addr);
+      mlir::Value null =
+          builder.create<mlir::LLVM::ZeroOp>(loc, llvmPointerType);
+      auto isNull = builder.create<mlir::LLVM::ICmpOp>(
+          loc, mlir::LLVM::ICmpPredicate::eq, stream, null);
+      builder.create<mlir::LLVM::CondBrOp>(loc, isNull, done, destroy);
+
+      builder.setInsertionPointToStart(destroy);
+      streamDestroyCallBuilder.create(loc, builder, stream);
+      auto store = builder.create<mlir::LLVM::StoreOp>(loc, null, addr);
+      store.setOrdering(mlir::LLVM::AtomicOrdering::release);
+      store.setAlignment(kPointerAlignment);
+      builder.create<mlir::LLVM::BrOp>(loc, done);
+
+      builder.setInsertionPointToStart(done);
+      builder.create<mlir::LLVM::ReturnOp>(loc, mlir::ValueRange{});
+    }
+
+    builder.create<mlir::LLVM::GlobalDtorsOp>(
+        loc,
+        builder.getArrayAttr(mlir::FlatSymbolRefAttr::get(dtor.getNameAttr())),
+        builder.getI32ArrayAttr(kModuleStreamDtorPriority));
+    return getter;
+  }
 };
 
 /// A rewrite pattern to convert gpux.destroy_stream operations into a GPU
@@ -562,6 +941,15 @@ private:
   matchAndRewrite(imex::gpux::DestroyStreamOp op,
                   imex::gpux::DestroyStreamOp::Adaptor adaptor,
                   mlir::ConversionPatternRewriter &rewriter) const override {
+    // The module stream outlives the function and is destroyed by the module
+    // destructor.
+    auto createOp =
+        op.getGpuxStream().getDefiningOp<imex::gpux::CreateStreamOp>();
+    if (createOp && createOp.getModuleLifetime()) {
+      rewriter.eraseOp(op);
+      return mlir::success();
+    }
+
     auto loc = op.getLoc();
     auto res =
         streamDestroyCallBuilder.create(loc, rewriter, adaptor.getGpuxStream());
@@ -569,6 +957,70 @@ private:
     return mlir::success();
   }
 };
+
+/// A rewrite pattern to convert gpux.capture_begin operations into a GPU
+/// runtime call. The runtime keys the graphs of a stream by the address of a
+/// global created for every capture site.
+class ConvertCaptureBeginOpToGpuRuntimeCallPattern
+    : public ConvertOpToGpuRuntimeCallPattern<imex::gpux::CaptureBeginOp> {
+public:
+  ConvertCaptureBeginOpToGpuRuntimeCallPattern(
+      mlir::LLVMTypeConverter &converter)
+      : ConvertOpToGpuRuntimeCallPattern<imex::gpux::CaptureBeginOp>(
+            converter) {}
+
+private:
+  mlir::LogicalResult
+  matchAndRewrite(imex::gpux::CaptureBeginOp op, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    auto mod = op->getParentOfType<mlir::ModuleOp>();
+    if (!mod)
+      return mlir::failure();
+
+    auto loc = op.getLoc();
+    std::string name;
+    for (unsigned i = 0;; ++i) {
+      name = (llvm::Twine(kCaptureSitePrefix) + llvm::Twine(i)).str();
+      if (!mod.lookupSymbol(name))
+        break;
+    }
+
+    mlir::LLVM::GlobalOp site;
+    {
+      mlir::OpBuilder::InsertionGuard g(rewriter);
+      rewriter.setInsertionPointToStart(mod.getBody());
+      site = rewriter.create<mlir::LLVM::GlobalOp>(
+          loc, llvmInt8Type, /*isConstant=*/false,
+          mlir::LLVM::Linkage::Internal, name, rewriter.getI8IntegerAttr(0));
+    }
+    auto siteAddr = rewriter.create<mlir::LLVM::AddressOfOp>(loc, site);
+    captureBeginCallBuilder.create(loc, rewriter,
+                                   {adaptor.getGpuxStream(), siteAddr});
+    rewriter.eraseOp(op);
+    return mlir::success();
+  }
+};
+
+/// A rewrite pattern to convert gpux.capture_end operations into a GPU
+/// runtime call.
+class ConvertCaptureEndOpToGpuRuntimeCallPattern
+    : public ConvertOpToGpuRuntimeCallPattern<imex::gpux::CaptureEndOp> {
+public:
+  ConvertCaptureEndOpToGpuRuntimeCallPattern(
+      mlir::LLVMTypeConverter &converter)
+      : ConvertOpToGpuRuntimeCallPattern<imex::gpux::CaptureEndOp>(
+            converter) {}
+
+private:
+  mlir::LogicalResult
+  matchAndRewrite(imex::gpux::CaptureEndOp op, OpAdaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+    captureEndCallBuilder.create(op.getLoc(), rewriter,
+                                 adaptor.getGpuxStream());
+    rewriter.eraseOp(op);
+    return mlir::success();
+  }
+};
 } // namespace
 
 class GPUXToLLVMPass : public ::imex::ConvertGPUXToLLVMBase<GPUXToLLVMPass> {
@@ -625,13 +1077,21 @@ void imex::populateGpuxToLLVMPatternsAndLegality(
       [llvmPointerType](imex::gpux::ContextType) -> mlir::Type {
         return llvmPointerType;
       });
+  converter.addConversion(
+      [llvmPointerType](mlir::gpu::AsyncTokenType) -> mlir::Type {
+        return llvmPointerType;
+      });
 
   patterns.insert<
       // clang-format off
       ConvertGpuStreamCreatePattern,
       ConvertGpuStreamDestroyPattern,
       ConvertAllocOpToGpuRuntimeCallPattern,
-      ConvertDeallocOpToGpuRuntimeCallPattern
+      ConvertDeallocOpToGpuRuntimeCallPattern,
+      ConvertWaitOpToGpuRuntimeCallPattern,
+      ConvertMemcpyOpToGpuRuntimeCallPattern,
+      ConvertCaptureBeginOpToGpuRuntimeCallPattern,
+      ConvertCaptureEndOpToGpuRuntimeCallPattern
       // clang-format on
       >(converter);
 
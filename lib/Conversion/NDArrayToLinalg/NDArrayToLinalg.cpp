@@ -28,7 +28,9 @@
 #include <imex/Dialect/Dist/Utils/Utils.h>
 #include <imex/Dialect/NDArray/IR/NDArrayOps.h>
 #include <imex/Dialect/NDArray/Transforms/Utils.h>
+#include <imex/Dialect/Region/RegionUtils.h>
 #include <imex/Dialect/Region/Transforms/RegionConversions.h>
+#include <imex/Dialect/XeTile/IR/XeTileOps.h>
 #include <imex/Utils/ArithUtils.h>
 #include <imex/Utils/PassUtils.h>
 
@@ -37,14 +39,18 @@
 #include <mlir/Dialect/Bufferization/IR/Bufferization.h>
 #include <mlir/Dialect/Func/IR/FuncOps.h>
 #include <mlir/Dialect/Func/Transforms/FuncConversions.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
 #include <mlir/Dialect/LLVMIR/LLVMDialect.h>
 #include <mlir/Dialect/Linalg/IR/Linalg.h>
 #include <mlir/Dialect/Linalg/Utils/Utils.h>
 #include <mlir/Dialect/Math/IR/Math.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
 #include <mlir/Dialect/SCF/Transforms/Patterns.h>
 #include <mlir/Dialect/Shape/IR/Shape.h>
 #include <mlir/Dialect/Tensor/IR/Tensor.h>
 #include <mlir/Dialect/Tosa/IR/TosaOps.h>
+#include <mlir/Dialect/Vector/IR/VectorOps.h>
 #include <mlir/Pass/Pass.h>
 
 #include <iostream>
@@ -291,6 +297,40 @@ struct LoadOpLowering
   }
 };
 
+/// Write srcMR into the given slice of dstMR. A 0d srcMR is broadcasted.
+static void
+createSliceWrite(::mlir::Location loc, ::mlir::OpBuilder &builder,
+                 ::mlir::Value srcMR, ::mlir::Value dstMR,
+                 ::mlir::ArrayRef<::mlir::OpFoldResult> slcOffs,
+                 ::mlir::ArrayRef<::mlir::OpFoldResult> slcSizes,
+                 ::mlir::ArrayRef<::mlir::OpFoldResult> slcStrides) {
+  auto view = builder.create<::mlir::memref::SubViewOp>(
+      loc, dstMR, slcOffs, slcSizes, slcStrides);
+
+  auto srcRank = srcMR.getType().cast<::mlir::MemRefType>().getRank();
+  auto dstRank = dstMR.getType().cast<::mlir::MemRefType>().getRank();
+  // FIXME properly handle broadcasting
+  if (srcRank == 0) {
+    // emit a loop that broadcasts a scalar to dst shape
+    // construct broadcasting affine map; srcRank==0 case is simple
+    auto srcMap =
+        ::mlir::AffineMap::get(dstRank, srcRank, {}, builder.getContext());
+    auto dstMap = builder.getMultiDimIdentityMap(dstRank);
+    ::mlir::SmallVector<mlir::utils::IteratorType> iterators(
+        dstRank, ::mlir::utils::IteratorType::parallel);
+    builder.create<::mlir::linalg::GenericOp>(
+        loc, srcMR, view.getResult(), ::mlir::ArrayRef({srcMap, dstMap}),
+        iterators,
+        [](::mlir::OpBuilder &b, ::mlir::Location loc,
+           ::mlir::ValueRange args) {
+          b.create<::mlir::linalg::YieldOp>(loc, args.front());
+        });
+    return;
+  }
+
+  builder.create<::mlir::memref::CopyOp>(loc, srcMR, view);
+}
+
 /// Convert NDArray's insert_slice to memref
 struct InsertSliceLowering
     : public ::mlir::OpConversionPattern<::imex::ndarray::InsertSliceOp> {
@@ -327,41 +367,118 @@ struct InsertSliceLowering
     auto slcStrides = ::mlir::getMixedValues(adaptor.getStaticStrides(),
                                              adaptor.getStrides(), rewriter);
 
-    auto view = rewriter.create<::mlir::memref::SubViewOp>(
-        loc, dstMR, slcOffs, slcSizes, slcStrides);
-
-    auto srcRank = srcMRTyp.getRank();
-    auto dstRank = dstMRTyp.getRank();
-    // FIXME properly handle broadcasting
-    if (srcRank == 0) {
-      // emit a loop that broadcasts a scalar to dst shape
-      // construct broadcasting affine map; srcRank==0 case is simple
-      auto srcMap =
-          ::mlir::AffineMap::get(dstRank, srcRank, {}, rewriter.getContext());
-      auto dstMap = rewriter.getMultiDimIdentityMap(dstRank);
-      ::mlir::SmallVector<mlir::utils::IteratorType> iterators(
-          dstRank, ::mlir::utils::IteratorType::parallel);
-      auto copyOp = rewriter.create<::mlir::linalg::GenericOp>(
-          loc, srcMR, view.getResult(), ::mlir::ArrayRef({srcMap, dstMap}),
-          iterators,
-          [](::mlir::OpBuilder &b, ::mlir::Location loc,
-             ::mlir::ValueRange args) {
-            b.create<::mlir::linalg::YieldOp>(loc, args.front());
-          });
-      rewriter.replaceOp(op, copyOp);
-      return ::mlir::success();
-    }
-
-    rewriter.replaceOpWithNewOp<::mlir::memref::CopyOp>(op, srcMR, view);
+    createSliceWrite(loc, rewriter, srcMR, dstMR, slcOffs, slcSizes,
+                     slcStrides);
+    rewriter.eraseOp(op);
     return ::mlir::success();
   }
 };
 
-/// Convert immutable_insert_slice to tensor
+/// @return true if `a` is executed before `b` starts, comparing the
+/// ancestors of both in the innermost block containing both
+static bool isExecutedBefore(::mlir::Operation *a, ::mlir::Operation *b) {
+  for (auto x = a; x; x = x->getParentOp()) {
+    if (auto y = x->getBlock()->findAncestorOpInBlock(*b)) {
+      return x != y && x->isBeforeInBlock(y);
+    }
+  }
+  return false;
+}
+
+/// @return true if op creates a new array which does not alias its operands
+static bool createsNewArray(::mlir::Operation *op) {
+  return ::mlir::isa<::imex::ndarray::CreateOp, ::imex::ndarray::LinSpaceOp,
+                     ::imex::ndarray::CopyOp, ::imex::ndarray::EWBinOp,
+                     ::imex::ndarray::EWUnyOp, ::imex::ndarray::ReductionOp,
+                     ::imex::ndarray::MatMulOp>(op);
+}
+
+/// @return true if `val` is an array which nothing else refers to, i.e. it
+/// is created by an op producing a new array or by immutable_insert_slice,
+/// or it is the iteration argument of an scf.for whose initial value is such
+/// an array used only by the loop and which yields `yielded` for it.
+static bool isOwnedArray(::mlir::Value val, ::mlir::Value yielded) {
+  if (auto arg = val.dyn_cast<::mlir::BlockArgument>()) {
+    auto forOp =
+        ::mlir::dyn_cast<::mlir::scf::ForOp>(arg.getOwner()->getParentOp());
+    if (!forOp || arg.getArgNumber() < forOp.getNumInductionVars()) {
+      return false;
+    }
+    auto init = forOp.getTiedLoopInit(arg)->get();
+    return yielded && forOp.getTiedLoopYieldedValue(arg)->get() == yielded &&
+           init.hasOneUse() && isOwnedArray(init, nullptr);
+  }
+  auto defOp = val.getDefiningOp();
+  return defOp && (createsNewArray(defOp) ||
+                   ::mlir::isa<::imex::ndarray::ImmutableInsertSliceOp>(defOp));
+}
+
+/// @return true if all readers of `val`, and of values which may alias it,
+/// are executed before `op`
+static bool readersPrecede(::mlir::Value val, ::mlir::Operation *op) {
+  for (auto user : val.getUsers()) {
+    if (!isExecutedBefore(user, op)) {
+      return false;
+    }
+    if (createsNewArray(user)) {
+      continue;
+    }
+    for (auto res : user->getResults()) {
+      if (!readersPrecede(res, op)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// @return true if the destination of `op` can be updated in place, i.e. it
+/// is owned by the block computing `op` and it is not read after `op`. The
+/// source of `op` must not be a view of the destination, which is implied
+/// since `op` would be a reader of such a view.
+static bool canInsertInPlace(::imex::ndarray::ImmutableInsertSliceOp op) {
+  auto dst = op.getDestination();
+  if (op.getSource() == dst || !isOwnedArray(dst, op.getResult())) {
+    return false;
+  }
+  // env regions execute their body exactly once, other regions may execute
+  // op more than once for a single definition of dst
+  auto scope = dst.getParentBlock();
+  for (auto parent = op.getOperation(); parent->getBlock() != scope;) {
+    parent = parent->getParentOp();
+    if (!parent || !::mlir::isa<::imex::region::EnvironmentRegionOp>(parent)) {
+      return false;
+    }
+  }
+  for (auto user : dst.getUsers()) {
+    if (user == op.getOperation()) {
+      continue;
+    }
+    if (!isExecutedBefore(user, op)) {
+      return false;
+    }
+    if (createsNewArray(user)) {
+      continue;
+    }
+    for (auto res : user->getResults()) {
+      if (!readersPrecede(res, op)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// Convert immutable_insert_slice to tensor. If the destination can be
+/// updated in place, write the source directly into a view of the
+/// destination buffer instead, similar to insert_slice.
 struct ImmutableInsertSliceLowering
     : public ::mlir::OpConversionPattern<
           ::imex::ndarray::ImmutableInsertSliceOp> {
-  using OpConversionPattern::OpConversionPattern;
+  ImmutableInsertSliceLowering(
+      ::mlir::TypeConverter &typeConverter, ::mlir::MLIRContext *context,
+      const ::mlir::DenseSet<::mlir::Operation *> &inPlaceOps)
+      : OpConversionPattern(typeConverter, context), inPlaceOps(inPlaceOps) {}
 
   ::mlir::LogicalResult
   matchAndRewrite(::imex::ndarray::ImmutableInsertSliceOp op,
@@ -380,12 +497,31 @@ struct ImmutableInsertSliceLowering
     auto strides = ::mlir::getMixedValues(adaptor.getStaticStrides(),
                                           adaptor.getStrides(), rewriter);
 
+    if (inPlaceOps.contains(op)) {
+      auto srcArType =
+          op.getSource().getType().cast<imex::ndarray::NDArrayType>();
+      auto dstArType =
+          op.getDestination().getType().cast<imex::ndarray::NDArrayType>();
+      auto srcMR =
+          createToMemRef(loc, rewriter, src, srcArType.getMemRefType(src));
+      auto dstMR =
+          createToMemRef(loc, rewriter, dst, dstArType.getMemRefType(dst));
+      createSliceWrite(loc, rewriter, srcMR, dstMR, offsets, sizes, strides);
+      auto res = rewriter.create<::mlir::bufferization::ToTensorOp>(
+          loc, dstMR, false, true);
+      rewriter.replaceOp(op, res.getResult());
+      return ::mlir::success();
+    }
+
     auto slice = rewriter.create<::mlir::tensor::InsertSliceOp>(
         loc, src, dst, offsets, sizes, strides);
     rewriter.replaceOp(op, slice.getResult());
 
     return ::mlir::success();
   }
+
+private:
+  const ::mlir::DenseSet<::mlir::Operation *> &inPlaceOps;
 };
 
 /// Convert NDArray's linspace and its return type to Linalg/tensor.
@@ -490,9 +626,16 @@ struct CreateLowering
 };
 
 /// Convert ndarray.copy and its return type to memref.alloc + memref.copy.
+/// With parallelCopy, host copies use a parallel linalg.generic instead, so
+/// that, like creation, they are chunked across threads once parallel loops
+/// are lowered to threads. The copy then also touches the pages of the new
+/// array first from the threads which later compute on the same chunks.
 struct CopyLowering
     : public ::mlir::OpConversionPattern<::imex::ndarray::CopyOp> {
-  using OpConversionPattern::OpConversionPattern;
+  CopyLowering(::mlir::TypeConverter &typeConverter,
+               ::mlir::MLIRContext *context, bool parallelCopy)
+      : OpConversionPattern(typeConverter, context),
+        parallelCopy(parallelCopy) {}
 
   ::mlir::LogicalResult
   matchAndRewrite(::imex::ndarray::CopyOp op,
@@ -530,10 +673,26 @@ struct CopyLowering
           createToMemRef(loc, rewriter, src, srcArTyp.getMemRefType(src));
       // create a region with given env, add copy op within it
       auto env = rewriter.getStringAttr("protect_copy_op");
+      bool useGeneric = parallelCopy &&
+                        !::imex::ndarray::hasGPUEnv(srcArTyp) &&
+                        !::imex::ndarray::hasGPUEnv(retArTyp);
       rewriter.create<::imex::region::EnvironmentRegionOp>(
           loc, env, std::nullopt, std::nullopt,
-          [&srcMR, &mr](::mlir::OpBuilder &builder, ::mlir::Location loc) {
-            (void)builder.create<::mlir::memref::CopyOp>(loc, srcMR, mr);
+          [&](::mlir::OpBuilder &builder, ::mlir::Location loc) {
+            if (useGeneric) {
+              auto map = builder.getMultiDimIdentityMap(rank);
+              ::mlir::SmallVector<::mlir::utils::IteratorType> iterators(
+                  rank, ::mlir::utils::IteratorType::parallel);
+              (void)builder.create<::mlir::linalg::GenericOp>(
+                  loc, srcMR, ::mlir::ValueRange{mr},
+                  ::mlir::ArrayRef<::mlir::AffineMap>{map, map}, iterators,
+                  [](::mlir::OpBuilder &b, ::mlir::Location loc,
+                     ::mlir::ValueRange args) {
+                    (void)b.create<::mlir::linalg::YieldOp>(loc, args[0]);
+                  });
+            } else {
+              (void)builder.create<::mlir::memref::CopyOp>(loc, srcMR, mr);
+            }
             (void)builder.create<::imex::region::EnvironmentRegionYieldOp>(loc);
           });
     }
@@ -544,6 +703,9 @@ struct CopyLowering
 
     return ::mlir::success();
   }
+
+private:
+  bool parallelCopy;
 };
 
 /// Convert ndarray.delete and its return type to memref.dealloc.
@@ -859,6 +1021,132 @@ static BodyType getBodyBuilder(::imex::ndarray::EWBinOpId binOp,
   return ::mlir::Value();
 }
 
+/// Broadcasting aligns the shapes of the operands to the right.
+/// @return true if dim d of tnsrType is dynamic and other has a non-unit
+/// extent for the same result dim. Whether d must be broadcast is then only
+/// known at runtime.
+static bool isDynBroadcastDim(::mlir::TensorType tnsrType, int64_t d,
+                              ::mlir::TensorType other) {
+  auto od = d + other.getRank() - tnsrType.getRank();
+  return tnsrType.isDynamicDim(d) && od >= 0 && other.getDimSize(od) != 1;
+}
+
+/// @return true if tnsrType needs a broadcast view when combined with other
+static bool needsBroadcastView(::mlir::TensorType tnsrType,
+                               ::mlir::TensorType other) {
+  for (int64_t d = 0; d < tnsrType.getRank(); ++d) {
+    if (isDynBroadcastDim(tnsrType, d, other)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// @return the sizes of the broadcast of operands to resType. Static sizes of
+/// resType are used as-is, dynamic sizes are the maximum of the non-unit
+/// extents of the operands (which a valid broadcast requires to be equal), or
+/// 0 if any of them is 0 since 0 and 1 broadcast to 0.
+static ::mlir::SmallVector<::mlir::OpFoldResult>
+getBroadcastSizes(::mlir::Location loc, ::mlir::OpBuilder &builder,
+                  ::mlir::TensorType resType, ::mlir::ValueRange operands) {
+  auto rank = resType.getRank();
+  ::mlir::SmallVector<::mlir::OpFoldResult> sizes;
+  for (int64_t i = 0; i < rank; ++i) {
+    if (!resType.isDynamicDim(i)) {
+      sizes.emplace_back(builder.getIndexAttr(resType.getDimSize(i)));
+      continue;
+    }
+    ::mlir::Value sz, isEmpty;
+    bool staticEmpty = false;
+    for (auto [n, operand] : llvm::enumerate(operands)) {
+      if (n > 0 && operand == operands[0]) {
+        continue;
+      }
+      auto tnsrType = operand.getType().cast<::mlir::TensorType>();
+      auto d = i - (rank - tnsrType.getRank());
+      if (d < 0 || tnsrType.getDimSize(d) == 1) {
+        continue;
+      }
+      if (!tnsrType.isDynamicDim(d)) {
+        staticEmpty |= tnsrType.getDimSize(d) == 0;
+        auto v = createIndex(loc, builder, tnsrType.getDimSize(d));
+        sz = sz ? builder.create<::mlir::arith::MaxUIOp>(loc, sz, v).getResult()
+                : v;
+        continue;
+      }
+      ::mlir::Value v =
+          builder.create<::mlir::tensor::DimOp>(loc, operand, d).getResult();
+      auto vEmpty = builder.create<::mlir::arith::CmpIOp>(
+          loc, ::mlir::arith::CmpIPredicate::eq, v,
+          createIndex(loc, builder, 0));
+      isEmpty =
+          isEmpty
+              ? builder.create<::mlir::arith::OrIOp>(loc, isEmpty, vEmpty)
+                    .getResult()
+              : vEmpty.getResult();
+      sz = sz ? builder.create<::mlir::arith::MaxUIOp>(loc, sz, v).getResult()
+              : v;
+    }
+    if (staticEmpty) {
+      sizes.emplace_back(builder.getIndexAttr(0));
+    } else if (isEmpty) {
+      sizes.emplace_back(
+          builder
+              .create<::mlir::arith::SelectOp>(
+                  loc, isEmpty, createIndex(loc, builder, 0), sz)
+              .getResult());
+    } else {
+      sizes.emplace_back(sz ? sz : createIndex(loc, builder, 1));
+    }
+  }
+  return sizes;
+}
+
+/// Create a view of tnsr with the given broadcast sizes instead of
+/// materializing the expanded operand. Missing leading dims and unit dims get
+/// a stride of 0. Dynamic dims which may be broadcast select a stride of 0 at
+/// runtime if their size is 1.
+static ::mlir::Value
+createBroadcastView(::mlir::Location loc, ::mlir::OpBuilder &builder,
+                    ::mlir::Value tnsr, ::imex::ndarray::NDArrayType arType,
+                    ::mlir::TensorType other, ::mlir::TensorType resType,
+                    ::mlir::ArrayRef<::mlir::OpFoldResult> sizes) {
+  auto tnsrType = tnsr.getType().cast<::mlir::TensorType>();
+  auto rank = resType.getRank();
+  auto inRank = tnsrType.getRank();
+  auto mr = createToMemRef(loc, builder, tnsr, arType.getMemRefType(tnsr));
+  auto meta = builder.create<::mlir::memref::ExtractStridedMetadataOp>(loc, mr);
+  auto zero = createIndex(loc, builder, 0);
+  auto one = createIndex(loc, builder, 1);
+
+  ::mlir::SmallVector<::mlir::OpFoldResult> strides;
+  for (int64_t i = 0; i < rank; ++i) {
+    auto d = i - (rank - inRank);
+    if (d < 0 || tnsrType.getDimSize(d) == 1) {
+      strides.emplace_back(zero);
+    } else if (isDynBroadcastDim(tnsrType, d, other)) {
+      auto isUnit = builder.create<::mlir::arith::CmpIOp>(
+          loc, ::mlir::arith::CmpIPredicate::eq, meta.getSizes()[d], one);
+      strides.emplace_back(
+          builder
+              .create<::mlir::arith::SelectOp>(loc, isUnit, zero,
+                                               meta.getStrides()[d])
+              .getResult());
+    } else {
+      strides.emplace_back(meta.getStrides()[d]);
+    }
+  }
+
+  auto viewType = ::imex::getMemRefType(builder.getContext(),
+                                        resType.getShape(),
+                                        arType.getElementType());
+  auto view = builder.create<::mlir::memref::ReinterpretCastOp>(
+      loc, viewType, meta.getBaseBuffer(),
+      ::mlir::OpFoldResult(meta.getOffset()), sizes, strides);
+  return builder.create<::mlir::bufferization::ToTensorOp>(loc, view, false,
+                                                           false);
+}
+
 /// Convert NDArray's elementwise binary operations and their return type to
 /// Linalg/tensor. The given op's type is expected to convert to the appropriate
 /// type (shape and element-type).
@@ -905,38 +1193,60 @@ struct EWBinOpLowering
             .cast<::mlir::IntegerAttr>()
             .getInt();
 
+    // Broadcasts which can only be resolved at runtime use stride-0 views of
+    // the operands, neither Linalg nor TOSA then materialize the broadcast.
+    // Static unit dims and lower ranks are handled by the indexing maps.
+    bool lhsView = lhs != rhs && needsBroadcastView(lhsTnsr, rhsTnsr);
+    bool rhsView = lhs != rhs && needsBroadcastView(rhsTnsr, lhsTnsr);
+    ::mlir::SmallVector<::mlir::OpFoldResult> resSizes;
+    if (lhsView || rhsView) {
+      resSizes = getBroadcastSizes(loc, rewriter, resType, {lhs, rhs});
+      auto lhsIn = lhs;
+      if (lhsView) {
+        lhs = createBroadcastView(loc, rewriter, lhs, lhsArTyp, rhsTnsr,
+                                  resType, resSizes);
+      }
+      if (rhsView) {
+        rhs = createBroadcastView(loc, rewriter, rhs, rhsArTyp,
+                                  lhsIn.getType().cast<::mlir::TensorType>(),
+                                  resType, resSizes);
+      }
+    }
+
     ::mlir::Value newOp =
         createTosaOp(loc, binOpId, rewriter, resType, lhs, rhs);
     if (!newOp) {
       // generate linalg.generic loop
 
       // create output tensor with right dimensions
-      auto tensor = createEmptyTensor(rewriter, loc, resType, {lhs, rhs});
+      if (resSizes.empty()) {
+        resSizes = getBroadcastSizes(loc, rewriter, resType, {lhs, rhs});
+      }
+      auto tensor =
+          rewriter.create<::mlir::tensor::EmptyOp>(loc, resSizes, elTyp)
+              .getResult();
 
       // we need affine maps for linalg::generic
-      // as long as we have no proper support for rank-reduced sizes above
-      // Linalg, we can handle only
-      //   - explicitly rank-reduced inputs (such as explicit 0d tensors)
-      //   - shapes with static dim-sizes of 1
-      ::mlir::SmallVector<::mlir::AffineExpr> lhsExprs, rhsExprs, resExprs;
-      for (int i = 0; i < lhsRank; ++i) {
-        lhsExprs.emplace_back(lhsTnsr.getDimSize(i) == 1
-                                  ? rewriter.getAffineConstantExpr(0)
-                                  : rewriter.getAffineDimExpr(i));
-      }
-      for (int i = 0; i < rhsRank; ++i) {
-        rhsExprs.emplace_back(rhsTnsr.getDimSize(i) == 1
-                                  ? rewriter.getAffineConstantExpr(0)
-                                  : rewriter.getAffineDimExpr(i));
-      }
-      for (unsigned i = 0; i < rank; ++i) {
-        resExprs.emplace_back(rewriter.getAffineDimExpr(i));
-      }
-      auto lhsMap = ::mlir::AffineMap::get(resType.getRank(), /*symbolCount=*/0,
-                                           lhsExprs, rewriter.getContext());
-      auto rhsMap = ::mlir::AffineMap::get(resType.getRank(), /*symbolCount=*/0,
-                                           rhsExprs, rewriter.getContext());
-      auto resMap = rewriter.getMultiDimIdentityMap(resType.getRank());
+      // shapes are aligned to the right, missing dims and static dim-sizes of
+      // 1 are broadcast through the map, views already have the result shape
+      auto getMap = [&](::mlir::TensorType tnsrType, bool isView) {
+        if (isView) {
+          return rewriter.getMultiDimIdentityMap(rank);
+        }
+        ::mlir::SmallVector<::mlir::AffineExpr> exprs;
+        auto inRank = tnsrType.getRank();
+        for (int64_t i = 0; i < inRank; ++i) {
+          exprs.emplace_back(
+              tnsrType.getDimSize(i) == 1
+                  ? rewriter.getAffineConstantExpr(0)
+                  : rewriter.getAffineDimExpr(i + rank - inRank));
+        }
+        return ::mlir::AffineMap::get(rank, /*symbolCount=*/0, exprs,
+                                      rewriter.getContext());
+      };
+      auto lhsMap = getMap(lhsTnsr, lhsView);
+      auto rhsMap = getMap(rhsTnsr, rhsView);
+      auto resMap = rewriter.getMultiDimIdentityMap(rank);
 
       // we just make all dims parallel
       ::mlir::SmallVector<mlir::utils::IteratorType> iterators(
@@ -1225,6 +1535,226 @@ struct ReductionOpLowering
   }
 };
 
+/// Create a XeTile GEMM kernel computing lhs x rhs for 2d f16/bf16 tensors
+/// with f32 result. Every work group (of a single subgroup) computes one
+/// 16x32 tile of the result, iterating over k in steps of 32.
+/// @return result tensor or null-value if shapes/types are not supported
+static ::mlir::Value createXeTileMatMul(::mlir::Location loc,
+                                        ::mlir::OpBuilder &builder,
+                                        ::mlir::Value lhs, ::mlir::Value rhs,
+                                        ::mlir::RankedTensorType resType) {
+  constexpr int64_t tileM = 16, tileN = 32, tileK = 32;
+  auto lhsType = lhs.getType().cast<::mlir::RankedTensorType>();
+  auto rhsType = rhs.getType().cast<::mlir::RankedTensorType>();
+  auto elTyp = lhsType.getElementType();
+  auto resElTyp = resType.getElementType();
+  if (lhsType.getRank() != 2 || !lhsType.hasStaticShape() ||
+      !rhsType.hasStaticShape() || !resType.hasStaticShape() ||
+      rhsType.getElementType() != elTyp || !(elTyp.isF16() || elTyp.isBF16()) ||
+      !resElTyp.isF32()) {
+    return {};
+  }
+  auto m = lhsType.getDimSize(0);
+  auto k = lhsType.getDimSize(1);
+  auto n = rhsType.getDimSize(1);
+  if (m % tileM || n % tileN || k % tileK) {
+    return {};
+  }
+
+  auto lhsMR = createToMemRef(
+      loc, builder, lhs, ::mlir::MemRefType::get(lhsType.getShape(), elTyp));
+  auto rhsMR = createToMemRef(
+      loc, builder, rhs, ::mlir::MemRefType::get(rhsType.getShape(), elTyp));
+  auto resMR = builder.create<::mlir::memref::AllocOp>(
+      loc, ::mlir::MemRefType::get(resType.getShape(), resElTyp));
+
+  auto gridX = createIndex(loc, builder, m / tileM);
+  auto gridY = createIndex(loc, builder, n / tileN);
+  auto one = createIndex(loc, builder, 1);
+  auto launch = builder.create<::mlir::gpu::LaunchOp>(loc, gridX, gridY, one,
+                                                      one, one, one);
+  {
+    ::mlir::OpBuilder::InsertionGuard guard(builder);
+    builder.setInsertionPointToStart(&launch.getBody().front());
+    auto zero = createIndex(loc, builder, 0);
+    auto tileKV = createIndex(loc, builder, tileK);
+    auto blockIds = launch.getBlockIds();
+    ::mlir::Value off0 = builder.create<::mlir::arith::MulIOp>(
+        loc, blockIds.x, createIndex(loc, builder, tileM));
+    ::mlir::Value off1 = builder.create<::mlir::arith::MulIOp>(
+        loc, blockIds.y, createIndex(loc, builder, tileN));
+
+    auto aTileType = ::imex::xetile::TileType::get({tileM, tileK}, elTyp);
+    auto bTileType = ::imex::xetile::TileType::get({tileK, tileN}, elTyp);
+    auto cTileType = ::imex::xetile::TileType::get({tileM, tileN}, resElTyp);
+    auto aVecType = ::mlir::VectorType::get({tileM, tileK}, elTyp);
+    auto bVecType = ::mlir::VectorType::get({tileK, tileN}, elTyp);
+    auto cVecType = ::mlir::VectorType::get({tileM, tileN}, resElTyp);
+
+    using OFRs = ::mlir::ArrayRef<::mlir::OpFoldResult>;
+    auto cTile = builder.create<::imex::xetile::InitTileOp>(
+        loc, cTileType, resMR, OFRs{off0, off1});
+    auto aTile = builder.create<::imex::xetile::InitTileOp>(
+        loc, aTileType, lhsMR, OFRs{off0, zero});
+    auto bTile = builder.create<::imex::xetile::InitTileOp>(
+        loc, bTileType, rhsMR, OFRs{zero, off1});
+    auto acc = builder.create<::mlir::arith::ConstantOp>(
+        loc, cVecType, builder.getZeroAttr(cVecType));
+
+    auto loop = builder.create<::mlir::scf::ForOp>(
+        loc, zero, createIndex(loc, builder, k), tileKV,
+        ::mlir::ValueRange{aTile, bTile, acc},
+        [&](::mlir::OpBuilder &b, ::mlir::Location loc, ::mlir::Value,
+            ::mlir::ValueRange args) {
+          auto aVal = b.create<::imex::xetile::LoadTileOp>(
+              loc, aVecType, args[0], nullptr, nullptr);
+          auto bVal = b.create<::imex::xetile::LoadTileOp>(
+              loc, bVecType, args[1], nullptr, nullptr);
+          auto cVal = b.create<::imex::xetile::TileMMAOp>(loc, cVecType, aVal,
+                                                          bVal, args[2]);
+          auto aNext = b.create<::imex::xetile::UpdateTileOffsetOp>(
+              loc, aTileType, args[0], zero, tileKV);
+          auto bNext = b.create<::imex::xetile::UpdateTileOffsetOp>(
+              loc, bTileType, args[1], tileKV, zero);
+          b.create<::mlir::scf::YieldOp>(
+              loc, ::mlir::ValueRange{aNext, bNext, cVal});
+        });
+    builder.create<::imex::xetile::StoreTileOp>(loc, loop.getResult(2), cTile,
+                                                nullptr);
+    builder.create<::mlir::gpu::TerminatorOp>(loc);
+  }
+
+  return builder.create<::mlir::bufferization::ToTensorOp>(loc, resType, resMR);
+}
+
+/// Convert NDArray's matmul to linalg.matmul/linalg.batch_matmul. Transposed
+/// operands are folded into the indexing maps of a linalg.generic.
+/// Within a GPU region and if enabled, 2d f16/bf16 products with f32 result
+/// are lowered to a XeTile GEMM kernel instead.
+struct MatMulOpLowering
+    : public ::mlir::OpConversionPattern<::imex::ndarray::MatMulOp> {
+  MatMulOpLowering(::mlir::TypeConverter &typeConverter,
+                   ::mlir::MLIRContext *context, bool useXeTile)
+      : OpConversionPattern(typeConverter, context), useXeTile(useXeTile) {}
+
+  ::mlir::LogicalResult
+  matchAndRewrite(::imex::ndarray::MatMulOp op,
+                  ::imex::ndarray::MatMulOp::Adaptor adaptor,
+                  ::mlir::ConversionPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    // We expect to lower NDArrays
+    if (!op.getLhs().getType().isa<::imex::ndarray::NDArrayType>() ||
+        !op.getRhs().getType().isa<::imex::ndarray::NDArrayType>()) {
+      return ::mlir::failure();
+    }
+
+    auto resType = op.getType().cast<::imex::ndarray::NDArrayType>();
+    auto resTnsrTyp = resType.getTensorType();
+    auto elTyp = makeSignlessType(resTnsrTyp.getElementType());
+    auto lhs = adaptor.getLhs();
+    auto rhs = adaptor.getRhs();
+    bool transLhs = op.getTransposeLhs();
+    bool transRhs = op.getTransposeRhs();
+
+    if (useXeTile && !transLhs && !transRhs &&
+        ::imex::region::isInGpuRegion(op)) {
+      if (auto res = createXeTileMatMul(loc, rewriter, lhs, rhs, resTnsrTyp)) {
+        rewriter.replaceOp(op, res);
+        return ::mlir::success();
+      }
+    }
+
+    // (batch,) m, n of the result
+    auto rank = static_cast<unsigned>(resTnsrTyp.getRank());
+    ::imex::ValVec shp;
+    if (rank == 3) {
+      shp.emplace_back(
+          rewriter.createOrFold<::mlir::tensor::DimOp>(loc, lhs, 0));
+    }
+    shp.emplace_back(rewriter.createOrFold<::mlir::tensor::DimOp>(
+        loc, lhs, rank - (transLhs ? 1 : 2)));
+    shp.emplace_back(rewriter.createOrFold<::mlir::tensor::DimOp>(
+        loc, rhs, rank - (transRhs ? 2 : 1)));
+    auto zero = rewriter.create<::mlir::arith::ConstantOp>(
+        loc, rewriter.getZeroAttr(elTyp));
+    auto tensor = createEmptyTensor(rewriter, loc, elTyp, shp);
+    auto init = rewriter.create<::mlir::linalg::FillOp>(loc, zero.getResult(),
+                                                        tensor)
+                    .getResult(0);
+
+    ::mlir::Value res;
+    if (!transLhs && !transRhs) {
+      if (rank == 2) {
+        res = rewriter
+                  .create<::mlir::linalg::MatmulOp>(
+                      loc, ::mlir::ValueRange{lhs, rhs}, init)
+                  .getResult(0);
+      } else {
+        res = rewriter
+                  .create<::mlir::linalg::BatchMatmulOp>(
+                      loc, ::mlir::ValueRange{lhs, rhs}, init)
+                  .getResult(0);
+      }
+    } else {
+      // iteration space is (batch,) m, n, k
+      auto ctxt = rewriter.getContext();
+      auto nLoops = rank + 1;
+      auto b = rank - 2;
+      auto d = [&](unsigned i) { return rewriter.getAffineDimExpr(i); };
+      ::mlir::SmallVector<::mlir::AffineExpr> lhsExprs, rhsExprs, resExprs;
+      for (unsigned i = 0; i < b; ++i) {
+        lhsExprs.emplace_back(d(i));
+        rhsExprs.emplace_back(d(i));
+        resExprs.emplace_back(d(i));
+      }
+      auto addPair = [](auto &exprs, auto x, auto y, bool trans) {
+        exprs.emplace_back(trans ? y : x);
+        exprs.emplace_back(trans ? x : y);
+      };
+      addPair(lhsExprs, d(b), d(b + 2), transLhs);
+      addPair(rhsExprs, d(b + 2), d(b + 1), transRhs);
+      addPair(resExprs, d(b), d(b + 1), false);
+      const ::mlir::AffineMap maps[] = {
+          ::mlir::AffineMap::get(nLoops, 0, lhsExprs, ctxt),
+          ::mlir::AffineMap::get(nLoops, 0, rhsExprs, ctxt),
+          ::mlir::AffineMap::get(nLoops, 0, resExprs, ctxt)};
+      ::mlir::SmallVector<::mlir::utils::IteratorType> iterators(
+          rank, ::mlir::utils::IteratorType::parallel);
+      iterators.emplace_back(::mlir::utils::IteratorType::reduction);
+
+      auto bodyBuilder = [elTyp](::mlir::OpBuilder &builder,
+                                 ::mlir::Location loc,
+                                 ::mlir::ValueRange args) {
+        auto a = createCast(loc, builder, args[0], elTyp);
+        auto b = createCast(loc, builder, args[1], elTyp);
+        ::mlir::Value r;
+        if (elTyp.isIntOrIndex()) {
+          auto prod = builder.create<::mlir::arith::MulIOp>(loc, a, b);
+          r = builder.create<::mlir::arith::AddIOp>(loc, args[2], prod);
+        } else {
+          auto prod = builder.create<::mlir::arith::MulFOp>(loc, a, b);
+          r = builder.create<::mlir::arith::AddFOp>(loc, args[2], prod);
+        }
+        (void)builder.create<::mlir::linalg::YieldOp>(loc, r);
+      };
+      res = rewriter
+                .create<::mlir::linalg::GenericOp>(
+                    loc, init.getType(), ::mlir::ValueRange{lhs, rhs}, init,
+                    maps, iterators, bodyBuilder)
+                .getResult(0);
+    }
+
+    if (res.getType() != resTnsrTyp) {
+      res = rewriter.create<::mlir::tensor::CastOp>(loc, resTnsrTyp, res);
+    }
+    rewriter.replaceOp(op, res);
+    return ::mlir::success();
+  }
+
+private:
+  bool useXeTile;
+};
+
 // *******************************
 // ***** Pass infrastructure *****
 // *******************************
@@ -1306,7 +1836,9 @@ struct ConvertNDArrayToLinalgPass
         ::mlir::memref::MemRefDialect, ::mlir::tensor::TensorDialect,
         ::mlir::tosa::TosaDialect, ::mlir::shape::ShapeDialect,
         ::mlir::bufferization::BufferizationDialect,
-        ::imex::region::RegionDialect>();
+        ::mlir::gpu::GPUDialect, ::mlir::scf::SCFDialect,
+        ::mlir::vector::VectorDialect, ::imex::region::RegionDialect,
+        ::imex::xetile::XeTileDialect>();
     target.addLegalOp<::mlir::UnrealizedConversionCastOp>(); // FIXME
 
     // make sure function boundaries use tensors (not NDArrays)
@@ -1322,14 +1854,26 @@ struct ConvertNDArrayToLinalgPass
                                  ::imex::region::EnvironmentRegionYieldOp>(
         [&](mlir::Operation *op) { return typeConverter.isLegal(op); });
 
+    // find immutable_insert_slices which can update their destination in
+    // place before the conversion changes the use-def chains
+    ::mlir::DenseSet<::mlir::Operation *> inPlaceInserts;
+    getOperation()->walk([&](::imex::ndarray::ImmutableInsertSliceOp op) {
+      if (canInsertInPlace(op))
+        inPlaceInserts.insert(op);
+    });
+
     ::mlir::RewritePatternSet patterns(&ctxt);
     patterns.insert<
         ToTensorLowering, SubviewLowering, ExtractSliceLowering,
-        InsertSliceLowering, ImmutableInsertSliceLowering, LinSpaceLowering,
+        InsertSliceLowering, LinSpaceLowering,
         LoadOpLowering, CreateLowering, EWBinOpLowering, DimOpLowering,
         EWUnyOpLowering, ReductionOpLowering, ReshapeLowering, CastLowering,
-        CopyLowering, DeleteLowering, CastElemTypeLowering, FromMemRefLowering>(
+        DeleteLowering, CastElemTypeLowering, FromMemRefLowering>(
         typeConverter, &ctxt);
+    patterns.insert<CopyLowering>(typeConverter, &ctxt, parallelCopy);
+    patterns.insert<MatMulOpLowering>(typeConverter, &ctxt, useXeTile);
+    patterns.insert<ImmutableInsertSliceLowering>(typeConverter, &ctxt,
+                                                  inPlaceInserts);
     ::imex::populateRegionTypeConversionPatterns(patterns, typeConverter);
 
     // populate function boundaries using our special type converter
@@ -0,0 +1,1075 @@
+//===- XeGPUToCPU.cpp - XeGPUToCPU conversion  -------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the XeGPUToCPU conversion, a functional emulator for
+/// XeGPU kernels. Kernels are outlined from their gpu.module into host
+/// functions which are called for every subgroup of a launch, and the XeGPU
+/// ops are lowered to memref/vector code with the semantics of the hardware
+/// messages (block arrays, transpose, VNNI, boundary padding, masking).
+///
+/// A nd tensor_desc is represented by its base memref and one index offset
+/// per dimension, a scattered tensor_desc by its base memref and the vector
+/// of lane offsets.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Conversion/XeGPUToCPU/XeGPUToCPU.h>
+#include <imex/Dialect/XeGPU/IR/XeGPU.h>
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Dialect/SCF/Transforms/Patterns.h>
+#include <mlir/Dialect/Utils/StaticValueUtils.h>
+#include <mlir/Dialect/Vector/IR/VectorOps.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/IR/SymbolTable.h>
+#include <mlir/Transforms/OneToNTypeConversion.h>
+
+#include "../PassDetail.h"
+
+namespace imex {
+
+namespace {
+
+/// Number of index arguments appended to an outlined kernel: block ids,
+/// thread ids, grid sizes and block sizes, each for x, y and z.
+constexpr unsigned kNumIdArgs = 12;
+
+constexpr llvm::StringLiteral kProfileGlobal = "__xegpu_cpu_profile";
+constexpr llvm::StringLiteral kPrintProfileFunc = "printXeGPUProfile";
+
+/// Slots of the op-counting profile. Keep in sync with the names printed by
+/// printXeGPUProfile in ImexRunnerUtils.cpp.
+enum ProfileCounter : int64_t {
+  LoadND,
+  StoreND,
+  PrefetchND,
+  Dpas,
+  UpdateNDOffset,
+  Gather,
+  Scatter,
+  Prefetch,
+  AtomicRMW,
+  Barrier,
+  NumCounters
+};
+
+mlir::MemRefType getProfileType(mlir::MLIRContext *ctx) {
+  return mlir::MemRefType::get({NumCounters}, mlir::IntegerType::get(ctx, 64));
+}
+
+/// Returns the base memref type of a converted tensor_desc: a fully dynamic
+/// strided memref of the tensor_desc rank (1 for scattered descriptors).
+mlir::MemRefType getBaseMemRefType(xegpu::TensorDescType tdescTy) {
+  int64_t rank = tdescTy.getScattered() ? 1 : tdescTy.getRank();
+  llvm::SmallVector<int64_t> dynamic(rank, mlir::ShapedType::kDynamic);
+  auto layout = mlir::StridedLayoutAttr::get(
+      tdescTy.getContext(), mlir::ShapedType::kDynamic, dynamic);
+  return mlir::MemRefType::get(dynamic, tdescTy.getElementType(), layout);
+}
+
+mlir::Value createIndex(mlir::OpBuilder &b, mlir::Location loc, int64_t v) {
+  return b.create<mlir::arith::ConstantIndexOp>(loc, v);
+}
+
+/// Casts a memref to the base memref type of tdescTy, dropping its memory
+/// space; all memory is host memory in the emulation.
+mlir::Value castToBase(mlir::OpBuilder &b, mlir::Location loc,
+                       mlir::Value source, xegpu::TensorDescType tdescTy) {
+  auto srcTy = llvm::cast<mlir::MemRefType>(source.getType());
+  if (srcTy.getMemorySpace()) {
+    auto noSpaceTy = mlir::MemRefType::get(
+        srcTy.getShape(), srcTy.getElementType(), srcTy.getLayout());
+    source =
+        b.create<mlir::memref::MemorySpaceCastOp>(loc, noSpaceTy, source);
+  }
+  return b.create<mlir::memref::CastOp>(loc, getBaseMemRefType(tdescTy),
+                                        source);
+}
+
+/// Creates a memref.alloca_scope whose body is built by bodyBuilder, so that
+/// scratch buffers of ops inside loops are released every iteration.
+mlir::ValueRange createAllocaScope(
+    mlir::OpBuilder &b, mlir::Location loc,
+    llvm::ArrayRef<mlir::Type> resultTypes,
+    llvm::function_ref<llvm::SmallVector<mlir::Value>(mlir::OpBuilder &,
+                                                      mlir::Location)>
+        bodyBuilder) {
+  auto scope = b.create<mlir::memref::AllocaScopeOp>(
+      loc, mlir::TypeRange(resultTypes));
+  mlir::OpBuilder::InsertionGuard guard(b);
+  b.createBlock(&scope.getBodyRegion());
+  auto results = bodyBuilder(b, loc);
+  b.create<mlir::memref::AllocaScopeReturnOp>(loc, results);
+  return scope.getResults();
+}
+
+/// Allocates a 1D scratch buffer holding `value` (flattened), or zeros if
+/// value is null.
+mlir::Value createScratch(mlir::OpBuilder &b, mlir::Location loc,
+                          mlir::Type elemTy, int64_t numElements,
+                          mlir::Value value) {
+  auto flatTy = mlir::VectorType::get({numElements}, elemTy);
+  auto scratch = b.create<mlir::memref::AllocaOp>(
+      loc, mlir::MemRefType::get({numElements}, elemTy));
+  if (value)
+    value = b.create<mlir::vector::ShapeCastOp>(loc, flatTy, value);
+  else
+    value = b.create<mlir::arith::ConstantOp>(loc, flatTy,
+                                              b.getZeroAttr(flatTy));
+  b.create<mlir::vector::StoreOp>(loc, value, scratch, createIndex(b, loc, 0));
+  return scratch;
+}
+
+using IndexFn = llvm::function_ref<llvm::SmallVector<mlir::Value>(
+    mlir::OpBuilder &, mlir::Location, mlir::ValueRange)>;
+using ElementFn = llvm::function_ref<void(
+    mlir::OpBuilder &, mlir::Location, mlir::ValueRange, mlir::Value)>;
+
+/// Builds a loop nest over the elements of `shape`. indexFn maps the
+/// induction variables to the memory indices of an element in base. The body
+/// is called with the memory indices and the row-major linear index of the
+/// element, but only for elements inside the bounds of base whose bit in the
+/// flattened mask (if any) is set.
+void buildGuardedElementLoop(mlir::OpBuilder &b, mlir::Location loc,
+                             mlir::Value base, llvm::ArrayRef<int64_t> shape,
+                             IndexFn indexFn, mlir::Value flatMask,
+                             ElementFn bodyFn) {
+  auto c0 = createIndex(b, loc, 0);
+  auto c1 = createIndex(b, loc, 1);
+  llvm::SmallVector<mlir::Value> lbs(shape.size(), c0);
+  llvm::SmallVector<mlir::Value> steps(shape.size(), c1);
+  llvm::SmallVector<mlir::Value> ubs;
+  for (auto s : shape)
+    ubs.push_back(createIndex(b, loc, s));
+
+  mlir::scf::buildLoopNest(
+      b, loc, lbs, ubs, steps,
+      [&](mlir::OpBuilder &b, mlir::Location loc, mlir::ValueRange ivs) {
+        mlir::Value linear = createIndex(b, loc, 0);
+        int64_t stride = 1;
+        for (int64_t d = shape.size() - 1; d >= 0; --d) {
+          auto scaled = b.create<mlir::arith::MulIOp>(
+              loc, ivs[d], createIndex(b, loc, stride));
+          linear = b.create<mlir::arith::AddIOp>(loc, linear, scaled);
+          stride *= shape[d];
+        }
+
+        auto indices = indexFn(b, loc, ivs);
+        mlir::Value cond =
+            b.create<mlir::arith::ConstantIntOp>(loc, 1, b.getI1Type());
+        for (auto [dim, idx] : llvm::enumerate(indices)) {
+          auto size = b.create<mlir::memref::DimOp>(loc, base, dim);
+          auto geZero = b.create<mlir::arith::CmpIOp>(
+              loc, mlir::arith::CmpIPredicate::sge, idx,
+              createIndex(b, loc, 0));
+          auto ltSize = b.create<mlir::arith::CmpIOp>(
+              loc, mlir::arith::CmpIPredicate::slt, idx, size);
+          cond = b.create<mlir::arith::AndIOp>(loc, cond, geZero);
+          cond = b.create<mlir::arith::AndIOp>(loc, cond, ltSize);
+        }
+        if (flatMask) {
+          auto bit =
+              b.create<mlir::vector::ExtractElementOp>(loc, flatMask, linear);
+          cond = b.create<mlir::arith::AndIOp>(loc, cond, bit);
+        }
+
+        b.create<mlir::scf::IfOp>(
+            loc, cond, [&](mlir::OpBuilder &b, mlir::Location loc) {
+              bodyFn(b, loc, indices, linear);
+              b.create<mlir::scf::YieldOp>(loc);
+            });
+      });
+}
+
+/// Applies the transpose and VNNI transformation of a load to value of the
+/// given shape. The transformations act on the trailing dimensions; leading
+/// dimensions (block arrays) are kept. The result is cast to resultTy.
+mlir::Value applyLoadLayout(mlir::OpBuilder &b, mlir::Location loc,
+                            mlir::Value value, llvm::ArrayRef<int64_t> shape,
+                            int64_t numLeading,
+                            std::optional<llvm::ArrayRef<int64_t>> transpose,
+                            std::optional<uint32_t> vnniAxis,
+                            mlir::VectorType resultTy) {
+  auto elemTy = resultTy.getElementType();
+  llvm::SmallVector<int64_t> curShape(shape);
+  value = b.create<mlir::vector::ShapeCastOp>(
+      loc, mlir::VectorType::get(curShape, elemTy), value);
+
+  auto rank = static_cast<int64_t>(curShape.size());
+  if (transpose &&
+      static_cast<int64_t>(transpose->size()) + numLeading == rank) {
+    llvm::SmallVector<int64_t> perm;
+    for (int64_t i = 0; i < numLeading; ++i)
+      perm.push_back(i);
+    for (auto p : *transpose)
+      perm.push_back(p + numLeading);
+    value = b.create<mlir::vector::TransposeOp>(loc, value, perm);
+    curShape = llvm::to_vector(
+        llvm::cast<mlir::VectorType>(value.getType()).getShape());
+  }
+
+  // Packing along the innermost dimension does not change the element
+  // order. Otherwise the packed dimension is split and its inner part moved
+  // innermost: result[..., i, j, k] = value[..., i * factor + k, j].
+  if (vnniAxis && *vnniAxis + numLeading + 1 < rank) {
+    int64_t axis = *vnniAxis + numLeading;
+    int64_t factor = resultTy.getShape().back();
+    llvm::SmallVector<int64_t> split(curShape.begin(),
+                                     curShape.begin() + axis);
+    split.push_back(curShape[axis] / factor);
+    split.push_back(factor);
+    split.append(curShape.begin() + axis + 1, curShape.end());
+    value = b.create<mlir::vector::ShapeCastOp>(
+        loc, mlir::VectorType::get(split, elemTy), value);
+
+    llvm::SmallVector<int64_t> perm;
+    for (int64_t i = 0; i < static_cast<int64_t>(split.size()); ++i)
+      if (i != axis + 1)
+        perm.push_back(i);
+    perm.push_back(axis + 1);
+    value = b.create<mlir::vector::TransposeOp>(loc, value, perm);
+  }
+
+  return b.create<mlir::vector::ShapeCastOp>(loc, resultTy, value);
+}
+
+/// Returns the shape [array_length, tdesc shape...] of a nd block access.
+llvm::SmallVector<int64_t> getBlockShape(xegpu::TensorDescType tdescTy) {
+  llvm::SmallVector<int64_t> shape{tdescTy.getArrayLength()};
+  shape.append(tdescTy.getShape().begin(), tdescTy.getShape().end());
+  return shape;
+}
+
+/// Memory indices of an element of a nd block access. The blocks of a block
+/// array are adjacent along the innermost dimension.
+llvm::SmallVector<mlir::Value> getBlockIndices(mlir::OpBuilder &b,
+                                               mlir::Location loc,
+                                               mlir::ValueRange offsets,
+                                               llvm::ArrayRef<int64_t> shape,
+                                               mlir::ValueRange ivs) {
+  llvm::SmallVector<mlir::Value> indices;
+  for (auto [d, off] : llvm::enumerate(offsets))
+    indices.push_back(b.create<mlir::arith::AddIOp>(loc, off, ivs[d + 1]));
+  auto blockOff = b.create<mlir::arith::MulIOp>(
+      loc, ivs[0], createIndex(b, loc, shape.back()));
+  indices.back() =
+      b.create<mlir::arith::AddIOp>(loc, indices.back(), blockOff);
+  return indices;
+}
+
+/// Memory index of an element of a gather/scatter access; shape is [lanes]
+/// or [lanes, chunk].
+llvm::SmallVector<mlir::Value> getScatteredIndices(mlir::OpBuilder &b,
+                                                   mlir::Location loc,
+                                                   mlir::Value offsets,
+                                                   mlir::ValueRange ivs) {
+  mlir::Value idx =
+      b.create<mlir::vector::ExtractElementOp>(loc, offsets, ivs[0]);
+  if (ivs.size() > 1)
+    idx = b.create<mlir::arith::AddIOp>(loc, idx, ivs[1]);
+  return {idx};
+}
+
+mlir::Value flattenMask(mlir::OpBuilder &b, mlir::Location loc,
+                        mlir::Value mask) {
+  auto maskTy = llvm::cast<mlir::VectorType>(mask.getType());
+  return b.create<mlir::vector::ShapeCastOp>(
+      loc,
+      mlir::VectorType::get({maskTy.getNumElements()},
+                            maskTy.getElementType()),
+      mask);
+}
+
+//===----------------------------------------------------------------------===//
+// Emulation patterns
+//===----------------------------------------------------------------------===//
+
+struct CreateNdDescOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::CreateNdDescOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::CreateNdDescOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    auto tdescTy = op.getTensorDescType();
+    auto srcTy = llvm::dyn_cast<mlir::MemRefType>(op.getSource().getType());
+    if (!srcTy)
+      return rewriter.notifyMatchFailure(
+          op, "only memref sources can be emulated on the CPU");
+    if (srcTy.getRank() != tdescTy.getRank())
+      return rewriter.notifyMatchFailure(
+          op, "source rank must match the tensor_desc rank");
+
+    llvm::SmallVector<mlir::Value> values{
+        castToBase(rewriter, loc, op.getSource(), tdescTy)};
+    for (auto off : op.getOffsets())
+      values.push_back(
+          mlir::getValueOrCreateConstantIndexOp(rewriter, loc, off));
+    rewriter.replaceOp(op, values, adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+struct UpdateNDOffsetOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::UpdateNDOffsetOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::UpdateNDOffsetOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto tdesc = adaptor.getTensorDesc();
+    llvm::SmallVector<mlir::Value> values{tdesc.front()};
+    for (auto [off, delta] :
+         llvm::zip(tdesc.drop_front(), op.getOffsets()))
+      values.push_back(
+          rewriter.create<mlir::arith::AddIOp>(op.getLoc(), off, delta));
+    rewriter.replaceOp(op, values, adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+struct LoadNDOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::LoadNDOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::LoadNDOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    auto tdescTy = op.getTensorDescType();
+    auto resultTy = op.getValueType();
+    auto tdesc = adaptor.getTensorDesc();
+    auto base = tdesc.front();
+    auto offsets = tdesc.drop_front();
+    auto shape = getBlockShape(tdescTy);
+    auto elemTy = tdescTy.getElementType();
+    int64_t numElements = mlir::ShapedType::getNumElements(shape);
+
+    // Out-of-bounds elements keep the zero of the scratch buffer, which is
+    // the padding the block load returns with boundary checking.
+    auto flatTy = mlir::VectorType::get({numElements}, elemTy);
+    auto flat = createAllocaScope(
+        rewriter, loc, flatTy,
+        [&](mlir::OpBuilder &b, mlir::Location loc) {
+          auto scratch = createScratch(b, loc, elemTy, numElements, {});
+          buildGuardedElementLoop(
+              b, loc, base, shape,
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange ivs) {
+                return getBlockIndices(b, loc, offsets, shape, ivs);
+              },
+              {},
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange indices, mlir::Value linear) {
+                auto v = b.create<mlir::memref::LoadOp>(loc, base, indices);
+                b.create<mlir::memref::StoreOp>(loc, v, scratch, linear);
+              });
+          llvm::SmallVector<mlir::Value> results{
+              b.create<mlir::vector::LoadOp>(loc, flatTy, scratch,
+                                             createIndex(b, loc, 0))};
+          return results;
+        });
+
+    auto value = applyLoadLayout(rewriter, loc, flat.front(), shape,
+                                 /*numLeading=*/1, op.getTranspose(),
+                                 op.getVnniAxis(), resultTy);
+    rewriter.replaceOp(op, value, adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+struct StoreNDOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::StoreNDOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::StoreNDOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto tdescTy = op.getTensorDescType();
+    auto tdesc = adaptor.getTensorDesc();
+    auto base = tdesc.front();
+    auto offsets = tdesc.drop_front();
+    auto shape = getBlockShape(tdescTy);
+
+    createAllocaScope(
+        rewriter, op.getLoc(), {},
+        [&](mlir::OpBuilder &b, mlir::Location loc) {
+          auto scratch = createScratch(
+              b, loc, tdescTy.getElementType(),
+              mlir::ShapedType::getNumElements(shape), op.getValue());
+          buildGuardedElementLoop(
+              b, loc, base, shape,
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange ivs) {
+                return getBlockIndices(b, loc, offsets, shape, ivs);
+              },
+              {},
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange indices, mlir::Value linear) {
+                auto v = b.create<mlir::memref::LoadOp>(loc, scratch, linear);
+                b.create<mlir::memref::StoreOp>(loc, v, base, indices);
+              });
+          return llvm::SmallVector<mlir::Value>();
+        });
+    rewriter.eraseOp(op);
+    return mlir::success();
+  }
+};
+
+struct DpasOpPattern : public mlir::OneToNOpConversionPattern<xegpu::DpasOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::DpasOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    auto resultTy = op.getResultType();
+    auto accElemTy = resultTy.getElementType();
+    auto lhsTy = op.getLhsType();
+    auto rhsTy = op.getRhsType();
+    int64_t m = resultTy.getShape()[0];
+    int64_t n = resultTy.getShape()[1];
+    int64_t k = lhsTy.getNumElements() / m;
+
+    // Undo the VNNI packing: A is [M, K / f, f] and B is [K / f, N, f].
+    mlir::Value lhs = rewriter.create<mlir::vector::ShapeCastOp>(
+        loc, mlir::VectorType::get({m, k}, lhsTy.getElementType()),
+        op.getLhs());
+    mlir::Value rhs = op.getRhs();
+    if (rhsTy.getRank() == 3)
+      rhs = rewriter.create<mlir::vector::TransposeOp>(
+          loc, rhs, llvm::ArrayRef<int64_t>{0, 2, 1});
+    rhs = rewriter.create<mlir::vector::ShapeCastOp>(
+        loc, mlir::VectorType::get({k, n}, rhsTy.getElementType()), rhs);
+
+    // The products are accumulated in the precision of the result.
+    auto extend = [&](mlir::Value v) -> mlir::Value {
+      auto vTy = llvm::cast<mlir::VectorType>(v.getType());
+      if (vTy.getElementType() == accElemTy)
+        return v;
+      auto extTy = vTy.clone(accElemTy);
+      if (llvm::isa<mlir::FloatType>(accElemTy))
+        return rewriter.create<mlir::arith::ExtFOp>(loc, extTy, v);
+      return rewriter.create<mlir::arith::ExtSIOp>(loc, extTy, v);
+    };
+    lhs = extend(lhs);
+    rhs = extend(rhs);
+
+    mlir::Value acc = op.getAcc();
+    if (!acc)
+      acc = rewriter.create<mlir::arith::ConstantOp>(
+          loc, resultTy, rewriter.getZeroAttr(resultTy));
+
+    mlir::AffineExpr dm, dn, dk;
+    mlir::bindDims(rewriter.getContext(), dm, dn, dk);
+    auto contract = rewriter.create<mlir::vector::ContractionOp>(
+        loc, lhs, rhs, acc,
+        llvm::ArrayRef<llvm::ArrayRef<mlir::AffineExpr>>{
+            {dm, dk}, {dk, dn}, {dm, dn}},
+        llvm::ArrayRef<mlir::vector::IteratorType>{
+            mlir::vector::IteratorType::parallel,
+            mlir::vector::IteratorType::parallel,
+            mlir::vector::IteratorType::reduction});
+    rewriter.replaceOp(op, contract.getResult(), adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+struct CreateDescOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::CreateDescOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::CreateDescOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    auto tdescTy = llvm::cast<xegpu::TensorDescType>(op.getType());
+    auto srcTy = llvm::dyn_cast<mlir::MemRefType>(op.getSource().getType());
+    if (!srcTy)
+      return rewriter.notifyMatchFailure(
+          op, "only memref sources can be emulated on the CPU");
+
+    // Lane offsets address the source as a linear buffer.
+    mlir::Value source = op.getSource();
+    if (srcTy.getRank() != 1) {
+      if (!srcTy.getLayout().isIdentity() || !srcTy.hasStaticShape())
+        return rewriter.notifyMatchFailure(
+            op, "multi-dimensional sources must be static and contiguous");
+      mlir::ReassociationIndices all;
+      for (int64_t i = 0; i < srcTy.getRank(); ++i)
+        all.push_back(i);
+      source = rewriter.create<mlir::memref::CollapseShapeOp>(
+          loc, source, llvm::ArrayRef<mlir::ReassociationIndices>{all});
+    }
+
+    llvm::SmallVector<mlir::Value> values{
+        castToBase(rewriter, loc, source, tdescTy), op.getOffsets()};
+    rewriter.replaceOp(op, values, adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+struct UpdateOffsetOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::UpdateOffsetOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::UpdateOffsetOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto tdesc = adaptor.getTensorDesc();
+    llvm::SmallVector<mlir::Value> values{
+        tdesc[0], rewriter.create<mlir::arith::AddIOp>(op.getLoc(), tdesc[1],
+                                                       op.getOffsets())};
+    rewriter.replaceOp(op, values, adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+struct LoadGatherOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::LoadGatherOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::LoadGatherOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    auto resultTy = llvm::dyn_cast<mlir::VectorType>(op.getValueType());
+    if (!resultTy)
+      return rewriter.notifyMatchFailure(op, "expected a vector result");
+    auto tdescTy = op.getTensorDescType();
+    auto tdesc = adaptor.getTensorDesc();
+    auto base = tdesc[0];
+    auto laneOffsets = tdesc[1];
+    auto shape = llvm::to_vector(tdescTy.getShape());
+    auto elemTy = tdescTy.getElementType();
+    int64_t numElements = tdescTy.getNumElements();
+
+    auto flatTy = mlir::VectorType::get({numElements}, elemTy);
+    auto flat = createAllocaScope(
+        rewriter, loc, flatTy,
+        [&](mlir::OpBuilder &b, mlir::Location loc) {
+          auto scratch = createScratch(b, loc, elemTy, numElements, {});
+          buildGuardedElementLoop(
+              b, loc, base, shape,
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange ivs) {
+                return getScatteredIndices(b, loc, laneOffsets, ivs);
+              },
+              flattenMask(b, loc, op.getMask()),
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange indices, mlir::Value linear) {
+                auto v = b.create<mlir::memref::LoadOp>(loc, base, indices);
+                b.create<mlir::memref::StoreOp>(loc, v, scratch, linear);
+              });
+          llvm::SmallVector<mlir::Value> results{
+              b.create<mlir::vector::LoadOp>(loc, flatTy, scratch,
+                                             createIndex(b, loc, 0))};
+          return results;
+        });
+
+    auto value =
+        applyLoadLayout(rewriter, loc, flat.front(), shape, /*numLeading=*/0,
+                        op.getTranspose(), op.getVnniAxis(), resultTy);
+    rewriter.replaceOp(op, value, adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+struct StoreScatterOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::StoreScatterOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::StoreScatterOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    if (!llvm::isa<mlir::VectorType>(op.getValueType()))
+      return rewriter.notifyMatchFailure(op, "expected a vector value");
+    auto tdescTy = op.getTensorDescType();
+    auto tdesc = adaptor.getTensorDesc();
+    auto base = tdesc[0];
+    auto laneOffsets = tdesc[1];
+    auto shape = llvm::to_vector(tdescTy.getShape());
+
+    createAllocaScope(
+        rewriter, op.getLoc(), {},
+        [&](mlir::OpBuilder &b, mlir::Location loc) {
+          auto scratch =
+              createScratch(b, loc, tdescTy.getElementType(),
+                            tdescTy.getNumElements(), op.getValue());
+          buildGuardedElementLoop(
+              b, loc, base, shape,
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange ivs) {
+                return getScatteredIndices(b, loc, laneOffsets, ivs);
+              },
+              flattenMask(b, loc, op.getMask()),
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange indices, mlir::Value linear) {
+                auto v = b.create<mlir::memref::LoadOp>(loc, scratch, linear);
+                b.create<mlir::memref::StoreOp>(loc, v, base, indices);
+              });
+          return llvm::SmallVector<mlir::Value>();
+        });
+    rewriter.eraseOp(op);
+    return mlir::success();
+  }
+};
+
+std::optional<mlir::arith::AtomicRMWKind>
+getArithAtomicKind(xegpu::AtomicRMWKind kind) {
+  switch (kind) {
+  case xegpu::AtomicRMWKind::addf:
+    return mlir::arith::AtomicRMWKind::addf;
+  case xegpu::AtomicRMWKind::addi:
+    return mlir::arith::AtomicRMWKind::addi;
+  case xegpu::AtomicRMWKind::assign:
+    return mlir::arith::AtomicRMWKind::assign;
+  case xegpu::AtomicRMWKind::maxf:
+    return mlir::arith::AtomicRMWKind::maximumf;
+  case xegpu::AtomicRMWKind::maxs:
+    return mlir::arith::AtomicRMWKind::maxs;
+  case xegpu::AtomicRMWKind::maxu:
+    return mlir::arith::AtomicRMWKind::maxu;
+  case xegpu::AtomicRMWKind::minf:
+    return mlir::arith::AtomicRMWKind::minimumf;
+  case xegpu::AtomicRMWKind::mins:
+    return mlir::arith::AtomicRMWKind::mins;
+  case xegpu::AtomicRMWKind::minu:
+    return mlir::arith::AtomicRMWKind::minu;
+  case xegpu::AtomicRMWKind::mulf:
+    return mlir::arith::AtomicRMWKind::mulf;
+  case xegpu::AtomicRMWKind::muli:
+    return mlir::arith::AtomicRMWKind::muli;
+  case xegpu::AtomicRMWKind::ori:
+    return mlir::arith::AtomicRMWKind::ori;
+  case xegpu::AtomicRMWKind::andi:
+    return mlir::arith::AtomicRMWKind::andi;
+  }
+  return std::nullopt;
+}
+
+struct AtomicRMWOpPattern
+    : public mlir::OneToNOpConversionPattern<xegpu::AtomicRMWOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(xegpu::AtomicRMWOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    auto resultTy = llvm::dyn_cast<mlir::VectorType>(op.getResult().getType());
+    auto kind = getArithAtomicKind(op.getKind());
+    if (!resultTy || !op.getValue() || !kind)
+      return rewriter.notifyMatchFailure(
+          op, "expected a vector value and a supported kind");
+    auto tdescTy =
+        llvm::cast<xegpu::TensorDescType>(op.getTensorDesc().getType());
+    auto tdesc = adaptor.getTensorDesc();
+    auto base = tdesc[0];
+    auto laneOffsets = tdesc[1];
+    auto shape = llvm::to_vector(tdescTy.getShape());
+    auto elemTy = tdescTy.getElementType();
+    int64_t numElements = tdescTy.getNumElements();
+
+    // Returns the old memory values; masked-off lanes return zero.
+    auto flatTy = mlir::VectorType::get({numElements}, elemTy);
+    auto flat = createAllocaScope(
+        rewriter, loc, flatTy,
+        [&](mlir::OpBuilder &b, mlir::Location loc) {
+          auto values =
+              createScratch(b, loc, elemTy, numElements, op.getValue());
+          auto old = createScratch(b, loc, elemTy, numElements, {});
+          buildGuardedElementLoop(
+              b, loc, base, shape,
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange ivs) {
+                return getScatteredIndices(b, loc, laneOffsets, ivs);
+              },
+              flattenMask(b, loc, op.getMask()),
+              [&](mlir::OpBuilder &b, mlir::Location loc,
+                  mlir::ValueRange indices, mlir::Value linear) {
+                auto v = b.create<mlir::memref::LoadOp>(loc, values, linear);
+                auto prev = b.create<mlir::memref::AtomicRMWOp>(
+                    loc, elemTy, *kind, v, base, indices);
+                b.create<mlir::memref::StoreOp>(loc, prev, old, linear);
+              });
+          llvm::SmallVector<mlir::Value> results{b.create<mlir::vector::LoadOp>(
+              loc, flatTy, old, createIndex(b, loc, 0))};
+          return results;
+        });
+
+    auto value =
+        rewriter.create<mlir::vector::ShapeCastOp>(loc, resultTy, flat.front());
+    rewriter.replaceOp(op, value.getResult(), adaptor.getResultMapping());
+    return mlir::success();
+  }
+};
+
+/// Drops ops that have no functional effect in the emulation.
+template <typename SourceOp>
+struct EraseOpPattern : public mlir::OneToNOpConversionPattern<SourceOp> {
+  using mlir::OneToNOpConversionPattern<SourceOp>::OneToNOpConversionPattern;
+  using OpAdaptor =
+      typename mlir::OneToNOpConversionPattern<SourceOp>::OpAdaptor;
+
+  mlir::LogicalResult
+  matchAndRewrite(SourceOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    rewriter.eraseOp(op);
+    return mlir::success();
+  }
+};
+
+/// Converts the tensor_desc carried by scf.for loops.
+struct ForOpPattern : public mlir::OneToNOpConversionPattern<mlir::scf::ForOp> {
+  using OneToNOpConversionPattern::OneToNOpConversionPattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::scf::ForOp op, OpAdaptor adaptor,
+                  mlir::OneToNPatternRewriter &rewriter) const override {
+    const auto &resultMapping = adaptor.getResultMapping();
+    if (!resultMapping.hasNonIdentityConversion())
+      return mlir::failure();
+
+    auto argTypes = op.getBody()->getArgumentTypes();
+    mlir::OneToNTypeMapping argMapping(argTypes);
+    if (mlir::failed(getTypeConverter<mlir::OneToNTypeConverter>()
+                         ->computeTypeMapping(argTypes, argMapping)))
+      return mlir::failure();
+
+    llvm::SmallVector<mlir::Value> initArgs;
+    for (auto values : adaptor.getInitArgs())
+      initArgs.append(values.begin(), values.end());
+
+    auto newOp = rewriter.create<mlir::scf::ForOp>(
+        op.getLoc(), op.getLowerBound(), op.getUpperBound(), op.getStep(),
+        initArgs);
+    rewriter.eraseBlock(newOp.getBody());
+    rewriter.applySignatureConversion(op.getBody(), argMapping);
+    rewriter.inlineRegionBefore(op.getRegion(), newOp.getRegion(),
+                                newOp.getRegion().end());
+    rewriter.replaceOp(op, newOp.getResults(), resultMapping);
+    return mlir::success();
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Kernel outlining
+//===----------------------------------------------------------------------===//
+
+struct ConvertXeGPUToCPUPass
+    : public ::imex::ConvertXeGPUToCPUBase<ConvertXeGPUToCPUPass> {
+  ConvertXeGPUToCPUPass() = default;
+
+  void runOnOperation() override {
+    mlir::ModuleOp mod = getOperation();
+    mlir::SymbolTable symbolTable(mod);
+
+    if (profile)
+      declareProfile(mod, symbolTable);
+
+    llvm::SmallVector<mlir::gpu::GPUModuleOp> gpuModules(
+        mod.getOps<mlir::gpu::GPUModuleOp>());
+    for (auto gpuMod : gpuModules) {
+      for (auto gpuFunc :
+           llvm::make_early_inc_range(gpuMod.getOps<mlir::gpu::GPUFuncOp>())) {
+        if (mlir::failed(outlineKernel(gpuMod, gpuFunc, symbolTable)))
+          return signalPassFailure();
+      }
+    }
+
+    if (mlir::failed(convertHostOps(mod)))
+      return signalPassFailure();
+
+    for (auto gpuMod : gpuModules)
+      gpuMod.erase();
+    mod->removeAttr(mlir::gpu::GPUDialect::getContainerModuleAttrName());
+
+    if (mlir::failed(convertXeGPUOps(mod)))
+      return signalPassFailure();
+  }
+
+private:
+  void declareProfile(mlir::ModuleOp mod, mlir::SymbolTable &symbolTable) {
+    auto ctx = mod.getContext();
+    auto loc = mod.getLoc();
+    mlir::OpBuilder b(ctx);
+    b.setInsertionPointToStart(mod.getBody());
+    auto profileTy = getProfileType(ctx);
+    auto init = b.getZeroAttr(mlir::RankedTensorType::get(
+        profileTy.getShape(), profileTy.getElementType()));
+    auto global = b.create<mlir::memref::GlobalOp>(
+        loc, kProfileGlobal, b.getStringAttr("private"), profileTy, init,
+        /*constant=*/false, /*alignment=*/mlir::IntegerAttr());
+    symbolTable.insert(global);
+
+    auto unrankedTy = mlir::UnrankedMemRefType::get(profileTy.getElementType(),
+                                                    mlir::Attribute());
+    auto printFunc = b.create<mlir::func::FuncOp>(
+        loc, kPrintProfileFunc, b.getFunctionType({unrankedTy}, {}));
+    printFunc.setPrivate();
+    printFunc->setAttr("llvm.emit_c_interface", b.getUnitAttr());
+    symbolTable.insert(printFunc);
+  }
+
+  void emitCounterIncrement(mlir::OpBuilder &b, mlir::Location loc,
+                            ProfileCounter counter) {
+    auto counters = b.create<mlir::memref::GetGlobalOp>(
+        loc, getProfileType(b.getContext()), kProfileGlobal);
+    auto idx = createIndex(b, loc, counter);
+    auto old = b.create<mlir::memref::LoadOp>(loc, counters, idx);
+    auto one = b.create<mlir::arith::ConstantIntOp>(loc, 1, 64);
+    auto sum = b.create<mlir::arith::AddIOp>(loc, old, one);
+    b.create<mlir::memref::StoreOp>(loc, sum, counters, idx);
+  }
+
+  std::optional<ProfileCounter> getCounter(mlir::Operation *op) {
+    if (llvm::isa<xegpu::LoadNDOp>(op))
+      return LoadND;
+    if (llvm::isa<xegpu::StoreNDOp>(op))
+      return StoreND;
+    if (llvm::isa<xegpu::PrefetchNDOp>(op))
+      return PrefetchND;
+    if (llvm::isa<xegpu::DpasOp>(op))
+      return Dpas;
+    if (llvm::isa<xegpu::UpdateNDOffsetOp>(op))
+      return UpdateNDOffset;
+    if (llvm::isa<xegpu::LoadGatherOp>(op))
+      return Gather;
+    if (llvm::isa<xegpu::StoreScatterOp>(op))
+      return Scatter;
+    if (llvm::isa<xegpu::PrefetchOp>(op))
+      return Prefetch;
+    if (llvm::isa<xegpu::AtomicRMWOp>(op))
+      return AtomicRMW;
+    if (llvm::isa<mlir::gpu::BarrierOp, xegpu::NbarrierWaitOp>(op))
+      return Barrier;
+    return std::nullopt;
+  }
+
+  /// Moves the body of a gpu.func kernel into a new func.func in the host
+  /// module and replaces the gpu id/dimension ops by the appended arguments.
+  mlir::LogicalResult outlineKernel(mlir::gpu::GPUModuleOp gpuMod,
+                                    mlir::gpu::GPUFuncOp gpuFunc,
+                                    mlir::SymbolTable &symbolTable) {
+    if (!gpuFunc.isKernel())
+      return gpuFunc.emitOpError(
+          "device functions are not supported by the CPU emulation");
+    if (!gpuFunc.getWorkgroupAttributions().empty() ||
+        !gpuFunc.getPrivateAttributions().empty())
+      return gpuFunc.emitOpError(
+          "workgroup and private attributions are not supported by the CPU "
+          "emulation");
+
+    auto loc = gpuFunc.getLoc();
+    mlir::OpBuilder b(gpuMod);
+    auto indexTy = b.getIndexType();
+    llvm::SmallVector<mlir::Type> inputs(gpuFunc.getArgumentTypes());
+    inputs.append(kNumIdArgs, indexTy);
+    auto func = b.create<mlir::func::FuncOp>(
+        loc, (gpuMod.getName() + "_" + gpuFunc.getName()).str(),
+        b.getFunctionType(inputs, {}));
+    func.setPrivate();
+    symbolTable.insert(func);
+    func.getBody().takeBody(gpuFunc.getBody());
+
+    auto &entry = func.getBody().front();
+    llvm::SmallVector<mlir::Value> ids;
+    for (unsigned i = 0; i < kNumIdArgs; ++i)
+      ids.push_back(entry.addArgument(indexTy, loc));
+    auto getId = [&](unsigned group, mlir::gpu::Dimension dim) {
+      return ids[group * 3 + static_cast<unsigned>(dim)];
+    };
+
+    bool hasBarrier = false;
+    llvm::SmallVector<mlir::Operation *> toErase;
+    func.walk([&](mlir::Operation *op) {
+      b.setInsertionPoint(op);
+      if (auto counter = getCounter(op); counter && profile)
+        emitCounterIncrement(b, op->getLoc(), *counter);
+
+      mlir::Value id;
+      if (auto idOp = llvm::dyn_cast<mlir::gpu::BlockIdOp>(op))
+        id = getId(0, idOp.getDimension());
+      else if (auto idOp = llvm::dyn_cast<mlir::gpu::ThreadIdOp>(op))
+        id = getId(1, idOp.getDimension());
+      else if (auto dimOp = llvm::dyn_cast<mlir::gpu::GridDimOp>(op))
+        id = getId(2, dimOp.getDimension());
+      else if (auto dimOp = llvm::dyn_cast<mlir::gpu::BlockDimOp>(op))
+        id = getId(3, dimOp.getDimension());
+      if (id) {
+        op->getResult(0).replaceAllUsesWith(id);
+        toErase.push_back(op);
+      } else if (llvm::isa<mlir::gpu::ReturnOp>(op)) {
+        b.create<mlir::func::ReturnOp>(op->getLoc());
+        toErase.push_back(op);
+      } else if (llvm::isa<mlir::gpu::BarrierOp, xegpu::AllocNbarrierOp,
+                           xegpu::CreateNbarrierOp, xegpu::NbarrierArriveOp,
+                           xegpu::NbarrierWaitOp>(op)) {
+        hasBarrier = true;
+        toErase.push_back(op);
+      }
+    });
+    // Erase users before the named barriers they use.
+    for (auto *op : llvm::reverse(toErase))
+      op->erase();
+
+    kernels[mlir::SymbolRefAttr::get(
+        gpuMod.getNameAttr(),
+        {mlir::FlatSymbolRefAttr::get(gpuFunc.getNameAttr())})] = {
+        func, hasBarrier};
+    gpuFunc.erase();
+    return mlir::success();
+  }
+
+  /// Replaces gpu.launch_func by a loop nest calling the outlined kernel for
+  /// every subgroup, and gpu memory management by memref ops.
+  mlir::LogicalResult convertHostOps(mlir::ModuleOp mod) {
+    auto result = mod.walk([&](mlir::Operation *op) -> mlir::WalkResult {
+      mlir::OpBuilder b(op);
+      auto loc = op->getLoc();
+      if (auto asyncOp = llvm::dyn_cast<mlir::gpu::AsyncOpInterface>(op)) {
+        if (!asyncOp.getAsyncDependencies().empty() ||
+            asyncOp.getAsyncToken())
+          return op->emitOpError(
+              "async gpu ops are not supported by the CPU emulation");
+      }
+
+      if (auto launch = llvm::dyn_cast<mlir::gpu::LaunchFuncOp>(op)) {
+        auto it = kernels.find(launch.getKernel());
+        if (it == kernels.end())
+          return launch.emitOpError("kernel not found");
+        auto kernel = it->second;
+
+        llvm::SmallVector<mlir::Value> sizes{
+            launch.getGridSizeX(),  launch.getGridSizeY(),
+            launch.getGridSizeZ(),  launch.getBlockSizeX(),
+            launch.getBlockSizeY(), launch.getBlockSizeZ()};
+        if (kernel.hasBarrier) {
+          // Subgroups run one after another, so a barrier can only be
+          // honored if it is the only subgroup of its work-group.
+          for (auto size : llvm::ArrayRef<mlir::Value>(sizes).drop_front(3)) {
+            auto c = mlir::getConstantIntValue(size);
+            if (!c || *c != 1)
+              return launch.emitOpError(
+                  "kernels with barriers must be launched with one subgroup "
+                  "per work-group to be emulated on the CPU");
+          }
+        }
+
+        auto c0 = createIndex(b, loc, 0);
+        auto c1 = createIndex(b, loc, 1);
+        llvm::SmallVector<mlir::Value> zeros(sizes.size(), c0);
+        llvm::SmallVector<mlir::Value> ones(sizes.size(), c1);
+        mlir::scf::buildLoopNest(
+            b, loc, zeros, sizes, ones,
+            [&](mlir::OpBuilder &b, mlir::Location loc, mlir::ValueRange ivs) {
+              llvm::SmallVector<mlir::Value> args(launch.getKernelOperands());
+              args.append(ivs.begin(), ivs.end());
+              args.append(sizes.begin(), sizes.end());
+              b.create<mlir::func::CallOp>(loc, kernel.func, args);
+            });
+        if (profile) {
+          auto profileTy = getProfileType(b.getContext());
+          auto counters = b.create<mlir::memref::GetGlobalOp>(
+              loc, profileTy, kProfileGlobal);
+          auto unranked = b.create<mlir::memref::CastOp>(
+              loc,
+              mlir::UnrankedMemRefType::get(profileTy.getElementType(),
+                                            mlir::Attribute()),
+              counters);
+          b.create<mlir::func::CallOp>(loc, kPrintProfileFunc,
+                                       mlir::TypeRange(),
+                                       mlir::ValueRange{unranked});
+        }
+        launch.erase();
+      } else if (auto alloc = llvm::dyn_cast<mlir::gpu::AllocOp>(op)) {
+        auto newAlloc = b.create<mlir::memref::AllocOp>(
+            loc, alloc.getType(), alloc.getDynamicSizes(),
+            alloc.getSymbolOperands());
+        alloc.getMemref().replaceAllUsesWith(newAlloc.getResult());
+        alloc.erase();
+      } else if (auto dealloc = llvm::dyn_cast<mlir::gpu::DeallocOp>(op)) {
+        b.create<mlir::memref::DeallocOp>(loc, dealloc.getMemref());
+        dealloc.erase();
+      } else if (auto memcpy = llvm::dyn_cast<mlir::gpu::MemcpyOp>(op)) {
+        b.create<mlir::memref::CopyOp>(loc, memcpy.getSrc(), memcpy.getDst());
+        memcpy.erase();
+      } else if (llvm::isa<mlir::gpu::WaitOp>(op)) {
+        op->erase();
+      }
+      return mlir::WalkResult::advance();
+    });
+    return mlir::failure(result.wasInterrupted());
+  }
+
+  mlir::LogicalResult convertXeGPUOps(mlir::ModuleOp mod) {
+    auto ctx = mod.getContext();
+    mlir::OneToNTypeConverter typeConverter;
+    typeConverter.addConversion([](mlir::Type type) { return type; });
+    typeConverter.addConversion(
+        [](xegpu::TensorDescType type,
+           llvm::SmallVectorImpl<mlir::Type> &results)
+            -> std::optional<mlir::LogicalResult> {
+          results.push_back(getBaseMemRefType(type));
+          auto indexTy = mlir::IndexType::get(type.getContext());
+          if (type.getScattered())
+            results.push_back(
+                mlir::VectorType::get({type.getShape()[0]}, indexTy));
+          else
+            results.append(type.getRank(), indexTy);
+          return mlir::success();
+        });
+
+    mlir::RewritePatternSet patterns(ctx);
+    patterns.add<CreateNdDescOpPattern, UpdateNDOffsetOpPattern,
+                 LoadNDOpPattern, StoreNDOpPattern, DpasOpPattern,
+                 CreateDescOpPattern, UpdateOffsetOpPattern,
+                 LoadGatherOpPattern, StoreScatterOpPattern,
+                 AtomicRMWOpPattern, EraseOpPattern<xegpu::PrefetchNDOp>,
+                 EraseOpPattern<xegpu::PrefetchOp>,
+                 EraseOpPattern<xegpu::CompileHintOp>,
+                 EraseOpPattern<xegpu::MfenceOp>, ForOpPattern>(typeConverter,
+                                                                ctx);
+    mlir::scf::populateSCFStructuralOneToNTypeConversions(typeConverter,
+                                                          patterns);
+    if (mlir::failed(mlir::applyPartialOneToNConversion(
+            mod, typeConverter, std::move(patterns))))
+      return mlir::failure();
+
+    auto result = mod.walk([](mlir::Operation *op) {
+      if (llvm::isa<xegpu::XeGPUDialect>(op->getDialect()))
+        return mlir::WalkResult(
+            op->emitOpError("cannot be emulated on the CPU"));
+      return mlir::WalkResult::advance();
+    });
+    return mlir::failure(result.wasInterrupted());
+  }
+
+  struct OutlinedKernel {
+    mlir::func::FuncOp func;
+    bool hasBarrier;
+  };
+  llvm::DenseMap<mlir::SymbolRefAttr, OutlinedKernel> kernels;
+};
+
+} // namespace
+
+/// Create a pass that emulates XeGPU kernels on the CPU
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
+createConvertXeGPUToCPUPass() {
+  return std::make_unique<ConvertXeGPUToCPUPass>();
+}
+
+} // namespace imex
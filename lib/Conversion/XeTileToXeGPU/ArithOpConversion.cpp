@@ -9,10 +9,14 @@
 ///
 /// \file
 /// This file implements the ArithOpConversionPattern, used in XeTileToXeGPU
-/// conversion, converting the Arith Ops.
+/// conversion, converting the Arith Ops, and the elementwise Arith and Math
+/// ops applied to the blocked results of tile_mma (the GEMM epilogue, e.g.,
+/// bias add, activation and downcast) before they are stored.
 ///
 //===----------------------------------------------------------------------===//
 
+#include <mlir/Dialect/Math/IR/Math.h>
+
 #include "ArithOpConversion.h"
 
 namespace imex {
@@ -50,7 +54,7 @@ class SgArithConstantOpPattern
     if (!denseElementsAttr.isSplat())
       return mlir::failure();
 
-    auto splatVal = denseElementsAttr.getSplatValue<mlir::FloatAttr>();
+    auto splatVal = denseElementsAttr.getSplatValue<mlir::Attribute>();
 
     rewriter.setInsertionPoint(op);
     llvm::SmallVector<mlir::Value> newOps;
@@ -68,6 +72,93 @@ class SgArithConstantOpPattern
   }
 };
 
+// Rounds f32 values to bf16 (round to nearest even) with integer ops, since
+// the SPIR-V lowering has no bf16 arithmetic. The bf16 bits are bitcast back
+// to bf16 so that the following store_nd keeps its element type.
+static mlir::Value createTruncFToBF16(mlir::Location loc, mlir::Value value,
+                                      mlir::VectorType resultTy,
+                                      XeGPUOneToNPatterRewriter &rewriter) {
+  auto shape = resultTy.getShape();
+  auto i32VecTy = mlir::VectorType::get(shape, rewriter.getI32Type());
+  auto i16VecTy = mlir::VectorType::get(shape, rewriter.getIntegerType(16));
+  auto createSplat = [&](int64_t v) -> mlir::Value {
+    return rewriter.create<mlir::arith::ConstantOp>(
+        loc, i32VecTy,
+        mlir::DenseElementsAttr::get(i32VecTy, rewriter.getI32IntegerAttr(v)));
+  };
+
+  auto bits = rewriter.create<mlir::arith::BitcastOp>(loc, i32VecTy, value);
+  auto c16 = createSplat(16);
+  auto lsb = rewriter.create<mlir::arith::AndIOp>(
+      loc, rewriter.create<mlir::arith::ShRUIOp>(loc, bits, c16),
+      createSplat(1));
+  auto bias =
+      rewriter.create<mlir::arith::AddIOp>(loc, lsb, createSplat(0x7FFF));
+  auto rounded = rewriter.create<mlir::arith::ShRUIOp>(
+      loc, rewriter.create<mlir::arith::AddIOp>(loc, bits, bias), c16);
+  auto truncated =
+      rewriter.create<mlir::arith::TruncIOp>(loc, i16VecTy, rounded);
+  return rewriter.create<mlir::arith::BitcastOp>(loc, resultTy, truncated);
+}
+
+// Blocked elementwise ops (4D vectors) -> one op per 2D block. Operands
+// and results are blocked in the same way by xetile-tiling, so block i of
+// the result only depends on block i of each operand.
+template <typename OpTy>
+class SgElementwiseOpPattern : public SgXeTileToXeGPUConversion<OpTy> {
+  using SgXeTileToXeGPUConversion<OpTy>::SgXeTileToXeGPUConversion;
+
+  mlir::LogicalResult
+  matchAndRewrite(OpTy op, typename SgXeTileToXeGPUConversion<OpTy>::OpAdaptor
+                               adaptor,
+                  XeGPUOneToNPatterRewriter &rewriter) const override {
+    auto loc = op.getLoc();
+    auto resultTy =
+        llvm::dyn_cast<mlir::VectorType>(op->getResult(0).getType());
+    if (op->getNumResults() != 1 || !resultTy || resultTy.getRank() != 4)
+      return mlir::failure();
+
+    auto shape = resultTy.getShape();
+    auto numBlocks = shape[0] * shape[1];
+    auto blockTy =
+        mlir::VectorType::get({shape[2], shape[3]}, resultTy.getElementType());
+
+    auto operands = adaptor.getOperands();
+    for (auto values : operands) {
+      if ((int64_t)values.size() != numBlocks) {
+        op.emitOpError() << "Failed to lower the elementwise op, because the "
+                            "number of blocks of operands and result doesn't "
+                            "match.";
+        return mlir::failure();
+      }
+    }
+
+    bool isTruncToBF16 = false;
+    if constexpr (std::is_same_v<OpTy, mlir::arith::TruncFOp>)
+      isTruncToBF16 = resultTy.getElementType().isBF16() &&
+                      op.getIn().getType().getElementType().isF32();
+
+    rewriter.setInsertionPoint(op);
+    llvm::SmallVector<mlir::Value> newOps;
+    for (int64_t i = 0; i < numBlocks; i++) {
+      llvm::SmallVector<mlir::Value> blockOperands;
+      for (auto values : operands)
+        blockOperands.push_back(values[i]);
+      if (isTruncToBF16) {
+        newOps.push_back(
+            createTruncFToBF16(loc, blockOperands[0], blockTy, rewriter));
+        continue;
+      }
+      auto newOp = rewriter.create<OpTy>(loc, mlir::TypeRange{blockTy},
+                                         blockOperands, op->getAttrs());
+      newOps.push_back(newOp->getResult(0));
+    }
+
+    rewriter.replaceOp(op, newOps);
+    return mlir::success();
+  }
+};
+
 bool isLegalArithOp(mlir::Operation *op) {
   if (llvm::isa<mlir::arith::ConstantOp>(op)) {
     auto constOp = llvm::cast<mlir::arith::ConstantOp>(op);
@@ -76,12 +167,45 @@ bool isLegalArithOp(mlir::Operation *op) {
         resultTy.cast<mlir::VectorType>().getRank() == 4)
       return false;
   }
-  return true;
+  return isLegalElementwiseOp(op);
+}
+
+bool isLegalElementwiseOp(mlir::Operation *op) {
+  if (!op->hasTrait<mlir::OpTrait::Elementwise>())
+    return true;
+  auto isBlocked = [](mlir::Type type) {
+    auto vecTy = llvm::dyn_cast<mlir::VectorType>(type);
+    return vecTy && vecTy.getRank() == 4;
+  };
+  return llvm::none_of(op->getOperandTypes(), isBlocked) &&
+         llvm::none_of(op->getResultTypes(), isBlocked);
 }
 
 void populateArithOpConversionPatterns(imex::XeGPUTypeConverter &converter,
                                        mlir::RewritePatternSet &patterns) {
   patterns.add<SgArithConstantOpPattern>(patterns.getContext(), converter);
+  patterns.add<SgElementwiseOpPattern<mlir::arith::AddFOp>,
+               SgElementwiseOpPattern<mlir::arith::SubFOp>,
+               SgElementwiseOpPattern<mlir::arith::MulFOp>,
+               SgElementwiseOpPattern<mlir::arith::DivFOp>,
+               SgElementwiseOpPattern<mlir::arith::NegFOp>,
+               SgElementwiseOpPattern<mlir::arith::MaximumFOp>,
+               SgElementwiseOpPattern<mlir::arith::MinimumFOp>,
+               SgElementwiseOpPattern<mlir::arith::AddIOp>,
+               SgElementwiseOpPattern<mlir::arith::SubIOp>,
+               SgElementwiseOpPattern<mlir::arith::MulIOp>,
+               SgElementwiseOpPattern<mlir::arith::MaxSIOp>,
+               SgElementwiseOpPattern<mlir::arith::MinSIOp>,
+               SgElementwiseOpPattern<mlir::arith::TruncFOp>,
+               SgElementwiseOpPattern<mlir::arith::ExtFOp>,
+               SgElementwiseOpPattern<mlir::arith::SIToFPOp>,
+               SgElementwiseOpPattern<mlir::arith::FPToSIOp>,
+               SgElementwiseOpPattern<mlir::math::ExpOp>,
+               SgElementwiseOpPattern<mlir::math::TanhOp>,
+               SgElementwiseOpPattern<mlir::math::ErfOp>,
+               SgElementwiseOpPattern<mlir::math::SqrtOp>,
+               SgElementwiseOpPattern<mlir::math::AbsFOp>>(
+      patterns.getContext(), converter);
 }
 
 } // namespace imex
@@ -21,6 +21,8 @@
 namespace imex {
 bool isLegalArithOp(mlir::Operation *op);
 
+bool isLegalElementwiseOp(mlir::Operation *op);
+
 void populateArithOpConversionPatterns(imex::XeGPUTypeConverter &converter,
                                        mlir::RewritePatternSet &patterns);
 
@@ -23,6 +23,54 @@
 
 namespace imex {
 
+// Maps the cache policy of a tile access (see assignCacheHints) to the XeGPU
+// L1/L2/L3 hints. Streaming only bypasses L1, so the data can still be shared
+// with other subgroups through L2/L3.
+static llvm::SmallVector<xegpu::CacheReadHintAttr>
+getCacheReadHints(mlir::MLIRContext *context,
+                  std::optional<xetile::CacheHint> hint) {
+  auto get = [&](xegpu::CacheReadHint h) {
+    return xegpu::CacheReadHintAttr::get(context, h);
+  };
+  switch (hint.value_or(xetile::CacheHint::CACHED)) {
+  case xetile::CacheHint::STREAMING:
+    return {get(xegpu::CacheReadHint::STREAMING),
+            get(xegpu::CacheReadHint::CACHED),
+            get(xegpu::CacheReadHint::CACHED)};
+  case xetile::CacheHint::UNCACHED:
+    return {get(xegpu::CacheReadHint::UNCACHED),
+            get(xegpu::CacheReadHint::UNCACHED),
+            get(xegpu::CacheReadHint::UNCACHED)};
+  case xetile::CacheHint::CACHED:
+    break;
+  }
+  return {get(xegpu::CacheReadHint::CACHED), get(xegpu::CacheReadHint::CACHED),
+          get(xegpu::CacheReadHint::CACHED)};
+}
+
+static llvm::SmallVector<xegpu::CacheWriteHintAttr>
+getCacheWriteHints(mlir::MLIRContext *context,
+                   std::optional<xetile::CacheHint> hint) {
+  auto get = [&](xegpu::CacheWriteHint h) {
+    return xegpu::CacheWriteHintAttr::get(context, h);
+  };
+  switch (hint.value_or(xetile::CacheHint::CACHED)) {
+  case xetile::CacheHint::STREAMING:
+    return {get(xegpu::CacheWriteHint::STREAMING),
+            get(xegpu::CacheWriteHint::WRITE_BACK),
+            get(xegpu::CacheWriteHint::WRITE_BACK)};
+  case xetile::CacheHint::UNCACHED:
+    return {get(xegpu::CacheWriteHint::UNCACHED),
+            get(xegpu::CacheWriteHint::UNCACHED),
+            get(xegpu::CacheWriteHint::UNCACHED)};
+  case xetile::CacheHint::CACHED:
+    break;
+  }
+  return {get(xegpu::CacheWriteHint::WRITE_BACK),
+          get(xegpu::CacheWriteHint::WRITE_BACK),
+          get(xegpu::CacheWriteHint::WRITE_BACK)};
+}
+
 // Sg-level XeTile::init_tile -> XeGPU::init_tile
 class SgInitTileOpPattern
     : public SgXeTileToXeGPUConversion<xetile::InitTileOp> {
@@ -114,17 +162,13 @@ struct SgPrefetchTileOpPattern
       return mlir::failure();
     }
 
-    auto L1 = xegpu::CacheReadHintAttr::get(op.getContext(),
-                                            xegpu::CacheReadHint::CACHED);
-    auto L2 = xegpu::CacheReadHintAttr::get(op.getContext(),
-                                            xegpu::CacheReadHint::CACHED);
-    auto L3 = xegpu::CacheReadHintAttr::get(op.getContext(),
-                                            xegpu::CacheReadHint::CACHED);
+    auto hints = getCacheReadHints(op.getContext(), op.getCacheHint());
 
     for (int i = 0; i < shape[0]; i++) {
       for (int j = 0; j < shape[1]; j++) {
         auto tile = tiles[i * shape[1] + j];
-        rewriter.create<xegpu::PrefetchNDOp>(op.getLoc(), tile, L1, L2, L3,
+        rewriter.create<xegpu::PrefetchNDOp>(op.getLoc(), tile, hints[0],
+                                             hints[1], hints[2],
                                              imex::xegpu::Mode::VC);
       }
     }
@@ -170,12 +214,7 @@ struct SgLoadTileOpPattern
     // FIXME : remove the usage of tranpose attribute and rely on order
     // attribute.
     mlir::DenseI64ArrayAttr transposeAttr;
-    auto L1 = xegpu::CacheReadHintAttr::get(op.getContext(),
-                                            xegpu::CacheReadHint::CACHED);
-    auto L2 = xegpu::CacheReadHintAttr::get(op.getContext(),
-                                            xegpu::CacheReadHint::CACHED);
-    auto L3 = xegpu::CacheReadHintAttr::get(op.getContext(),
-                                            xegpu::CacheReadHint::CACHED);
+    auto hints = getCacheReadHints(op.getContext(), op.getCacheHint());
 
     llvm::SmallVector<int64_t> newShape = {shape[2], shape[3]};
     // needs vnni transform;
@@ -200,8 +239,8 @@ struct SgLoadTileOpPattern
         // FIXME: (chencha3) it assumes arr_len is 1,
         // pending improvement in the new lowering passes.
         auto ldOp = rewriter.create<xegpu::LoadNDOp>(
-            op.getLoc(), subVectorTy, tile, vnniAxisAttr, transposeAttr, L1, L2,
-            L3, imex::xegpu::Mode::VC);
+            op.getLoc(), subVectorTy, tile, vnniAxisAttr, transposeAttr,
+            hints[0], hints[1], hints[2], imex::xegpu::Mode::VC);
         xegpuOps.push_back(ldOp);
       }
     }
@@ -231,16 +270,11 @@ struct SgStoreTileOpPattern
       return mlir::failure();
     }
 
-    auto context = op.getContext();
-    auto L1 = xegpu::CacheWriteHintAttr::get(context,
-                                             xegpu::CacheWriteHint::WRITE_BACK);
-    auto L2 = xegpu::CacheWriteHintAttr::get(context,
-                                             xegpu::CacheWriteHint::WRITE_BACK);
-    auto L3 = xegpu::CacheWriteHintAttr::get(context,
-                                             xegpu::CacheWriteHint::WRITE_BACK);
+    auto hints = getCacheWriteHints(op.getContext(), op.getCacheHint());
     for (size_t i = 0; i < tiles.size(); i++)
-      rewriter.create<xegpu::StoreNDOp>(op.getLoc(), tiles[i], values[i], L1,
-                                        L2, L3, imex::xegpu::Mode::VC);
+      rewriter.create<xegpu::StoreNDOp>(op.getLoc(), tiles[i], values[i],
+                                        hints[0], hints[1], hints[2],
+                                        imex::xegpu::Mode::VC);
 
     rewriter.eraseOp(op);
     return ::mlir::success();
@@ -16,6 +16,7 @@
 #include <mlir/Conversion/SCFToControlFlow/SCFToControlFlow.h>
 #include <mlir/Dialect/Arith/IR/Arith.h>
 #include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/Math/IR/Math.h>
 #include <mlir/Dialect/Vector/IR/VectorOps.h>
 #include <mlir/IR/BuiltinOps.h>
 #include <mlir/Transforms/Passes.h>
@@ -45,6 +46,9 @@ public:
     addDynamicallyLegalDialect<mlir::arith::ArithDialect>(
         [&](mlir::Operation *op) { return isLegalArithOp(op); });
 
+    addDynamicallyLegalDialect<mlir::math::MathDialect>(
+        [&](mlir::Operation *op) { return isLegalElementwiseOp(op); });
+
     addDynamicallyLegalDialect<mlir::scf::SCFDialect>(
         [&](mlir::Operation *op) { return isLegalSCFOp(op); });
 
@@ -127,6 +131,9 @@ struct ConvertXeTileToXeGPUPass // convert XeTile to XeGPU
       markUseChainValues(op.getOutput(), OperandType::DPASR, map);
     });
 
+    // choose the cache hints of tile accesses without an explicit one.
+    assignCacheHints(mod);
+
     XeGPUTypeConverter typeConverter(context, map);
     XeTileConversionTarget target(context, uArchInterface);
 
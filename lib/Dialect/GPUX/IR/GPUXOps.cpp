@@ -42,10 +42,11 @@ void GPUXDialect::initialize() {
 void CreateStreamOp::build(::mlir::OpBuilder &odsBuilder,
                            ::mlir::OperationState &odsState,
                            std::optional<::mlir::Value> device,
-                           std::optional<::mlir::Value> context) {
+                           std::optional<::mlir::Value> context,
+                           bool moduleLifetime) {
   CreateStreamOp::build(odsBuilder, odsState, odsBuilder.getType<StreamType>(),
                         device.value_or(mlir::Value{}),
-                        context.value_or(mlir::Value{}));
+                        context.value_or(mlir::Value{}), moduleLifetime);
 }
 
 void LaunchFuncOp::build(
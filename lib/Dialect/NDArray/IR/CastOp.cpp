@@ -211,9 +211,119 @@ public:
   }
 };
 
+/// @return true if every value of element type from is representable in
+/// element type to, i.e. casting to to and back yields the original value.
+static bool isLosslessElemTypeCast(::mlir::Type from, ::mlir::Type to) {
+  if (from == to) {
+    return true;
+  }
+  auto fTo = to.dyn_cast<::mlir::FloatType>();
+  if (auto fFrom = from.dyn_cast<::mlir::FloatType>()) {
+    return fTo && fTo.getWidth() > fFrom.getWidth() &&
+           fTo.getFPMantissaWidth() >= fFrom.getFPMantissaWidth();
+  }
+  auto iFrom = from.dyn_cast<::mlir::IntegerType>();
+  if (!iFrom) {
+    return false;
+  }
+  if (fTo) {
+    return fTo.getFPMantissaWidth() >= static_cast<int>(iFrom.getWidth());
+  }
+  auto iTo = to.dyn_cast<::mlir::IntegerType>();
+  if (!iTo) {
+    return false;
+  }
+  if (iFrom.isUnsigned()) {
+    return iTo.isUnsigned() ? iTo.getWidth() >= iFrom.getWidth()
+                            : iTo.getWidth() > iFrom.getWidth();
+  }
+  return !iTo.isUnsigned() && iTo.getWidth() >= iFrom.getWidth();
+}
+
+/// @return true if the lowering of CastElemTypeOp can cast element type from
+/// to to directly. Casts between two float types or two integer types are
+/// lowered to an extension or truncation, which requires different widths,
+/// so e.g. f16 and bf16 cannot be cast into each other.
+static bool canCastElemTypeDirectly(::mlir::Type from, ::mlir::Type to) {
+  if (from == to) {
+    return true;
+  }
+  bool floats = from.isa<::mlir::FloatType>() && to.isa<::mlir::FloatType>();
+  bool ints = from.isa<::mlir::IntegerType>() && to.isa<::mlir::IntegerType>();
+  return !((floats || ints) &&
+           from.getIntOrFloatBitWidth() == to.getIntOrFloatBitWidth());
+}
+
+/// Pattern to remove a CastElemTypeOp which does not change the type and
+/// does not request a copy.
+class NoopCastElemType final
+    : public mlir::OpRewritePattern<::imex::ndarray::CastElemTypeOp> {
+public:
+  using mlir::OpRewritePattern<
+      ::imex::ndarray::CastElemTypeOp>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(::imex::ndarray::CastElemTypeOp op,
+                  ::mlir::PatternRewriter &rewriter) const override {
+    if (op.getCopy().value_or(false) ||
+        op.getInput().getType() != op.getType()) {
+      return mlir::failure();
+    }
+    rewriter.replaceOp(op, op.getInput());
+    return ::mlir::success();
+  }
+};
+
+/// Pattern to fold a CastElemTypeOp of a lossless CastElemTypeOp into a
+/// single cast of the original input. Round trips, e.g. f16 -> f32 -> f16,
+/// fold to the original input. Chains whose direct cast could not be lowered,
+/// e.g. f16 -> f32 -> bf16, are kept.
+class ChainedCastElemType final
+    : public mlir::OpRewritePattern<::imex::ndarray::CastElemTypeOp> {
+public:
+  using mlir::OpRewritePattern<
+      ::imex::ndarray::CastElemTypeOp>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(::imex::ndarray::CastElemTypeOp op,
+                  ::mlir::PatternRewriter &rewriter) const override {
+    auto defOp = op.getInput().getDefiningOp<::imex::ndarray::CastElemTypeOp>();
+    if (!defOp || op.getCopy().value_or(false) ||
+        defOp.getCopy().value_or(false)) {
+      return mlir::failure();
+    }
+
+    auto src = defOp.getInput();
+    auto srcNDTyp = src.getType().dyn_cast<::imex::ndarray::NDArrayType>();
+    auto midNDTyp =
+        defOp.getResult().getType().dyn_cast<::imex::ndarray::NDArrayType>();
+    auto resNDTyp =
+        op.getResult().getType().dyn_cast<::imex::ndarray::NDArrayType>();
+    if (!(srcNDTyp && midNDTyp && resNDTyp) ||
+        !isLosslessElemTypeCast(srcNDTyp.getElementType(),
+                                midNDTyp.getElementType())) {
+      return mlir::failure();
+    }
+
+    if (srcNDTyp == resNDTyp) {
+      rewriter.replaceOp(op, src);
+      return ::mlir::success();
+    }
+    // the lowering expects identical shapes
+    if (srcNDTyp.getShape() != resNDTyp.getShape() ||
+        !canCastElemTypeDirectly(srcNDTyp.getElementType(),
+                                 resNDTyp.getElementType())) {
+      return mlir::failure();
+    }
+    rewriter.replaceOpWithNewOp<::imex::ndarray::CastElemTypeOp>(op, resNDTyp,
+                                                                 src);
+    return ::mlir::success();
+  }
+};
+
 void imex::ndarray::CastElemTypeOp::getCanonicalizationPatterns(
     mlir::RewritePatternSet &results, mlir::MLIRContext *context) {
   results
-      .add<CastElemTypeOpResultCanonicalizer, CastElemTypeOpInputCanonicalizer>(
-          context);
+      .add<CastElemTypeOpResultCanonicalizer, CastElemTypeOpInputCanonicalizer,
+           NoopCastElemType, ChainedCastElemType>(context);
 }
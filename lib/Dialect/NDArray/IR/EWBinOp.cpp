@@ -69,9 +69,66 @@ public:
   }
 };
 
+/// Pattern to sink a cast_elemtype to the result element type into a
+/// consuming ewbin op. The lowered ewbin casts its operands to the result
+/// element type in its body anyway, which saves the separate conversion
+/// kernel and its temporary array.
+class EWBinOpCastElemTypeSinking final
+    : public mlir::OpRewritePattern<::imex::ndarray::EWBinOp> {
+public:
+  using mlir::OpRewritePattern<::imex::ndarray::EWBinOp>::OpRewritePattern;
+
+  mlir::LogicalResult
+  matchAndRewrite(::imex::ndarray::EWBinOp op,
+                  ::mlir::PatternRewriter &rewriter) const override {
+    auto resPtTyp =
+        op.getResult().getType().dyn_cast<::imex::ndarray::NDArrayType>();
+    auto binOpId = op.getOp().dyn_cast<::mlir::IntegerAttr>();
+    if (!resPtTyp || !binOpId) {
+      return mlir::failure();
+    }
+
+    // these are lowered to TOSA, which requires identical element types
+    switch (binOpId.getInt()) {
+    case ::imex::ndarray::BITWISE_AND:
+    case ::imex::ndarray::BITWISE_OR:
+    case ::imex::ndarray::BITWISE_XOR:
+    case ::imex::ndarray::LOGICAL_AND:
+    case ::imex::ndarray::LOGICAL_OR:
+    case ::imex::ndarray::LOGICAL_XOR:
+      return mlir::failure();
+    default:
+      break;
+    }
+
+    bool succ = false;
+    for (unsigned idx = 0; idx < 2; ++idx) {
+      auto castOp =
+          op->getOperand(idx).getDefiningOp<::imex::ndarray::CastElemTypeOp>();
+      if (!castOp || castOp.getCopy().value_or(false)) {
+        continue;
+      }
+      auto src = castOp.getInput();
+      auto srcPtTyp = src.getType().dyn_cast<::imex::ndarray::NDArrayType>();
+      auto castPtTyp =
+          castOp.getType().dyn_cast<::imex::ndarray::NDArrayType>();
+      if (!srcPtTyp || !castPtTyp ||
+          castPtTyp.getElementType() != resPtTyp.getElementType() ||
+          srcPtTyp.cloneWith(srcPtTyp.getShape(),
+                             castPtTyp.getElementType()) != castPtTyp) {
+        continue;
+      }
+      rewriter.modifyOpInPlace(op, [&]() { op->setOperand(idx, src); });
+      succ = true;
+    }
+    return succ ? ::mlir::success() : ::mlir::failure();
+  }
+};
+
 } // namespace
 
 void imex::ndarray::EWBinOp::getCanonicalizationPatterns(
     mlir::RewritePatternSet &results, mlir::MLIRContext *context) {
-  results.add<EWBinOpInputCanonicalizer, EWBinOpResultCanonicalizer>(context);
+  results.add<EWBinOpInputCanonicalizer, EWBinOpResultCanonicalizer,
+              EWBinOpCastElemTypeSinking>(context);
 }
@@ -0,0 +1,55 @@
+//===- MatMulOp.cpp - NDArray dialect  --------------------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the MatMulOp of the NDArray dialect.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Dialect/NDArray/IR/NDArrayOps.h>
+
+/// @return true if the given dim-sizes are equal or one of them is dynamic
+static bool isCompatibleDim(int64_t a, int64_t b) {
+  return a == b || ::mlir::ShapedType::isDynamic(a) ||
+         ::mlir::ShapedType::isDynamic(b);
+}
+
+::mlir::LogicalResult imex::ndarray::MatMulOp::verify() {
+  auto lhsType = getLhs().getType().dyn_cast<::imex::ndarray::NDArrayType>();
+  auto rhsType = getRhs().getType().dyn_cast<::imex::ndarray::NDArrayType>();
+  auto resType = getType().cast<::imex::ndarray::NDArrayType>();
+  if (!lhsType || !rhsType) {
+    return emitOpError("expects NDArray operands");
+  }
+
+  auto rank = lhsType.getRank();
+  if ((rank != 2 && rank != 3) || rhsType.getRank() != rank ||
+      resType.getRank() != rank) {
+    return emitOpError("expects operands and result of the same rank 2 or 3");
+  }
+
+  // (batch, m, k) x (batch, k, n) -> (batch, m, n) after transposition
+  auto lhsShape = lhsType.getShape();
+  auto rhsShape = rhsType.getShape();
+  auto resShape = resType.getShape();
+  auto m = lhsShape[rank - (getTransposeLhs() ? 1 : 2)];
+  auto lk = lhsShape[rank - (getTransposeLhs() ? 2 : 1)];
+  auto rk = rhsShape[rank - (getTransposeRhs() ? 1 : 2)];
+  auto n = rhsShape[rank - (getTransposeRhs() ? 2 : 1)];
+  if (!isCompatibleDim(lk, rk)) {
+    return emitOpError("contracting dimensions do not match");
+  }
+  if (!isCompatibleDim(m, resShape[rank - 2]) ||
+      !isCompatibleDim(n, resShape[rank - 1]) ||
+      (rank == 3 && !(isCompatibleDim(lhsShape[0], rhsShape[0]) &&
+                      isCompatibleDim(lhsShape[0], resShape[0])))) {
+    return emitOpError("result shape does not match operand shapes");
+  }
+  return ::mlir::success();
+}
@@ -0,0 +1,328 @@
+//===- RegionCoalesce.cpp - Coalescing of env regions ----------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements placement and coalescing of env regions. Host NDArray
+/// and Dist ops producing arrays are moved into a GPU env region when that
+/// reduces the number of arrays crossing environments, cheap scalar host ops
+/// between compatible env regions are moved into the first one, and adjacent
+/// compatible env regions are merged. Every array crossing from one
+/// environment to another becomes a host/device transfer when lowered, so
+/// fewer and larger regions mean fewer transfers.
+///
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+#include "imex/Dialect/Dist/IR/DistOps.h"
+#include "imex/Dialect/NDArray/IR/NDArrayOps.h"
+#include "imex/Dialect/Region/IR/RegionOps.h"
+#include "imex/Dialect/Region/Transforms/Passes.h"
+
+namespace imex {
+#define GEN_PASS_DEF_REGIONCOALESCE
+#include "imex/Dialect/Region/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+using ::imex::region::EnvironmentRegionOp;
+using ::imex::region::EnvironmentRegionYieldOp;
+
+/// An environment for a single op overriding the one it is nested in, used to
+/// evaluate moving the op. The host environment is the null attribute.
+struct Placement {
+  ::mlir::Operation *op = nullptr;
+  ::mlir::Attribute env;
+};
+
+bool isArray(::mlir::Type type) { return type.isa<::mlir::ShapedType>(); }
+
+/// Returns the environment op is executed in.
+::mlir::Attribute getEnv(::mlir::Operation *op, const Placement &placement) {
+  if (op == placement.op)
+    return placement.env;
+  auto region = op->getParentOfType<EnvironmentRegionOp>();
+  return region ? region.getEnvironment() : ::mlir::Attribute();
+}
+
+/// Returns the environment value is defined in. Results of an env region
+/// live in the environment of the region.
+::mlir::Attribute getDefEnv(::mlir::Value value, const Placement &placement) {
+  if (auto region = value.getDefiningOp<EnvironmentRegionOp>())
+    return region.getEnvironment();
+  if (auto *def = value.getDefiningOp())
+    return getEnv(def, placement);
+  return getEnv(value.getParentBlock()->getParentOp(), placement);
+}
+
+/// Returns the number of transfers of value, which is the number of
+/// environments other than its own it is used in.
+unsigned countTransfers(::mlir::Value value, const Placement &placement) {
+  auto defEnv = getDefEnv(value, placement);
+  llvm::SmallDenseSet<::mlir::Attribute> envs;
+  for (auto *user : value.getUsers()) {
+    auto env = getEnv(user, placement);
+    if (env != defEnv)
+      envs.insert(env);
+  }
+  return envs.size();
+}
+
+/// Returns the number of transfers of all arrays defined in root.
+unsigned countTransfers(::mlir::Operation *root) {
+  unsigned count = 0;
+  root->walk([&](::mlir::Block *block) {
+    for (auto arg : block->getArguments()) {
+      if (isArray(arg.getType()))
+        count += countTransfers(arg, {});
+    }
+    for (auto &op : *block) {
+      for (auto res : op.getResults()) {
+        if (isArray(res.getType()))
+          count += countTransfers(res, {});
+      }
+    }
+  });
+  return count;
+}
+
+/// Returns the number of transfers of the arrays op uses or defines if it is
+/// executed in env.
+unsigned countTransfers(::mlir::Operation *op, ::mlir::Attribute env) {
+  Placement placement{op, env};
+  llvm::SmallDenseSet<::mlir::Value> values;
+  unsigned count = 0;
+  for (auto value : op->getOperands()) {
+    if (isArray(value.getType()) && values.insert(value).second)
+      count += countTransfers(value, placement);
+  }
+  for (auto res : op->getResults()) {
+    if (isArray(res.getType()))
+      count += countTransfers(res, placement);
+  }
+  return count;
+}
+
+/// Returns true for the ops AddGPURegions puts into GPU env regions.
+bool isGPURegionOp(::mlir::Operation *op) {
+  return ::mlir::isa<
+      ::imex::ndarray::ToTensorOp, ::imex::ndarray::FromMemRefOp,
+      ::imex::ndarray::DeleteOp, ::imex::ndarray::DimOp,
+      ::imex::ndarray::SubviewOp, ::imex::ndarray::ExtractSliceOp,
+      ::imex::ndarray::InsertSliceOp, ::imex::ndarray::ImmutableInsertSliceOp,
+      ::imex::ndarray::LoadOp, ::imex::ndarray::CopyOp,
+      ::imex::ndarray::CastOp, ::imex::ndarray::CastElemTypeOp,
+      ::imex::ndarray::LinSpaceOp, ::imex::ndarray::CreateOp,
+      ::imex::ndarray::ReshapeOp, ::imex::ndarray::EWBinOp,
+      ::imex::ndarray::EWUnyOp, ::imex::ndarray::ReductionOp,
+      ::imex::ndarray::MatMulOp, ::imex::dist::InitDistArrayOp,
+      ::imex::dist::LocalOffsetsOfOp, ::imex::dist::PartsOfOp,
+      ::imex::dist::DefaultPartitionOp, ::imex::dist::LocalTargetOfSliceOp,
+      ::imex::dist::LocalBoundingBoxOp, ::imex::dist::LocalCoreOp,
+      ::imex::dist::RePartitionOp, ::imex::dist::SubviewOp,
+      ::imex::dist::EWBinOp, ::imex::dist::EWUnyOp>(op);
+}
+
+/// Host ops which AddGPURegions handles and which produce arrays can be moved
+/// into GPU env regions. Their NDArray results get the environment of the
+/// region, so all their users must be such ops as well.
+bool isPlaceable(::mlir::Operation *op) {
+  if (!isGPURegionOp(op) || llvm::none_of(op->getResultTypes(), isArray))
+    return false;
+  return llvm::all_of(op->getUsers(), isGPURegionOp);
+}
+
+/// Returns the result types of op executed in the GPU environment env.
+::mlir::SmallVector<::mlir::Type>
+getPlacedTypes(::mlir::Operation *op, ::imex::region::GPUEnvAttr env) {
+  ::mlir::SmallVector<::mlir::Type> types;
+  for (auto type : op->getResultTypes()) {
+    auto arType = type.dyn_cast<::imex::ndarray::NDArrayType>();
+    if (arType && !::imex::ndarray::getGPUEnv(arType))
+      type = arType.cloneWithEnv(env);
+    types.emplace_back(type);
+  }
+  return types;
+}
+
+/// Side-effect free scalar ops are cheap enough to be executed in any
+/// environment.
+bool isCheap(::mlir::Operation *op) {
+  return op->getNumRegions() == 0 &&
+         !op->hasTrait<::mlir::OpTrait::IsTerminator>() &&
+         ::mlir::isMemoryEffectFree(op) &&
+         llvm::none_of(op->getOperandTypes(), isArray) &&
+         llvm::none_of(op->getResultTypes(), isArray);
+}
+
+/// Wraps op into a new env region with the GPU environment env. The NDArray
+/// results of op get env, like the ones of ops AddGPURegions wraps.
+void wrapInRegion(::mlir::Operation *op, ::imex::region::GPUEnvAttr env) {
+  ::mlir::OpBuilder builder(op);
+  auto types = getPlacedTypes(op, env);
+  auto region = builder.create<EnvironmentRegionOp>(
+      op->getLoc(), env, std::nullopt, types,
+      [op, &types](::mlir::OpBuilder &b, ::mlir::Location loc) {
+        auto cOp = b.clone(*op);
+        for (auto [res, type] : llvm::zip(cOp->getResults(), types))
+          res.setType(type);
+        (void)b.create<EnvironmentRegionYieldOp>(loc, cOp->getResults());
+      });
+  op->replaceAllUsesWith(region.getResults());
+  op->erase();
+}
+
+/// Moves the placeable host ops into the GPU env region where they cause the
+/// fewest transfers, if that is less than on the host.
+void placeOps(::mlir::Operation *root) {
+  llvm::SmallVector<::mlir::Operation *> ops;
+  root->walk<::mlir::WalkOrder::PreOrder>(
+      [&](::mlir::Operation *op) -> ::mlir::WalkResult {
+        if (::mlir::isa<EnvironmentRegionOp>(op))
+          return ::mlir::WalkResult::skip();
+        if (op != root && isPlaceable(op))
+          ops.push_back(op);
+        return ::mlir::WalkResult::advance();
+      });
+
+  for (auto *op : ops) {
+    // candidates are the GPU environments of producers and consumers
+    llvm::SmallVector<::imex::region::GPUEnvAttr> envs;
+    auto addEnv = [&](::mlir::Attribute attr) {
+      auto env = ::mlir::dyn_cast_or_null<::imex::region::GPUEnvAttr>(attr);
+      if (env && !llvm::is_contained(envs, env))
+        envs.push_back(env);
+    };
+    for (auto value : op->getOperands()) {
+      if (isArray(value.getType()))
+        addEnv(getDefEnv(value, {}));
+    }
+    for (auto res : op->getResults()) {
+      for (auto *user : res.getUsers())
+        addEnv(getEnv(user, {}));
+    }
+
+    ::imex::region::GPUEnvAttr best;
+    auto bestCount = countTransfers(op, ::mlir::Attribute());
+    for (auto env : envs) {
+      auto count = countTransfers(op, env);
+      if (count < bestCount) {
+        best = env;
+        bestCount = count;
+      }
+    }
+    if (best)
+      wrapInRegion(op, best);
+  }
+}
+
+/// Appends values to the results yielded by op and replaces the uses of
+/// values outside of it. Returns the new env region.
+EnvironmentRegionOp appendResults(EnvironmentRegionOp op,
+                                  ::mlir::ValueRange values) {
+  auto count = op.getNumResults();
+  auto term = ::mlir::cast<EnvironmentRegionYieldOp>(
+      op.getRegion().front().getTerminator());
+  llvm::SmallVector<::mlir::Value> yieldArgs(term.getResults());
+  yieldArgs.append(values.begin(), values.end());
+
+  ::mlir::OpBuilder builder(term);
+  builder.create<EnvironmentRegionYieldOp>(term->getLoc(), yieldArgs);
+  term->erase();
+
+  builder.setInsertionPoint(op);
+  ::mlir::ValueRange yieldArgsRange(yieldArgs);
+  auto newOp = builder.create<EnvironmentRegionOp>(
+      op->getLoc(), yieldArgsRange.getTypes(), op.getEnvironment(),
+      op.getArgs());
+  newOp.getRegion().takeBody(op.getRegion());
+  auto newResults = newOp.getResults();
+  op->replaceAllUsesWith(newResults.take_front(count));
+  op->erase();
+  for (auto [value, res] : llvm::zip(values, newResults.drop_front(count))) {
+    value.replaceUsesWithIf(res, [&](::mlir::OpOperand &use) {
+      return !newOp->isAncestor(use.getOwner());
+    });
+  }
+  return newOp;
+}
+
+/// Moves the cheap ops between op and the next env region with the same
+/// environment and arguments into op, making both adjacent.
+void absorbCheapOps(EnvironmentRegionOp op) {
+  llvm::SmallVector<::mlir::Operation *> between;
+  EnvironmentRegionOp next;
+  for (auto it = std::next(op->getIterator()); it != op->getBlock()->end();
+       ++it) {
+    next = ::mlir::dyn_cast<EnvironmentRegionOp>(*it);
+    if (next || !isCheap(&*it))
+      break;
+    between.push_back(&*it);
+  }
+  if (!next || between.empty() ||
+      next.getEnvironment() != op.getEnvironment() ||
+      next.getArgs() != op.getArgs())
+    return;
+
+  auto term = op.getRegion().front().getTerminator();
+  llvm::SmallPtrSet<::mlir::Operation *, 8> moved(between.begin(),
+                                                   between.end());
+  for (auto [res, arg] : llvm::zip(op.getResults(), term->getOperands())) {
+    res.replaceUsesWithIf(arg, [&](::mlir::OpOperand &use) {
+      return moved.contains(use.getOwner());
+    });
+  }
+  llvm::SmallVector<::mlir::Value> values;
+  for (auto *cheapOp : between) {
+    cheapOp->moveBefore(term);
+    values.append(cheapOp->result_begin(), cheapOp->result_end());
+  }
+  // unused results are removed by the canonicalization of env regions
+  (void)appendResults(op, values);
+}
+
+struct RegionCoalescePass
+    : public ::imex::impl::RegionCoalesceBase<RegionCoalescePass> {
+  using ::imex::impl::RegionCoalesceBase<
+      RegionCoalescePass>::RegionCoalesceBase;
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    auto before = countTransfers(func);
+
+    placeOps(func);
+
+    llvm::SmallVector<EnvironmentRegionOp> regions;
+    func->walk([&](EnvironmentRegionOp op) { regions.push_back(op); });
+    for (auto op : regions)
+      absorbCheapOps(op);
+
+    // merge the now adjacent env regions, only the env regions are
+    // rewritten so the ops moved into them are not folded away
+    ::mlir::RewritePatternSet patterns(&getContext());
+    EnvironmentRegionOp::getCanonicalizationPatterns(patterns, &getContext());
+    llvm::SmallVector<::mlir::Operation *> ops;
+    func->walk([&](EnvironmentRegionOp op) { ops.push_back(op); });
+    ::mlir::GreedyRewriteConfig config;
+    config.strictMode = ::mlir::GreedyRewriteStrictness::ExistingAndNewOps;
+    (void)::mlir::applyOpPatternsAndFold(ops, std::move(patterns), config);
+
+    if (report)
+      func.emitRemark() << "env_region transfers before " << before
+                        << ", after " << countTransfers(func);
+  }
+};
+} // namespace
+
+std::unique_ptr<::mlir::Pass> imex::createRegionCoalescePass() {
+  return std::make_unique<RegionCoalescePass>();
+}
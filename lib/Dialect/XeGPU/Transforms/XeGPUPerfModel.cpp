@@ -0,0 +1,285 @@
+//===- XeGPUPerfModel.cpp - XeGPU analytical performance model --*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements an analytical performance model for XeGPU kernels.
+/// It counts memory messages, dpas ops and barriers of each kernel and
+/// combines them with the throughput table of the target uArch into a
+/// roofline-style time estimate that is reported as JSON.
+///
+//===----------------------------------------------------------------------===//
+
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Dialect/Utils/StaticValueUtils.h>
+#include <mlir/Interfaces/FunctionInterfaces.h>
+#include <mlir/Support/FileUtilities.h>
+
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/ToolOutputFile.h>
+
+#include "imex/Dialect/XeGPU/IR/XeGPU.h"
+#include "imex/Dialect/XeGPU/Transforms/Passes.h"
+#include "imex/Utils/XeArch.h"
+
+#include "PassDetail.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace imex {
+
+namespace {
+
+struct MessageStats {
+  int64_t count = 0;
+  int64_t bytes = 0;
+};
+
+/// Op counts of a single kernel, weighted by loop trip counts.
+struct KernelStats {
+  std::string name;
+  int64_t subgroups = 1;
+  bool dynamicTripCounts = false;
+  int64_t dpas = 0;
+  int64_t dpasFlops = 0;
+  int64_t dpasUsedRows = 0;
+  MessageStats load2d;
+  MessageStats store2d;
+  MessageStats prefetch2d;
+  MessageStats gather;
+  MessageStats scatter;
+  MessageStats atomic;
+  int64_t barriers = 0;
+};
+
+int64_t getTensorDescBytes(xegpu::TensorDescType tdescTy) {
+  return tdescTy.getNumElements() * tdescTy.getArrayLength() *
+         tdescTy.getElementTypeBitWidth() / 8;
+}
+
+/// Returns the product of the trip counts of all scf.for ops enclosing op
+/// within func. Loops with non-constant bounds count once.
+int64_t getTripCountWeight(mlir::Operation *op, mlir::Operation *func,
+                           bool &dynamicTripCounts) {
+  int64_t weight = 1;
+  for (auto *parent = op->getParentOp(); parent && parent != func;
+       parent = parent->getParentOp()) {
+    auto forOp = llvm::dyn_cast<mlir::scf::ForOp>(parent);
+    if (!forOp)
+      continue;
+    auto lb = mlir::getConstantIntValue(forOp.getLowerBound());
+    auto ub = mlir::getConstantIntValue(forOp.getUpperBound());
+    auto step = mlir::getConstantIntValue(forOp.getStep());
+    if (!lb || !ub || !step || *step <= 0) {
+      dynamicTripCounts = true;
+      continue;
+    }
+    weight *= std::max<int64_t>(0, (*ub - *lb + *step - 1) / *step);
+  }
+  return weight;
+}
+
+/// Returns the total number of subgroups launched for the given gpu.func, or
+/// 1 if there is no gpu.launch_func with a constant grid for it.
+int64_t getLaunchedSubgroups(mlir::ModuleOp mod, mlir::gpu::GPUFuncOp func) {
+  auto gpuMod = func->getParentOfType<mlir::gpu::GPUModuleOp>();
+  int64_t subgroups = 0;
+  mod.walk([&](mlir::gpu::LaunchFuncOp launch) {
+    if (!gpuMod || launch.getKernelModuleName() != gpuMod.getNameAttr() ||
+        launch.getKernelName() != func.getNameAttr())
+      return;
+    int64_t n = 1;
+    for (auto v : {launch.getGridSizeX(), launch.getGridSizeY(),
+                   launch.getGridSizeZ(), launch.getBlockSizeX(),
+                   launch.getBlockSizeY(), launch.getBlockSizeZ()}) {
+      auto c = mlir::getConstantIntValue(v);
+      n *= c ? *c : 1;
+    }
+    subgroups += n;
+  });
+  return subgroups ? subgroups : 1;
+}
+
+void writeMessageStats(llvm::json::OStream &J, llvm::StringRef key,
+                       const MessageStats &stats) {
+  J.attributeObject(key, [&] {
+    J.attribute("count", stats.count);
+    J.attribute("bytes", stats.bytes);
+  });
+}
+
+struct XeGPUPerfModelPass : public XeGPUPerfModelBase<XeGPUPerfModelPass> {
+  XeGPUPerfModelPass() = default;
+
+  void runOnOperation() override {
+    mlir::ModuleOp mod = getOperation();
+
+    if (device == "pvc")
+      uArchInterface = std::make_shared<XePVCuArch>();
+    if (!uArchInterface) {
+      mod.emitOpError("Can not get GPU Arch Definition for given Arch param");
+      return signalPassFailure();
+    }
+
+    llvm::SmallVector<KernelStats> kernels;
+    mod.walk([&](mlir::FunctionOpInterface func) {
+      KernelStats stats;
+      bool hasXeGPUOps = false;
+      func->walk([&](mlir::Operation *op) {
+        if (!llvm::isa<xegpu::XeGPUDialect>(op->getDialect()) &&
+            !llvm::isa<mlir::gpu::BarrierOp>(op))
+          return;
+        // barriers are counted, but do not make a function a kernel
+        hasXeGPUOps |= llvm::isa<xegpu::XeGPUDialect>(op->getDialect());
+        auto w = getTripCountWeight(op, func.getOperation(),
+                                    stats.dynamicTripCounts);
+        countOp(op, w, stats);
+      });
+      if (!hasXeGPUOps)
+        return;
+
+      stats.name = func.getName().str();
+      if (auto gpuFunc =
+              llvm::dyn_cast<mlir::gpu::GPUFuncOp>(func.getOperation())) {
+        if (auto gpuMod = gpuFunc->getParentOfType<mlir::gpu::GPUModuleOp>())
+          stats.name = (gpuMod.getName() + "::" + gpuFunc.getName()).str();
+        stats.subgroups = getLaunchedSubgroups(mod, gpuFunc);
+      }
+      kernels.push_back(stats);
+    });
+
+    std::string errorMessage;
+    auto output = mlir::openOutputFile(reportFile, &errorMessage);
+    if (!output) {
+      mod.emitError(errorMessage);
+      return signalPassFailure();
+    }
+    writeReport(output->os(), kernels, uArchInterface->getThroughput());
+    output->keep();
+
+    markAllAnalysesPreserved();
+  }
+
+private:
+  void countOp(mlir::Operation *op, int64_t w, KernelStats &stats) {
+    if (auto dpasOp = llvm::dyn_cast<xegpu::DpasOp>(op)) {
+      auto lhsTy = dpasOp.getLhsType();
+      auto rhsTy = dpasOp.getRhsType();
+      auto config = uArchInterface->getDPASConfig(
+          lhsTy.getElementTypeBitWidth(), rhsTy.getElementTypeBitWidth(), 0,
+          dpasOp.getResultType().getElementTypeBitWidth());
+      int64_t m = dpasOp.getResultType().getShape()[0];
+      stats.dpas += w;
+      stats.dpasUsedRows += w * m;
+      stats.dpasFlops += w * 2 * m * config.n * config.k;
+    } else if (auto loadOp = llvm::dyn_cast<xegpu::LoadNDOp>(op)) {
+      stats.load2d.count += w;
+      stats.load2d.bytes += w * getTensorDescBytes(loadOp.getTensorDescType());
+    } else if (auto storeOp = llvm::dyn_cast<xegpu::StoreNDOp>(op)) {
+      stats.store2d.count += w;
+      stats.store2d.bytes +=
+          w * getTensorDescBytes(storeOp.getTensorDescType());
+    } else if (auto prefetchOp = llvm::dyn_cast<xegpu::PrefetchNDOp>(op)) {
+      stats.prefetch2d.count += w;
+      stats.prefetch2d.bytes +=
+          w * getTensorDescBytes(prefetchOp.getTensorDescType());
+    } else if (auto gatherOp = llvm::dyn_cast<xegpu::LoadGatherOp>(op)) {
+      stats.gather.count += w;
+      stats.gather.bytes += w * getTensorDescBytes(gatherOp.getTensorDescType());
+    } else if (auto scatterOp = llvm::dyn_cast<xegpu::StoreScatterOp>(op)) {
+      stats.scatter.count += w;
+      stats.scatter.bytes +=
+          w * getTensorDescBytes(scatterOp.getTensorDescType());
+    } else if (auto atomicOp = llvm::dyn_cast<xegpu::AtomicRMWOp>(op)) {
+      auto tdescTy =
+          llvm::cast<xegpu::TensorDescType>(atomicOp.getTensorDesc().getType());
+      stats.atomic.count += w;
+      stats.atomic.bytes += w * getTensorDescBytes(tdescTy);
+    } else if (llvm::isa<xegpu::NbarrierWaitOp, mlir::gpu::BarrierOp>(op)) {
+      stats.barriers += w;
+    }
+  }
+
+  void writeReport(llvm::raw_ostream &os, llvm::ArrayRef<KernelStats> kernels,
+                   const XeuArchThroughput &hw) {
+    llvm::json::OStream J(os, 2);
+    J.object([&] {
+      J.attribute("device", std::string(device));
+      J.attributeArray("kernels", [&] {
+        for (auto &k : kernels)
+          J.object([&] { writeKernel(J, k, hw); });
+      });
+    });
+    os << "\n";
+  }
+
+  void writeKernel(llvm::json::OStream &J, const KernelStats &k,
+                   const XeuArchThroughput &hw) {
+    // Per-subgroup counts are scaled by the number of launched subgroups;
+    // compute and issue time are spread over the engines kept busy.
+    double n = static_cast<double>(k.subgroups);
+    double busyXVE = std::min<double>(n, hw.numXVE);
+    double cyclesPerUs = hw.frequency * 1e3;
+
+    double computeCycles = k.dpas * hw.dpasCycles;
+    double issueCycles = k.load2d.count * hw.load2dCycles +
+                         k.store2d.count * hw.store2dCycles +
+                         k.prefetch2d.count * hw.prefetch2dCycles +
+                         (k.gather.count + k.scatter.count) * hw.gatherCycles +
+                         k.atomic.count * hw.atomicCycles +
+                         k.barriers * hw.barrierCycles;
+    double computeUs = n * (computeCycles + issueCycles) / busyXVE / cyclesPerUs;
+
+    int64_t bytes = k.load2d.bytes + k.store2d.bytes + k.gather.bytes +
+                    k.scatter.bytes + 2 * k.atomic.bytes;
+    double memoryUs = n * bytes / (hw.memBandwidth * 1e3);
+    double utilization =
+        k.dpas ? static_cast<double>(k.dpasUsedRows) /
+                     (k.dpas * uArchInterface->getRepeatCount())
+               : 0.0;
+
+    J.attribute("name", k.name);
+    J.attribute("subgroups", k.subgroups);
+    J.attribute("dynamic_trip_counts", k.dynamicTripCounts);
+    J.attributeObject("dpas", [&] {
+      J.attribute("count", k.dpas * k.subgroups);
+      J.attribute("flops", k.dpasFlops * k.subgroups);
+      J.attribute("utilization", utilization);
+    });
+    auto scaled = [&](MessageStats s) {
+      s.count *= k.subgroups;
+      s.bytes *= k.subgroups;
+      return s;
+    };
+    writeMessageStats(J, "load_2d", scaled(k.load2d));
+    writeMessageStats(J, "store_2d", scaled(k.store2d));
+    writeMessageStats(J, "prefetch_2d", scaled(k.prefetch2d));
+    writeMessageStats(J, "gather", scaled(k.gather));
+    writeMessageStats(J, "scatter", scaled(k.scatter));
+    writeMessageStats(J, "atomic", scaled(k.atomic));
+    J.attribute("barriers", k.barriers * k.subgroups);
+    J.attribute("arithmetic_intensity",
+                bytes ? static_cast<double>(k.dpasFlops) / bytes : 0.0);
+    J.attribute("compute_us", computeUs);
+    J.attribute("memory_us", memoryUs);
+    J.attribute("estimated_us", std::max(computeUs, memoryUs));
+    J.attribute("bound", computeUs >= memoryUs ? "compute" : "memory");
+  }
+
+  std::shared_ptr<XeuArchInterface> uArchInterface = nullptr;
+};
+
+} // namespace
+
+std::unique_ptr<mlir::Pass> createXeGPUPerfModelPass() {
+  return std::make_unique<XeGPUPerfModelPass>();
+}
+
+} // namespace imex
@@ -82,6 +82,8 @@ parseOptionalAttrDict(mlir::OpAsmParser &parser, mlir::OperationState &result,
     if (nameId == "padding") {
       return parseAttributeHelper<mlir::Attribute>(parser, result, nameId);
     }
+    if (nameId == "cache_hint")
+      return parseAttributeHelper<mlir::Attribute>(parser, result, nameId);
 
     assert(0 && "Unreachable!");
   };
@@ -289,7 +291,7 @@ mlir::ParseResult LoadTileOp::parse(mlir::OpAsmParser &parser,
     return mlir::failure();
 
   // try to parse the optional dictionary attributes
-  if (parseOptionalAttrDict(parser, result, {"padding"}))
+  if (parseOptionalAttrDict(parser, result, {"padding", "cache_hint"}))
     return mlir::failure();
 
   if (parser.parseColon())
@@ -330,6 +332,8 @@ void LoadTileOp::print(mlir::OpAsmPrinter &printer) {
   printer << " { ";
   printer << "padding = ";
   printPaddingValue(getPaddingValueOrDefault(), printer);
+  if (auto cacheHint = getCacheHintAttr())
+    printer << ", cache_hint = " << cacheHint;
   printer << " } ";
   printer << " : ";
   printer << getSource().getType();
@@ -22,6 +22,7 @@
 #include <mlir/Dialect/GPU/IR/GPUDialect.h>
 #include <mlir/Dialect/Linalg/IR/Linalg.h>
 #include <mlir/Dialect/Linalg/Utils/Utils.h>
+#include <mlir/Dialect/Math/IR/Math.h>
 #include <mlir/Dialect/MemRef/IR/MemRef.h>
 #include <mlir/Dialect/SCF/IR/SCF.h>
 #include <mlir/IR/PatternMatch.h>
@@ -242,7 +243,8 @@ struct LoadTileOpPattern : public XeTileConversion<xetile::LoadTileOp> {
                                          resultTy.getElementType());
 
     auto newOp = rewriter.create<::imex::xetile::LoadTileOp>(
-        loc, vecTy, adaptor.getSource(), op.getPaddingAttr());
+        loc, vecTy, adaptor.getSource(), op.getPaddingAttr(),
+        op.getCacheHintAttr());
 
     rewriter.replaceOp(op, newOp);
     return mlir::success();
@@ -257,7 +259,8 @@ struct StoreTileOpPattern : public XeTileConversion<xetile::StoreTileOp> {
                   OpPatternRewriter &rewriter) const override {
 
     auto newOp = rewriter.create<::imex::xetile::StoreTileOp>(
-        op.getLoc(), adaptor.getValue(), adaptor.getTile());
+        op.getLoc(), adaptor.getValue(), adaptor.getTile(),
+        op.getCacheHintAttr());
     rewriter.replaceOp(op, newOp);
     return mlir::success();
   }
@@ -307,12 +310,102 @@ struct UpdateTileOffsetOpPattern
   }
 };
 
+// Elementwise ops consuming blocked vectors, e.g., the bias add, activation
+// and downcast applied to the result of tile_mma before it is stored. The op
+// is blocked like its blocked operands; 2D splat constant operands are
+// re-created in the same blocked layout.
+template <typename OpTy>
+struct ElementwiseOpPattern : public XeTileConversion<OpTy> {
+  using XeTileConversion<OpTy>::XeTileConversion;
+
+  ::mlir::LogicalResult
+  matchAndRewrite(OpTy op, typename XeTileConversion<OpTy>::OpAdaptor adaptor,
+                  OpPatternRewriter &rewriter) const override {
+    if (op->getNumResults() != 1)
+      return mlir::failure();
+    auto resultTy =
+        llvm::dyn_cast<mlir::VectorType>(op->getResult(0).getType());
+    if (!resultTy || resultTy.getRank() != 2)
+      return mlir::failure();
+
+    // the blocked layout is taken from the operands already blocked.
+    mlir::VectorType blockedTy;
+    for (auto operand : op->getOperands()) {
+      auto vecTy = llvm::dyn_cast<mlir::VectorType>(operand.getType());
+      if (vecTy && vecTy.getRank() == 4) {
+        blockedTy = vecTy;
+        break;
+      }
+    }
+    if (!blockedTy)
+      return mlir::failure();
+
+    auto shape = resultTy.getShape();
+    auto blockShape = blockedTy.getShape();
+    if (shape[0] != blockShape[0] * blockShape[2] ||
+        shape[1] != blockShape[1] * blockShape[3])
+      return mlir::failure();
+
+    auto blockedTyWith = [&](mlir::Type elemTy) {
+      return mlir::VectorType::get(blockShape, elemTy);
+    };
+
+    llvm::SmallVector<mlir::Value> operands;
+    for (auto operand : op->getOperands()) {
+      auto vecTy = llvm::dyn_cast<mlir::VectorType>(operand.getType());
+      if (!vecTy || vecTy.getRank() == 4) {
+        operands.push_back(operand);
+        continue;
+      }
+      mlir::DenseElementsAttr attr;
+      if (vecTy.getRank() != 2 ||
+          !mlir::matchPattern(operand, mlir::m_Constant(&attr)) ||
+          !attr.isSplat())
+        return mlir::failure();
+      auto newTy = blockedTyWith(vecTy.getElementType());
+      operands.push_back(rewriter.create<mlir::arith::ConstantOp>(
+          op.getLoc(), newTy,
+          mlir::DenseElementsAttr::get(newTy,
+                                       attr.getSplatValue<mlir::Attribute>())));
+    }
+
+    auto newOp = rewriter.create<OpTy>(
+        op.getLoc(),
+        mlir::TypeRange{blockedTyWith(resultTy.getElementType())}, operands,
+        op->getAttrs());
+    rewriter.replaceOp(op, newOp->getResults());
+    return mlir::success();
+  }
+};
+
 void populateXeTileTilingPatterns(imex::XeTypeConverter &converter,
                                   mlir::RewritePatternSet &patterns) {
 
   patterns.insert<ArithConstantOpPattern, SCFForOpPattern, InitTileOpPattern,
                   LoadTileOpPattern, StoreTileOpPattern, TileMMAOpPattern,
                   UpdateTileOffsetOpPattern>(patterns.getContext(), converter);
+  patterns.insert<ElementwiseOpPattern<mlir::arith::AddFOp>,
+                  ElementwiseOpPattern<mlir::arith::SubFOp>,
+                  ElementwiseOpPattern<mlir::arith::MulFOp>,
+                  ElementwiseOpPattern<mlir::arith::DivFOp>,
+                  ElementwiseOpPattern<mlir::arith::NegFOp>,
+                  ElementwiseOpPattern<mlir::arith::MaximumFOp>,
+                  ElementwiseOpPattern<mlir::arith::MinimumFOp>,
+                  ElementwiseOpPattern<mlir::arith::AddIOp>,
+                  ElementwiseOpPattern<mlir::arith::SubIOp>,
+                  ElementwiseOpPattern<mlir::arith::MulIOp>,
+                  ElementwiseOpPattern<mlir::arith::MaxSIOp>,
+                  ElementwiseOpPattern<mlir::arith::MinSIOp>,
+                  ElementwiseOpPattern<mlir::arith::TruncFOp>,
+                  ElementwiseOpPattern<mlir::arith::ExtFOp>,
+                  ElementwiseOpPattern<mlir::arith::SIToFPOp>,
+                  ElementwiseOpPattern<mlir::arith::FPToSIOp>,
+                  ElementwiseOpPattern<mlir::math::ExpOp>,
+                  ElementwiseOpPattern<mlir::math::TanhOp>,
+                  ElementwiseOpPattern<mlir::math::ErfOp>,
+                  ElementwiseOpPattern<mlir::math::SqrtOp>,
+                  ElementwiseOpPattern<mlir::math::AbsFOp>>(
+      patterns.getContext(), converter);
 }
 
 // Lowers XeTile to blocked layout with high-dim vector
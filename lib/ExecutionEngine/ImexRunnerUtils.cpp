@@ -233,4 +233,23 @@ extern "C" void _mlir_ciface_printAllcloseF32(UnrankedMemRefType<float> *M,
   }
 }
 
+/// Prints the op counts collected by convert-xegpu-to-cpu{profile=true} and
+/// resets them. The order matches the ProfileCounter slots of the pass.
+extern "C" void
+_mlir_ciface_printXeGPUProfile(UnrankedMemRefType<int64_t> *counters) {
+  static const char *names[] = {
+      "load_nd", "store_nd", "prefetch_nd", "dpas",       "update_nd_offset",
+      "load",    "store",    "prefetch",    "atomic_rmw", "barrier"};
+  constexpr int64_t numNames = sizeof(names) / sizeof(names[0]);
+  DynamicMemRefType<int64_t> DM = DynamicMemRefType<int64_t>(*counters);
+  int64_t i = 0;
+  std::cout << "xegpu-cpu profile:";
+  for (auto it = DM.begin(); it != DM.end(); ++it, ++i) {
+    if (i < numNames)
+      std::cout << (i ? ", " : " ") << names[i] << " " << *it;
+    *it = 0;
+  }
+  std::cout << "\n";
+}
+
 // NOLINTEND(*-identifier-naming)
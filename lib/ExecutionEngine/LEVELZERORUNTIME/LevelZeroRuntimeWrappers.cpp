@@ -20,10 +20,12 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -66,16 +68,31 @@ struct SpirvModule {
   ~SpirvModule();
 };
 
+struct SpirvKernel {
+  ze_kernel_handle_t kernel = nullptr;
+  ~SpirvKernel();
+};
+
 namespace {
 // Create a Map for the spirv module lookup
 std::map<const void *, SpirvModule> moduleCache;
+// Kernels are created once per module and name, so the kernels of repeated
+// launches compare equal when they are captured into a command graph.
+std::map<std::pair<ze_module_handle_t, std::string>, SpirvKernel> kernelCache;
 std::mutex mutexLock;
+// The group size and arguments are state of the shared kernel handles, they
+// are set and the launch appended under this lock.
+std::mutex launchLock;
 } // namespace
 
 SpirvModule::~SpirvModule() {
   CHECK_ZE_RESULT(zeModuleDestroy(SpirvModule::module));
 }
 
+SpirvKernel::~SpirvKernel() {
+  CHECK_ZE_RESULT(zeKernelDestroy(SpirvKernel::kernel));
+}
+
 struct ParamDesc {
   void *data;
   size_t size;
@@ -96,6 +113,44 @@ template <typename T> size_t countUntil(T *ptr, T &&elem) {
   return static_cast<size_t>(curr - ptr);
 }
 
+// The arguments of a kernel launch, without the shared local memory. They
+// are passed either as a null terminated ParamDesc array or packed: one blob
+// with the values of all arguments and its layout {count, offset_0, size_0,
+// offset_1, size_1, ...}, a constant the compiler emits once per kernel.
+class KernelParams {
+public:
+  KernelParams(ParamDesc *params, size_t sharedMemBytes) : params_(params) {
+    count_ = countUntil(params, ParamDesc{nullptr, 0});
+    // The shared local memory is the last param, if any.
+    if (sharedMemBytes)
+      count_ = count_ - 1;
+  }
+
+  KernelParams(void *blob, const int64_t *layout)
+      : blob_(static_cast<char *>(blob)), layout_(layout) {
+    assert(layout);
+    // Unlike the ParamDesc array, the layout leaves out the shared local
+    // memory.
+    count_ = static_cast<size_t>(layout[0]);
+  }
+
+  size_t size() const { return count_; }
+
+  ParamDesc operator[](size_t i) const {
+    assert(i < count_);
+    if (params_)
+      return params_[i];
+    return {blob_ + layout_[1 + 2 * i],
+            static_cast<size_t>(layout_[2 + 2 * i])};
+  }
+
+private:
+  ParamDesc *params_ = nullptr;
+  char *blob_ = nullptr;
+  const int64_t *layout_ = nullptr;
+  size_t count_ = 0;
+};
+
 static std::pair<ze_driver_handle_t, ze_device_handle_t>
 getDriverAndDevice(ze_device_type_t deviceType = ZE_DEVICE_TYPE_GPU) {
 
@@ -214,14 +269,265 @@ public:
   ~Event() { CHECK_ZE_RESULT(zeEventDestroy(zeEvent)); }
 };
 
+// An event signaled by the device and waited for by the host or by other
+// work on the device. Async tokens are lowered to these.
+class AsyncEventPool;
+struct AsyncEvent {
+  AsyncEventPool *pool = nullptr;
+  ze_event_handle_t zeEvent = nullptr;
+  // The number of events recorded on the queue before this one.
+  uint64_t seq = 0;
+};
+
+// The events of a queue. They are created kEventsPerPool at a time and reused
+// once released: a released event may still be waited on by work queued
+// before the release, it is reset and reused only after the host has
+// synchronized with an event recorded after the release.
+class AsyncEventPool {
+public:
+  AsyncEventPool(ze_context_handle_t zeContext, ze_device_handle_t zeDevice)
+      : zeContext_(zeContext), zeDevice_(zeDevice) {}
+
+  ~AsyncEventPool() {
+    for (auto &event : events_)
+      CHECK_ZE_RESULT(zeEventDestroy(event.zeEvent));
+    for (auto zeEventPool : zeEventPools_)
+      CHECK_ZE_RESULT(zeEventPoolDestroy(zeEventPool));
+  }
+
+  AsyncEvent *acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty())
+      grow();
+    auto event = free_.back();
+    free_.pop_back();
+    event->seq = recorded_++;
+    return event;
+  }
+
+  void release(AsyncEvent *event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    released_.emplace_back(event, recorded_);
+  }
+
+  // Reuses an event the host has waited for and nothing else waits on.
+  void reuse(AsyncEvent *event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK_ZE_RESULT(zeEventHostReset(event->zeEvent));
+    free_.push_back(event);
+  }
+
+  // The host has waited for the event, the work queued before it has
+  // completed and no longer waits on the events released before it was
+  // recorded.
+  void synchronized(AsyncEvent *event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = released_.begin();
+    while (it != released_.end()) {
+      if (it->second > event->seq) {
+        ++it;
+        continue;
+      }
+      CHECK_ZE_RESULT(zeEventHostReset(it->first->zeEvent));
+      free_.push_back(it->first);
+      it = released_.erase(it);
+    }
+  }
+
+private:
+  static constexpr uint32_t kEventsPerPool = 64;
+
+  void grow() {
+    ze_event_pool_desc_t poolDesc = {ZE_STRUCTURE_TYPE_EVENT_POOL_DESC,
+                                     nullptr, ZE_EVENT_POOL_FLAG_HOST_VISIBLE,
+                                     kEventsPerPool};
+    ze_event_pool_handle_t zeEventPool = nullptr;
+    CHECK_ZE_RESULT(
+        zeEventPoolCreate(zeContext_, &poolDesc, 1, &zeDevice_, &zeEventPool));
+    zeEventPools_.push_back(zeEventPool);
+    for (uint32_t i = 0; i < kEventsPerPool; ++i) {
+      ze_event_desc_t eventDesc = {ZE_STRUCTURE_TYPE_EVENT_DESC, nullptr, i,
+                                   ZE_EVENT_SCOPE_FLAG_HOST,
+                                   ZE_EVENT_SCOPE_FLAG_HOST};
+      auto &event = events_.emplace_back();
+      event.pool = this;
+      CHECK_ZE_RESULT(zeEventCreate(zeEventPool, &eventDesc, &event.zeEvent));
+      free_.push_back(&event);
+    }
+  }
+
+  ze_context_handle_t zeContext_;
+  ze_device_handle_t zeDevice_;
+  std::mutex mutex_;
+  std::vector<ze_event_pool_handle_t> zeEventPools_;
+  // Stable addresses, events are handed out by pointer.
+  std::deque<AsyncEvent> events_;
+  std::vector<AsyncEvent *> free_;
+  // The released events with the number of events recorded at the release.
+  std::vector<std::pair<AsyncEvent *, uint64_t>> released_;
+  uint64_t recorded_ = 0;
+};
+
+static uint32_t getComputeQueueOrdinal(ze_device_handle_t zeDevice_) {
+  uint32_t numQueueGroups = 0;
+  CHECK_ZE_RESULT(zeDeviceGetCommandQueueGroupProperties(
+      zeDevice_, &numQueueGroups, nullptr));
+
+  std::vector<ze_command_queue_group_properties_t> queueProperties(
+      numQueueGroups);
+  CHECK_ZE_RESULT(zeDeviceGetCommandQueueGroupProperties(
+      zeDevice_, &numQueueGroups, queueProperties.data()));
+
+  uint32_t ordinal = 0;
+  for (uint32_t i = 0; i < numQueueGroups; i++) {
+    if (queueProperties[i].flags &
+        ZE_COMMAND_QUEUE_GROUP_PROPERTY_FLAG_COMPUTE) {
+      ordinal = i;
+    }
+  }
+  return ordinal;
+}
+
+// The launches and copies of a capture site of a stream. They are encoded
+// into a regular command list which is executed with a single submission.
+// The graph keeps its own copy of the kernel arguments: every execution of
+// the site compares the launches queued by the host against the recorded
+// nodes, patches the nodes which changed (e.g. new buffer pointers) and
+// re-encodes the command list only if any did.
+struct CommandGraph {
+  struct Node {
+    // Null for copies.
+    ze_kernel_handle_t kernel = nullptr;
+    ze_group_count_t groupCount = {};
+    std::array<uint32_t, 3> groupSize = {};
+    size_t sharedMemBytes = 0;
+    std::vector<std::vector<char>> args;
+    void *dst = nullptr;
+    const void *src = nullptr;
+    size_t size = 0;
+
+    bool operator==(const Node &rhs) const {
+      return kernel == rhs.kernel &&
+             groupCount.groupCountX == rhs.groupCount.groupCountX &&
+             groupCount.groupCountY == rhs.groupCount.groupCountY &&
+             groupCount.groupCountZ == rhs.groupCount.groupCountZ &&
+             groupSize == rhs.groupSize &&
+             sharedMemBytes == rhs.sharedMemBytes && args == rhs.args &&
+             dst == rhs.dst && src == rhs.src && size == rhs.size;
+    }
+  };
+
+  ze_command_queue_handle_t zeCommandQueue_ = nullptr;
+  ze_command_list_handle_t zeCommandList_ = nullptr;
+  std::vector<Node> nodes;
+  // Index of the next node to compare against during an execution.
+  size_t cursor = 0;
+  // Set if the command list does not match the nodes.
+  bool stale = true;
+
+  CommandGraph(ze_context_handle_t zeContext_, ze_device_handle_t zeDevice_) {
+    auto ordinal = getComputeQueueOrdinal(zeDevice_);
+    ze_command_queue_desc_t queueDesc = {};
+    queueDesc.stype = ZE_STRUCTURE_TYPE_COMMAND_QUEUE_DESC;
+    queueDesc.ordinal = ordinal;
+    queueDesc.mode = ZE_COMMAND_QUEUE_MODE_ASYNCHRONOUS;
+    CHECK_ZE_RESULT(zeCommandQueueCreate(zeContext_, zeDevice_, &queueDesc,
+                                         &zeCommandQueue_));
+    ze_command_list_desc_t listDesc = {};
+    listDesc.stype = ZE_STRUCTURE_TYPE_COMMAND_LIST_DESC;
+    listDesc.commandQueueGroupOrdinal = ordinal;
+    CHECK_ZE_RESULT(zeCommandListCreate(zeContext_, zeDevice_, &listDesc,
+                                        &zeCommandList_));
+  }
+
+  // Records the next launch or copy of the current execution.
+  void add(Node &&node) {
+    if (cursor < nodes.size() && nodes[cursor] == node) {
+      ++cursor;
+      return;
+    }
+    // The queued work diverges from the graph from here on: drop the rest,
+    // it is recorded again by the following launches.
+    nodes.resize(cursor);
+    nodes.push_back(std::move(node));
+    ++cursor;
+    stale = true;
+  }
+
+  void encode() {
+    CHECK_ZE_RESULT(zeCommandListReset(zeCommandList_));
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      auto &node = nodes[i];
+      // Work on a regular command list may overlap, the nodes are executed
+      // in order as they were on the stream.
+      if (i)
+        CHECK_ZE_RESULT(
+            zeCommandListAppendBarrier(zeCommandList_, nullptr, 0, nullptr));
+      if (!node.kernel) {
+        CHECK_ZE_RESULT(zeCommandListAppendMemoryCopy(
+            zeCommandList_, node.dst, node.src, node.size, nullptr, 0,
+            nullptr));
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(launchLock);
+      CHECK_ZE_RESULT(zeKernelSetGroupSize(node.kernel, node.groupSize[0],
+                                           node.groupSize[1],
+                                           node.groupSize[2]));
+      uint32_t argIndex = 0;
+      for (auto &arg : node.args)
+        CHECK_ZE_RESULT(zeKernelSetArgumentValue(node.kernel, argIndex++,
+                                                 arg.size(), arg.data()));
+      if (node.sharedMemBytes)
+        CHECK_ZE_RESULT(zeKernelSetArgumentValue(
+            node.kernel, argIndex, node.sharedMemBytes, nullptr));
+      CHECK_ZE_RESULT(zeCommandListAppendLaunchKernel(
+          zeCommandList_, node.kernel, &node.groupCount, nullptr, 0,
+          nullptr));
+    }
+    CHECK_ZE_RESULT(zeCommandListClose(zeCommandList_));
+    stale = false;
+  }
+
+  // Executes the graph, patched with the work queued by the current
+  // execution, and waits for it.
+  void execute() {
+    if (cursor != nodes.size()) {
+      nodes.resize(cursor);
+      stale = true;
+    }
+    cursor = 0;
+    if (nodes.empty())
+      return;
+    if (stale)
+      encode();
+    CHECK_ZE_RESULT(zeCommandQueueExecuteCommandLists(
+        zeCommandQueue_, 1, &zeCommandList_, nullptr));
+    CHECK_ZE_RESULT(zeCommandQueueSynchronize(zeCommandQueue_, UINT64_MAX));
+  }
+
+  ~CommandGraph() {
+    CHECK_ZE_RESULT(zeCommandListDestroy(zeCommandList_));
+    CHECK_ZE_RESULT(zeCommandQueueDestroy(zeCommandQueue_));
+  }
+};
+
 struct GPUL0QUEUE {
 
   ze_driver_handle_t zeDriver_ = nullptr;
   ze_device_handle_t zeDevice_ = nullptr;
   ze_context_handle_t zeContext_ = nullptr;
   ze_command_list_handle_t zeCommandList_ = nullptr;
-
-  GPUL0QUEUE() {
+  // Async queues return from appends before the work completes, the work is
+  // ordered with the host through events only.
+  bool async_ = false;
+  // The command graphs of the capture sites executed on this queue and the
+  // one currently capturing the launches and copies, if any.
+  std::map<const void *, std::unique_ptr<CommandGraph>> graphs_;
+  CommandGraph *capture_ = nullptr;
+  // The events recorded on this queue, created with the first one.
+  std::unique_ptr<AsyncEventPool> events_;
+
+  GPUL0QUEUE(bool async = false) : async_(async) {
     auto driverAndDevice = getDriverAndDevice();
     zeDriver_ = driverAndDevice.first;
     zeDevice_ = driverAndDevice.second;
@@ -240,7 +546,8 @@ struct GPUL0QUEUE {
         zeDevice_, &numQueueGroups, queueProperties.data()));
 
     ze_command_queue_desc_t desc = {};
-    desc.mode = ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
+    desc.mode = async ? ZE_COMMAND_QUEUE_MODE_ASYNCHRONOUS
+                      : ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
     for (uint32_t i = 0; i < numQueueGroups; i++) {
       if (queueProperties[i].flags &
           ZE_COMMAND_QUEUE_GROUP_PROPERTY_FLAG_COMPUTE) {
@@ -251,7 +558,9 @@ struct GPUL0QUEUE {
                                                  &zeCommandList_));
   }
 
-  GPUL0QUEUE(ze_device_type_t *deviceType, ze_context_handle_t context) {
+  GPUL0QUEUE(ze_device_type_t *deviceType, ze_context_handle_t context,
+             bool async = false)
+      : async_(async) {
     auto driverAndDevice = getDriverAndDevice(*deviceType);
     zeDriver_ = driverAndDevice.first;
     zeDevice_ = driverAndDevice.second;
@@ -268,7 +577,8 @@ struct GPUL0QUEUE {
         zeDevice_, &numQueueGroups, queueProperties.data()));
 
     ze_command_queue_desc_t desc = {};
-    desc.mode = ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
+    desc.mode = async ? ZE_COMMAND_QUEUE_MODE_ASYNCHRONOUS
+                      : ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
     for (uint32_t i = 0; i < numQueueGroups; i++) {
       if (queueProperties[i].flags &
           ZE_COMMAND_QUEUE_GROUP_PROPERTY_FLAG_COMPUTE) {
@@ -279,7 +589,8 @@ struct GPUL0QUEUE {
                                                  &zeCommandList_));
   }
 
-  GPUL0QUEUE(ze_device_type_t *deviceType) {
+  GPUL0QUEUE(ze_device_type_t *deviceType, bool async = false)
+      : async_(async) {
 
     auto driverAndDevice = getDriverAndDevice(*deviceType);
     zeDriver_ = driverAndDevice.first;
@@ -299,7 +610,8 @@ struct GPUL0QUEUE {
         zeDevice_, &numQueueGroups, queueProperties.data()));
 
     ze_command_queue_desc_t desc = {};
-    desc.mode = ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
+    desc.mode = async ? ZE_COMMAND_QUEUE_MODE_ASYNCHRONOUS
+                      : ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
     for (uint32_t i = 0; i < numQueueGroups; i++) {
       if (queueProperties[i].flags &
           ZE_COMMAND_QUEUE_GROUP_PROPERTY_FLAG_COMPUTE) {
@@ -310,7 +622,8 @@ struct GPUL0QUEUE {
                                                  &zeCommandList_));
   }
 
-  GPUL0QUEUE(ze_context_handle_t context) {
+  GPUL0QUEUE(ze_context_handle_t context, bool async = false)
+      : async_(async) {
 
     auto driverAndDevice = getDriverAndDevice();
     zeDriver_ = driverAndDevice.first;
@@ -327,7 +640,8 @@ struct GPUL0QUEUE {
         zeDevice_, &numQueueGroups, queueProperties.data()));
 
     ze_command_queue_desc_t desc = {};
-    desc.mode = ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
+    desc.mode = async ? ZE_COMMAND_QUEUE_MODE_ASYNCHRONOUS
+                      : ZE_COMMAND_QUEUE_MODE_SYNCHRONOUS;
     for (uint32_t i = 0; i < numQueueGroups; i++) {
       if (queueProperties[i].flags &
           ZE_COMMAND_QUEUE_GROUP_PROPERTY_FLAG_COMPUTE) {
@@ -342,6 +656,8 @@ struct GPUL0QUEUE {
     // Device and Driver resource management is dony by L0.
     // Just release context and commandList.
     // TODO: Use unique ptrs.
+    graphs_.clear();
+    events_.reset();
     if (zeContext_)
       CHECK_ZE_RESULT(zeContextDestroy(zeContext_));
 
@@ -410,25 +726,28 @@ static ze_kernel_handle_t
 getKernel(GPUL0QUEUE *queue, ze_module_handle_t module, const char *name) {
   assert(module);
   assert(name);
+  std::lock_guard<std::mutex> entryLock(mutexLock);
+  auto &cached = kernelCache[{module, name}];
+  if (cached.kernel)
+    return cached.kernel;
+
   ze_kernel_desc_t desc = {};
   ze_kernel_handle_t zeKernel;
   desc.pKernelName = name;
   CHECK_ZE_RESULT(zeKernelCreate(module, &desc, &zeKernel));
+  cached.kernel = zeKernel;
   return zeKernel;
 }
 
 static void enqueueKernel(ze_command_list_handle_t zeCommandList,
                           ze_kernel_handle_t kernel,
                           const ze_group_count_t *pLaunchArgs,
-                          ParamDesc *params, size_t sharedMemBytes,
+                          const KernelParams &params,
+                          size_t sharedMemBytes,
                           ze_event_handle_t waitEvent = nullptr,
                           uint32_t numWaitEvents = 0,
                           ze_event_handle_t *phWaitEvents = nullptr) {
-  auto paramsCount = countUntil(params, ParamDesc{nullptr, 0});
-
-  if (sharedMemBytes) {
-    paramsCount = paramsCount - 1;
-  }
+  auto paramsCount = params.size();
 
   for (size_t i = 0; i < paramsCount; ++i) {
     auto param = params[i];
@@ -446,17 +765,46 @@ static void enqueueKernel(ze_command_list_handle_t zeCommandList,
                                                   numWaitEvents, phWaitEvents));
 }
 
+static void captureKernel(CommandGraph *graph, ze_kernel_handle_t kernel,
+                          const ze_group_count_t &groupCount,
+                          std::array<uint32_t, 3> groupSize,
+                          size_t sharedMemBytes,
+                          const KernelParams &params) {
+  auto paramsCount = params.size();
+
+  CommandGraph::Node node;
+  node.kernel = kernel;
+  node.groupCount = groupCount;
+  node.groupSize = groupSize;
+  node.sharedMemBytes = sharedMemBytes;
+  for (size_t i = 0; i < paramsCount; ++i) {
+    auto data = static_cast<const char *>(params[i].data);
+    node.args.emplace_back(data, data + params[i].size);
+  }
+  graph->add(std::move(node));
+}
+
 static void launchKernel(GPUL0QUEUE *queue, ze_kernel_handle_t kernel,
                          size_t gridX, size_t gridY, size_t gridZ,
                          size_t blockX, size_t blockY, size_t blockZ,
-                         size_t sharedMemBytes, ParamDesc *params) {
+                         size_t sharedMemBytes,
+                         const KernelParams &params) {
   assert(kernel);
 
   auto castSz = [](size_t val) { return static_cast<uint32_t>(val); };
 
+  ze_group_count_t launchArgs = {castSz(gridX), castSz(gridY), castSz(gridZ)};
+
+  if (queue->capture_) {
+    captureKernel(queue->capture_, kernel, launchArgs,
+                  {castSz(blockX), castSz(blockY), castSz(blockZ)},
+                  sharedMemBytes, params);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(launchLock);
   CHECK_ZE_RESULT(zeKernelSetGroupSize(kernel, castSz(blockX), castSz(blockY),
                                        castSz(blockZ)));
-  ze_group_count_t launchArgs = {castSz(gridX), castSz(gridY), castSz(gridZ)};
 
   if (getenv("IMEX_ENABLE_PROFILING")) {
     auto executionTime = 0.0f;
@@ -487,6 +835,8 @@ static void launchKernel(GPUL0QUEUE *queue, ze_kernel_handle_t kernel,
       Event event(queue->zeContext_, queue->zeDevice_);
       enqueueKernel(queue->zeCommandList_, kernel, &launchArgs, params,
                     sharedMemBytes, event.zeEvent, 0, nullptr);
+      if (queue->async_)
+        CHECK_ZE_RESULT(zeEventHostSynchronize(event.zeEvent, UINT64_MAX));
 
       auto startTime =
           event.get_profiling_info<imex::profiling::command_start>();
@@ -508,23 +858,52 @@ static void launchKernel(GPUL0QUEUE *queue, ze_kernel_handle_t kernel,
   }
 }
 
+static GPUL0QUEUE *createQueue(void *device, void *context, bool async) {
+  if (!device && !context) {
+    return new GPUL0QUEUE(async);
+  } else if (device && context) {
+    // TODO: Check if the pointers/address is valid and holds the correct
+    // device and context
+    return new GPUL0QUEUE(static_cast<ze_device_type_t *>(device),
+                          static_cast<ze_context_handle_t>(context), async);
+  } else if (device && !context) {
+    return new GPUL0QUEUE(static_cast<ze_device_type_t *>(device), async);
+  } else {
+    return new GPUL0QUEUE(static_cast<ze_context_handle_t>(context), async);
+  }
+}
+
+static AsyncEvent *recordEvent(GPUL0QUEUE *queue) {
+  if (!queue->events_)
+    queue->events_ = std::make_unique<AsyncEventPool>(queue->zeContext_,
+                                                      queue->zeDevice_);
+  auto event = queue->events_->acquire();
+  CHECK_ZE_RESULT(zeCommandListAppendBarrier(queue->zeCommandList_,
+                                             event->zeEvent, 0, nullptr));
+  return event;
+}
+
+static void synchronizeEvent(AsyncEvent *event) {
+  CHECK_ZE_RESULT(zeEventHostSynchronize(event->zeEvent, UINT64_MAX));
+  event->pool->synchronized(event);
+}
+
+// Blocks the host until the work queued on the queue so far has completed.
+static void synchronizeQueue(GPUL0QUEUE *queue) {
+  auto event = recordEvent(queue);
+  synchronizeEvent(event);
+  event->pool->reuse(event);
+}
+
 // Wrappers
 extern "C" LEVEL_ZERO_RUNTIME_EXPORT GPUL0QUEUE *
 gpuCreateStream(void *device, void *context) {
-  return catchAll([&]() {
-    if (!device && !context) {
-      return new GPUL0QUEUE();
-    } else if (device && context) {
-      // TODO: Check if the pointers/address is valid and holds the correct
-      // device and context
-      return new GPUL0QUEUE(static_cast<ze_device_type_t *>(device),
-                            static_cast<ze_context_handle_t>(context));
-    } else if (device && !context) {
-      return new GPUL0QUEUE(static_cast<ze_device_type_t *>(device));
-    } else {
-      return new GPUL0QUEUE(static_cast<ze_context_handle_t>(context));
-    }
-  });
+  return catchAll([&]() { return createQueue(device, context, false); });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT GPUL0QUEUE *
+gpuCreateAsyncStream(void *device, void *context) {
+  return catchAll([&]() { return createQueue(device, context, true); });
 }
 
 extern "C" LEVEL_ZERO_RUNTIME_EXPORT void gpuStreamDestroy(GPUL0QUEUE *queue) {
@@ -556,15 +935,97 @@ extern "C" LEVEL_ZERO_RUNTIME_EXPORT void
 gpuLaunchKernel(GPUL0QUEUE *queue, ze_kernel_handle_t kernel, size_t gridX,
                 size_t gridY, size_t gridZ, size_t blockX, size_t blockY,
                 size_t blockZ, size_t sharedMemBytes, void *params) {
+  return catchAll([&]() {
+    KernelParams kernelParams(static_cast<ParamDesc *>(params),
+                              sharedMemBytes);
+    launchKernel(queue, kernel, gridX, gridY, gridZ, blockX, blockY, blockZ,
+                 sharedMemBytes, kernelParams);
+  });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT void
+gpuLaunchKernelPacked(GPUL0QUEUE *queue, ze_kernel_handle_t kernel,
+                      size_t gridX, size_t gridY, size_t gridZ, size_t blockX,
+                      size_t blockY, size_t blockZ, size_t sharedMemBytes,
+                      void *blob, const int64_t *layout) {
   return catchAll([&]() {
     launchKernel(queue, kernel, gridX, gridY, gridZ, blockX, blockY, blockZ,
-                 sharedMemBytes, static_cast<ParamDesc *>(params));
+                 sharedMemBytes, KernelParams(blob, layout));
   });
 }
 
 extern "C" LEVEL_ZERO_RUNTIME_EXPORT void gpuWait(GPUL0QUEUE *queue) {
   catchAll([&]() {
-    // TODO: Find out ze Wait for host.
-    return;
+    // Work on synchronous queues has completed when it was appended, captured
+    // work is waited for by gpuCaptureEnd.
+    if (!queue->async_ || queue->capture_)
+      return;
+    synchronizeQueue(queue);
+  });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT void
+gpuMemcpy(GPUL0QUEUE *queue, void *dst, const void *src, size_t size) {
+  catchAll([&]() {
+    if (queue->capture_) {
+      CommandGraph::Node node;
+      node.dst = dst;
+      node.src = src;
+      node.size = size;
+      queue->capture_->add(std::move(node));
+      return;
+    }
+    CHECK_ZE_RESULT(zeCommandListAppendMemoryCopy(queue->zeCommandList_, dst,
+                                                  src, size, nullptr, 0,
+                                                  nullptr));
+  });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT void gpuCaptureBegin(GPUL0QUEUE *queue,
+                                                          const void *site) {
+  catchAll([&]() {
+    if (queue->capture_)
+      throw std::runtime_error("gpuCaptureBegin: capture already active");
+    auto &graph = queue->graphs_[site];
+    if (!graph)
+      graph = std::make_unique<CommandGraph>(queue->zeContext_,
+                                             queue->zeDevice_);
+    queue->capture_ = graph.get();
   });
 }
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT void gpuCaptureEnd(GPUL0QUEUE *queue) {
+  catchAll([&]() {
+    auto graph = queue->capture_;
+    if (!graph)
+      throw std::runtime_error("gpuCaptureEnd: no active capture");
+    queue->capture_ = nullptr;
+    // The graph runs on its own command queue, work queued on the stream
+    // before the capture has to complete first.
+    if (queue->async_)
+      synchronizeQueue(queue);
+    graph->execute();
+  });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT AsyncEvent *
+gpuEventRecord(GPUL0QUEUE *queue) {
+  return catchAll([&]() { return recordEvent(queue); });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT void
+gpuStreamWaitEvent(GPUL0QUEUE *queue, AsyncEvent *event) {
+  catchAll([&]() {
+    CHECK_ZE_RESULT(zeCommandListAppendWaitOnEvents(queue->zeCommandList_, 1,
+                                                    &event->zeEvent));
+  });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT void
+gpuEventSynchronize(AsyncEvent *event) {
+  catchAll([&]() { synchronizeEvent(event); });
+}
+
+extern "C" LEVEL_ZERO_RUNTIME_EXPORT void gpuEventDestroy(AsyncEvent *event) {
+  catchAll([&]() { event->pool->release(event); });
+}
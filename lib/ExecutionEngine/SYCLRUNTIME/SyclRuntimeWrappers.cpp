@@ -99,6 +99,44 @@ template <typename T> size_t countUntil(T *ptr, T &&elem) {
   return static_cast<size_t>(curr - ptr);
 }
 
+// The arguments of a kernel launch, without the shared local memory. They
+// are passed either as a null terminated ParamDesc array or packed: one blob
+// with the values of all arguments and its layout {count, offset_0, size_0,
+// offset_1, size_1, ...}, a constant the compiler emits once per kernel.
+class KernelParams {
+public:
+  KernelParams(ParamDesc *params, size_t sharedMemBytes) : params_(params) {
+    count_ = countUntil(params, ParamDesc{nullptr, 0});
+    // The shared local memory is the last param, if any.
+    if (sharedMemBytes)
+      count_ = count_ - 1;
+  }
+
+  KernelParams(void *blob, const int64_t *layout)
+      : blob_(static_cast<char *>(blob)), layout_(layout) {
+    assert(layout);
+    // Unlike the ParamDesc array, the layout leaves out the shared local
+    // memory.
+    count_ = static_cast<size_t>(layout[0]);
+  }
+
+  size_t size() const { return count_; }
+
+  ParamDesc operator[](size_t i) const {
+    assert(i < count_);
+    if (params_)
+      return params_[i];
+    return {blob_ + layout_[1 + 2 * i],
+            static_cast<size_t>(layout_[2 + 2 * i])};
+  }
+
+private:
+  ParamDesc *params_ = nullptr;
+  char *blob_ = nullptr;
+  const int64_t *layout_ = nullptr;
+  size_t count_ = 0;
+};
+
 static sycl::device getDefaultDevice() {
   auto platformList = sycl::platform::get_platforms();
   for (const auto &platform : platformList) {
@@ -255,14 +293,10 @@ static sycl::kernel *getKernel(GPUSYCLQUEUE *queue, ze_module_handle_t zeModule,
 }
 
 static sycl::event enqueueKernel(sycl::queue queue, sycl::kernel *kernel,
-                                 sycl::nd_range<3> NdRange, ParamDesc *params,
+                                 sycl::nd_range<3> NdRange,
+                                 const KernelParams &params,
                                  size_t sharedMemBytes) {
-  auto paramsCount = countUntil(params, ParamDesc{nullptr, 0});
-  // The assumption is, if there is a param for the shared local memory,
-  // then that will always be the last argument.
-  if (sharedMemBytes) {
-    paramsCount = paramsCount - 1;
-  }
+  auto paramsCount = params.size();
   sycl::event event = queue.submit([&](sycl::handler &cgh) {
     for (size_t i = 0; i < paramsCount; i++) {
       auto param = params[i];
@@ -288,7 +322,8 @@ static sycl::event enqueueKernel(sycl::queue queue, sycl::kernel *kernel,
 static void launchKernel(GPUSYCLQUEUE *queue, sycl::kernel *kernel,
                          size_t gridX, size_t gridY, size_t gridZ,
                          size_t blockX, size_t blockY, size_t blockZ,
-                         size_t sharedMemBytes, ParamDesc *params) {
+                         size_t sharedMemBytes,
+                         const KernelParams &params) {
   auto syclQueue = queue->syclQueue_;
   auto syclGlobalRange =
       ::sycl::range<3>(blockZ * gridZ, blockY * gridY, blockX * gridX);
@@ -348,28 +383,36 @@ static void launchKernel(GPUSYCLQUEUE *queue, sycl::kernel *kernel,
   }
 }
 
-// Wrappers
-
-extern "C" SYCL_RUNTIME_EXPORT GPUSYCLQUEUE *gpuCreateStream(void *device,
-                                                             void *context) {
+static GPUSYCLQUEUE *createQueue(void *device, void *context) {
   auto propList = sycl::property_list{};
   if (getenv("IMEX_ENABLE_PROFILING")) {
     propList = sycl::property_list{sycl::property::queue::enable_profiling()};
   }
-  return catchAll([&]() {
-    if (!device && !context) {
-      return new GPUSYCLQUEUE(propList);
-    } else if (device && context) {
-      // TODO: Check if the pointers/address is valid and holds the correct
-      // device and context
-      return new GPUSYCLQUEUE(static_cast<sycl::device *>(device),
-                              static_cast<sycl::context *>(context), propList);
-    } else if (device && !context) {
-      return new GPUSYCLQUEUE(static_cast<sycl::device *>(device), propList);
-    } else {
-      return new GPUSYCLQUEUE(static_cast<sycl::context *>(context), propList);
-    }
-  });
+  if (!device && !context) {
+    return new GPUSYCLQUEUE(propList);
+  } else if (device && context) {
+    // TODO: Check if the pointers/address is valid and holds the correct
+    // device and context
+    return new GPUSYCLQUEUE(static_cast<sycl::device *>(device),
+                            static_cast<sycl::context *>(context), propList);
+  } else if (device && !context) {
+    return new GPUSYCLQUEUE(static_cast<sycl::device *>(device), propList);
+  } else {
+    return new GPUSYCLQUEUE(static_cast<sycl::context *>(context), propList);
+  }
+}
+
+// Wrappers
+
+extern "C" SYCL_RUNTIME_EXPORT GPUSYCLQUEUE *gpuCreateStream(void *device,
+                                                             void *context) {
+  return catchAll([&]() { return createQueue(device, context); });
+}
+
+// SYCL queues already run asynchronously to the host.
+extern "C" SYCL_RUNTIME_EXPORT GPUSYCLQUEUE *
+gpuCreateAsyncStream(void *device, void *context) {
+  return catchAll([&]() { return createQueue(device, context); });
 }
 
 extern "C" SYCL_RUNTIME_EXPORT void gpuStreamDestroy(GPUSYCLQUEUE *queue) {
@@ -417,8 +460,23 @@ gpuLaunchKernel(GPUSYCLQUEUE *queue, sycl::kernel *kernel, size_t gridX,
                 size_t blockZ, size_t sharedMemBytes, void *params) {
   return catchAll([&]() {
     if (queue) {
+      KernelParams kernelParams(static_cast<ParamDesc *>(params),
+                                sharedMemBytes);
       launchKernel(queue, kernel, gridX, gridY, gridZ, blockX, blockY, blockZ,
-                   sharedMemBytes, static_cast<ParamDesc *>(params));
+                   sharedMemBytes, kernelParams);
+    }
+  });
+}
+
+extern "C" SYCL_RUNTIME_EXPORT void
+gpuLaunchKernelPacked(GPUSYCLQUEUE *queue, sycl::kernel *kernel, size_t gridX,
+                      size_t gridY, size_t gridZ, size_t blockX, size_t blockY,
+                      size_t blockZ, size_t sharedMemBytes, void *blob,
+                      const int64_t *layout) {
+  return catchAll([&]() {
+    if (queue) {
+      launchKernel(queue, kernel, gridX, gridY, gridZ, blockX, blockY, blockZ,
+                   sharedMemBytes, KernelParams(blob, layout));
     }
   });
 }
@@ -431,3 +489,43 @@ extern "C" SYCL_RUNTIME_EXPORT void gpuWait(GPUSYCLQUEUE *queue) {
     }
   });
 }
+
+extern "C" SYCL_RUNTIME_EXPORT void gpuMemcpy(GPUSYCLQUEUE *queue, void *dst,
+                                              const void *src, size_t size) {
+  catchAll([&]() {
+    if (queue) {
+      queue->syclQueue_.memcpy(dst, src, size);
+    }
+  });
+}
+
+// Async tokens are lowered to sycl events. The queue is out of order, so
+// events are recorded and waited for through barriers.
+extern "C" SYCL_RUNTIME_EXPORT sycl::event *
+gpuEventRecord(GPUSYCLQUEUE *queue) {
+  return catchAll([&]() {
+    return new sycl::event(queue->syclQueue_.ext_oneapi_submit_barrier());
+  });
+}
+
+extern "C" SYCL_RUNTIME_EXPORT void gpuStreamWaitEvent(GPUSYCLQUEUE *queue,
+                                                       sycl::event *event) {
+  catchAll([&]() { queue->syclQueue_.ext_oneapi_submit_barrier({*event}); });
+}
+
+extern "C" SYCL_RUNTIME_EXPORT void gpuEventSynchronize(sycl::event *event) {
+  catchAll([&]() { event->wait(); });
+}
+
+extern "C" SYCL_RUNTIME_EXPORT void gpuEventDestroy(sycl::event *event) {
+  catchAll([&]() { delete event; });
+}
+
+// Command graphs are not available on every SYCL implementation, captured
+// launches and copies are executed as they are queued.
+extern "C" SYCL_RUNTIME_EXPORT void gpuCaptureBegin(GPUSYCLQUEUE *queue,
+                                                    const void *site) {}
+
+extern "C" SYCL_RUNTIME_EXPORT void gpuCaptureEnd(GPUSYCLQUEUE *queue) {
+  catchAll([&]() { queue->syclQueue_.wait(); });
+}
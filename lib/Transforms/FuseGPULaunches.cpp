@@ -0,0 +1,476 @@
+//===- FuseGPULaunches.cpp - FuseGPULaunches Pass  --------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file fuses consecutive gpu.launch ops with the same launch sizes in
+/// which every work item only reads the elements of shared buffers it wrote
+/// itself, e.g. the kernels of an elementwise chain, into one kernel. Buffers
+/// which only carry values between the fused kernels are removed.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/Utils/StaticValueUtils.h>
+#include <mlir/IR/Dominance.h>
+#include <mlir/IR/IRMapping.h>
+#include <mlir/Interfaces/SideEffectInterfaces.h>
+#include <mlir/Interfaces/ViewLikeInterface.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/SmallBitVector.h>
+
+#include <limits>
+
+namespace imex {
+#define GEN_PASS_DEF_FUSEGPULAUNCHES
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+// Block, thread ids and grid, block sizes.
+static constexpr unsigned kNumConfigArgs = 12;
+
+/// A memref access of a kernel.
+struct Access {
+  mlir::Operation *op;
+  mlir::Value memref;
+  mlir::Value root;
+  mlir::ValueRange indices;
+  bool isWrite;
+};
+
+/// Returns the allocation or argument memref is a view of.
+mlir::Value getRoot(mlir::Value memref) {
+  while (auto view = memref.getDefiningOp<mlir::ViewLikeOpInterface>())
+    memref = view.getViewSource();
+  return memref;
+}
+
+bool isSameValue(mlir::Value lhs, mlir::Value rhs) {
+  if (lhs == rhs)
+    return true;
+  auto lhsCst = mlir::getConstantIntValue(lhs);
+  auto rhsCst = mlir::getConstantIntValue(rhs);
+  return lhsCst && rhsCst && *lhsCst == *rhsCst;
+}
+
+/// Returns true if lhs computes the same value as rhs for every work item,
+/// where argMap maps the launch arguments of the kernel of lhs to the ones of
+/// the kernel of rhs.
+bool isEquivalent(mlir::Value lhs, mlir::Value rhs,
+                  const mlir::IRMapping &argMap) {
+  if (argMap.lookupOrNull(lhs) == rhs || isSameValue(lhs, rhs))
+    return true;
+  auto *lhsOp = lhs.getDefiningOp();
+  auto *rhsOp = rhs.getDefiningOp();
+  if (!lhsOp || !rhsOp || lhsOp->getName() != rhsOp->getName() ||
+      lhsOp->getAttrDictionary() != rhsOp->getAttrDictionary() ||
+      lhsOp->getNumOperands() != rhsOp->getNumOperands() ||
+      lhsOp->getNumRegions() || !mlir::isMemoryEffectFree(lhsOp) ||
+      mlir::cast<mlir::OpResult>(lhs).getResultNumber() !=
+          mlir::cast<mlir::OpResult>(rhs).getResultNumber())
+    return false;
+  return llvm::all_of(
+      llvm::zip(lhsOp->getOperands(), rhsOp->getOperands()), [&](auto pair) {
+        return isEquivalent(std::get<0>(pair), std::get<1>(pair), argMap);
+      });
+}
+
+bool isEquivalent(mlir::ValueRange lhs, mlir::ValueRange rhs,
+                  const mlir::IRMapping &argMap) {
+  return lhs.size() == rhs.size() &&
+         llvm::all_of(llvm::zip(lhs, rhs), [&](auto pair) {
+           return isEquivalent(std::get<0>(pair), std::get<1>(pair), argMap);
+         });
+}
+
+/// Returns the integer constant held by value if it is positive.
+std::optional<int64_t> getPositiveConstant(mlir::Value value) {
+  auto cst = mlir::getConstantIntValue(value);
+  if (!cst || *cst <= 0)
+    return std::nullopt;
+  return cst;
+}
+
+class LaunchInfo {
+public:
+  /// Returns std::nullopt if launch can't take part in a fusion.
+  static std::optional<LaunchInfo> get(mlir::gpu::LaunchOp launch) {
+    if (!launch.getAsyncDependencies().empty() || launch.getAsyncToken() ||
+        launch.getDynamicSharedMemorySize() ||
+        !launch.getWorkgroupAttributions().empty() ||
+        !launch.getPrivateAttributions().empty() ||
+        !launch.getBody().hasOneBlock())
+      return std::nullopt;
+
+    LaunchInfo info;
+    info.launch = launch;
+    auto result = launch.getBody().walk([&](mlir::Operation *op) {
+      if (auto load = mlir::dyn_cast<mlir::memref::LoadOp>(op)) {
+        info.accesses.push_back({op, load.getMemRef(),
+                                 getRoot(load.getMemRef()), load.getIndices(),
+                                 /*isWrite=*/false});
+        return mlir::WalkResult::advance();
+      }
+      if (auto store = mlir::dyn_cast<mlir::memref::StoreOp>(op)) {
+        info.accesses.push_back({op, store.getMemRef(),
+                                 getRoot(store.getMemRef()),
+                                 store.getIndices(), /*isWrite=*/true});
+        return mlir::WalkResult::advance();
+      }
+      // Other memory effects, barriers etc. are not analyzed.
+      if (op->getNumRegions() || mlir::isMemoryEffectFree(op) ||
+          mlir::isa<mlir::gpu::TerminatorOp>(op))
+        return mlir::WalkResult::advance();
+      return mlir::WalkResult::interrupt();
+    });
+    if (result.wasInterrupted())
+      return std::nullopt;
+    return info;
+  }
+
+  bool hasSameSizes(const LaunchInfo &other) const {
+    auto lhs = launch.getOperands().take_back(6);
+    auto rhs = other.launch.getOperands().take_back(6);
+    return llvm::all_of(llvm::zip(lhs, rhs), [](auto pair) {
+      return isSameValue(std::get<0>(pair), std::get<1>(pair));
+    });
+  }
+
+  /// Returns true if the writes of access are to a different element for
+  /// every work item, i.e. the indices are an injective function of the ids
+  /// with an extent > 1. Recognized are indices `x * c + u` with a constant
+  /// c != 0 and u the same for the whole launch, where x is either an
+  /// injective linear combination of the ids or part of a delinearization of
+  /// one by constant divui/remui, as emitted by imex-tune-launch-config.
+  bool isDistinctPerWorkItem(const Access &access) const {
+    llvm::SmallVector<mlir::Value> cores;
+    for (auto index : access.indices)
+      cores.push_back(peel(index));
+
+    // The linear combinations of ids the indices determine.
+    llvm::SmallVector<mlir::Value> linears;
+    auto addLinear = [&](mlir::Value value) {
+      if (!llvm::is_contained(linears, value) && isRecovered(value, cores))
+        linears.push_back(value);
+    };
+    for (auto core : cores) {
+      if (auto rem = core.getDefiningOp<mlir::arith::RemUIOp>())
+        addLinear(rem.getLhs());
+      addLinear(core);
+    }
+
+    llvm::SmallBitVector covered(6);
+    for (auto linear : linears) {
+      llvm::SmallVector<int64_t> coeffs(6, 0);
+      if (!decompose(linear, 1, coeffs))
+        continue;
+      llvm::SmallVector<std::pair<int64_t, unsigned>> terms;
+      for (unsigned i = 0; i < 6; ++i) {
+        if (!coeffs[i] || isInactive(i))
+          continue;
+        // Each id has to be determined by one linear combination only.
+        if (covered.test(i))
+          return false;
+        covered.set(i);
+        terms.emplace_back(std::abs(coeffs[i]), i);
+      }
+      // Mixed radix: every coefficient exceeds the largest value the terms
+      // with smaller coefficients add up to.
+      llvm::sort(terms);
+      int64_t range = 0;
+      for (auto [coeff, i] : terms) {
+        if (coeff <= range)
+          return false;
+        auto extent = mlir::getConstantIntValue(getSizes()[i]);
+        if (!extent) {
+          range = std::numeric_limits<int64_t>::max();
+          continue;
+        }
+        range += coeff * (*extent - 1);
+      }
+    }
+    for (unsigned i = 0; i < 6; ++i)
+      if (!covered.test(i) && !isInactive(i))
+        return false;
+    return true;
+  }
+
+  mlir::gpu::LaunchOp launch;
+  llvm::SmallVector<Access> accesses;
+
+private:
+  mlir::ValueRange getSizes() const {
+    return launch.getOperands().take_back(6);
+  }
+
+  bool isInactive(unsigned id) const {
+    auto size = mlir::getConstantIntValue(getSizes()[id]);
+    return size && *size == 1;
+  }
+
+  /// Returns true if value is the same for all work items of the launch.
+  bool isInvariant(mlir::Value value) const {
+    if (!launch.getBody().isAncestor(value.getParentRegion()))
+      return true;
+    if (auto arg = mlir::dyn_cast<mlir::BlockArgument>(value))
+      return arg.getOwner() == &launch.getBody().front() &&
+             arg.getArgNumber() >= 6 && arg.getArgNumber() < kNumConfigArgs;
+    auto *op = value.getDefiningOp();
+    return !op->getNumRegions() && mlir::isMemoryEffectFree(op) &&
+           llvm::all_of(op->getOperands(), [&](mlir::Value operand) {
+             return isInvariant(operand);
+           });
+  }
+
+  /// Strips `* c` with a constant c != 0 and `+ u`, `- u` with an invariant
+  /// u off value.
+  mlir::Value peel(mlir::Value value) const {
+    while (auto *op = value.getDefiningOp()) {
+      if (mlir::isa<mlir::arith::AddIOp, mlir::arith::SubIOp,
+                    mlir::arith::MulIOp>(op)) {
+        auto lhs = op->getOperand(0);
+        auto rhs = op->getOperand(1);
+        auto isFactor = [&](mlir::Value factor) {
+          auto cst = mlir::getConstantIntValue(factor);
+          return cst && *cst != 0;
+        };
+        bool mul = mlir::isa<mlir::arith::MulIOp>(op);
+        if (mul ? isFactor(rhs) : isInvariant(rhs)) {
+          value = lhs;
+          continue;
+        }
+        if (!mlir::isa<mlir::arith::SubIOp>(op) &&
+            (mul ? isFactor(lhs) : isInvariant(lhs))) {
+          value = rhs;
+          continue;
+        }
+      }
+      break;
+    }
+    return value;
+  }
+
+  /// Returns true if value can be computed from the cores of the indices,
+  /// either directly or from `value remui c` and `value divui c`.
+  bool isRecovered(mlir::Value value, llvm::ArrayRef<mlir::Value> cores) const {
+    if (llvm::is_contained(cores, value))
+      return true;
+    for (auto core : cores) {
+      auto rem = core.getDefiningOp<mlir::arith::RemUIOp>();
+      if (!rem || rem.getLhs() != value)
+        continue;
+      auto divisor = getPositiveConstant(rem.getRhs());
+      if (!divisor)
+        continue;
+      for (auto *user : value.getUsers()) {
+        auto div = mlir::dyn_cast<mlir::arith::DivUIOp>(user);
+        if (div && div.getLhs() == value &&
+            getPositiveConstant(div.getRhs()) == divisor &&
+            isRecovered(div.getResult(), cores))
+          return true;
+      }
+    }
+    return false;
+  }
+
+  /// Adds value * factor as a linear combination of the ids to coeffs, up to
+  /// an invariant term. Returns false if value isn't of that form.
+  bool decompose(mlir::Value value, int64_t factor,
+                 llvm::SmallVectorImpl<int64_t> &coeffs) const {
+    if (isInvariant(value))
+      return true;
+    if (auto arg = mlir::dyn_cast<mlir::BlockArgument>(value)) {
+      if (arg.getOwner() != &launch.getBody().front() ||
+          arg.getArgNumber() >= 6)
+        return false;
+      coeffs[arg.getArgNumber()] += factor;
+      return true;
+    }
+    auto *op = value.getDefiningOp();
+    if (mlir::isa<mlir::arith::AddIOp>(op))
+      return decompose(op->getOperand(0), factor, coeffs) &&
+             decompose(op->getOperand(1), factor, coeffs);
+    if (mlir::isa<mlir::arith::SubIOp>(op))
+      return decompose(op->getOperand(0), factor, coeffs) &&
+             decompose(op->getOperand(1), -factor, coeffs);
+    if (mlir::isa<mlir::arith::MulIOp>(op)) {
+      if (auto cst = mlir::getConstantIntValue(op->getOperand(1)))
+        return decompose(op->getOperand(0), factor * *cst, coeffs);
+      if (auto cst = mlir::getConstantIntValue(op->getOperand(0)))
+        return decompose(op->getOperand(1), factor * *cst, coeffs);
+    }
+    return false;
+  }
+};
+
+/// Returns true if consumer can execute the work of producer first in every
+/// work item, i.e. every element of a buffer written by one kernel and
+/// accessed by the other is only accessed by the same work item in both.
+/// Distinct function arguments and allocations are assumed not to alias.
+bool canFuse(const LaunchInfo &producer, const LaunchInfo &consumer) {
+  if (!producer.hasSameSizes(consumer))
+    return false;
+  mlir::IRMapping argMap;
+  auto &srcBody = producer.launch.getBody().front();
+  auto &dstBody = consumer.launch.getBody().front();
+  for (unsigned i = 0; i < kNumConfigArgs; ++i)
+    argMap.map(srcBody.getArgument(i), dstBody.getArgument(i));
+
+  for (auto &src : producer.accesses) {
+    for (auto &dst : consumer.accesses) {
+      if ((!src.isWrite && !dst.isWrite) || src.root != dst.root)
+        continue;
+      if (src.memref != dst.memref ||
+          !isEquivalent(src.indices, dst.indices, argMap))
+        return false;
+      auto &write = src.isWrite ? src : dst;
+      auto &writer = src.isWrite ? producer : consumer;
+      if (!writer.isDistinctPerWorkItem(write))
+        return false;
+    }
+  }
+  return true;
+}
+
+/// Moves the body of producer to the start of consumer and erases producer.
+void fuse(mlir::gpu::LaunchOp producer, mlir::gpu::LaunchOp consumer) {
+  auto &srcBody = producer.getBody().front();
+  auto &dstBody = consumer.getBody().front();
+  for (unsigned i = 0; i < kNumConfigArgs; ++i)
+    srcBody.getArgument(i).replaceAllUsesWith(dstBody.getArgument(i));
+  srcBody.getTerminator()->erase();
+  dstBody.getOperations().splice(dstBody.begin(), srcBody.getOperations());
+  producer.erase();
+}
+
+/// Returns true if op can be executed before a gpu.launch instead of after
+/// it.
+bool canMoveBeforeLaunch(mlir::Operation *op) {
+  if (mlir::isMemoryEffectFree(op))
+    return true;
+  // Fresh allocations are not accessed by the launch.
+  auto effects = mlir::dyn_cast<mlir::MemoryEffectOpInterface>(op);
+  if (!effects || op->getNumRegions())
+    return false;
+  llvm::SmallVector<mlir::MemoryEffects::EffectInstance> instances;
+  effects.getEffects(instances);
+  return llvm::all_of(instances, [](auto &instance) {
+    return mlir::isa<mlir::MemoryEffects::Allocate>(instance.getEffect());
+  });
+}
+
+/// Replaces a buffer which is written and read only by the work items of
+/// launch at the same element by the stored value.
+void forwardBuffers(mlir::gpu::LaunchOp launch) {
+  auto info = LaunchInfo::get(launch);
+  if (!info)
+    return;
+  mlir::DominanceInfo dom(launch);
+  llvm::SmallDenseMap<mlir::Value, llvm::SmallVector<const Access *>> byRoot;
+  for (auto &access : info->accesses)
+    byRoot[access.root].push_back(&access);
+
+  mlir::IRMapping identity;
+  for (auto &entry : byRoot) {
+    auto &accesses = entry.second;
+    auto alloc = entry.first.getDefiningOp<mlir::memref::AllocOp>();
+    if (!alloc)
+      continue;
+    // The buffer must not be used outside of the launch.
+    bool localOnly =
+        llvm::all_of(alloc->getUsers(), [&](mlir::Operation *user) {
+          return mlir::isa<mlir::memref::DeallocOp>(user) ||
+                 llvm::any_of(accesses, [&](const Access *access) {
+                   return access->op == user;
+                 });
+        });
+    auto stores = llvm::make_filter_range(
+        accesses, [](const Access *access) { return access->isWrite; });
+    if (!localOnly || !llvm::hasSingleElement(stores))
+      continue;
+
+    auto *store = *stores.begin();
+    bool forwardable = llvm::all_of(accesses, [&](const Access *access) {
+      return access == store ||
+             (dom.properlyDominates(store->op, access->op) &&
+              isEquivalent(store->indices, access->indices, identity));
+    });
+    if (!forwardable)
+      continue;
+
+    auto value = mlir::cast<mlir::memref::StoreOp>(store->op).getValue();
+    for (auto *access : accesses) {
+      if (access == store)
+        continue;
+      access->op->getResult(0).replaceAllUsesWith(value);
+      access->op->erase();
+    }
+    store->op->erase();
+    for (auto *user : llvm::make_early_inc_range(alloc->getUsers()))
+      user->erase();
+    alloc.erase();
+  }
+}
+
+struct FuseGPULaunchesPass final
+    : public imex::impl::FuseGPULaunchesBase<FuseGPULaunchesPass> {
+
+  void runOnOperation() override {
+    llvm::SmallVector<mlir::Block *> blocks;
+    getOperation().walk([&](mlir::gpu::LaunchOp launch) {
+      if (!llvm::is_contained(blocks, launch->getBlock()))
+        blocks.push_back(launch->getBlock());
+    });
+
+    llvm::SmallVector<mlir::gpu::LaunchOp> fused;
+    for (auto *block : blocks) {
+      std::optional<LaunchInfo> current;
+      bool currentFused = false;
+      for (auto &op : llvm::make_early_inc_range(*block)) {
+        auto launch = mlir::dyn_cast<mlir::gpu::LaunchOp>(op);
+        if (!launch) {
+          if (current && !canMoveBeforeLaunch(&op))
+            current.reset();
+          continue;
+        }
+        auto next = LaunchInfo::get(launch);
+        if (current && next && canFuse(*current, *next)) {
+          fuse(current->launch, launch);
+          next = LaunchInfo::get(launch);
+          currentFused = true;
+        } else {
+          if (current && currentFused)
+            fused.push_back(current->launch);
+          currentFused = false;
+        }
+        current = next;
+      }
+      if (current && currentFused)
+        fused.push_back(current->launch);
+    }
+
+    for (auto launch : fused)
+      forwardBuffers(launch);
+  }
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createFuseGPULaunchesPass() {
+  return std::make_unique<FuseGPULaunchesPass>();
+}
+} // namespace imex
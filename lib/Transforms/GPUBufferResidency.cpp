@@ -0,0 +1,335 @@
+//===- GPUBufferResidency.cpp - GPUBufferResidency Pass  --------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file removes host/device copies inserted by insert-gpu-allocs across
+/// function boundaries. insert-gpu-allocs works on one function at a time and
+/// mirrors every buffer a function receives from (or returns to) its caller
+/// in a host shared gpu.alloc, copying it in at function entry and out at
+/// function exit. This pass tracks which buffers are already host shared
+/// device memory at the call sites and lets internal functions work on them
+/// directly:
+///
+/// * a parameter whose callers all pass host shared memory uses that memory
+///   instead of its mirror,
+/// * a result copied out of a host shared gpu.alloc is returned without the
+///   copy, the callers free it with gpu.dealloc,
+/// * host allocations passed to such parameters are allocated as host shared
+///   memory, so that the data stays on the device across calls and loop
+///   iterations of the caller.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/IR/SymbolTable.h>
+#include <mlir/Interfaces/ViewLikeInterface.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/SetVector.h>
+
+#include <optional>
+
+namespace imex {
+#define GEN_PASS_DEF_GPUBUFFERRESIDENCY
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+/// Returns the buffer the given view (or cast) of a memref is based on.
+mlir::Value getViewSource(mlir::Value value) {
+  while (auto view = value.getDefiningOp<mlir::ViewLikeOpInterface>())
+    value = view.getViewSource();
+  return value;
+}
+
+/// Returns the host shared gpu.alloc the given memref is a view of, if any.
+mlir::gpu::AllocOp getSharedAlloc(mlir::Value value) {
+  auto alloc = getViewSource(value).getDefiningOp<mlir::gpu::AllocOp>();
+  if (alloc && alloc.getHostShared() && !alloc.getAsyncToken())
+    return alloc;
+  return nullptr;
+}
+
+/// Collects the memref.dealloc ops freeing the given buffer or one of its
+/// views. Returns false if the buffer escapes through a func.return, in which
+/// case the owner of the buffer is unknown.
+bool collectDeallocs(mlir::Value buffer,
+                     llvm::SmallVectorImpl<mlir::memref::DeallocOp> &deallocs) {
+  for (auto *user : buffer.getUsers()) {
+    if (mlir::isa<mlir::func::ReturnOp>(user))
+      return false;
+    if (auto dealloc = mlir::dyn_cast<mlir::memref::DeallocOp>(user)) {
+      deallocs.push_back(dealloc);
+      continue;
+    }
+    if (auto view = mlir::dyn_cast<mlir::ViewLikeOpInterface>(user)) {
+      if (view.getViewSource() == buffer &&
+          !collectDeallocs(view->getResult(0), deallocs))
+        return false;
+    }
+  }
+  return true;
+}
+
+/// Replaces the memref.dealloc ops with gpu.dealloc ops.
+void convertDeallocs(llvm::ArrayRef<mlir::memref::DeallocOp> deallocs) {
+  for (auto dealloc : deallocs) {
+    mlir::OpBuilder builder(dealloc);
+    builder.create<mlir::gpu::DeallocOp>(dealloc.getLoc(), std::nullopt,
+                                         dealloc.getMemref());
+    dealloc.erase();
+  }
+}
+
+/// Host allocation which can be turned into a host shared gpu.alloc.
+bool isPromotableAlloc(mlir::Value value) {
+  auto alloc = getViewSource(value).getDefiningOp<mlir::memref::AllocOp>();
+  if (!alloc || alloc->getParentOfType<mlir::gpu::LaunchOp>())
+    return false;
+  llvm::SmallVector<mlir::memref::DeallocOp> deallocs;
+  return collectDeallocs(alloc.getResult(), deallocs);
+}
+
+/// The host shared gpu.alloc insert-gpu-allocs mirrors a parameter in, with
+/// the copies between the two.
+struct MirroredParam {
+  mlir::gpu::AllocOp alloc;
+  llvm::SmallVector<mlir::memref::CopyOp> copies;
+};
+
+std::optional<MirroredParam> getMirroredParam(mlir::BlockArgument arg) {
+  MirroredParam mirror;
+  for (auto *user : arg.getUsers()) {
+    if (mlir::isa<mlir::memref::DimOp>(user))
+      continue;
+    auto copy = mlir::dyn_cast<mlir::memref::CopyOp>(user);
+    if (!copy)
+      return std::nullopt;
+    auto other = copy.getSource() == arg ? copy.getTarget() : copy.getSource();
+    auto alloc = getSharedAlloc(other);
+    if (!alloc || (mirror.alloc && mirror.alloc != alloc))
+      return std::nullopt;
+    mirror.alloc = alloc;
+    mirror.copies.push_back(copy);
+  }
+  if (!mirror.alloc)
+    return std::nullopt;
+
+  // The mirror must be usable as the parameter, either directly or through
+  // a cast to the parameter type.
+  auto argType = arg.getType();
+  for (auto *user : mirror.alloc->getUsers()) {
+    if (llvm::is_contained(mirror.copies, user) ||
+        mlir::isa<mlir::gpu::DeallocOp>(user))
+      continue;
+    auto cast = mlir::dyn_cast<mlir::memref::CastOp>(user);
+    if (cast && cast.getType() == argType)
+      continue;
+    if (mirror.alloc.getType() != argType)
+      return std::nullopt;
+  }
+  return mirror;
+}
+
+/// Makes the function work on the parameter instead of its mirror.
+unsigned forwardParam(mlir::BlockArgument arg, MirroredParam &mirror) {
+  unsigned numCopies = mirror.copies.size();
+  for (auto copy : mirror.copies)
+    copy.erase();
+
+  auto eraseDeallocs = [](mlir::Value value) {
+    for (auto *user : llvm::make_early_inc_range(value.getUsers()))
+      if (mlir::isa<mlir::gpu::DeallocOp>(user))
+        user->erase();
+  };
+
+  mlir::Value buffer = mirror.alloc.getMemref();
+  eraseDeallocs(buffer);
+  for (auto *user : llvm::make_early_inc_range(buffer.getUsers())) {
+    auto cast = mlir::dyn_cast<mlir::memref::CastOp>(user);
+    if (cast && cast.getType() == arg.getType()) {
+      eraseDeallocs(cast);
+      cast.replaceAllUsesWith(arg);
+      cast.erase();
+    }
+  }
+  buffer.replaceAllUsesWith(arg);
+  mirror.alloc.erase();
+  return numCopies;
+}
+
+/// A result insert-gpu-allocs copies out of a host shared gpu.alloc:
+///
+///   %0 = memref.alloc() : memref<8xf32>
+///   memref.copy %gpu, %0 : memref<8xf32> to memref<8xf32>
+///   gpu.dealloc %gpu : memref<8xf32>
+///   return %0 : memref<8xf32>
+mlir::memref::CopyOp getCopiedOutResult(mlir::func::ReturnOp ret,
+                                        unsigned index) {
+  auto hostAlloc =
+      ret.getOperand(index).getDefiningOp<mlir::memref::AllocOp>();
+  if (!hostAlloc)
+    return nullptr;
+
+  mlir::memref::CopyOp copyOut;
+  for (auto *user : hostAlloc->getUsers()) {
+    if (user == ret)
+      continue;
+    auto copy = mlir::dyn_cast<mlir::memref::CopyOp>(user);
+    if (!copy || copyOut || copy.getTarget() != hostAlloc.getResult())
+      return nullptr;
+    copyOut = copy;
+  }
+  if (!copyOut || !getSharedAlloc(copyOut.getSource()) ||
+      copyOut.getSource().getType() != hostAlloc.getType() ||
+      llvm::count(ret.getOperands(), hostAlloc.getResult()) != 1)
+    return nullptr;
+  return copyOut;
+}
+
+struct GPUBufferResidencyPass final
+    : public imex::impl::GPUBufferResidencyBase<GPUBufferResidencyPass> {
+
+  void runOnOperation() override {
+    auto mod = getOperation();
+    mlir::SymbolTable symbolTable(mod);
+
+    // Functions which are only called from within the module.
+    llvm::MapVector<mlir::func::FuncOp, llvm::SmallVector<mlir::func::CallOp>>
+        internalFuncs;
+    for (auto func : mod.getOps<mlir::func::FuncOp>()) {
+      if (func.isDeclaration() || !func.getBody().hasOneBlock())
+        continue;
+      auto uses = mlir::SymbolTable::getSymbolUses(func, mod);
+      if (!uses)
+        continue;
+      llvm::SmallVector<mlir::func::CallOp> calls;
+      bool onlyCalls = true;
+      for (auto &use : *uses) {
+        auto call = mlir::dyn_cast<mlir::func::CallOp>(use.getUser());
+        onlyCalls &= static_cast<bool>(call);
+        if (call)
+          calls.push_back(call);
+      }
+      if (!onlyCalls || calls.empty())
+        continue;
+      bool closed = closedModule && !func->hasAttr("llvm.emit_c_interface");
+      if (func.isPrivate() || closed)
+        internalFuncs.insert({func, std::move(calls)});
+    }
+
+    // Results: return the host shared buffer instead of a host copy of it.
+    llvm::DenseSet<std::pair<mlir::Operation *, unsigned>> sharedResults;
+    for (auto &[func, calls] : internalFuncs) {
+      auto ret = mlir::cast<mlir::func::ReturnOp>(
+          func.getBody().front().getTerminator());
+      for (auto i : llvm::seq(0u, ret.getNumOperands())) {
+        auto copyOut = getCopiedOutResult(ret, i);
+        if (!copyOut)
+          continue;
+
+        llvm::SmallVector<mlir::memref::DeallocOp> deallocs;
+        if (!llvm::all_of(calls, [&](mlir::func::CallOp call) {
+              return collectDeallocs(call.getResult(i), deallocs);
+            }))
+          continue;
+
+        auto hostAlloc = ret.getOperand(i).getDefiningOp();
+        mlir::Value buffer = copyOut.getSource();
+        for (auto *user : llvm::make_early_inc_range(buffer.getUsers()))
+          if (mlir::isa<mlir::gpu::DeallocOp>(user))
+            user->erase();
+        ret.setOperand(i, buffer);
+        copyOut.erase();
+        hostAlloc->erase();
+        convertDeallocs(deallocs);
+        sharedResults.insert({func, i});
+        ++numCopiesRemoved;
+      }
+    }
+
+    // Parameters: a parameter is resident if all callers pass host shared
+    // memory, possibly through resident parameters of their own.
+    llvm::DenseSet<mlir::Value> residentParams;
+    auto isResident = [&](mlir::Value value) {
+      auto source = getViewSource(value);
+      if (getSharedAlloc(source) || isPromotableAlloc(source) ||
+          residentParams.contains(source))
+        return true;
+      auto call = source.getDefiningOp<mlir::func::CallOp>();
+      if (!call)
+        return false;
+      auto callee = symbolTable.lookup<mlir::func::FuncOp>(call.getCallee());
+      return sharedResults.contains(
+          {callee, llvm::cast<mlir::OpResult>(source).getResultNumber()});
+    };
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (auto &[func, calls] : internalFuncs) {
+        for (auto arg : func.getArguments()) {
+          if (!arg.getType().isa<mlir::MemRefType>() ||
+              residentParams.contains(arg))
+            continue;
+          if (llvm::all_of(calls, [&](mlir::func::CallOp call) {
+                return isResident(call.getOperand(arg.getArgNumber()));
+              })) {
+            residentParams.insert(arg);
+            changed = true;
+          }
+        }
+      }
+    }
+
+    llvm::SetVector<mlir::memref::AllocOp> promotedAllocs;
+    for (auto &[func, calls] : internalFuncs) {
+      for (auto arg : func.getArguments()) {
+        if (!residentParams.contains(arg))
+          continue;
+        if (auto mirror = getMirroredParam(arg))
+          numCopiesRemoved += forwardParam(arg, *mirror);
+        for (auto call : calls) {
+          auto source = getViewSource(call.getOperand(arg.getArgNumber()));
+          if (auto alloc = source.getDefiningOp<mlir::memref::AllocOp>())
+            promotedAllocs.insert(alloc);
+        }
+      }
+    }
+
+    for (auto alloc : promotedAllocs) {
+      llvm::SmallVector<mlir::memref::DeallocOp> deallocs;
+      (void)collectDeallocs(alloc.getResult(), deallocs);
+      mlir::OpBuilder builder(alloc);
+      auto gpuAlloc = builder.create<mlir::gpu::AllocOp>(
+          alloc.getLoc(), alloc.getType(), /*asyncToken*/ nullptr,
+          /*asyncDependencies*/ std::nullopt, alloc.getDynamicSizes(),
+          alloc.getSymbolOperands(), /*hostShared*/ true);
+      alloc.replaceAllUsesWith(gpuAlloc.getMemref());
+      alloc.erase();
+      convertDeallocs(deallocs);
+      ++numAllocsPromoted;
+    }
+  }
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createGPUBufferResidencyPass() {
+  return std::make_unique<GPUBufferResidencyPass>();
+}
+} // namespace imex
@@ -0,0 +1,228 @@
+//===- PlanBufferReuse.cpp - PlanBufferReuse Pass  --------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file computes the lifetimes of the function-local buffers of a
+/// bufferized function and packs buffers with disjoint lifetimes into shared
+/// slabs of a single arena allocation.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Interfaces/CallInterfaces.h>
+#include <mlir/Interfaces/ViewLikeInterface.h>
+#include <mlir/Pass/Pass.h>
+
+namespace imex {
+#define GEN_PASS_DEF_PLANBUFFERREUSE
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+// Alignment of the arena and of every slab in it.
+static constexpr int64_t kSlabAlignment = 64;
+
+/// A function-local buffer and its lifetime, given as the positions of the
+/// top-level ops of the function which create and last use it.
+struct Buffer {
+  mlir::memref::AllocOp alloc;
+  llvm::SmallVector<mlir::memref::DeallocOp> deallocs;
+  int64_t size;
+  unsigned start;
+  unsigned end;
+  // end of the lifetime as given by the deallocations of the input program
+  unsigned naiveEnd;
+  int64_t offset = 0;
+};
+
+/// A range of the arena shared by buffers with disjoint lifetimes.
+struct Slab {
+  int64_t offset;
+  int64_t size;
+  // position of the last use of the buffer currently occupying the slab
+  unsigned busyUntil;
+};
+
+/// Returns the size in bytes of the buffer allocated by alloc or nullopt if
+/// it cannot be placed in the arena.
+std::optional<int64_t> getPackableSize(mlir::memref::AllocOp alloc) {
+  auto type = alloc.getType();
+  auto elType = type.getElementType();
+  if (!type.hasStaticShape() || !type.getLayout().isIdentity() ||
+      type.getMemorySpace() || !alloc.getSymbolOperands().empty() ||
+      !elType.isIntOrFloat() || elType.getIntOrFloatBitWidth() % 8 != 0)
+    return std::nullopt;
+  if (auto alignment = alloc.getAlignment())
+    if (*alignment > static_cast<uint64_t>(kSlabAlignment))
+      return std::nullopt;
+  return type.getNumElements() * (elType.getIntOrFloatBitWidth() / 8);
+}
+
+/// Computes the lifetime of the buffer allocated by buffer.alloc in block,
+/// following all views of it. Returns failure if the buffer, or a view of it,
+/// escapes, i.e. it may be accessed after its last use in block.
+mlir::LogicalResult
+computeLifetime(Buffer &buffer, mlir::Block &block,
+                const llvm::DenseMap<mlir::Operation *, unsigned> &positions) {
+  buffer.start = positions.lookup(buffer.alloc);
+  buffer.end = buffer.start;
+  buffer.naiveEnd = positions.lookup(block.getTerminator());
+
+  llvm::SmallVector<mlir::Value> worklist = {buffer.alloc.getResult()};
+  while (!worklist.empty()) {
+    auto value = worklist.pop_back_val();
+    for (auto &use : value.getUses()) {
+      auto *user = use.getOwner();
+      if (auto dealloc = mlir::dyn_cast<mlir::memref::DeallocOp>(user)) {
+        if (dealloc->getBlock() != &block)
+          return mlir::failure();
+        buffer.deallocs.push_back(dealloc);
+        buffer.naiveEnd = positions.lookup(dealloc);
+        continue;
+      }
+      if (user->hasTrait<mlir::OpTrait::IsTerminator>() ||
+          mlir::isa<mlir::CallOpInterface>(user))
+        return mlir::failure();
+      if (auto view = mlir::dyn_cast<mlir::ViewLikeOpInterface>(user)) {
+        if (view.getViewSource() == value)
+          worklist.append(user->result_begin(), user->result_end());
+      } else if (llvm::any_of(user->getResultTypes(), [](mlir::Type type) {
+                   return type.isa<mlir::BaseMemRefType, mlir::TensorType>();
+                 })) {
+        // e.g. bufferization.to_tensor, which may hand out the buffer
+        return mlir::failure();
+      }
+      auto *ancestor = block.findAncestorOpInBlock(*user);
+      if (!ancestor)
+        return mlir::failure();
+      buffer.end = std::max(buffer.end, positions.lookup(ancestor));
+    }
+  }
+  return mlir::success();
+}
+
+/// Assigns arena offsets to buffers, which are sorted by the start of their
+/// lifetimes. A buffer reuses the smallest free slab which is large enough to
+/// hold it, a new slab is appended to the arena otherwise. Returns the size
+/// of the arena.
+int64_t assignOffsets(llvm::MutableArrayRef<Buffer> buffers) {
+  llvm::SmallVector<Slab> slabs;
+  int64_t arenaSize = 0;
+  for (auto &buffer : buffers) {
+    Slab *best = nullptr;
+    for (auto &slab : slabs) {
+      if (slab.busyUntil < buffer.start && slab.size >= buffer.size &&
+          (!best || slab.size < best->size))
+        best = &slab;
+    }
+    if (!best) {
+      auto size = llvm::alignTo(buffer.size, kSlabAlignment);
+      slabs.push_back({arenaSize, static_cast<int64_t>(size), 0});
+      arenaSize += size;
+      best = &slabs.back();
+    }
+    best->busyUntil = buffer.end;
+    buffer.offset = best->offset;
+  }
+  return arenaSize;
+}
+
+/// Returns the maximum number of bytes allocated at the same time if every
+/// buffer lives until it is deallocated in the input program.
+int64_t computeNaivePeak(llvm::ArrayRef<Buffer> buffers) {
+  int64_t peak = 0;
+  for (auto &buffer : buffers) {
+    int64_t live = 0;
+    for (auto &other : buffers) {
+      if (other.start <= buffer.start && buffer.start <= other.naiveEnd)
+        live += other.size;
+    }
+    peak = std::max(peak, live);
+  }
+  return peak;
+}
+
+struct PlanBufferReusePass final
+    : public imex::impl::PlanBufferReuseBase<PlanBufferReusePass> {
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.isExternal() || !func.getBody().hasOneBlock())
+      return;
+
+    // Lifetimes are derived from program order, which is not the order of
+    // execution of asynchronous gpu ops.
+    bool hasAsync = false;
+    func.walk([&](mlir::gpu::AsyncOpInterface op) {
+      if (op.getAsyncToken() || !op.getAsyncDependencies().empty())
+        hasAsync = true;
+    });
+    if (hasAsync)
+      return;
+
+    auto &block = func.getBody().front();
+    llvm::DenseMap<mlir::Operation *, unsigned> positions;
+    unsigned position = 0;
+    for (auto &op : block)
+      positions[&op] = position++;
+
+    llvm::SmallVector<Buffer> buffers;
+    for (auto alloc : block.getOps<mlir::memref::AllocOp>()) {
+      auto size = getPackableSize(alloc);
+      if (!size)
+        continue;
+      Buffer buffer{alloc, {}, *size, 0, 0, 0};
+      if (mlir::succeeded(computeLifetime(buffer, block, positions)))
+        buffers.push_back(std::move(buffer));
+    }
+    if (buffers.size() < 2)
+      return;
+
+    auto arenaSize = assignOffsets(buffers);
+    if (report)
+      func.emitRemark() << "naive peak bytes " << computeNaivePeak(buffers)
+                        << ", planned bytes " << arenaSize;
+
+    mlir::OpBuilder builder(&getContext());
+    builder.setInsertionPointToStart(&block);
+    auto arenaType =
+        mlir::MemRefType::get({arenaSize}, builder.getIntegerType(8));
+    auto arena = builder.create<mlir::memref::AllocOp>(
+        func.getLoc(), arenaType, builder.getI64IntegerAttr(kSlabAlignment));
+
+    for (auto &buffer : buffers) {
+      auto loc = buffer.alloc.getLoc();
+      builder.setInsertionPoint(buffer.alloc);
+      auto offset =
+          builder.create<mlir::arith::ConstantIndexOp>(loc, buffer.offset);
+      auto view = builder.create<mlir::memref::ViewOp>(
+          loc, buffer.alloc.getType(), arena, offset, mlir::ValueRange{});
+      buffer.alloc.replaceAllUsesWith(view.getResult());
+      buffer.alloc.erase();
+      for (auto dealloc : buffer.deallocs)
+        dealloc.erase();
+    }
+
+    builder.setInsertionPoint(block.getTerminator());
+    builder.create<mlir::memref::DeallocOp>(func.getLoc(), arena);
+  }
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createPlanBufferReusePass() {
+  return std::make_unique<PlanBufferReusePass>();
+}
+} // namespace imex
@@ -0,0 +1,347 @@
+//===- PromoteToSLM.cpp - PromoteToSLM Pass  --------------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file promotes the tiles of read-only kernel arguments which are
+/// reused by the work items of a work group, or read transposed to the lane
+/// order, to shared local memory. The tile is copied in cooperatively with
+/// coalesced reads before it is used.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include "UniformityAnalysis.h"
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Dialect/Utils/StaticValueUtils.h>
+#include <mlir/IR/Dominance.h>
+#include <mlir/Pass/Pass.h>
+
+#include <optional>
+
+namespace imex {
+#define GEN_PASS_DEF_PROMOTETOSLM
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+static constexpr llvm::StringLiteral kKnownBlockSizeAttrName =
+    "gpu.known_block_size";
+// OpenCL memory space of the shared local memory, mapped to the SPIR-V
+// Workgroup storage class by imex-convert-gpu-to-spirv.
+static constexpr unsigned kSLMMemorySpace = 3;
+
+/// A memref index of the form `sum(uniform) + [gpu.thread_id dim] + offset`.
+struct TileIndex {
+  llvm::SmallVector<mlir::Value> uniformTerms;
+  std::optional<mlir::gpu::Dimension> threadDim;
+  int64_t offset = 0;
+};
+
+std::optional<TileIndex> decompose(imex::UniformityAnalysis &analysis,
+                                   mlir::Value index) {
+  TileIndex res;
+  llvm::SmallVector<mlir::Value> worklist{index};
+  while (!worklist.empty()) {
+    auto value = worklist.pop_back_val();
+    if (auto add = value.getDefiningOp<mlir::arith::AddIOp>()) {
+      worklist.push_back(add.getLhs());
+      worklist.push_back(add.getRhs());
+    } else if (auto cst = mlir::getConstantIntValue(value)) {
+      res.offset += *cst;
+    } else if (auto tid = value.getDefiningOp<mlir::gpu::ThreadIdOp>()) {
+      if (res.threadDim)
+        return std::nullopt;
+      res.threadDim = tid.getDimension();
+    } else if (analysis.isUniform(value)) {
+      res.uniformTerms.push_back(value);
+    } else {
+      return std::nullopt;
+    }
+  }
+  llvm::sort(res.uniformTerms, [](mlir::Value lhs, mlir::Value rhs) {
+    return lhs.getAsOpaquePointer() < rhs.getAsOpaquePointer();
+  });
+  return res;
+}
+
+/// The loads of a kernel argument sharing one tile.
+struct Candidate {
+  mlir::BlockArgument memref;
+  llvm::SmallVector<mlir::memref::LoadOp> loads;
+  llvm::SmallVector<llvm::SmallVector<TileIndex>> indices;
+  // Per dimension: lowest offset and extent of the tile.
+  llvm::SmallVector<int64_t> minOffsets;
+  llvm::SmallVector<int64_t> extents;
+  bool transposed = false;
+};
+
+/// Collects the loads of arg and checks that they access a tile of the size
+/// of the work group plus constant offsets, which is worth promoting.
+std::optional<Candidate> analyze(imex::UniformityAnalysis &analysis,
+                                 mlir::BlockArgument arg,
+                                 llvm::ArrayRef<int32_t> blockSize) {
+  auto type = mlir::dyn_cast<mlir::MemRefType>(arg.getType());
+  if (!type || !type.hasStaticShape() || !type.getLayout().isIdentity() ||
+      type.getMemorySpace() || !type.getElementType().isIntOrFloat() ||
+      type.getRank() == 0)
+    return std::nullopt;
+
+  Candidate candidate;
+  candidate.memref = arg;
+  for (auto *user : arg.getUsers()) {
+    // Only read-only arguments are promoted, arguments are assumed not to
+    // alias.
+    auto load = mlir::dyn_cast<mlir::memref::LoadOp>(user);
+    if (!load)
+      return std::nullopt;
+    llvm::SmallVector<TileIndex> indices;
+    for (auto index : load.getIndices()) {
+      auto decomposed = decompose(analysis, index);
+      if (!decomposed)
+        return std::nullopt;
+      indices.push_back(*decomposed);
+    }
+    candidate.loads.push_back(load);
+    candidate.indices.push_back(std::move(indices));
+  }
+  if (candidate.loads.empty())
+    return std::nullopt;
+
+  // All loads must share the uniform base and the thread dimension.
+  auto rank = type.getRank();
+  auto &first = candidate.indices.front();
+  for (int64_t d = 0; d < rank; ++d) {
+    int64_t minOffset = first[d].offset;
+    int64_t maxOffset = first[d].offset;
+    for (auto &indices : candidate.indices) {
+      if (indices[d].uniformTerms != first[d].uniformTerms ||
+          indices[d].threadDim != first[d].threadDim)
+        return std::nullopt;
+      minOffset = std::min(minOffset, indices[d].offset);
+      maxOffset = std::max(maxOffset, indices[d].offset);
+    }
+    int64_t extent = maxOffset - minOffset + 1;
+    if (auto dim = first[d].threadDim)
+      extent += blockSize[static_cast<unsigned>(*dim)] - 1;
+    candidate.minOffsets.push_back(minOffset);
+    candidate.extents.push_back(extent);
+  }
+
+  // Reuse: work items read elements loaded by other work items. Transposed:
+  // consecutive lanes read along a dimension which isn't the innermost one,
+  // so the direct reads aren't coalesced.
+  bool reuse = llvm::any_of(candidate.indices, [&](auto &indices) {
+    return llvm::any_of(llvm::zip(indices, first), [](auto pair) {
+      return std::get<0>(pair).offset != std::get<1>(pair).offset;
+    });
+  });
+  auto xDim = llvm::find_if(first, [](const TileIndex &index) {
+    return index.threadDim == mlir::gpu::Dimension::x;
+  });
+  candidate.transposed =
+      xDim != first.end() && std::next(xDim) != first.end() &&
+      blockSize[static_cast<unsigned>(mlir::gpu::Dimension::x)] > 1;
+  if (!reuse && !candidate.transposed)
+    return std::nullopt;
+  return candidate;
+}
+
+/// Returns the shape of the tile of candidate. The innermost dimension of
+/// transposed tiles is padded so that the lanes reading a column hit
+/// different banks.
+llvm::SmallVector<int64_t> getTileShape(const Candidate &candidate) {
+  llvm::SmallVector<int64_t> shape(candidate.extents);
+  if (candidate.transposed)
+    ++shape.back();
+  return shape;
+}
+
+mlir::Value createThreadId(mlir::OpBuilder &builder, mlir::Location loc,
+                           mlir::gpu::Dimension dim) {
+  return builder.create<mlir::gpu::ThreadIdOp>(loc, dim);
+}
+
+/// Creates the tile of candidate and copies it in at the insertion point of
+/// builder, followed by a barrier.
+mlir::Value copyIn(mlir::OpBuilder &builder, const Candidate &candidate,
+                   llvm::ArrayRef<int32_t> blockSize) {
+  auto loc = candidate.memref.getLoc();
+  auto type = mlir::cast<mlir::MemRefType>(candidate.memref.getType());
+  auto cst = [&](int64_t value) -> mlir::Value {
+    return builder.create<mlir::arith::ConstantIndexOp>(loc, value);
+  };
+
+  auto tileType =
+      mlir::MemRefType::get(getTileShape(candidate), type.getElementType(),
+                            mlir::MemRefLayoutAttrInterface{},
+                            builder.getI64IntegerAttr(kSLMMemorySpace));
+  mlir::Value tile = builder.create<mlir::memref::AllocOp>(loc, tileType);
+
+  // for (%k = %linear_thread_id; %k < TILE_SIZE; %k += NUM_THREADS)
+  using mlir::gpu::Dimension;
+  mlir::Value linear = createThreadId(builder, loc, Dimension::z);
+  linear = builder.create<mlir::arith::MulIOp>(loc, linear, cst(blockSize[1]));
+  linear = builder.create<mlir::arith::AddIOp>(
+      loc, linear, createThreadId(builder, loc, Dimension::y));
+  linear = builder.create<mlir::arith::MulIOp>(loc, linear, cst(blockSize[0]));
+  linear = builder.create<mlir::arith::AddIOp>(
+      loc, linear, createThreadId(builder, loc, Dimension::x));
+  int64_t tileSize = 1;
+  for (auto extent : candidate.extents)
+    tileSize *= extent;
+  int64_t numThreads =
+      int64_t(blockSize[0]) * int64_t(blockSize[1]) * int64_t(blockSize[2]);
+  auto forOp = builder.create<mlir::scf::ForOp>(loc, linear, cst(tileSize),
+                                                cst(numThreads));
+  mlir::OpBuilder::InsertionGuard guard(builder);
+  builder.setInsertionPointToStart(forOp.getBody());
+
+  // Consecutive lanes copy consecutive elements of the innermost dimension.
+  auto rank = type.getRank();
+  auto &first = candidate.indices.front();
+  llvm::SmallVector<mlir::Value> tileIndices(rank);
+  llvm::SmallVector<mlir::Value> globalIndices(rank);
+  mlir::Value rest = forOp.getInductionVar();
+  mlir::Value inBounds;
+  for (auto d = rank; d-- > 0;) {
+    mlir::Value idx = rest;
+    if (d > 0) {
+      idx = builder.create<mlir::arith::RemUIOp>(loc, rest,
+                                                 cst(candidate.extents[d]));
+      rest = builder.create<mlir::arith::DivUIOp>(loc, rest,
+                                                  cst(candidate.extents[d]));
+    }
+    tileIndices[d] = idx;
+    mlir::Value global = builder.create<mlir::arith::AddIOp>(
+        loc, idx, cst(candidate.minOffsets[d]));
+    for (auto term : first[d].uniformTerms)
+      global = builder.create<mlir::arith::AddIOp>(loc, global, term);
+    globalIndices[d] = global;
+
+    // The tile may reach over the edges of the memref.
+    mlir::Value cond = builder.create<mlir::arith::CmpIOp>(
+        loc, mlir::arith::CmpIPredicate::ult, global,
+        cst(type.getDimSize(d)));
+    if (inBounds)
+      cond = builder.create<mlir::arith::AndIOp>(loc, inBounds, cond);
+    inBounds = cond;
+  }
+  auto ifOp = builder.create<mlir::scf::IfOp>(loc, inBounds,
+                                              /*withElseRegion=*/false);
+  builder.setInsertionPointToStart(ifOp.thenBlock());
+  auto value = builder.create<mlir::memref::LoadOp>(loc, candidate.memref,
+                                                    globalIndices);
+  builder.create<mlir::memref::StoreOp>(loc, value, tile, tileIndices);
+
+  builder.setInsertionPointAfter(forOp);
+  builder.create<mlir::gpu::BarrierOp>(loc);
+  return tile;
+}
+
+/// Replaces the loads of candidate by loads of tile.
+void redirectLoads(const Candidate &candidate, mlir::Value tile) {
+  for (auto [load, indices] : llvm::zip(candidate.loads, candidate.indices)) {
+    mlir::OpBuilder builder(load);
+    auto loc = load.getLoc();
+    llvm::SmallVector<mlir::Value> tileIndices;
+    for (auto [d, index] : llvm::enumerate(indices)) {
+      mlir::Value idx = builder.create<mlir::arith::ConstantIndexOp>(
+          loc, index.offset - candidate.minOffsets[d]);
+      if (index.threadDim)
+        idx = builder.create<mlir::arith::AddIOp>(
+            loc, createThreadId(builder, loc, *index.threadDim), idx);
+      tileIndices.push_back(idx);
+    }
+    auto newLoad = builder.create<mlir::memref::LoadOp>(loc, tile, tileIndices);
+    load.replaceAllUsesWith(newLoad.getResult());
+    load.erase();
+  }
+}
+
+struct PromoteToSLMPass final
+    : public imex::impl::PromoteToSLMBase<PromoteToSLMPass> {
+
+  void runOnOperation() override {
+    getOperation().walk([&](mlir::gpu::GPUFuncOp func) {
+      if (func.isKernel())
+        runOnKernel(func);
+    });
+  }
+
+  void runOnKernel(mlir::gpu::GPUFuncOp func) {
+    auto blockSizeAttr =
+        func->getAttrOfType<mlir::DenseI32ArrayAttr>(kKnownBlockSizeAttrName);
+    if (!blockSizeAttr || blockSizeAttr.size() != 3)
+      return;
+    auto blockSize = blockSizeAttr.asArrayRef();
+
+    imex::UniformityAnalysis analysis(func);
+    mlir::DominanceInfo dom(func);
+    auto &entry = func.getBody().front();
+    int64_t usedBytes = 0;
+    for (auto arg : func.getArguments()) {
+      auto candidate = analyze(analysis, arg, blockSize);
+      if (!candidate)
+        continue;
+
+      auto elemType =
+          mlir::cast<mlir::MemRefType>(arg.getType()).getElementType();
+      int64_t bytes = elemType.getIntOrFloatBitWidth() / 8;
+      for (auto size : getTileShape(*candidate))
+        bytes *= size;
+      if (usedBytes + bytes > maxSLMBytes)
+        continue;
+
+      // Copy in before the first load, at the top level of the kernel where
+      // all work items reach the barrier.
+      // Loads in other blocks of a kernel with unstructured control flow have
+      // no such point, their argument is left alone.
+      mlir::Operation *insertPoint = nullptr;
+      bool topLevel = true;
+      for (auto load : candidate->loads) {
+        auto *ancestor = entry.findAncestorOpInBlock(*load);
+        if (!ancestor) {
+          topLevel = false;
+          break;
+        }
+        if (!insertPoint || ancestor->isBeforeInBlock(insertPoint))
+          insertPoint = ancestor;
+      }
+      if (!topLevel || !insertPoint)
+        continue;
+      bool dominated = llvm::all_of(
+          candidate->indices.front(), [&](const TileIndex &index) {
+            return llvm::all_of(index.uniformTerms, [&](mlir::Value term) {
+              return dom.properlyDominates(term, insertPoint);
+            });
+          });
+      if (!dominated)
+        continue;
+
+      mlir::OpBuilder builder(insertPoint);
+      auto tile = copyIn(builder, *candidate, blockSize);
+      redirectLoads(*candidate, tile);
+      usedBytes += bytes;
+    }
+  }
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createPromoteToSLMPass() {
+  return std::make_unique<PromoteToSLMPass>();
+}
+} // namespace imex
@@ -13,8 +13,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Pass/Pass.h"
+#include <imex/Dialect/Region/IR/RegionOps.h>
 #include <imex/Utils/PassUtils.h>
 #include <mlir/Analysis/AliasAnalysis.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
 
 namespace imex {
 #define GEN_PASS_DEF_REMOVETEMPORARIES
@@ -65,20 +67,34 @@ namespace {
   return (it == users.end() ? nullptr : *it);
 }
 
-/// Finds all subviews of an operation
+/// Finds all subviews of a value
 /// Follows chained subview and cast ops
-void findAllSubviews(::mlir::Operation *op,
+void findAllSubviews(::mlir::Value val,
                      ::mlir::SmallVector<::mlir::Operation *> &foundOps) {
-  for (auto user : op->getUsers()) {
+  for (auto user : val.getUsers()) {
     if (::mlir::isa<::mlir::memref::SubViewOp>(user)) {
       foundOps.push_back(user);
     }
     if (::mlir::isa<::mlir::memref::SubViewOp, ::mlir::memref::CastOp>(user)) {
-      findAllSubviews(user, foundOps);
+      findAllSubviews(user->getResult(0), foundOps);
     }
   }
 }
 
+/// @return true if a memref.cast is applied to `val` or one of its subviews
+bool hasCastInSubviewChain(::mlir::Value val) {
+  for (auto user : val.getUsers()) {
+    if (::mlir::isa<::mlir::memref::CastOp>(user)) {
+      return true;
+    }
+    if (::mlir::isa<::mlir::memref::SubViewOp>(user) &&
+        hasCastInSubviewChain(user->getResult(0))) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /// Returns the root value in a chain of memref.subview/cast ops
 /// Appends all found subview ops to `subviewOps` vector.
 ::mlir::Value
@@ -180,6 +196,17 @@ bool collectMatchingOps(
   return true;
 }
 
+/// Collect all users of `val`, including the ones nested in regions, that have
+/// a write effect on `val`.
+void collectWritingUsers(::mlir::Value val,
+                         ::mlir::SmallVector<::mlir::Operation *> &foundOps) {
+  for (auto user : val.getUsers()) {
+    if (opHasWriteEffect(val, user) && !llvm::is_contained(foundOps, user)) {
+      foundOps.emplace_back(user);
+    }
+  }
+}
+
 /// Collect all operations between `startOp` and `endOp` that have a write
 /// effect on `val`.
 /// @return true if property checking succeeded
@@ -262,16 +289,18 @@ bool opHasRAWConflict(mlir::Operation *op, mlir::Value writeVal,
       ::mlir::SmallVector<::mlir::Operation *> newSVOps, readSVOps;
       auto newRoot = findSubviewRootValue(newVal, newSVOps);
       auto readRoot = findSubviewRootValue(readVal, readSVOps);
-      auto readType = readVal.getType().dyn_cast<::mlir::MemRefType>();
-      auto newType = newVal.getType().dyn_cast<::mlir::MemRefType>();
-      if (newRoot == readRoot && readType && newType) {
-        // check memref types of write and read operands
+      auto rootType = newRoot.getType().dyn_cast<::mlir::MemRefType>();
+      if (newRoot == readRoot && rootType) {
+        // check memref types of write and read operands, both chains start
+        // at the common root
         // 1) infer static-layout memref type for readVal by applying subviews
-        auto readType2 = inferSubviewChainResultType(readType, readSVOps);
-        // append all writeVal subviews to newVal subview chain
-        findSubviewRootValue(writeVal, newSVOps);
+        auto readType2 = inferSubviewChainResultType(rootType, readSVOps);
+        // the writeVal subviews are applied on top of the newVal subviews
+        ::mlir::SmallVector<::mlir::Operation *> writeSVOps;
+        findSubviewRootValue(writeVal, writeSVOps);
+        writeSVOps.append(newSVOps);
         // 2) infer what write operand memref type would be after replacement
-        auto writeType = inferSubviewChainResultType(newType, newSVOps);
+        auto writeType = inferSubviewChainResultType(rootType, writeSVOps);
         DEBUG_MSG("checkReadWriteConflict", "   readType: " << readType2)
         DEBUG_MSG("checkReadWriteConflict", "  writeType: " << writeType)
         compatibleMemrefs = safeToWrite(writeType, readType2);
@@ -287,19 +316,14 @@ bool opHasRAWConflict(mlir::Operation *op, mlir::Value writeVal,
   return false;
 }
 
-/// Checks whether replacing `scrAllocOp` with `dstDefOp` would result in a
-/// read/write conflict in some operation that writes into `scrAllocOp` value.
+/// Checks whether replacing `srcVal` with `newVal` would result in a
+/// read/write conflict in some operation that writes into `srcVal`.
 /// @return true if no conflict is found
-bool checkReadWriteConflict(mlir::Operation *op, mlir::Operation *srcAllocOp,
-                            mlir::Operation *dstDefOp,
-                            mlir::AliasAnalysis &mAlias) {
-  // find all ops that write to srcAlloc, traverse through all blocks
-  auto srcVal = srcAllocOp->getResult(0);
-  auto newVal = dstDefOp->getResult(0);
+bool checkReadWriteConflict(mlir::Operation *op, mlir::Value srcVal,
+                            mlir::Value newVal, mlir::AliasAnalysis &mAlias) {
+  // find all ops that write to srcAlloc, including nested ones
   ::mlir::SmallVector<::mlir::Operation *> srcAllocWriteOps;
-  if (!collectWriteEffectOps(srcAllocOp, nullptr, srcAllocWriteOps, srcVal)) {
-    return false;
-  }
+  collectWritingUsers(srcVal, srcAllocWriteOps);
   DEBUG_OP_VEC("checkReadWriteConflict", "ops that write to src alloc",
                srcAllocWriteOps)
   // check if op has potential write conflict
@@ -310,14 +334,12 @@ bool checkReadWriteConflict(mlir::Operation *op, mlir::Operation *srcAllocOp,
 
   // repeat to all ops that write to a view of srcAlloc
   ::mlir::SmallVector<::mlir::Operation *> srcSubviewOps;
-  findAllSubviews(srcAllocOp, srcSubviewOps);
+  findAllSubviews(srcVal, srcSubviewOps);
   DEBUG_OP_VEC("checkReadWriteConflict", "src subview ops", srcSubviewOps)
   for (auto sview : srcSubviewOps) {
     ::mlir::SmallVector<::mlir::Operation *> writeOps;
     auto svVal = sview->getResult(0);
-    if (!collectWriteEffectOps(srcAllocOp, nullptr, writeOps, svVal)) {
-      return false;
-    }
+    collectWritingUsers(svVal, writeOps);
     DEBUG_OP("checkReadWriteConflict", "inspecting src alloc view", sview)
     DEBUG_OP_VEC("checkReadWriteConflict", "ops that write to a src alloc view",
                  writeOps)
@@ -329,20 +351,19 @@ bool checkReadWriteConflict(mlir::Operation *op, mlir::Operation *srcAllocOp,
   return true;
 }
 
-/// Replace the uses of `oldOp` with the given `val` and for subview uses
+/// Replace the uses of `oldVal` with the given `val` and for subview uses
 /// propagate the type change. Changing the memref type may require
 /// propagating it through subview ops so we cannot just do a replaceAllUse
 /// but need to propagate the type change and erase old subview ops. Ported
 /// from mlir memref MultiBuffer.cpp
 static void replaceUsesAndPropagateType(mlir::RewriterBase &rewriter,
-                                        mlir::Operation *oldOp,
-                                        mlir::Value val) {
+                                        mlir::Value oldVal, mlir::Value val) {
   mlir::SmallVector<mlir::Operation *> opsToDelete;
   mlir::SmallVector<mlir::OpOperand *> operandsToReplace;
 
   // Save the operand to replace / delete later (avoid iterator invalidation).
   // TODO: can we use an early_inc iterator?
-  for (mlir::OpOperand &use : oldOp->getUses()) {
+  for (mlir::OpOperand &use : oldVal.getUses()) {
     // Check for dealloc ops
     if (auto effects =
             ::mlir::dyn_cast<::mlir::MemoryEffectOpInterface>(use.getOwner())) {
@@ -371,7 +392,7 @@ static void replaceUsesAndPropagateType(mlir::RewriterBase &rewriter,
         subviewUse.getMixedStrides());
 
     // Ouch recursion ... is this really necessary?
-    replaceUsesAndPropagateType(rewriter, subviewUse, newSubview);
+    replaceUsesAndPropagateType(rewriter, subviewUse.getResult(), newSubview);
 
     opsToDelete.push_back(use.getOwner());
   }
@@ -442,6 +463,169 @@ bool moveAfterIfPossible(::mlir::Operation *op, ::mlir::Operation *markerOp,
   return false;
 }
 
+/// @return true if `val` properly dominates all users of `oldVal`
+bool dominatesAllUses(::mlir::DominanceInfo &dom, ::mlir::Value val,
+                      ::mlir::Value oldVal) {
+  return llvm::all_of(oldVal.getUsers(), [&](::mlir::Operation *user) {
+    return dom.properlyDominates(val, user);
+  });
+}
+
+/// Returns the ancestor of `op` in `block` if all ops in between execute
+/// their region exactly once (region.env_region) or in sequential
+/// iterations (scf.for), nullptr otherwise. Sets `inLoop` if an scf.for is
+/// crossed.
+::mlir::Operation *findTransparentAncestor(::mlir::Operation *op,
+                                           ::mlir::Block *block,
+                                           bool &inLoop) {
+  auto anchor = block->findAncestorOpInBlock(*op);
+  if (!anchor) {
+    return nullptr;
+  }
+  for (auto parent = op; parent != anchor;) {
+    parent = parent->getParentOp();
+    if (::mlir::isa<::mlir::scf::ForOp>(parent)) {
+      inLoop = true;
+    } else if (!::mlir::isa<::imex::region::EnvironmentRegionOp>(parent)) {
+      return nullptr;
+    }
+  }
+  return anchor;
+}
+
+/// @return true if `op` has a write effect on `val` itself
+bool opWritesToValue(::mlir::Operation *op, ::mlir::Value val) {
+  auto memEffect = ::mlir::dyn_cast<::mlir::MemoryEffectOpInterface>(op);
+  if (!memEffect) {
+    return false;
+  }
+  ::mlir::SmallVector<::mlir::MemoryEffects::EffectInstance, 2> effects;
+  memEffect.getEffects(effects);
+  return llvm::any_of(
+      effects, [&](::mlir::MemoryEffects::EffectInstance effect) {
+        return effect.getValue() == val &&
+               ::mlir::isa<::mlir::MemoryEffects::Write>(effect.getEffect());
+      });
+}
+
+/// Collects the ops writing to `src` or one of its views into `srcWriteOps`.
+/// @return false if `src` is used after `copyOp` in its block or outside of
+/// that block, if `inLoop` is set.
+static bool collectSrcWriteOps(
+    ::mlir::Operation *copyOp, ::mlir::Value src, bool inLoop,
+    ::mlir::SmallPtrSetImpl<::mlir::Operation *> &srcWriteOps) {
+  auto block = copyOp->getBlock();
+  ::mlir::SmallVector<::mlir::Value> worklist = {src};
+  while (!worklist.empty()) {
+    auto val = worklist.pop_back_val();
+    for (auto user : val.getUsers()) {
+      if (::mlir::isa<::mlir::memref::SubViewOp, ::mlir::memref::CastOp>(
+              user)) {
+        worklist.push_back(user->getResult(0));
+      }
+      if (auto effects =
+              ::mlir::dyn_cast<::mlir::MemoryEffectOpInterface>(user)) {
+        if (effects.hasEffect<::mlir::MemoryEffects::Free>()) {
+          continue;
+        }
+      }
+      if (inLoop) {
+        auto ancestor = block->findAncestorOpInBlock(*user);
+        if (!ancestor || copyOp->isBeforeInBlock(ancestor)) {
+          DEBUG_OP("canForwardInLoop", "  src used after copy by", user)
+          return false;
+        }
+      }
+      if (opWritesToValue(user, val)) {
+        srcWriteOps.insert(user);
+      }
+    }
+  }
+  return true;
+}
+
+/// @return true if `op` accesses the memref `dstRoot` or one of its views and
+/// is neither `copyOp` nor one of `srcWriteOps`, which are checked for
+/// read/write conflicts separately
+static bool
+accessesDst(::mlir::Operation *op, ::mlir::Operation *copyOp,
+            const ::mlir::SmallPtrSetImpl<::mlir::Operation *> &srcWriteOps,
+            ::mlir::Value dstRoot) {
+  if (op == copyOp || srcWriteOps.contains(op) ||
+      ::mlir::isa<::mlir::memref::SubViewOp, ::mlir::memref::CastOp>(op)) {
+    return false;
+  }
+  for (auto operand : op->getOperands()) {
+    ::mlir::SmallVector<::mlir::Operation *> svOps;
+    if (findSubviewRootValue(operand, svOps) == dstRoot) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Checks whether the temporary `src`, which is allocated outside of the
+/// loop body containing the copy op `copyOp`, can be replaced by the copy
+/// target `dst`. This is the case if `src` and its views are only used
+/// before `copyOp` in its block, so that `src` holds the value of `dst` at
+/// the start of every iteration, and `dst` is accessed in the block only by
+/// `copyOp` and by ops writing to `src`, which are checked for read/write
+/// conflicts separately.
+bool canForwardInLoop(::mlir::Operation *copyOp, ::mlir::Value src,
+                      ::mlir::Value dst) {
+  ::mlir::SmallPtrSet<::mlir::Operation *, 8> srcWriteOps;
+  if (!collectSrcWriteOps(copyOp, src, /*inLoop=*/true, srcWriteOps)) {
+    return false;
+  }
+
+  ::mlir::SmallVector<::mlir::Operation *> dstSVOps;
+  auto dstRoot = findSubviewRootValue(dst, dstSVOps);
+  auto res = copyOp->getBlock()->walk([&](::mlir::Operation *op) {
+    if (accessesDst(op, copyOp, srcWriteOps, dstRoot)) {
+      DEBUG_OP("canForwardInLoop", "  dst accessed by", op)
+      return ::mlir::WalkResult::interrupt();
+    }
+    return ::mlir::WalkResult::advance();
+  });
+  return !res.wasInterrupted();
+}
+
+/// Checks whether the temporary `src`, allocated by `srcAllocOp`, can be
+/// replaced by the copy target `dst` of `copyOp`, which is nested in regions
+/// other than loops in the block of `srcAllocOp`. Once replaced, the ops
+/// writing to `src` write to `dst` before the copy, so no other op may
+/// access `dst` between `srcAllocOp` and `copyOp`.
+bool canForwardAcrossRegions(::mlir::Operation *copyOp,
+                             ::mlir::Operation *srcAllocOp, ::mlir::Value src,
+                             ::mlir::Value dst) {
+  ::mlir::SmallPtrSet<::mlir::Operation *, 8> srcWriteOps;
+  (void)collectSrcWriteOps(copyOp, src, /*inLoop=*/false, srcWriteOps);
+
+  ::mlir::SmallVector<::mlir::Operation *> dstSVOps;
+  auto dstRoot = findSubviewRootValue(dst, dstSVOps);
+  auto copyBlock = copyOp->getBlock();
+  auto copyAncestor = srcAllocOp->getBlock()->findAncestorOpInBlock(*copyOp);
+  auto end = std::next(copyAncestor->getIterator());
+  for (auto it = std::next(srcAllocOp->getIterator()); it != end; ++it) {
+    auto res = it->walk([&](::mlir::Operation *op) {
+      // accesses following the copy see the value of src anyway
+      auto ancestor = copyBlock->findAncestorOpInBlock(*op);
+      if (ancestor && copyOp->isBeforeInBlock(ancestor)) {
+        return ::mlir::WalkResult::advance();
+      }
+      if (accessesDst(op, copyOp, srcWriteOps, dstRoot)) {
+        DEBUG_OP("canForwardAcrossRegions", "  dst accessed by", op)
+        return ::mlir::WalkResult::interrupt();
+      }
+      return ::mlir::WalkResult::advance();
+    });
+    if (res.wasInterrupted()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 struct RemoveTemporaries
     : public imex::impl::RemoveTemporariesBase<RemoveTemporaries> {
   void runOnOperation() override {
@@ -485,39 +669,63 @@ private:
     DEBUG_OP("RemoveTemporaries", "inspecting", op)
     DEBUG_OP("RemoveTemporaries", "  src alloc op", srcAllocOp)
 
-    if (copyOpParentReg != allocOpParentReg) {
-      DEBUG_MSG("RemoveTemporaries",
-                "alloc and copy are in different regions, skipping")
+    if (hasCastInSubviewChain(src)) {
+      DEBUG_MSG("RemoveTemporaries", "src alloc is casted, skipping")
       return;
     }
-    if (dstDefOp) {
+    auto &memrefAlias = getAnalysis<mlir::AliasAnalysis>();
+    auto &dom = getAnalysis<::mlir::DominanceInfo>();
+    if (copyOpParentReg != allocOpParentReg) {
+      // The copy is nested in env regions or loops in the block of the alloc
+      bool inLoop = false;
+      if (!findTransparentAncestor(op, srcAllocOp->getBlock(), inLoop)) {
+        DEBUG_MSG("RemoveTemporaries",
+                  "copy is nested in an unsupported region, skipping")
+        return;
+      }
+      if (!dominatesAllUses(dom, dst, src)) {
+        DEBUG_MSG("RemoveTemporaries",
+                  "dst does not dominate uses of src alloc, skipping")
+        return;
+      }
+      if (inLoop && !canForwardInLoop(op, src, dst)) {
+        DEBUG_MSG("RemoveTemporaries",
+                  "cannot forward dst through loop iterations, skipping")
+        return;
+      }
+      if (!inLoop && !canForwardAcrossRegions(op, srcAllocOp, src, dst)) {
+        DEBUG_MSG("RemoveTemporaries",
+                  "dst accessed between src alloc and copy, skipping")
+        return;
+      }
+      if (!checkReadWriteConflict(op, src, dst, memrefAlias)) {
+        DEBUG_MSG("RemoveTemporaries",
+                  "found read after write conflict, skipping")
+        return;
+      }
+    } else if (dstDefOp) {
       // There is a dst defining op
       DEBUG_OP("RemoveTemporaries", "  defining op", dstDefOp)
-      auto &memrefAlias = getAnalysis<mlir::AliasAnalysis>();
-      memrefAlias.alias(src, dst);
-      if (!checkReadWriteConflict(op, srcAllocOp, dstDefOp, memrefAlias)) {
+      if (!checkReadWriteConflict(op, src, dst, memrefAlias)) {
         DEBUG_MSG("RemoveTemporaries",
                   "found read after write conflict, skipping")
         return;
       }
-      // Move copy target right after src allocation
-      auto &dom = getAnalysis<::mlir::DominanceInfo>();
-      if (!moveAfterIfPossible(dstDefOp, srcAllocOp, op, dom)) {
+      // Move copy target right after src allocation unless it already
+      // dominates all uses of src
+      if (!dominatesAllUses(dom, dst, src) &&
+          !moveAfterIfPossible(dstDefOp, srcAllocOp, op, dom)) {
         DEBUG_MSG("RemoveTemporaries", "cannot move dst defining op, skipping")
         return;
       }
-      // Replace src alloc uses by dst defining op
-      DEBUG_OP("RemoveTemporaries", "  replacing src alloc", srcAllocOp)
-      DEBUG_OP("RemoveTemporaries", "   with", dstDefOp)
-      replaceUsesAndPropagateType(rewriter, srcAllocOp, dstDefOp->getResult(0));
-    } else {
-      // no defining op, replace src with dst mlir::Value
-      DEBUG_OP("RemoveTemporaries", "  replacing src alloc", srcAllocOp)
-      DEBUG_MSG("RemoveTemporaries", "    with copy op dst value")
-      replaceUsesAndPropagateType(rewriter, srcAllocOp, dst);
     }
+    // Replace src alloc uses by copy op dst value
+    DEBUG_OP("RemoveTemporaries", "  replacing src alloc", srcAllocOp)
+    DEBUG_MSG("RemoveTemporaries", "    with copy op dst value")
+    replaceUsesAndPropagateType(rewriter, src, dst);
     DEBUG_OP("RemoveTemporaries", "  removing op", op)
     opsToRemove.push_back(op);
+    ++numRemovedCopies;
     if (srcDeallocOp) {
       DEBUG_OP("RemoveTemporaries", "  removing src dealloc op", srcDeallocOp)
       opsToRemove.push_back(srcDeallocOp);
@@ -527,8 +735,13 @@ private:
       DEBUG_OP("RemoveTemporaries", "  removing dst dealloc op", dstDeallocOp)
       opsToRemove.push_back(dstDeallocOp);
     }
-    DEBUG_OP("RemoveTemporaries", "  removing src alloc op", srcAllocOp)
-    opsToRemove.push_back(srcAllocOp);
+    // other results of a multi-result allocation may still be in use
+    if (llvm::all_of(srcAllocOp->getResults(), [&](::mlir::Value res) {
+          return res == src || res.use_empty();
+        })) {
+      DEBUG_OP("RemoveTemporaries", "  removing src alloc op", srcAllocOp)
+      opsToRemove.push_back(srcAllocOp);
+    }
   }
 };
 
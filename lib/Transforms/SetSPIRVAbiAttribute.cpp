@@ -23,6 +23,8 @@
 #include <mlir/Dialect/SPIRV/IR/TargetAndABI.h>
 #include <mlir/Pass/Pass.h>
 
+#include <optional>
+
 namespace imex {
 #define GEN_PASS_DEF_SETSPIRVABIATTRIBUTE
 #include "imex/Transforms/Passes.h.inc"
@@ -55,8 +57,11 @@ public:
     auto *context = &getContext();
     auto attrName =
         mlir::StringAttr::get(context, mlir::spirv::getEntryPointABIAttrName());
+    std::optional<int> sgSize;
+    if (subgroupSize > 0)
+      sgSize = static_cast<int>(subgroupSize);
     if (m_clientAPI == "opencl") {
-      auto abi = mlir::spirv::getEntryPointABIAttr(context);
+      auto abi = mlir::spirv::getEntryPointABIAttr(context, {}, sgSize);
       for (const auto &gpuFunc : gpuModule.getOps<mlir::gpu::GPUFuncOp>()) {
         if (!mlir::gpu::GPUDialect::isKernel(gpuFunc) ||
             gpuFunc->getAttr(attrName))
@@ -65,7 +70,7 @@ public:
         gpuFunc->setAttr(attrName, abi);
       }
     } else if (m_clientAPI == "vulkan") {
-      auto abi = mlir::spirv::getEntryPointABIAttr(context, {1, 1, 1});
+      auto abi = mlir::spirv::getEntryPointABIAttr(context, {1, 1, 1}, sgSize);
       for (const auto &gpuFunc : gpuModule.getOps<mlir::gpu::GPUFuncOp>()) {
         if (!mlir::gpu::GPUDialect::isKernel(gpuFunc) ||
             gpuFunc->getAttr(attrName))
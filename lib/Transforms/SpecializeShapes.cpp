@@ -0,0 +1,268 @@
+//===- SpecializeShapes.cpp - SpecializeShapes Pass  ------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file clones functions with dynamically shaped arguments for concrete
+/// shapes and turns the original function into a dispatcher which calls the
+/// clone matching the shapes of its arguments. Within a clone all argument
+/// dims are constant, so loops get static bounds and can be vectorized and
+/// unrolled, while calls with other shapes take the unchanged generic path.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Dialect/Tensor/IR/Tensor.h>
+#include <mlir/IR/SymbolTable.h>
+#include <mlir/Pass/Pass.h>
+#include <mlir/Rewrite/FrozenRewritePatternSet.h>
+#include <mlir/Transforms/GreedyPatternRewriteDriver.h>
+
+namespace imex {
+#define GEN_PASS_DEF_SPECIALIZESHAPES
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+static constexpr llvm::StringLiteral kSpecializeAttrName =
+    "imex.specialize_shapes";
+
+/// The static argument types of one specialization, indexed like the
+/// function arguments. Arguments which are not specialized keep their type.
+using Specialization = llvm::SmallVector<mlir::Type>;
+
+bool isSpecializable(mlir::Type type) {
+  return type.isa<mlir::MemRefType, mlir::RankedTensorType>();
+}
+
+/// Parses the `imex.specialize_shapes` attribute of func. Entries which
+/// leave all argument types unchanged are dropped. Returns failure and emits
+/// an error if the attribute does not match the signature of func.
+mlir::LogicalResult
+parseSpecializations(mlir::func::FuncOp func, mlir::ArrayAttr attr,
+                     llvm::SmallVectorImpl<Specialization> &specs) {
+  auto argTypes = func.getArgumentTypes();
+  for (auto entry : attr) {
+    auto shapes = entry.dyn_cast<mlir::ArrayAttr>();
+    if (!shapes)
+      return func.emitError() << kSpecializeAttrName
+                              << " expects an array of shape arrays";
+
+    Specialization spec(argTypes.begin(), argTypes.end());
+    bool isDynamic = false;
+    unsigned next = 0;
+    for (auto [i, argType] : llvm::enumerate(argTypes)) {
+      if (!isSpecializable(argType))
+        continue;
+      if (next >= shapes.size())
+        return func.emitError() << kSpecializeAttrName
+                                << " has too few shapes for the arguments";
+      auto shape = shapes[next++].dyn_cast<mlir::DenseI64ArrayAttr>();
+      auto shapedType = argType.cast<mlir::ShapedType>();
+      if (!shape || shape.size() != shapedType.getRank())
+        return func.emitError()
+               << kSpecializeAttrName << " has a shape of wrong rank for "
+               << "argument " << i;
+      for (auto [dim, size] : llvm::enumerate(shape.asArrayRef())) {
+        if (size < 0 || (!shapedType.isDynamicDim(dim) &&
+                         shapedType.getDimSize(dim) != size))
+          return func.emitError()
+                 << kSpecializeAttrName << " has a shape incompatible with "
+                 << "argument " << i;
+        isDynamic |= shapedType.isDynamicDim(dim);
+      }
+      spec[i] = shapedType.clone(shape.asArrayRef());
+    }
+    if (next != shapes.size())
+      return func.emitError() << kSpecializeAttrName
+                              << " has more shapes than arguments";
+    if (isDynamic)
+      specs.push_back(std::move(spec));
+  }
+  return mlir::success();
+}
+
+/// Casts value to type, which only differs in the static sizes.
+mlir::Value createShapeCast(mlir::OpBuilder &builder, mlir::Location loc,
+                            mlir::Type type, mlir::Value value) {
+  if (type == value.getType())
+    return value;
+  if (type.isa<mlir::MemRefType>())
+    return builder.create<mlir::memref::CastOp>(loc, type, value);
+  return builder.create<mlir::tensor::CastOp>(loc, type, value);
+}
+
+/// Returns a private clone of func named name, inserted after func, whose
+/// arguments have the types of spec. The body sees the original types
+/// through casts.
+mlir::func::FuncOp createClone(mlir::func::FuncOp func, llvm::StringRef name,
+                               const Specialization &spec) {
+  auto clone = func.clone();
+  clone.setName(name);
+  clone.setPrivate();
+  mlir::OpBuilder builder(func);
+  builder.setInsertionPointAfter(func);
+  builder.insert(clone);
+
+  auto &entry = clone.getBody().front();
+  builder.setInsertionPointToStart(&entry);
+  for (auto [arg, type] : llvm::zip(entry.getArguments(), spec)) {
+    auto origType = arg.getType();
+    if (type == origType)
+      continue;
+    arg.setType(type);
+    auto cast = createShapeCast(builder, clone.getLoc(), origType, arg);
+    arg.replaceAllUsesExcept(cast, cast.getDefiningOp());
+  }
+  clone.setFunctionType(builder.getFunctionType(
+      spec, clone.getFunctionType().getResults()));
+  return clone;
+}
+
+/// Returns an i1 which is true if the sizes of args match spec.
+mlir::Value createMatch(mlir::OpBuilder &builder, mlir::Location loc,
+                        mlir::ValueRange args, const Specialization &spec) {
+  mlir::Value match;
+  for (auto [arg, type] : llvm::zip(args, spec)) {
+    auto argType = arg.getType().dyn_cast<mlir::ShapedType>();
+    if (!argType || type == argType)
+      continue;
+    auto shape = type.cast<mlir::ShapedType>().getShape();
+    for (auto [i, size] : llvm::enumerate(shape)) {
+      if (!argType.isDynamicDim(i))
+        continue;
+      mlir::Value dim =
+          argType.isa<mlir::MemRefType>()
+              ? builder.create<mlir::memref::DimOp>(loc, arg, i).getResult()
+              : builder.create<mlir::tensor::DimOp>(loc, arg, i).getResult();
+      auto expected = builder.create<mlir::arith::ConstantIndexOp>(loc, size);
+      mlir::Value eq = builder.create<mlir::arith::CmpIOp>(
+          loc, mlir::arith::CmpIPredicate::eq, dim, expected);
+      match = match ? builder.create<mlir::arith::AndIOp>(loc, match, eq)
+                          .getResult()
+                    : eq;
+    }
+  }
+  return match;
+}
+
+/// Creates the calls of the clones, guarded by the shape checks, at the
+/// insertion point of builder and returns the results. Specializations are
+/// tried in order, the generic clone is called if none matches.
+mlir::ValueRange createDispatch(mlir::OpBuilder &builder, mlir::Location loc,
+                                mlir::ValueRange args,
+                                llvm::ArrayRef<Specialization> specs,
+                                llvm::ArrayRef<mlir::func::FuncOp> clones,
+                                mlir::func::FuncOp generic) {
+  if (specs.empty())
+    return builder.create<mlir::func::CallOp>(loc, generic, args).getResults();
+
+  auto match = createMatch(builder, loc, args, specs.front());
+  auto ifOp = builder.create<mlir::scf::IfOp>(
+      loc, match,
+      [&](mlir::OpBuilder &b, mlir::Location l) {
+        llvm::SmallVector<mlir::Value> castArgs;
+        for (auto [arg, type] : llvm::zip(args, specs.front()))
+          castArgs.push_back(createShapeCast(b, l, type, arg));
+        auto call = b.create<mlir::func::CallOp>(l, clones.front(), castArgs);
+        b.create<mlir::scf::YieldOp>(l, call.getResults());
+      },
+      [&](mlir::OpBuilder &b, mlir::Location l) {
+        auto res = createDispatch(b, l, args, specs.drop_front(),
+                                  clones.drop_front(), generic);
+        b.create<mlir::scf::YieldOp>(l, res);
+      });
+  return ifOp.getResults();
+}
+
+struct SpecializeShapesPass final
+    : public imex::impl::SpecializeShapesBase<SpecializeShapesPass> {
+  using SpecializeShapesBase::SpecializeShapesBase;
+
+  mlir::LogicalResult initialize(mlir::MLIRContext *context) override {
+    // the canonicalization patterns propagate the static shapes through the
+    // bodies of the clones
+    mlir::RewritePatternSet owningPatterns(context);
+    for (auto *dialect : context->getLoadedDialects())
+      dialect->getCanonicalizationPatterns(owningPatterns);
+    for (auto op : context->getRegisteredOperations())
+      op.getCanonicalizationPatterns(owningPatterns, context);
+    patterns = std::make_shared<mlir::FrozenRewritePatternSet>(
+        std::move(owningPatterns));
+    return mlir::success();
+  }
+
+  void runOnOperation() override {
+    auto module = getOperation();
+    mlir::SymbolTable symbolTable(module);
+
+    llvm::SmallVector<mlir::func::FuncOp> funcs;
+    for (auto func : module.getOps<mlir::func::FuncOp>()) {
+      if (func->hasAttr(kSpecializeAttrName))
+        funcs.push_back(func);
+    }
+
+    for (auto func : funcs) {
+      auto attr = func->getAttrOfType<mlir::ArrayAttr>(kSpecializeAttrName);
+      func->removeAttr(kSpecializeAttrName);
+      if (!attr || func.isExternal()) {
+        func.emitError() << kSpecializeAttrName
+                         << " expects a function with a body and an array";
+        return signalPassFailure();
+      }
+
+      llvm::SmallVector<Specialization> specs;
+      if (mlir::failed(parseSpecializations(func, attr, specs)))
+        return signalPassFailure();
+      if (specs.size() > maxSpecializations)
+        specs.resize(maxSpecializations);
+      if (specs.empty())
+        continue;
+
+      // clones are inserted right after func, create them in reverse order
+      auto argTypes = func.getArgumentTypes();
+      auto generic = createClone(
+          func, (func.getName() + "_generic").str(),
+          Specialization(argTypes.begin(), argTypes.end()));
+      symbolTable.insert(generic);
+      llvm::SmallVector<mlir::func::FuncOp> clones(specs.size());
+      for (auto n = specs.size(); n-- > 0;) {
+        auto name = (func.getName() + "_spec" + llvm::Twine(n)).str();
+        clones[n] = createClone(func, name, specs[n]);
+        symbolTable.insert(clones[n]);
+        (void)mlir::applyPatternsAndFoldGreedily(clones[n], *patterns);
+      }
+
+      // turn func into the dispatcher
+      auto loc = func.getLoc();
+      func.eraseBody();
+      auto *entry = func.addEntryBlock();
+      mlir::OpBuilder builder = mlir::OpBuilder::atBlockBegin(entry);
+      auto results = createDispatch(builder, loc, entry->getArguments(),
+                                    specs, clones, generic);
+      builder.create<mlir::func::ReturnOp>(loc, results);
+    }
+  }
+
+private:
+  std::shared_ptr<mlir::FrozenRewritePatternSet> patterns;
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createSpecializeShapesPass() {
+  return std::make_unique<SpecializeShapesPass>();
+}
+} // namespace imex
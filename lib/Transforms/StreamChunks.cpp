@@ -0,0 +1,303 @@
+//===- StreamChunks.cpp - StreamChunks Pass  --------------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file streams bufferized linalg.generic ops over large memrefs chunk by
+/// chunk along their leading dimension. Every chunk of the operands is staged
+/// through two alternating chunk-sized buffers: while one chunk is computed
+/// the next one is loaded into the other buffer by an async.execute region,
+/// which is awaited before that chunk is computed. Compute only ever touches
+/// the staging buffers, so only chunk-sized buffers need to be resident in
+/// the memory the computation runs in, while the full arrays can live in host
+/// memory or memory-mapped files.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Async/IR/Async.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/Linalg/IR/Linalg.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Pass/Pass.h>
+
+namespace imex {
+#define GEN_PASS_DEF_STREAMCHUNKS
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+/// An operand of a streamed op which is accessed chunk by chunk.
+struct StreamedOperand {
+  unsigned index;
+  /// inputs, and outputs whose values are read by the payload, are loaded
+  /// into the staging buffers before compute
+  bool load;
+  /// outputs are stored back from the staging buffers after compute
+  bool store;
+  /// the two staging buffers
+  mlir::Value stage[2];
+};
+
+/// Returns true if map accesses the leading dim of the operand with d0 and
+/// d0 nowhere else.
+bool isStreamedMap(mlir::AffineMap map) {
+  if (map.getNumResults() == 0)
+    return false;
+  auto first = map.getResult(0).dyn_cast<mlir::AffineDimExpr>();
+  if (!first || first.getPosition() != 0)
+    return false;
+  for (auto expr : map.getResults().drop_front()) {
+    if (expr.isFunctionOfDim(0))
+      return false;
+  }
+  return true;
+}
+
+/// Collects the operands of op which are streamed. Returns false if op
+/// cannot be streamed: it must not be nested in a parallel op, its leading
+/// loop must be parallel and every output must be indexed by it in its
+/// leading dim. Inputs which do not depend on the leading loop, like
+/// broadcasted operands, are used whole.
+bool getStreamedOperands(mlir::linalg::GenericOp op, int64_t chunkSize,
+                         llvm::SmallVectorImpl<StreamedOperand> &streamed) {
+  if (op->getParentOfType<mlir::gpu::LaunchOp>() ||
+      op->getParentOfType<mlir::scf::ParallelOp>() || op->getNumResults() != 0)
+    return false;
+  auto iterators = op.getIteratorTypesArray();
+  if (iterators.empty() || !mlir::linalg::isParallelIterator(iterators[0]))
+    return false;
+  auto size = op.getStaticLoopRanges()[0];
+  if (!mlir::ShapedType::isDynamic(size) && size <= chunkSize)
+    return false;
+
+  for (auto &operand : op->getOpOperands()) {
+    auto type = operand.get().getType();
+    bool isOutput = op.isDpsInit(&operand);
+    if (type.isa<mlir::TensorType>())
+      return false;
+    auto map = op.getMatchingIndexingMap(&operand);
+    if (!type.isa<mlir::MemRefType>() || !map.isFunctionOfDim(0)) {
+      if (isOutput)
+        return false;
+      continue;
+    }
+    if (!isStreamedMap(map))
+      return false;
+    bool load = !isOutput || !op.getMatchingBlockArgument(&operand).use_empty();
+    streamed.push_back({operand.getOperandNumber(), load, isOutput, {}});
+  }
+  return true;
+}
+
+/// Returns the size of dim of the memref value.
+mlir::OpFoldResult getSize(mlir::OpBuilder &builder, mlir::Location loc,
+                           mlir::Value value, int64_t dim) {
+  auto type = value.getType().cast<mlir::MemRefType>();
+  if (!type.isDynamicDim(dim))
+    return builder.getIndexAttr(type.getDimSize(dim));
+  return builder.create<mlir::memref::DimOp>(loc, value, dim).getResult();
+}
+
+/// Returns the view of the rows [offset, offset + size) of the memref value.
+mlir::Value createChunkView(mlir::OpBuilder &builder, mlir::Location loc,
+                            mlir::Value value, mlir::OpFoldResult offset,
+                            mlir::Value size) {
+  auto rank = value.getType().cast<mlir::MemRefType>().getRank();
+  llvm::SmallVector<mlir::OpFoldResult> offsets(rank, builder.getIndexAttr(0));
+  llvm::SmallVector<mlir::OpFoldResult> sizes;
+  llvm::SmallVector<mlir::OpFoldResult> strides(rank, builder.getIndexAttr(1));
+  offsets[0] = offset;
+  sizes.push_back(size);
+  for (int64_t i = 1; i < rank; ++i)
+    sizes.push_back(getSize(builder, loc, value, i));
+  return builder.create<mlir::memref::SubViewOp>(loc, value, offsets, sizes,
+                                                 strides);
+}
+
+/// Returns a new chunk-sized buffer for the rows of the memref value.
+mlir::Value createStage(mlir::OpBuilder &builder, mlir::Location loc,
+                        mlir::Value value, int64_t chunkSize) {
+  auto type = value.getType().cast<mlir::MemRefType>();
+  llvm::SmallVector<int64_t> shape(type.getShape());
+  shape[0] = chunkSize;
+  llvm::SmallVector<mlir::Value> dynSizes;
+  for (int64_t i = 1; i < type.getRank(); ++i) {
+    if (type.isDynamicDim(i))
+      dynSizes.push_back(builder.create<mlir::memref::DimOp>(loc, value, i));
+  }
+  auto stageType = mlir::MemRefType::get(shape, type.getElementType());
+  return builder.create<mlir::memref::AllocOp>(loc, stageType, dynSizes);
+}
+
+/// Returns min(chunk, n - offset).
+mlir::Value createChunkSize(mlir::OpBuilder &builder, mlir::Location loc,
+                            mlir::Value chunk, mlir::Value n,
+                            mlir::Value offset) {
+  auto rest = builder.create<mlir::arith::SubIOp>(loc, n, offset);
+  return builder.create<mlir::arith::MinUIOp>(loc, chunk, rest);
+}
+
+/// Replaces op by a loop over the chunks of its leading dim.
+void streamOp(mlir::linalg::GenericOp op, int64_t chunkSize,
+              llvm::MutableArrayRef<StreamedOperand> streamed) {
+  auto loc = op.getLoc();
+  mlir::OpBuilder builder(op);
+  auto zero = builder.create<mlir::arith::ConstantIndexOp>(loc, 0);
+  auto one = builder.create<mlir::arith::ConstantIndexOp>(loc, 1);
+  auto two = builder.create<mlir::arith::ConstantIndexOp>(loc, 2);
+  auto chunk = builder.create<mlir::arith::ConstantIndexOp>(loc, chunkSize);
+  auto outputs = op.getDpsInits();
+  mlir::Value n = builder.create<mlir::memref::DimOp>(loc, outputs[0], 0);
+
+  for (auto &opnd : streamed) {
+    auto value = op->getOperand(opnd.index);
+    opnd.stage[0] = createStage(builder, loc, value, chunkSize);
+    // outputs which are not loaded need no second buffer
+    opnd.stage[1] = opnd.load ? createStage(builder, loc, value, chunkSize)
+                              : opnd.stage[0];
+  }
+
+  // copies the rows [offset, offset + size) of the loaded operands into stages
+  auto loadChunk = [&](mlir::OpBuilder &b, mlir::Location l,
+                       mlir::OpFoldResult offset, mlir::Value size,
+                       mlir::ArrayRef<mlir::Value> stages) {
+    for (auto [opnd, stage] : llvm::zip(streamed, stages)) {
+      if (!opnd.load)
+        continue;
+      auto value = op->getOperand(opnd.index);
+      b.create<mlir::memref::CopyOp>(
+          l, createChunkView(b, l, value, offset, size),
+          createChunkView(b, l, stage, b.getIndexAttr(0), size));
+    }
+  };
+
+  // start loading the first chunk
+  auto firstSize = createChunkSize(builder, loc, chunk, n, zero);
+  llvm::SmallVector<mlir::Value> first;
+  for (auto &opnd : streamed)
+    first.push_back(opnd.stage[0]);
+  auto firstLoad = builder.create<mlir::async::ExecuteOp>(
+      loc, mlir::TypeRange{}, mlir::ValueRange{}, mlir::ValueRange{},
+      [&](mlir::OpBuilder &b, mlir::Location l, mlir::ValueRange) {
+        loadChunk(b, l, b.getIndexAttr(0), firstSize, first);
+        b.create<mlir::async::YieldOp>(l, mlir::ValueRange{});
+      });
+
+  // the loop carries the token of the load of the chunk it computes next
+  auto loop = builder.create<mlir::scf::ForOp>(
+      loc, zero, n, chunk, mlir::ValueRange{firstLoad.getToken()});
+  builder.setInsertionPointToStart(loop.getBody());
+  auto offset = loop.getInductionVar();
+  auto loaded = loop.getRegionIterArgs()[0];
+  auto iter = builder.create<mlir::arith::DivUIOp>(loc, offset, chunk);
+  auto parity = builder.create<mlir::arith::RemUIOp>(loc, iter, two);
+  auto odd = builder.create<mlir::arith::CmpIOp>(
+      loc, mlir::arith::CmpIPredicate::eq, parity, one);
+  auto selectStage = [&](StreamedOperand &opnd, bool next) -> mlir::Value {
+    if (opnd.stage[0] == opnd.stage[1])
+      return opnd.stage[0];
+    return builder.create<mlir::arith::SelectOp>(
+        loc, odd, opnd.stage[next ? 0 : 1], opnd.stage[next ? 1 : 0]);
+  };
+  llvm::SmallVector<mlir::Value> current, next;
+  for (auto &opnd : streamed) {
+    current.push_back(selectStage(opnd, false));
+    next.push_back(selectStage(opnd, true));
+  }
+
+  // start prefetching the next chunk into the other buffers, it overlaps with
+  // computing this chunk, which must have been loaded before
+  auto nextOffset = builder.create<mlir::arith::AddIOp>(loc, offset, chunk);
+  auto hasNext = builder.create<mlir::arith::CmpIOp>(
+      loc, mlir::arith::CmpIPredicate::ult, nextOffset, n);
+  auto prefetch = builder.create<mlir::async::ExecuteOp>(
+      loc, mlir::TypeRange{}, mlir::ValueRange{}, mlir::ValueRange{},
+      [&](mlir::OpBuilder &b, mlir::Location l, mlir::ValueRange) {
+        b.create<mlir::scf::IfOp>(
+            l, hasNext, [&](mlir::OpBuilder &ib, mlir::Location il) {
+              auto nextSize = createChunkSize(ib, il, chunk, n, nextOffset);
+              loadChunk(ib, il, nextOffset.getResult(), nextSize, next);
+              ib.create<mlir::scf::YieldOp>(il);
+            });
+        b.create<mlir::async::YieldOp>(l, mlir::ValueRange{});
+      });
+  builder.create<mlir::async::AwaitOp>(loc, loaded);
+
+  // compute this chunk on the staging buffers and store the outputs
+  auto size = createChunkSize(builder, loc, chunk, n, offset);
+  llvm::SmallVector<mlir::Value> views;
+  for (auto stage : current)
+    views.push_back(
+        createChunkView(builder, loc, stage, builder.getIndexAttr(0), size));
+  // operands are replaced by index, the same memref may be passed twice
+  auto chunkOp = builder.clone(*op);
+  for (auto [opnd, view] : llvm::zip(streamed, views))
+    chunkOp->setOperand(opnd.index, view);
+  // the leading loop of the chunk starts at offset
+  chunkOp->walk([&](mlir::linalg::IndexOp indexOp) {
+    if (indexOp.getDim() != 0)
+      return;
+    mlir::OpBuilder b(indexOp);
+    b.setInsertionPointAfter(indexOp);
+    auto global =
+        b.create<mlir::arith::AddIOp>(indexOp.getLoc(), indexOp, offset);
+    indexOp.getResult().replaceAllUsesExcept(global, global);
+  });
+  for (auto [opnd, view] : llvm::zip(streamed, views)) {
+    if (!opnd.store)
+      continue;
+    auto value = op->getOperand(opnd.index);
+    builder.create<mlir::memref::CopyOp>(
+        loc, view, createChunkView(builder, loc, value, offset, size));
+  }
+  builder.create<mlir::scf::YieldOp>(loc, prefetch.getToken());
+
+  // the last prefetch has nothing to load but is awaited nevertheless
+  builder.setInsertionPointAfter(loop);
+  builder.create<mlir::async::AwaitOp>(loc, loop.getResult(0));
+  for (auto &opnd : streamed) {
+    builder.create<mlir::memref::DeallocOp>(loc, opnd.stage[0]);
+    if (opnd.stage[1] != opnd.stage[0])
+      builder.create<mlir::memref::DeallocOp>(loc, opnd.stage[1]);
+  }
+  op->erase();
+}
+
+struct StreamChunksPass final
+    : public imex::impl::StreamChunksBase<StreamChunksPass> {
+  using StreamChunksBase::StreamChunksBase;
+
+  void runOnOperation() override {
+    if (chunkSize <= 0) {
+      getOperation().emitError() << "chunk-size must be positive";
+      return signalPassFailure();
+    }
+
+    llvm::SmallVector<mlir::linalg::GenericOp> ops;
+    getOperation().walk([&](mlir::linalg::GenericOp op) { ops.push_back(op); });
+    for (auto op : ops) {
+      llvm::SmallVector<StreamedOperand> streamed;
+      if (getStreamedOperands(op, chunkSize, streamed))
+        streamOp(op, chunkSize, streamed);
+    }
+  }
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createStreamChunksPass() {
+  return std::make_unique<StreamChunksPass>();
+}
+} // namespace imex
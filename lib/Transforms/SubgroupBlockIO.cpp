@@ -0,0 +1,181 @@
+//===- SubgroupBlockIO.cpp - SubgroupBlockIO Pass  --------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file marks the memref loads and stores of kernels in which the lanes
+/// of a subgroup access consecutive elements from a subgroup-uniform base, so
+/// that imex-convert-gpu-to-spirv lowers them to the Intel subgroup block
+/// read/write instructions instead of one scattered access per lane.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include "UniformityAnalysis.h"
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SPIRV/IR/SPIRVAttributes.h>
+#include <mlir/Dialect/SPIRV/IR/TargetAndABI.h>
+#include <mlir/IR/Matchers.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/SetVector.h>
+
+namespace imex {
+#define GEN_PASS_DEF_SUBGROUPBLOCKIO
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+static constexpr llvm::StringLiteral kBlockIOAttrName =
+    "imex.subgroup_block_io";
+static constexpr llvm::StringLiteral kKnownBlockSizeAttrName =
+    "gpu.known_block_size";
+
+/// Returns true if value is provably a multiple of factor.
+bool isMultipleOf(mlir::Value value, int64_t factor) {
+  llvm::APInt cst;
+  if (mlir::matchPattern(value, mlir::m_ConstantInt(&cst)))
+    return cst.getSExtValue() % factor == 0;
+  auto *op = value.getDefiningOp();
+  if (!op)
+    return false;
+  if (auto mul = mlir::dyn_cast<mlir::arith::MulIOp>(op))
+    return isMultipleOf(mul.getLhs(), factor) ||
+           isMultipleOf(mul.getRhs(), factor);
+  if (mlir::isa<mlir::arith::AddIOp, mlir::arith::SubIOp>(op))
+    return isMultipleOf(op->getOperand(0), factor) &&
+           isMultipleOf(op->getOperand(1), factor);
+  if (auto shl = mlir::dyn_cast<mlir::arith::ShLIOp>(op)) {
+    if (isMultipleOf(shl.getLhs(), factor))
+      return true;
+    llvm::APInt shift;
+    return mlir::matchPattern(shl.getRhs(), mlir::m_ConstantInt(&shift)) &&
+           shift.ult(63) && (int64_t(1) << shift.getZExtValue()) % factor == 0;
+  }
+  return false;
+}
+
+/// Returns true if index is `%uniform + gpu.thread_id x` with %uniform a
+/// multiple of the subgroup size, i.e. the first lane of each subgroup
+/// accesses an element aligned to the subgroup.
+bool isLaneContiguous(imex::UniformityAnalysis &analysis, mlir::Value index,
+                      int64_t sgSize) {
+  auto add = index.getDefiningOp<mlir::arith::AddIOp>();
+  if (!add)
+    return false;
+  auto isThreadIdX = [](mlir::Value value) {
+    auto tid = value.getDefiningOp<mlir::gpu::ThreadIdOp>();
+    return tid && tid.getDimension() == mlir::gpu::Dimension::x;
+  };
+  auto isAlignedBase = [&](mlir::Value value) {
+    return analysis.isUniform(value) && isMultipleOf(value, sgSize);
+  };
+  return (isThreadIdX(add.getLhs()) && isAlignedBase(add.getRhs())) ||
+         (isThreadIdX(add.getRhs()) && isAlignedBase(add.getLhs()));
+}
+
+bool canUseBlockIO(imex::UniformityAnalysis &analysis, mlir::Operation *op,
+                   mlir::MemRefType type, mlir::ValueRange indices,
+                   int64_t sgSize) {
+  auto elemType = type.getElementType();
+  if (!elemType.isIntOrFloat() || !type.getLayout().isIdentity() ||
+      !llvm::is_contained({16u, 32u}, elemType.getIntOrFloatBitWidth()) ||
+      indices.empty())
+    return false;
+  // The outer indices step by whole rows, which keep the alignment only if
+  // the row length is a multiple of the subgroup size.
+  auto rank = type.getRank();
+  if (rank > 1 &&
+      (type.isDynamicDim(rank - 1) || type.getShape().back() % sgSize))
+    return false;
+  if (!llvm::all_of(indices.drop_back(), [&](mlir::Value index) {
+        return analysis.isUniform(index);
+      }))
+    return false;
+  return isLaneContiguous(analysis, indices.back(), sgSize) &&
+         analysis.isUniformlyReached(op);
+}
+
+/// Adds the capability and extension needed for the block instructions to
+/// the target environment of module.
+void requireBlockIO(mlir::gpu::GPUModuleOp module) {
+  namespace spirv = mlir::spirv;
+  auto targetAttr = spirv::lookupTargetEnvOrDefault(module);
+  auto triple = targetAttr.getTripleAttr();
+  llvm::SetVector<spirv::Capability> caps;
+  for (auto cap : triple.getCapabilities())
+    caps.insert(cap);
+  caps.insert(spirv::Capability::SubgroupBufferBlockIOINTEL);
+  llvm::SetVector<spirv::Extension> exts;
+  for (auto ext : triple.getExtensions())
+    exts.insert(ext);
+  exts.insert(spirv::Extension::SPV_INTEL_subgroups);
+
+  auto newTriple =
+      spirv::VerCapExtAttr::get(triple.getVersion(), caps.getArrayRef(),
+                                exts.getArrayRef(), module.getContext());
+  module->setAttr(spirv::getTargetEnvAttrName(),
+                  spirv::TargetEnvAttr::get(
+                      newTriple, targetAttr.getResourceLimits(),
+                      targetAttr.getClientAPI(), targetAttr.getVendorID(),
+                      targetAttr.getDeviceType(), targetAttr.getDeviceID()));
+}
+
+struct SubgroupBlockIOPass final
+    : public imex::impl::SubgroupBlockIOBase<SubgroupBlockIOPass> {
+
+  void runOnOperation() override {
+    auto module = getOperation();
+    auto unitAttr = mlir::UnitAttr::get(&getContext());
+    bool changed = false;
+    module.walk([&](mlir::gpu::GPUFuncOp func) {
+      if (!func.isKernel())
+        return;
+      int64_t sgSize = subgroupSize;
+      if (auto abi = mlir::spirv::lookupEntryPointABI(func))
+        if (auto size = abi.getSubgroupSize())
+          sgSize = *size;
+      // The lanes of a subgroup only have consecutive x ids if the x size of
+      // the work group is a multiple of the subgroup size.
+      auto blockSize =
+          func->getAttrOfType<mlir::DenseI32ArrayAttr>(kKnownBlockSizeAttrName);
+      if (sgSize <= 0 || !blockSize || blockSize.empty() ||
+          blockSize[0] % sgSize)
+        return;
+
+      imex::UniformityAnalysis analysis(func);
+      func.walk([&](mlir::Operation *op) {
+        bool blockIO = false;
+        if (auto load = mlir::dyn_cast<mlir::memref::LoadOp>(op))
+          blockIO = canUseBlockIO(analysis, op, load.getMemRefType(),
+                                  load.getIndices(), sgSize);
+        else if (auto store = mlir::dyn_cast<mlir::memref::StoreOp>(op))
+          blockIO = canUseBlockIO(analysis, op, store.getMemRefType(),
+                                  store.getIndices(), sgSize);
+        if (blockIO) {
+          op->setAttr(kBlockIOAttrName, unitAttr);
+          changed = true;
+        }
+      });
+    });
+    if (changed)
+      requireBlockIO(module);
+  }
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createSubgroupBlockIOPass() {
+  return std::make_unique<SubgroupBlockIOPass>();
+}
+} // namespace imex
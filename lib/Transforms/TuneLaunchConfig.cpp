@@ -0,0 +1,409 @@
+//===- TuneLaunchConfig.cpp - TuneLaunchConfig Pass  ------------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file chooses the launch configuration of the kernels created from
+/// parallel loops by gpu-map-parallel-loops and convert-parallel-loops-to-gpu.
+/// Without it, the grid and block sizes are whatever falls out of the loop
+/// nest, e.g. an elementwise op on a 4D tensor runs one work item per work
+/// group. The pass linearizes the iteration space of an outermost
+/// scf.parallel and splits it into work groups, work items and a sequential
+/// loop per work item, chosen from a device description and the trip count
+/// or given through options and attributes.
+///
+//===----------------------------------------------------------------------===//
+
+#include <imex/Transforms/Passes.h>
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Dialect/Utils/StaticValueUtils.h>
+#include <mlir/Dialect/Vector/IR/VectorOps.h>
+#include <mlir/IR/IRMapping.h>
+#include <mlir/Interfaces/SideEffectInterfaces.h>
+#include <mlir/Pass/Pass.h>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/MathExtras.h>
+
+#include <algorithm>
+#include <optional>
+
+namespace imex {
+#define GEN_PASS_DEF_TUNELAUNCHCONFIG
+#include "imex/Transforms/Passes.h.inc"
+} // namespace imex
+
+namespace {
+
+static constexpr llvm::StringLiteral kLaunchConfigAttrName =
+    "imex.launch_config";
+
+/// The properties of a device the launch configuration is chosen from.
+struct DeviceDesc {
+  int64_t maxWorkGroupSize;
+  int64_t preferredWorkGroupSize;
+  // Supported subgroup sizes, in increasing order.
+  llvm::SmallVector<int64_t, 2> subgroupSizes;
+  int64_t numXVE;
+  int64_t threadsPerXVE;
+};
+
+std::optional<DeviceDesc> getDeviceDesc(llvm::StringRef device) {
+  // Intel Data Center GPU Max 1550, see XePVCuArch::getThroughput.
+  if (device == "pvc")
+    return DeviceDesc{1024, 256, {16, 32}, 1024, 8};
+  if (device == "generic")
+    return DeviceDesc{256, 128, {16}, 96, 7};
+  return std::nullopt;
+}
+
+struct LaunchConfig {
+  int64_t workGroupSize = 0;
+  int64_t workPerThread = 0;
+  int64_t subgroupSize = 0;
+  int64_t vectorWidth = 0;
+};
+
+/// Fills the values left at 0 in config from the `imex.launch_config`
+/// attribute of op, if any.
+void mergeConfigAttr(mlir::Operation *op, LaunchConfig &config) {
+  auto dict = op->getAttrOfType<mlir::DictionaryAttr>(kLaunchConfigAttrName);
+  if (!dict)
+    return;
+  auto get = [&](llvm::StringRef name, int64_t &value) {
+    if (value)
+      return;
+    if (auto attr = dict.getAs<mlir::IntegerAttr>(name))
+      value = attr.getInt();
+  };
+  get("work_group_size", config.workGroupSize);
+  get("work_per_thread", config.workPerThread);
+  get("subgroup_size", config.subgroupSize);
+  get("vector_width", config.vectorWidth);
+}
+
+/// Chooses the values left at 0 in config for a loop with numIters
+/// iterations.
+void completeConfig(const DeviceDesc &device, int64_t numIters,
+                    LaunchConfig &config) {
+  // Subgroups needed to give every hardware thread some work.
+  int64_t hwThreads = device.numXVE * device.threadsPerXVE;
+
+  if (!config.subgroupSize) {
+    config.subgroupSize = device.subgroupSizes.front();
+    for (auto size : device.subgroupSizes)
+      if (numIters >= size * hwThreads)
+        config.subgroupSize = size;
+  }
+
+  if (!config.workPerThread) {
+    config.workPerThread = 1;
+    for (int64_t seq : {8, 4, 2}) {
+      if (numIters >= seq * config.subgroupSize * hwThreads) {
+        config.workPerThread = seq;
+        break;
+      }
+    }
+  }
+
+  if (!config.workGroupSize) {
+    auto perThread = llvm::divideCeil(numIters, config.workPerThread);
+    auto sg = config.subgroupSize;
+    auto limit = std::min(device.preferredWorkGroupSize,
+                          static_cast<int64_t>(llvm::alignTo(perThread, sg)));
+    // Prefer a work-group size which divides the work, so that no bounds
+    // check is needed.
+    config.workGroupSize = std::max<int64_t>(limit / sg * sg, sg);
+    for (auto size = config.workGroupSize; size >= sg; size -= sg) {
+      if (perThread % size == 0) {
+        config.workGroupSize = size;
+        break;
+      }
+    }
+  }
+}
+
+/// Returns the trip counts of all dimensions of op if they are constant.
+std::optional<llvm::SmallVector<int64_t>>
+getConstantTripCounts(mlir::scf::ParallelOp op) {
+  llvm::SmallVector<int64_t> tripCounts;
+  for (auto [lb, ub, step] : llvm::zip(op.getLowerBound(), op.getUpperBound(),
+                                       op.getStep())) {
+    auto lbVal = mlir::getConstantIntValue(lb);
+    auto ubVal = mlir::getConstantIntValue(ub);
+    auto stepVal = mlir::getConstantIntValue(step);
+    if (!lbVal || !ubVal || !stepVal || *stepVal <= 0)
+      return std::nullopt;
+    tripCounts.push_back(
+        std::max<int64_t>(0, llvm::divideCeil(*ubVal - *lbVal, *stepVal)));
+  }
+  return tripCounts;
+}
+
+/// Returns true if the memref access with indices addresses the iteration
+/// of op itself, i.e. the indices are the induction variables in order.
+bool isIdentityAccess(mlir::scf::ParallelOp op, mlir::MemRefType type,
+                      mlir::ValueRange indices) {
+  return type.getLayout().isIdentity() &&
+         llvm::equal(indices, op.getInductionVars());
+}
+
+/// Returns true if the body of op can be executed on vectors of width
+/// consecutive iterations of the innermost dimension: all memory accesses
+/// are identity loads/stores and all other ops are elementwise on scalars.
+bool canVectorize(mlir::scf::ParallelOp op, llvm::ArrayRef<int64_t> tripCounts,
+                  int64_t width) {
+  if (tripCounts.back() % width ||
+      mlir::getConstantIntValue(op.getStep().back()) != 1)
+    return false;
+  auto isScalar = [](mlir::Type type) { return type.isIntOrFloat(); };
+  for (auto &nested : op.getBody()->without_terminator()) {
+    if (auto load = mlir::dyn_cast<mlir::memref::LoadOp>(nested)) {
+      if (!isIdentityAccess(op, load.getMemRefType(), load.getIndices()) ||
+          !isScalar(load.getType()))
+        return false;
+      continue;
+    }
+    if (auto store = mlir::dyn_cast<mlir::memref::StoreOp>(nested)) {
+      if (!isIdentityAccess(op, store.getMemRefType(), store.getIndices()) ||
+          !isScalar(store.getValueToStore().getType()))
+        return false;
+      continue;
+    }
+    if (nested.hasTrait<mlir::OpTrait::ConstantLike>())
+      continue;
+    if (!nested.hasTrait<mlir::OpTrait::Elementwise>() ||
+        nested.getNumRegions() || !mlir::isMemoryEffectFree(&nested) ||
+        !llvm::all_of(nested.getOperandTypes(), isScalar) ||
+        !llvm::all_of(nested.getResultTypes(), isScalar))
+      return false;
+  }
+  // The induction variables may only be used as load/store indices.
+  for (auto iv : op.getInductionVars())
+    for (auto *user : iv.getUsers())
+      if (!mlir::isa<mlir::memref::LoadOp, mlir::memref::StoreOp>(user))
+        return false;
+  return true;
+}
+
+/// Emits the body of op at the insertion point of builder on vectors of
+/// width consecutive iterations starting at ivs.
+void emitVectorBody(mlir::OpBuilder &builder, mlir::scf::ParallelOp op,
+                    mlir::ValueRange ivs, int64_t width) {
+  auto loc = op.getLoc();
+  auto vecType = [&](mlir::Type type) {
+    return mlir::VectorType::get({width}, type);
+  };
+  mlir::IRMapping mapping;
+  // Loop invariant operands are broadcast once.
+  auto getVector = [&](mlir::Value value) -> mlir::Value {
+    auto mapped = mapping.lookupOrDefault(value);
+    if (mlir::isa<mlir::VectorType>(mapped.getType()))
+      return mapped;
+    auto splat = builder.create<mlir::vector::BroadcastOp>(
+        loc, vecType(mapped.getType()), mapped);
+    mapping.map(value, splat.getResult());
+    return splat;
+  };
+
+  for (auto &nested : op.getBody()->without_terminator()) {
+    if (auto load = mlir::dyn_cast<mlir::memref::LoadOp>(nested)) {
+      auto vec = builder.create<mlir::vector::LoadOp>(
+          load.getLoc(), vecType(load.getType()), load.getMemRef(), ivs);
+      mapping.map(load.getResult(), vec.getResult());
+    } else if (auto store = mlir::dyn_cast<mlir::memref::StoreOp>(nested)) {
+      builder.create<mlir::vector::StoreOp>(
+          store.getLoc(), getVector(store.getValueToStore()),
+          store.getMemRef(), ivs);
+    } else if (nested.hasTrait<mlir::OpTrait::ConstantLike>()) {
+      builder.clone(nested, mapping);
+    } else {
+      mlir::OperationState state(nested.getLoc(), nested.getName());
+      for (auto operand : nested.getOperands())
+        state.addOperands(getVector(operand));
+      for (auto type : nested.getResultTypes())
+        state.addTypes(vecType(type));
+      state.addAttributes(nested.getAttrs());
+      auto *vecOp = builder.create(state);
+      mapping.map(nested.getResults(), vecOp->getResults());
+    }
+  }
+}
+
+/// Rewrites op into the grid/work-group/sequential loop nest described in
+/// the pass description. With a vector width VW > 1, numIters counts
+/// vectors of VW consecutive iterations and the body is vectorized.
+void distribute(mlir::scf::ParallelOp op, llvm::ArrayRef<int64_t> tripCounts,
+                int64_t numIters, const LaunchConfig &config) {
+  mlir::OpBuilder builder(op);
+  auto loc = op.getLoc();
+  // The index constants in front of op are reused, the missing ones are
+  // created there, once per value.
+  mlir::OpBuilder cstBuilder(op);
+  llvm::DenseMap<int64_t, mlir::Value> constants;
+  for (auto *anchor = op.getOperation();
+       !anchor->hasTrait<mlir::OpTrait::IsIsolatedFromAbove>();
+       anchor = anchor->getParentOp()) {
+    auto *block = anchor->getBlock();
+    for (auto &prev : llvm::make_range(block->begin(), anchor->getIterator()))
+      if (auto constant = mlir::dyn_cast<mlir::arith::ConstantIndexOp>(prev))
+        constants.try_emplace(constant.value(), constant);
+  }
+  auto cst = [&](int64_t value) -> mlir::Value {
+    auto &res = constants[value];
+    if (!res)
+      res = cstBuilder.create<mlir::arith::ConstantIndexOp>(loc, value);
+    return res;
+  };
+
+  auto wg = config.workGroupSize;
+  auto seq = config.workPerThread;
+  auto vw = config.vectorWidth;
+  auto numGroups = llvm::divideCeil(numIters, wg * seq);
+
+  auto zero = cst(0);
+  auto one = cst(1);
+  auto grid = builder.create<mlir::scf::ParallelOp>(
+      loc, mlir::ValueRange{zero}, mlir::ValueRange{cst(numGroups)},
+      mlir::ValueRange{one});
+  builder.setInsertionPointToStart(grid.getBody());
+  auto group = builder.create<mlir::scf::ParallelOp>(
+      loc, mlir::ValueRange{zero}, mlir::ValueRange{cst(wg)},
+      mlir::ValueRange{one});
+  builder.setInsertionPointToStart(group.getBody());
+
+  mlir::Value groupId = grid.getInductionVars().front();
+  mlir::Value lane = group.getInductionVars().front();
+  mlir::Value iter = zero;
+  if (seq > 1) {
+    auto forOp = builder.create<mlir::scf::ForOp>(loc, zero, cst(seq), one);
+    builder.setInsertionPointToStart(forOp.getBody());
+    iter = forOp.getInductionVar();
+  }
+
+  // %linear = (%group * SEQ + %i) * WG + %lane
+  mlir::Value linear =
+      builder.create<mlir::arith::MulIOp>(loc, groupId, cst(seq));
+  linear = builder.create<mlir::arith::AddIOp>(loc, linear, iter);
+  linear = builder.create<mlir::arith::MulIOp>(loc, linear, cst(wg));
+  linear = builder.create<mlir::arith::AddIOp>(loc, linear, lane);
+
+  if (numIters % (wg * seq)) {
+    auto inBounds = builder.create<mlir::arith::CmpIOp>(
+        loc, mlir::arith::CmpIPredicate::slt, linear, cst(numIters));
+    auto ifOp = builder.create<mlir::scf::IfOp>(loc, inBounds,
+                                                /*withElseRegion=*/false);
+    builder.setInsertionPointToStart(ifOp.thenBlock());
+  }
+
+  // Delinearize, the last dimension varies fastest.
+  auto numDims = tripCounts.size();
+  llvm::SmallVector<mlir::Value> ivs(numDims);
+  mlir::Value rest = linear;
+  if (vw > 1)
+    rest = builder.create<mlir::arith::MulIOp>(loc, rest, cst(vw));
+  for (auto d = numDims; d-- > 0;) {
+    mlir::Value idx = rest;
+    if (d > 0) {
+      auto count = cst(tripCounts[d]);
+      idx = builder.create<mlir::arith::RemUIOp>(loc, rest, count);
+      rest = builder.create<mlir::arith::DivUIOp>(loc, rest, count);
+    }
+    mlir::Value iv =
+        builder.create<mlir::arith::MulIOp>(loc, idx, op.getStep()[d]);
+    ivs[d] =
+        builder.create<mlir::arith::AddIOp>(loc, iv, op.getLowerBound()[d]);
+  }
+
+  if (vw > 1) {
+    emitVectorBody(builder, op, ivs, vw);
+    op.erase();
+    return;
+  }
+
+  auto *body = op.getBody();
+  for (auto [oldIv, newIv] : llvm::zip(op.getInductionVars(), ivs))
+    oldIv.replaceAllUsesWith(newIv);
+  auto *dest = builder.getInsertionBlock();
+  auto destIt = builder.getInsertionPoint();
+  dest->getOperations().splice(destIt, body->getOperations(), body->begin(),
+                               std::prev(body->end()));
+  op.erase();
+}
+
+struct TuneLaunchConfigPass final
+    : public imex::impl::TuneLaunchConfigBase<TuneLaunchConfigPass> {
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    auto desc = getDeviceDesc(device);
+    if (!desc) {
+      func.emitError() << "unknown device: " << device;
+      return signalPassFailure();
+    }
+
+    llvm::SmallVector<mlir::scf::ParallelOp> loops;
+    func.walk([&](mlir::scf::ParallelOp op) {
+      if (op->getParentOfType<mlir::scf::ParallelOp>())
+        return;
+      // Loops already mapped or distributed by hand are left alone.
+      bool nested = false;
+      op.getBody()->walk([&](mlir::scf::ParallelOp) { nested = true; });
+      if (!nested && op.getInitVals().empty() && !op->hasAttr("mapping"))
+        loops.push_back(op);
+    });
+
+    for (auto op : loops) {
+      auto tripCounts = getConstantTripCounts(op);
+      if (!tripCounts)
+        continue;
+      int64_t numIters = 1;
+      for (auto count : *tripCounts)
+        numIters *= count;
+      if (numIters <= 1)
+        continue;
+
+      LaunchConfig config;
+      mergeConfigAttr(op, config);
+      mergeConfigAttr(func, config);
+      if (!config.workGroupSize)
+        config.workGroupSize = workGroupSize;
+      if (!config.workPerThread)
+        config.workPerThread = workPerThread;
+      if (!config.subgroupSize)
+        config.subgroupSize = subgroupSize;
+      if (!config.vectorWidth)
+        config.vectorWidth = vectorWidth;
+      if (config.workGroupSize < 0 || config.workPerThread < 0 ||
+          config.subgroupSize < 0 || config.vectorWidth < 0 ||
+          config.workGroupSize > desc->maxWorkGroupSize) {
+        op.emitError("invalid launch configuration");
+        return signalPassFailure();
+      }
+      // Bodies which can't be vectorized are distributed per element.
+      if (config.vectorWidth <= 1 ||
+          !canVectorize(op, *tripCounts, config.vectorWidth))
+        config.vectorWidth = 1;
+      numIters /= config.vectorWidth;
+      completeConfig(*desc, numIters, config);
+      distribute(op, *tripCounts, numIters, config);
+    }
+  }
+};
+
+} // namespace
+
+namespace imex {
+std::unique_ptr<mlir::Pass> createTuneLaunchConfigPass() {
+  return std::make_unique<TuneLaunchConfigPass>();
+}
+} // namespace imex
@@ -0,0 +1,80 @@
+//===- UniformityAnalysis.h - Work-group uniform values ---------*- C++ -*-===//
+//
+// Copyright 2023 Intel Corporation
+// Part of the IMEX Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file defines a conservative analysis of the values of a gpu.func which
+/// are the same for all work items of a work group, shared by the passes
+/// which rewrite kernel memory accesses.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TRANSFORMS_UNIFORMITYANALYSIS_H_
+#define TRANSFORMS_UNIFORMITYANALYSIS_H_
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/GPU/IR/GPUDialect.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Interfaces/SideEffectInterfaces.h>
+
+namespace imex {
+
+/// Conservative check whether value is the same for all work items of a work
+/// group.
+class UniformityAnalysis {
+public:
+  explicit UniformityAnalysis(mlir::gpu::GPUFuncOp func) : func(func) {}
+
+  bool isUniform(mlir::Value value) {
+    if (auto arg = mlir::dyn_cast<mlir::BlockArgument>(value)) {
+      auto *owner = arg.getOwner()->getParentOp();
+      if (owner == func)
+        return true;
+      auto forOp = mlir::dyn_cast<mlir::scf::ForOp>(owner);
+      return forOp && arg == forOp.getInductionVar() &&
+             isUniform(forOp.getLowerBound()) &&
+             isUniform(forOp.getUpperBound()) && isUniform(forOp.getStep());
+    }
+    auto *def = value.getDefiningOp();
+    if (mlir::isa<mlir::gpu::BlockIdOp, mlir::gpu::GridDimOp,
+                  mlir::gpu::BlockDimOp>(def))
+      return true;
+    if (!mlir::isa<mlir::arith::ArithDialect>(def->getDialect()) ||
+        def->getNumRegions() || !mlir::isMemoryEffectFree(def))
+      return false;
+    return llvm::all_of(def->getOperands(), [&](mlir::Value operand) {
+      return isUniform(operand);
+    });
+  }
+
+  /// Returns true if all work items reach op, i.e. it isn't nested into
+  /// divergent control flow.
+  bool isUniformlyReached(mlir::Operation *op) {
+    for (auto *parent = op->getParentOp(); parent != func;
+         parent = parent->getParentOp()) {
+      if (auto forOp = mlir::dyn_cast<mlir::scf::ForOp>(parent)) {
+        if (!isUniform(forOp.getLowerBound()) ||
+            !isUniform(forOp.getUpperBound()) || !isUniform(forOp.getStep()))
+          return false;
+      } else if (auto ifOp = mlir::dyn_cast<mlir::scf::IfOp>(parent)) {
+        if (!isUniform(ifOp.getCondition()))
+          return false;
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  mlir::gpu::GPUFuncOp func;
+};
+
+} // namespace imex
+
+#endif // TRANSFORMS_UNIFORMITYANALYSIS_H_
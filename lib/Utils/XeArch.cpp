@@ -191,6 +191,24 @@ XePVCuArch::get2DStoreConfig(int element_data_size) {
   return storeParams;
 }
 
+/// Throughput numbers of the Intel Data Center GPU Max 1550 (128 Xe-cores).
+/// A dpas with repeat count 8 keeps the systolic array busy for 16 cycles
+/// for all supported precisions (K scales with the ops per channel).
+XeuArchThroughput XePVCuArch::getThroughput() {
+  XeuArchThroughput throughput;
+  throughput.frequency = 1.6;
+  throughput.numXVE = 1024;
+  throughput.memBandwidth = 3276.8;
+  throughput.dpasCycles = 16;
+  throughput.load2dCycles = 8;
+  throughput.store2dCycles = 8;
+  throughput.prefetch2dCycles = 4;
+  throughput.gatherCycles = 16;
+  throughput.atomicCycles = 32;
+  throughput.barrierCycles = 64;
+  return throughput;
+}
+
 mlir::LogicalResult XeuArchInterface::isLegalDpasOp(mlir::Operation *op) {
 
   if (auto dpasOp = llvm::dyn_cast<xegpu::DpasOp>(op)) {
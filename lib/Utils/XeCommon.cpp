@@ -300,6 +300,105 @@ void markUseChainValues(mlir::Value value, imex::OperandType type,
   mark(postOrderArgs);
 }
 
+// Returns true if the tile value is a loop-carried tile of forOp which is
+// moved by update_tile_offset in every iteration, i.e., each iteration
+// accesses a different tile.
+static bool isAdvancedEveryIteration(mlir::Value tile, mlir::scf::ForOp forOp) {
+  auto arg = llvm::dyn_cast<mlir::BlockArgument>(tile);
+  if (!arg || arg.getOwner()->getParentOp() != forOp.getOperation() ||
+      arg.getArgNumber() < forOp.getNumInductionVars())
+    return false;
+  auto yieldOp =
+      llvm::cast<mlir::scf::YieldOp>(forOp.getBody()->getTerminator());
+  auto yielded =
+      yieldOp.getOperand(arg.getArgNumber() - forOp.getNumInductionVars());
+  auto updateOp = yielded.getDefiningOp<imex::xetile::UpdateTileOffsetOp>();
+  return updateOp && updateOp.getTile() == arg;
+}
+
+// Returns true if value is computed inside forOp from its induction
+// variable.
+static bool dependsOnInductionVar(mlir::Value value, mlir::scf::ForOp forOp) {
+  if (value == forOp.getInductionVar())
+    return true;
+  auto defOp = value.getDefiningOp();
+  if (!defOp || !forOp->isProperAncestor(defOp))
+    return false;
+  return llvm::any_of(defOp->getOperands(), [&](mlir::Value operand) {
+    return dependsOnInductionVar(operand, forOp);
+  });
+}
+
+// Returns true if the tile value is created inside forOp by an init_tile at
+// offsets depending on the induction variable, i.e., each iteration
+// accesses a different tile.
+static bool isCreatedEveryIteration(mlir::Value tile, mlir::scf::ForOp forOp) {
+  auto initOp = tile.getDefiningOp<imex::xetile::InitTileOp>();
+  if (!initOp || !forOp->isProperAncestor(initOp))
+    return false;
+  return llvm::any_of(initOp.getOffsets(), [&](mlir::Value offset) {
+    return dependsOnInductionVar(offset, forOp);
+  });
+}
+
+// The reuse distance of a tile access is estimated in iterations of the
+// innermost enclosing loop:
+// * a tile defined outside the loop is accessed again in the next iteration
+//   (distance 1), so it is worth caching;
+// * a tile advanced by update_tile_offset in every iteration, or created in
+//   the loop body at offsets depending on the induction variable, is never
+//   accessed again by this subgroup (infinite distance) and is streamed
+//   through L1 unless it is prefetched, in which case it was brought in on
+//   purpose;
+// * outside of loops a tile accessed once is streamed.
+static imex::xetile::CacheHint getCacheHint(mlir::Operation *op,
+                                            mlir::Value tile) {
+  auto forOp = op->getParentOfType<mlir::scf::ForOp>();
+  auto isAccess = [&](mlir::Operation *user) {
+    return user != op &&
+           llvm::isa<imex::xetile::LoadTileOp, imex::xetile::StoreTileOp,
+                     imex::xetile::PrefetchTileOp>(user);
+  };
+
+  if (!forOp) {
+    // an epilogue or prologue access, e.g., loading a bias or storing C.
+    if (llvm::any_of(tile.getUsers(), isAccess))
+      return imex::xetile::CacheHint::CACHED;
+    return imex::xetile::CacheHint::STREAMING;
+  }
+
+  if (isAdvancedEveryIteration(tile, forOp) ||
+      isCreatedEveryIteration(tile, forOp)) {
+    auto isPrefetch = [](mlir::Operation *user) {
+      return llvm::isa<imex::xetile::PrefetchTileOp>(user);
+    };
+    if (llvm::any_of(tile.getUsers(), isPrefetch))
+      return imex::xetile::CacheHint::CACHED;
+    return imex::xetile::CacheHint::STREAMING;
+  }
+
+  return imex::xetile::CacheHint::CACHED;
+}
+
+void assignCacheHints(mlir::Operation *root) {
+  auto ctx = root->getContext();
+  root->walk([&](mlir::Operation *op) {
+    if (op->hasAttr("cache_hint"))
+      return;
+    std::optional<imex::xetile::CacheHint> hint;
+    if (auto loadOp = llvm::dyn_cast<imex::xetile::LoadTileOp>(op))
+      hint = getCacheHint(op, loadOp.getSource());
+    else if (auto storeOp = llvm::dyn_cast<imex::xetile::StoreTileOp>(op))
+      hint = getCacheHint(op, storeOp.getTile());
+    else if (llvm::isa<imex::xetile::PrefetchTileOp>(op))
+      // prefetching is only useful if the data is kept in the cache.
+      hint = imex::xetile::CacheHint::CACHED;
+
+    if (hint)
+      op->setAttr("cache_hint", imex::xetile::CacheHintAttr::get(ctx, *hint));
+  });
+}
+
 mlir::ValueRange buildUnrealizedCast(mlir::OpBuilder &builder,
                                      mlir::TypeRange resultTypes,
                                      mlir::ValueRange inputs) {
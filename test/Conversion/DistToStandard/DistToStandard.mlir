@@ -216,3 +216,60 @@ func.func @test_cast_elemtype(%arg0: !ndarray.ndarray<?xi64>, %arg1: !ndarray.nd
 // CHECK-NEXT: [[V2:%.*]] = ndarray.cast_elemtype %arg1
 // CHECK-NEXT: [[V3:%.*]] = ndarray.cast_elemtype %arg2
 // CHECK: return [[V1]], [[V2]], [[V3]]
+
+// -----
+func.func @test_matmul(%arg0: !ndarray.ndarray<0x4xf32>, %arg1: !ndarray.ndarray<4x4xf32>, %arg2: !ndarray.ndarray<0x4xf32>, %arg3: !ndarray.ndarray<0x6xf32>, %arg4: !ndarray.ndarray<2x6xf32>, %arg5: !ndarray.ndarray<0x6xf32>) -> (!ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>) {
+  %c0 = arith.constant 0 : index
+  %c2 = arith.constant 2 : index
+  %c4 = arith.constant 4 : index
+  %a = dist.init_dist_array l_offset %c4, %c0 parts %arg0, %arg1, %arg2 : index, index, !ndarray.ndarray<0x4xf32>, !ndarray.ndarray<4x4xf32>, !ndarray.ndarray<0x4xf32> to !ndarray.ndarray<8x4xf32, #dist.dist_env<team = 22 : i64 loffs = 4,0 lparts = 0x4,4x4,0x4>>
+  %b = dist.init_dist_array l_offset %c2, %c0 parts %arg3, %arg4, %arg5 : index, index, !ndarray.ndarray<0x6xf32>, !ndarray.ndarray<2x6xf32>, !ndarray.ndarray<0x6xf32> to !ndarray.ndarray<4x6xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 0x6,2x6,0x6>>
+  %c = ndarray.matmul %a, %b : (!ndarray.ndarray<8x4xf32, #dist.dist_env<team = 22 : i64 loffs = 4,0 lparts = 0x4,4x4,0x4>>, !ndarray.ndarray<4x6xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 0x6,2x6,0x6>>) -> !ndarray.ndarray<8x6xf32, #dist.dist_env<team = 22 : i64 loffs = ?,? lparts = ?x?,?x?,?x?>>
+  %20, %21, %22 = "dist.parts_of"(%c) : (!ndarray.ndarray<8x6xf32, #dist.dist_env<team = 22 : i64 loffs = ?,? lparts = ?x?,?x?,?x?>>) -> (!ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>)
+  return %20, %21, %22 : !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>
+}
+// CHECK-LABEL: func.func @test_matmul
+// CHECK-SAME: [[arg1:%[^:]*]]: !ndarray.ndarray<4x4xf32>, {{.*}}, [[arg4:%[^:]*]]: !ndarray.ndarray<2x6xf32>
+// CHECK: [[panels:%.*]] = ndarray.create {{.*}} -> !ndarray.ndarray<?xi64>
+// CHECK: distruntime.allreduce
+// CHECK: [[res:%.*]] = ndarray.create {{.*}} value {{.*}} -> !ndarray.ndarray<
+// CHECK: scf.for {{.*}} iter_args([[acc:%.*]] = [[res]])
+// CHECK: [[panel:%.*]] = ndarray.create {{.*}} value {{.*}} -> !ndarray.ndarray<
+// CHECK: [[own:%.*]] = ndarray.subview [[arg4]]
+// CHECK: ndarray.insert_slice [[own]] into [[panel]]
+// CHECK: distruntime.allreduce
+// CHECK: [[cols:%.*]] = ndarray.subview [[arg1]]
+// CHECK: [[prod:%.*]] = ndarray.matmul [[cols]], [[panel]]
+// CHECK: [[sum:%.*]] = ndarray.ewbin [[acc]], [[prod]]
+// CHECK: scf.yield [[sum]]
+
+// -----
+func.func @test_matmul_one_part(%arg0: !ndarray.ndarray<4x4xf32>, %arg1: !ndarray.ndarray<2x6xf32>) -> (!ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>) {
+  %c0 = arith.constant 0 : index
+  %c2 = arith.constant 2 : index
+  %c4 = arith.constant 4 : index
+  %a = dist.init_dist_array l_offset %c4, %c0 parts %arg0 : index, index, !ndarray.ndarray<4x4xf32> to !ndarray.ndarray<8x4xf32, #dist.dist_env<team = 22 : i64 loffs = 4,0 lparts = 4x4>>
+  %b = dist.init_dist_array l_offset %c2, %c0 parts %arg1 : index, index, !ndarray.ndarray<2x6xf32> to !ndarray.ndarray<4x6xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 2x6>>
+  %c = ndarray.matmul %a, %b : (!ndarray.ndarray<8x4xf32, #dist.dist_env<team = 22 : i64 loffs = 4,0 lparts = 4x4>>, !ndarray.ndarray<4x6xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 2x6>>) -> !ndarray.ndarray<8x6xf32, #dist.dist_env<team = 22 : i64 loffs = ?,? lparts = ?x?,?x?,?x?>>
+  %20, %21, %22 = "dist.parts_of"(%c) : (!ndarray.ndarray<8x6xf32, #dist.dist_env<team = 22 : i64 loffs = ?,? lparts = ?x?,?x?,?x?>>) -> (!ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>)
+  return %20, %21, %22 : !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>
+}
+// CHECK-LABEL: func.func @test_matmul_one_part
+// CHECK-SAME: [[arg0:%[^:]*]]: !ndarray.ndarray<4x4xf32>, [[arg1:%[^:]*]]: !ndarray.ndarray<2x6xf32>
+// CHECK: scf.for
+// CHECK: [[own:%.*]] = ndarray.subview [[arg1]]
+// CHECK: [[cols:%.*]] = ndarray.subview [[arg0]]
+// CHECK: ndarray.matmul [[cols]]
+// CHECK: scf.yield
+
+// -----
+func.func @test_matmul_transpose_lhs(%arg0: !ndarray.ndarray<0x8xf32>, %arg1: !ndarray.ndarray<4x8xf32>, %arg2: !ndarray.ndarray<0x8xf32>, %arg3: !ndarray.ndarray<0x6xf32>, %arg4: !ndarray.ndarray<2x6xf32>, %arg5: !ndarray.ndarray<0x6xf32>) {
+  %c0 = arith.constant 0 : index
+  %c2 = arith.constant 2 : index
+  %c4 = arith.constant 4 : index
+  %a = dist.init_dist_array l_offset %c2, %c0 parts %arg0, %arg1, %arg2 : index, index, !ndarray.ndarray<0x8xf32>, !ndarray.ndarray<4x8xf32>, !ndarray.ndarray<0x8xf32> to !ndarray.ndarray<4x8xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 0x8,4x8,0x8>>
+  %b = dist.init_dist_array l_offset %c2, %c0 parts %arg3, %arg4, %arg5 : index, index, !ndarray.ndarray<0x6xf32>, !ndarray.ndarray<2x6xf32>, !ndarray.ndarray<0x6xf32> to !ndarray.ndarray<4x6xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 0x6,2x6,0x6>>
+  // expected-error @+1 {{distributed operands must be 2d and lhs must not be transposed}}
+  %c = ndarray.matmul %a, %b {transpose_lhs} : (!ndarray.ndarray<4x8xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 0x8,4x8,0x8>>, !ndarray.ndarray<4x6xf32, #dist.dist_env<team = 22 : i64 loffs = 2,0 lparts = 0x6,2x6,0x6>>) -> !ndarray.ndarray<8x6xf32, #dist.dist_env<team = 22 : i64 loffs = ?,? lparts = ?x?,?x?,?x?>>
+  return
+}
@@ -0,0 +1,49 @@
+// RUN: imex-opt --convert-gpu-to-gpux="capture-launches=true" %s | FileCheck %s
+
+module attributes {gpu.container_module} {
+// CHECK-LABEL: func.func @step
+func.func @step(%arg0: memref<8xf32>, %arg1: memref<8xf32>, %arg2: memref<8xf32>) {
+  %c8 = arith.constant 8 : index
+  %c1 = arith.constant 1 : index
+  // CHECK: %[[STREAM:.*]] = "gpux.create_stream"() : () -> !gpux.StreamType
+  // CHECK: "gpux.capture_begin"(%[[STREAM]]) : (!gpux.StreamType) -> ()
+  // CHECK-NEXT: "gpux.launch_func"(%[[STREAM]]
+  // CHECK-SAME: kernel = @Kernels::@add
+  gpu.launch_func @Kernels::@add blocks in (%c8, %c1, %c1) threads in (%c1, %c1, %c1) args(%arg0 : memref<8xf32>, %arg1 : memref<8xf32>, %arg2 : memref<8xf32>)
+  // CHECK-NEXT: "gpux.memcpy"(%[[STREAM]], %{{.*}}, %{{.*}})
+  gpu.memcpy %arg1, %arg2 : memref<8xf32>, memref<8xf32>
+  // CHECK-NEXT: "gpux.launch_func"(%[[STREAM]]
+  // CHECK-SAME: kernel = @Kernels::@add
+  gpu.launch_func @Kernels::@add blocks in (%c8, %c1, %c1) threads in (%c1, %c1, %c1) args(%arg2 : memref<8xf32>, %arg1 : memref<8xf32>, %arg0 : memref<8xf32>)
+  // CHECK-NEXT: "gpux.capture_end"(%[[STREAM]]) : (!gpux.StreamType) -> ()
+  // CHECK: "gpux.destroy_stream"(%[[STREAM]])
+  return
+}
+
+// A single launch and launches separated by host side effects are not
+// captured.
+// CHECK-LABEL: func.func @single
+func.func @single(%arg0: memref<8xf32>, %arg1: memref<8xf32>, %arg2: memref<8xf32>, %arg3: f32) {
+  %c8 = arith.constant 8 : index
+  %c1 = arith.constant 1 : index
+  %c0 = arith.constant 0 : index
+  // CHECK-NOT: gpux.capture_begin
+  gpu.launch_func @Kernels::@add blocks in (%c8, %c1, %c1) threads in (%c1, %c1, %c1) args(%arg0 : memref<8xf32>, %arg1 : memref<8xf32>, %arg2 : memref<8xf32>)
+  memref.store %arg3, %arg2[%c0] : memref<8xf32>
+  gpu.launch_func @Kernels::@add blocks in (%c8, %c1, %c1) threads in (%c1, %c1, %c1) args(%arg0 : memref<8xf32>, %arg1 : memref<8xf32>, %arg2 : memref<8xf32>)
+  // CHECK-NOT: gpux.capture_end
+  // CHECK: return
+  return
+}
+
+gpu.module @Kernels {
+  gpu.func @add(%arg0: memref<8xf32>, %arg1: memref<8xf32>, %arg2: memref<8xf32>) kernel {
+    %0 = gpu.block_id x
+    %1 = memref.load %arg0[%0] : memref<8xf32>
+    %2 = memref.load %arg1[%0] : memref<8xf32>
+    %3 = arith.addf %1, %2 : f32
+    memref.store %3, %arg2[%0] : memref<8xf32>
+    gpu.return
+  }
+}
+}
@@ -0,0 +1,21 @@
+// RUN: imex-opt --convert-gpu-to-gpux="module-stream=true" %s | FileCheck %s
+
+// CHECK-LABEL: func.func @alloc
+func.func @alloc() -> memref<8xf32> {
+  // CHECK: %[[STREAM:.*]] = "gpux.create_stream"() <{module_lifetime}> : () -> !gpux.StreamType
+  // CHECK: "gpux.alloc"(%[[STREAM]])
+  %memref = gpu.alloc  () : memref<8xf32>
+  // CHECK-NOT: gpux.destroy_stream
+  // CHECK: return
+  return %memref : memref<8xf32>
+}
+
+// CHECK-LABEL: func.func @dealloc
+func.func @dealloc(%arg0: memref<8xf32>) {
+  // CHECK: %[[STREAM:.*]] = "gpux.create_stream"() <{module_lifetime}> : () -> !gpux.StreamType
+  // CHECK: "gpux.dealloc"(%[[STREAM]], %{{.*}}) : (!gpux.StreamType, memref<8xf32>) -> ()
+  gpu.dealloc  %arg0 : memref<8xf32>
+  // CHECK-NOT: gpux.destroy_stream
+  // CHECK: return
+  return
+}
@@ -0,0 +1,42 @@
+// RUN: imex-opt --pass-pipeline='builtin.module(gpu.module(imex-promote-to-slm),imex-convert-gpu-to-spirv{enable-vc-intrinsic=true})' %s -o - | FileCheck %s
+
+module attributes {
+  gpu.container_module,
+  spirv.target_env = #spirv.target_env<#spirv.vce<v1.0, [Addresses, Float16Buffer, Int64, Int16, Int8, Kernel, Linkage, Vector16, GenericPointer, Groups, Float16, Float64, AtomicFloat32AddEXT, ExpectAssumeKHR], [SPV_EXT_shader_atomic_float_add, SPV_KHR_expect_assume]>, #spirv.resource_limits<>>
+} {
+  func.func @transpose(%arg0: memref<256x256xf32>, %arg1: memref<256x256xf32>) {
+    %c1 = arith.constant 1 : index
+    %c16 = arith.constant 16 : index
+    gpu.launch_func @kernels::@transpose_kernel
+        blocks in (%c16, %c16, %c1) threads in (%c16, %c16, %c1)
+        args(%arg0 : memref<256x256xf32>, %arg1 : memref<256x256xf32>)
+    return
+  }
+
+  // CHECK-LABEL: spirv.module @{{.*}} Physical64 OpenCL
+  gpu.module @kernels {
+    // CHECK: spirv.GlobalVariable @[[TILE:.*]] : !spirv.ptr<{{.*}}272 x f32{{.*}}, Workgroup>
+    // CHECK-LABEL: spirv.func @transpose_kernel
+    // CHECK: spirv.mlir.addressof @[[TILE]]
+    // CHECK: spirv.mlir.loop
+    // CHECK: spirv.Store "Workgroup"
+    // CHECK: spirv.ControlBarrier <Workgroup>, <Workgroup>
+    // CHECK: spirv.Load "Workgroup"
+    // CHECK: spirv.Store "CrossWorkgroup"
+    gpu.func @transpose_kernel(%arg0: memref<256x256xf32>, %arg1: memref<256x256xf32>) kernel
+      attributes {gpu.known_block_size = array<i32: 16, 16, 1>, spirv.entry_point_abi = #spirv.entry_point_abi<>} {
+      %c16 = arith.constant 16 : index
+      %0 = gpu.block_id x
+      %1 = gpu.block_id y
+      %2 = gpu.thread_id x
+      %3 = gpu.thread_id y
+      %4 = arith.muli %0, %c16 : index
+      %5 = arith.muli %1, %c16 : index
+      %6 = arith.addi %4, %2 : index
+      %7 = arith.addi %5, %3 : index
+      %8 = memref.load %arg0[%6, %7] : memref<256x256xf32>
+      memref.store %8, %arg1[%7, %6] : memref<256x256xf32>
+      gpu.return
+    }
+  }
+}
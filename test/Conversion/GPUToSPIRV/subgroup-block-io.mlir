@@ -0,0 +1,50 @@
+// RUN: imex-opt --pass-pipeline='builtin.module(gpu.module(imex-subgroup-block-io),imex-convert-gpu-to-spirv{enable-vc-intrinsic=true})' %s -o - | FileCheck %s
+
+module attributes {
+  gpu.container_module,
+  spirv.target_env = #spirv.target_env<#spirv.vce<v1.0, [Addresses, Float16Buffer, Int64, Int16, Int8, Kernel, Linkage, Vector16, GenericPointer, Groups, Float16, Float64, AtomicFloat32AddEXT, ExpectAssumeKHR], [SPV_EXT_shader_atomic_float_add, SPV_KHR_expect_assume]>, #spirv.resource_limits<>>
+} {
+  func.func @relu(%arg0: memref<4096xf32>, %arg1: memref<4096xf32>) {
+    %c1 = arith.constant 1 : index
+    %c64 = arith.constant 64 : index
+    gpu.launch_func @kernels::@relu_kernel
+        blocks in (%c64, %c1, %c1) threads in (%c64, %c1, %c1)
+        args(%arg0 : memref<4096xf32>, %arg1 : memref<4096xf32>)
+    return
+  }
+
+  // CHECK-LABEL: spirv.module @{{.*}} Physical64 OpenCL
+  gpu.module @kernels {
+    // CHECK: spirv.GlobalVariable @[[$LANEID:.*]] built_in("SubgroupLocalInvocationId") : !spirv.ptr<i32, Input>
+    // CHECK-LABEL: spirv.func @relu_kernel(
+    // CHECK-SAME: %[[ARG0:.*]]: !spirv.ptr<!spirv.array<4096 x f32>, CrossWorkgroup>{{.*}}, %[[ARG1:.*]]: !spirv.ptr<!spirv.array<4096 x f32>, CrossWorkgroup>
+    gpu.func @relu_kernel(%arg0: memref<4096xf32>, %arg1: memref<4096xf32>) kernel
+      attributes {gpu.known_block_size = array<i32: 64, 1, 1>, spirv.entry_point_abi = #spirv.entry_point_abi<subgroup_size = 16>} {
+      %cst = arith.constant 0.000000e+00 : f32
+      %c64 = arith.constant 64 : index
+      %0 = gpu.block_id x
+      %1 = gpu.thread_id x
+      %2 = arith.muli %0, %c64 : index
+      // CHECK: %[[IDX:.*]] = spirv.IAdd
+      %3 = arith.addi %2, %1 : index
+      // CHECK: %[[LANEPTR:.*]] = spirv.mlir.addressof @[[$LANEID]] : !spirv.ptr<i32, Input>
+      // CHECK: %[[LANE32:.*]] = spirv.Load "Input" %[[LANEPTR]] : i32
+      // CHECK: %[[LANE:.*]] = spirv.UConvert %[[LANE32]] : i32 to i64
+      // CHECK: %[[BASE:.*]] = spirv.ISub %[[IDX]], %[[LANE]] : i64
+      // CHECK: %[[PTR0:.*]] = spirv.AccessChain %[[ARG0]]
+      // CHECK: %[[IPTR0:.*]] = spirv.Bitcast %[[PTR0]] : !spirv.ptr<f32, CrossWorkgroup> to !spirv.ptr<i32, CrossWorkgroup>
+      // CHECK: %[[RAW:.*]] = spirv.INTEL.SubgroupBlockRead "CrossWorkgroup" %[[IPTR0]] : i32
+      // CHECK: %[[VAL:.*]] = spirv.Bitcast %[[RAW]] : i32 to f32
+      %4 = memref.load %arg0[%3] : memref<4096xf32>
+      %5 = arith.addf %4, %cst : f32
+      // CHECK: %[[SUM:.*]] = spirv.FAdd %[[VAL]]
+      // CHECK: spirv.ISub %[[IDX]], %{{.*}} : i64
+      // CHECK: %[[PTR1:.*]] = spirv.AccessChain %[[ARG1]]
+      // CHECK: %[[IPTR1:.*]] = spirv.Bitcast %[[PTR1]] : !spirv.ptr<f32, CrossWorkgroup> to !spirv.ptr<i32, CrossWorkgroup>
+      // CHECK: %[[ISUM:.*]] = spirv.Bitcast %[[SUM]] : f32 to i32
+      // CHECK: spirv.INTEL.SubgroupBlockWrite "CrossWorkgroup" %[[IPTR1]], %[[ISUM]] : i32
+      memref.store %5, %arg1[%3] : memref<4096xf32>
+      gpu.return
+    }
+  }
+}
@@ -0,0 +1,45 @@
+// RUN: imex-opt -imex-convert-gpu-to-spirv='enable-vc-intrinsic=true' %s -o - | FileCheck %s
+
+module attributes {
+  gpu.container_module,
+  spirv.target_env = #spirv.target_env<#spirv.vce<v1.0, [Addresses, Float16Buffer, Int64, Int16, Int8, Kernel, Linkage, Vector16, GenericPointer, Groups, Float16, Float64, AtomicFloat32AddEXT, ExpectAssumeKHR], [SPV_EXT_shader_atomic_float_add, SPV_KHR_expect_assume]>, #spirv.resource_limits<>>
+} {
+  func.func @add(%arg0: memref<64x32xf32>, %arg1: memref<64x32xf32>) {
+    %c1 = arith.constant 1 : index
+    %c8 = arith.constant 8 : index
+    %c64 = arith.constant 64 : index
+    gpu.launch_func @kernels::@add_kernel
+        blocks in (%c8, %c1, %c1) threads in (%c64, %c1, %c1)
+        args(%arg0 : memref<64x32xf32>, %arg1 : memref<64x32xf32>)
+    return
+  }
+
+  // CHECK-LABEL: spirv.module @{{.*}} Physical64 OpenCL
+  gpu.module @kernels {
+    // CHECK-LABEL: spirv.func @add_kernel(
+    // CHECK-SAME: %[[ARG0:.*]]: !spirv.ptr<!spirv.array<2048 x f32>, CrossWorkgroup>{{.*}}, %[[ARG1:.*]]: !spirv.ptr<!spirv.array<2048 x f32>, CrossWorkgroup>
+    gpu.func @add_kernel(%arg0: memref<64x32xf32>, %arg1: memref<64x32xf32>) kernel
+      attributes {spirv.entry_point_abi = #spirv.entry_point_abi<>} {
+      %cst = arith.constant 1.000000e+00 : f32
+      %c4 = arith.constant 4 : index
+      %c32 = arith.constant 32 : index
+      %0 = gpu.thread_id x
+      %1 = arith.muli %0, %c4 : index
+      %2 = arith.remui %1, %c32 : index
+      %3 = arith.divui %1, %c32 : index
+      // CHECK: %[[PTR0:.*]] = spirv.AccessChain %[[ARG0]]
+      // CHECK: %[[VPTR0:.*]] = spirv.Bitcast %[[PTR0]] : !spirv.ptr<f32, CrossWorkgroup> to !spirv.ptr<vector<4xf32>, CrossWorkgroup>
+      // CHECK: %[[VAL:.*]] = spirv.Load "CrossWorkgroup" %[[VPTR0]] ["Aligned", 4] : vector<4xf32>
+      %4 = vector.load %arg0[%3, %2] : memref<64x32xf32>, vector<4xf32>
+      // CHECK: %[[ONE:.*]] = spirv.CompositeConstruct %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}} : (f32, f32, f32, f32) -> vector<4xf32>
+      %5 = vector.broadcast %cst : f32 to vector<4xf32>
+      // CHECK: %[[SUM:.*]] = spirv.FAdd %[[VAL]], %[[ONE]] : vector<4xf32>
+      %6 = arith.addf %4, %5 : vector<4xf32>
+      // CHECK: %[[PTR1:.*]] = spirv.AccessChain %[[ARG1]]
+      // CHECK: %[[VPTR1:.*]] = spirv.Bitcast %[[PTR1]] : !spirv.ptr<f32, CrossWorkgroup> to !spirv.ptr<vector<4xf32>, CrossWorkgroup>
+      // CHECK: spirv.Store "CrossWorkgroup" %[[VPTR1]], %[[SUM]] ["Aligned", 4] : vector<4xf32>
+      vector.store %6, %arg1[%3, %2] : memref<64x32xf32>, vector<4xf32>
+      gpu.return
+    }
+  }
+}
@@ -0,0 +1,60 @@
+// RUN: imex-opt -convert-func-to-llvm -convert-gpux-to-llvm %s | FileCheck %s
+
+module attributes {gpu.container_module}{
+  // CHECK-LABEL: llvm.func @main
+  func.func @main(%dst : memref<8xf32>) attributes {llvm.emit_c_interface} {
+    // CHECK: %[[STREAM:.*]] = llvm.call @gpuCreateAsyncStream(%{{.*}}, %{{.*}}) : (!llvm.ptr, !llvm.ptr) -> !llvm.ptr
+    %0 = "gpux.create_stream"() : () -> !gpux.StreamType
+    // CHECK: llvm.call @gpuMemAlloc(%[[STREAM]], %{{.*}}, %{{.*}}, %{{.*}}) : (!llvm.ptr, i64, i64, i32) -> !llvm.ptr
+    // CHECK: %[[E0:.*]] = llvm.call @gpuEventRecord(%[[STREAM]]) : (!llvm.ptr) -> !llvm.ptr
+    %memref, %t0 = "gpux.alloc"(%0) {operandSegmentSizes = array<i32: 0, 1, 0, 0>} : (!gpux.StreamType) -> (memref<8xf32>, !gpu.async.token)
+    // CHECK: llvm.call @gpuStreamWaitEvent(%[[STREAM]], %[[E0]]) : (!llvm.ptr, !llvm.ptr) -> ()
+    // CHECK: llvm.call @gpuEventDestroy(%[[E0]]) : (!llvm.ptr) -> ()
+    // CHECK: llvm.call @gpuMemcpy(%[[STREAM]], %{{.*}}, %{{.*}}, %{{.*}}) : (!llvm.ptr, !llvm.ptr, !llvm.ptr, i64) -> ()
+    // CHECK-NOT: llvm.call @gpuWait
+    // CHECK: %[[E1:.*]] = llvm.call @gpuEventRecord(%[[STREAM]]) : (!llvm.ptr) -> !llvm.ptr
+    %t1 = "gpux.memcpy"(%t0, %0, %dst, %memref) : (!gpu.async.token, !gpux.StreamType, memref<8xf32>, memref<8xf32>) -> !gpu.async.token
+    // CHECK: llvm.call @gpuEventSynchronize(%[[E1]]) : (!llvm.ptr) -> ()
+    // CHECK: llvm.call @gpuEventDestroy(%[[E1]]) : (!llvm.ptr) -> ()
+    "gpux.wait"(%t1, %0) : (!gpu.async.token, !gpux.StreamType) -> ()
+    // CHECK: llvm.call @gpuMemFree(%[[STREAM]], %{{.*}}) : (!llvm.ptr, !llvm.ptr) -> ()
+    "gpux.dealloc"(%0, %memref) : (!gpux.StreamType, memref<8xf32>) -> ()
+    // CHECK: llvm.call @gpuWait(%[[STREAM]]) : (!llvm.ptr) -> ()
+    "gpux.wait"(%0) : (!gpux.StreamType) -> ()
+    "gpux.destroy_stream"(%0) : (!gpux.StreamType) -> ()
+    return
+  }
+
+  // The events of tokens used once are released after the wait is queued or
+  // done, a token used twice keeps its event.
+  // CHECK-LABEL: llvm.func @release
+  func.func @release(%dst : memref<8xf32>, %src : memref<8xf32>) {
+    // CHECK: %[[STREAM:.*]] = llvm.call @gpuCreateAsyncStream
+    %0 = "gpux.create_stream"() : () -> !gpux.StreamType
+    // CHECK: %[[E0:.*]] = llvm.call @gpuEventRecord(%[[STREAM]])
+    %t0 = "gpux.memcpy"(%0, %dst, %src) : (!gpux.StreamType, memref<8xf32>, memref<8xf32>) -> !gpu.async.token
+    // CHECK: llvm.call @gpuStreamWaitEvent(%[[STREAM]], %[[E0]])
+    // CHECK-NOT: llvm.call @gpuEventDestroy
+    // CHECK: %[[E1:.*]] = llvm.call @gpuEventRecord(%[[STREAM]])
+    %t1 = "gpux.wait"(%t0, %0) : (!gpu.async.token, !gpux.StreamType) -> !gpu.async.token
+    // CHECK: llvm.call @gpuEventSynchronize(%[[E0]])
+    // CHECK-NOT: llvm.call @gpuEventDestroy(%[[E0]])
+    // CHECK: llvm.call @gpuEventSynchronize(%[[E1]])
+    // CHECK-NEXT: llvm.call @gpuEventDestroy(%[[E1]])
+    // CHECK: llvm.call @gpuMemFree
+    "gpux.dealloc"(%t0, %t1, %0, %src) : (!gpu.async.token, !gpu.async.token, !gpux.StreamType, memref<8xf32>) -> ()
+    "gpux.destroy_stream"(%0) : (!gpux.StreamType) -> ()
+    return
+  }
+
+  // CHECK-LABEL: llvm.func @sync_memcpy
+  func.func @sync_memcpy(%dst : memref<8xf32>, %src : memref<8xf32>) {
+    // CHECK: %[[STREAM:.*]] = llvm.call @gpuCreateStream(%{{.*}}, %{{.*}}) : (!llvm.ptr, !llvm.ptr) -> !llvm.ptr
+    %0 = "gpux.create_stream"() : () -> !gpux.StreamType
+    // CHECK: llvm.call @gpuMemcpy(%[[STREAM]], %{{.*}}, %{{.*}}, %{{.*}}) : (!llvm.ptr, !llvm.ptr, !llvm.ptr, i64) -> ()
+    // CHECK-NEXT: llvm.call @gpuWait(%[[STREAM]]) : (!llvm.ptr) -> ()
+    "gpux.memcpy"(%0, %dst, %src) : (!gpux.StreamType, memref<8xf32>, memref<8xf32>) -> ()
+    "gpux.destroy_stream"(%0) : (!gpux.StreamType) -> ()
+    return
+  }
+}
@@ -0,0 +1,28 @@
+// RUN: imex-opt -convert-func-to-llvm -convert-gpux-to-llvm %s | FileCheck %s
+
+// CHECK-DAG: llvm.mlir.global internal @imex_gpux_capture_site_0(0 : i8)
+// CHECK-DAG: llvm.mlir.global internal @imex_gpux_capture_site_1(0 : i8)
+module attributes {gpu.container_module}{
+  // CHECK-LABEL: llvm.func @main
+  func.func @main(%dst : memref<8xf32>, %src : memref<8xf32>) {
+    // CHECK: %[[STREAM:.*]] = llvm.call @gpuCreateStream
+    %0 = "gpux.create_stream"() : () -> !gpux.StreamType
+    // CHECK: %[[SITE0:.*]] = llvm.mlir.addressof @imex_gpux_capture_site_{{[01]}} : !llvm.ptr
+    // CHECK: llvm.call @gpuCaptureBegin(%[[STREAM]], %[[SITE0]]) : (!llvm.ptr, !llvm.ptr) -> ()
+    "gpux.capture_begin"(%0) : (!gpux.StreamType) -> ()
+    // CHECK: llvm.call @gpuMemcpy
+    "gpux.memcpy"(%0, %dst, %src) : (!gpux.StreamType, memref<8xf32>, memref<8xf32>) -> ()
+    // CHECK: llvm.call @gpuMemcpy
+    "gpux.memcpy"(%0, %src, %dst) : (!gpux.StreamType, memref<8xf32>, memref<8xf32>) -> ()
+    // CHECK: llvm.call @gpuCaptureEnd(%[[STREAM]]) : (!llvm.ptr) -> ()
+    "gpux.capture_end"(%0) : (!gpux.StreamType) -> ()
+    // CHECK: %[[SITE1:.*]] = llvm.mlir.addressof @imex_gpux_capture_site_{{[01]}} : !llvm.ptr
+    // CHECK: llvm.call @gpuCaptureBegin(%[[STREAM]], %[[SITE1]]) : (!llvm.ptr, !llvm.ptr) -> ()
+    "gpux.capture_begin"(%0) : (!gpux.StreamType) -> ()
+    "gpux.memcpy"(%0, %dst, %src) : (!gpux.StreamType, memref<8xf32>, memref<8xf32>) -> ()
+    // CHECK: llvm.call @gpuCaptureEnd(%[[STREAM]]) : (!llvm.ptr) -> ()
+    "gpux.capture_end"(%0) : (!gpux.StreamType) -> ()
+    "gpux.destroy_stream"(%0) : (!gpux.StreamType) -> ()
+    return
+  }
+}
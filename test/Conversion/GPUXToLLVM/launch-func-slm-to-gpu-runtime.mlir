@@ -0,0 +1,27 @@
+// RUN: imex-opt -convert-func-to-llvm -convert-gpux-to-llvm %s | FileCheck %s
+
+// The shared local memory operand of a launch with a dynamic shared memory
+// size is not packed, the runtime only gets its size.
+
+// CHECK: llvm.mlir.global internal constant @Kernels_slm_kernel_kernel_args(dense<[1, 0, 8]> : tensor<3xi64>) {addr_space = 0 : i32} : !llvm.array<3 x i64>
+module attributes {gpu.container_module} {
+  // CHECK-LABEL: llvm.func @main
+  func.func @main(%arg0: memref<8xf32>, %slm: memref<8xf32, 3>) {
+    %c1 = arith.constant 1 : index
+    %c8 = arith.constant 8 : index
+    %c32_i32 = arith.constant 32 : i32
+    // CHECK: %[[BLOB:.*]] = llvm.alloca %{{.*}} x !llvm.struct<(ptr)> : (i64) -> !llvm.ptr
+    %0 = "gpux.create_stream"() : () -> !gpux.StreamType
+    // CHECK: llvm.getelementptr %[[BLOB]][0, 0]
+    // CHECK-NOT: llvm.getelementptr %[[BLOB]][0, 1]
+    // CHECK: llvm.call @gpuLaunchKernelPacked(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %[[BLOB]], %{{.*}})
+    "gpux.launch_func"(%0, %c1, %c1, %c1, %c8, %c1, %c1, %c32_i32, %arg0, %slm) {kernel = @Kernels::@slm_kernel, operandSegmentSizes = array<i32: 0, 1, 1, 1, 1, 1, 1, 1, 1, 2>} : (!gpux.StreamType, index, index, index, index, index, index, i32, memref<8xf32>, memref<8xf32, 3>) -> ()
+    "gpux.destroy_stream"(%0) : (!gpux.StreamType) -> ()
+    return
+  }
+  gpu.module @Kernels attributes {gpu.binary = "\00"} {
+    gpu.func @slm_kernel(%arg0: memref<8xf32>, %arg1: memref<8xf32, 3>) kernel {
+      gpu.return
+    }
+  }
+}
@@ -1,11 +1,13 @@
 // RUN: imex-opt -convert-func-to-llvm -convert-gpux-to-llvm %s | FileCheck %s
 
 module attributes {gpu.container_module, spirv.target_env = #spirv.target_env<#spirv.vce<v1.0, [Shader], [SPV_KHR_storage_buffer_storage_class]>, #spirv.resource_limits<>>} {
+   // CHECK: llvm.mlir.global internal constant @Kernels_kernel_1_kernel_args(dense<[3, 0, 8, 8, 8, 16, 8]> : tensor<7xi64>) {addr_space = 0 : i32} : !llvm.array<7 x i64>
    // CHECK: llvm.mlir.global internal constant @Kernels_kernel_1_kernel_name("kernel_1\00") {addr_space = 0 : i32}
    // CHECK: llvm.mlir.global internal constant @Kernels_spirv_binary("\03\02#\07\00\00\01\00\16\00\00\00\17\00\00\00\00\00\00\00\11\00\02\00\0B\00\00\00\11\00\02\00\04\00\00\00\11\00\02\00\06\00\00\00\0E\00\03\00\02\00\00\00\02\00\00\00\0F\00\07\00\06\00\00\00\09\00\00\00main_kernel\00\04\00\00\00\05\00\09\00\04\00\00\00__builtin_var_WorkgroupId__\00\05\00\05\00\09\00\00\00main_kernel\00G\00\04\00\04\00\00\00\0B\00\00\00\1A\00\00\00\15\00\04\00\03\00\00\00@\00\00\00\00\00\00\00\17\00\04\00\02\00\00\00\03\00\00\00\03\00\00\00 \00\04\00\01\00\00\00\01\00\00\00\02\00\00\00;\00\04\00\01\00\00\00\04\00\00\00\01\00\00\00\13\00\02\00\06\00\00\00\16\00\03\00\08\00\00\00 \00\00\00 \00\04\00\07\00\00\00\05\00\00\00\08\00\00\00!\00\06\00\05\00\00\00\06\00\00\00\07\00\00\00\07\00\00\00\07\00\00\006\00\05\00\06\00\00\00\09\00\00\00\00\00\00\00\05\00\00\007\00\03\00\07\00\00\00\0A\00\00\007\00\03\00\07\00\00\00\0B\00\00\007\00\03\00\07\00\00\00\0C\00\00\00\F8\00\02\00\0D\00\00\00\F9\00\02\00\0E\00\00\00\F8\00\02\00\0E\00\00\00=\00\04\00\02\00\00\00\0F\00\00\00\04\00\00\00Q\00\05\00\03\00\00\00\10\00\00\00\0F\00\00\00\00\00\00\00F\00\05\00\07\00\00\00\11\00\00\00\0A\00\00\00\10\00\00\00=\00\06\00\08\00\00\00\12\00\00\00\11\00\00\00\02\00\00\00\04\00\00\00F\00\05\00\07\00\00\00\13\00\00\00\0B\00\00\00\10\00\00\00=\00\06\00\08\00\00\00\14\00\00\00\13\00\00\00\02\00\00\00\04\00\00\00\81\00\05\00\08\00\00\00\15\00\00\00\12\00\00\00\14\00\00\00F\00\05\00\07\00\00\00\16\00\00\00\0C\00\00\00\10\00\00\00>\00\05\00\16\00\00\00\15\00\00\00\02\00\00\00\04\00\00\00\FD\00\01\008\00\01\00") {addr_space = 0 : i32}
   func.func @main() attributes {llvm.emit_c_interface} {
     %c1 = arith.constant 1 : index
     %c8 = arith.constant 8 : index
+    // CHECK: %[[BLOB:.*]] = llvm.alloca %{{.*}} x !llvm.struct<(ptr, ptr, ptr)> : (i64) -> !llvm.ptr
     // CHECK: %[[DEVICE:.*]] =  llvm.mlir.zero : !llvm.ptr
     // CHECK: %[[CONTEXT:.*]] =  llvm.mlir.zero : !llvm.ptr
     // CHECK: %[[STREAM:.*]] = llvm.call @gpuCreateStream(%[[DEVICE]], %[[CONTEXT]]) : (!llvm.ptr, !llvm.ptr) -> !llvm.ptr
@@ -18,7 +20,13 @@ module attributes {gpu.container_module, spirv.target_env = #spirv.target_env<#s
     // CHECK: %[[MODULE:.*]] = llvm.call @gpuModuleLoad(%[[STREAM]], %{{.*}}, %{{.*}}) : (!llvm.ptr, !llvm.ptr, i64) -> !llvm.ptr
     // CHECK: llvm.mlir.addressof @Kernels_kernel_1_kernel_name : !llvm.ptr
     // CHECK: %[[KERNEL:.*]] = llvm.call @gpuKernelGet(%[[STREAM]], %[[MODULE]], %{{.*}}) : (!llvm.ptr, !llvm.ptr, !llvm.ptr) -> !llvm.ptr
-    // CHECK: llvm.call @gpuLaunchKernel(%[[STREAM]], %[[KERNEL]], %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (!llvm.ptr, !llvm.ptr, i64, i64, i64, i64, i64, i64, i32, !llvm.ptr) -> ()
+    // CHECK: %[[FIELD0:.*]] = llvm.getelementptr %[[BLOB]][0, 0] : (!llvm.ptr) -> !llvm.ptr, !llvm.struct<(ptr, ptr, ptr)>
+    // CHECK: llvm.store %{{.*}}, %[[FIELD0]] : !llvm.ptr, !llvm.ptr
+    // CHECK: %[[FIELD2:.*]] = llvm.getelementptr %[[BLOB]][0, 2] : (!llvm.ptr) -> !llvm.ptr, !llvm.struct<(ptr, ptr, ptr)>
+    // CHECK: llvm.store %{{.*}}, %[[FIELD2]] : !llvm.ptr, !llvm.ptr
+    // CHECK: %[[LAYOUT:.*]] = llvm.mlir.addressof @Kernels_kernel_1_kernel_args : !llvm.ptr
+    // CHECK-NOT: llvm.insertvalue
+    // CHECK: llvm.call @gpuLaunchKernelPacked(%[[STREAM]], %[[KERNEL]], %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %[[BLOB]], %[[LAYOUT]]) : (!llvm.ptr, !llvm.ptr, i64, i64, i64, i64, i64, i64, i32, !llvm.ptr, !llvm.ptr) -> ()
     "gpux.launch_func"(%0, %c8, %c1, %c1, %c1, %c1, %c1, %memref, %memref_0, %memref_1) {kernel = @Kernels::@kernel_1, operandSegmentSizes = array<i32: 0, 1, 1, 1, 1, 1, 1, 1, 0, 3>} : (!gpux.StreamType, index, index, index, index, index, index, memref<8xf32>, memref<8xf32>, memref<8xf32>) -> ()
     "gpux.dealloc"(%0, %memref) : (!gpux.StreamType, memref<8xf32>) -> ()
     "gpux.dealloc"(%0, %memref_0) : (!gpux.StreamType, memref<8xf32>) -> ()
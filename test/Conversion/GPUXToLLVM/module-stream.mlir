@@ -0,0 +1,48 @@
+// RUN: imex-opt -convert-func-to-llvm -convert-gpux-to-llvm %s | FileCheck %s
+
+module attributes {gpu.container_module}{
+  // CHECK-LABEL: llvm.func @main
+  func.func @main() attributes {llvm.emit_c_interface} {
+    // CHECK: %[[STREAM:.*]] = llvm.call @imex_gpux_get_module_stream() : () -> !llvm.ptr
+    %0 = "gpux.create_stream"() {module_lifetime} : () -> !gpux.StreamType
+    // CHECK-NOT: llvm.call @gpuStreamDestroy
+    "gpux.destroy_stream"(%0) : (!gpux.StreamType) -> ()
+    return
+  }
+
+  // CHECK-LABEL: llvm.func @other
+  func.func @other() {
+    // CHECK: llvm.call @imex_gpux_get_module_stream() : () -> !llvm.ptr
+    %0 = "gpux.create_stream"() {module_lifetime} : () -> !gpux.StreamType
+    return
+  }
+
+  // CHECK: llvm.mlir.global internal @imex_gpux_module_stream() {{.*}} : !llvm.ptr {
+  // CHECK:   %[[NULL:.*]] = llvm.mlir.zero : !llvm.ptr
+  // CHECK:   llvm.return %[[NULL]] : !llvm.ptr
+
+  // CHECK: llvm.func internal @imex_gpux_get_module_stream() -> !llvm.ptr {
+  // CHECK:   %[[ADDR:.*]] = llvm.mlir.addressof @imex_gpux_module_stream : !llvm.ptr
+  // CHECK:   %[[CUR:.*]] = llvm.load %[[ADDR]] atomic acquire {alignment = 8 : i64} : !llvm.ptr -> !llvm.ptr
+  // CHECK:   %[[ZERO:.*]] = llvm.mlir.zero : !llvm.ptr
+  // CHECK:   %[[ISNULL:.*]] = llvm.icmp "eq" %[[CUR]], %[[ZERO]] : !llvm.ptr
+  // CHECK:   llvm.cond_br %[[ISNULL]], ^[[CREATE:.*]], ^[[DONE:.*]](%[[CUR]] : !llvm.ptr)
+  // CHECK: ^[[CREATE]]:
+  // CHECK:   %[[NEW:.*]] = llvm.call @gpuCreateStream(%[[ZERO]], %[[ZERO]]) : (!llvm.ptr, !llvm.ptr) -> !llvm.ptr
+  // CHECK:   %[[PAIR:.*]] = llvm.cmpxchg %[[ADDR]], %[[ZERO]], %[[NEW]] acq_rel acquire
+  // CHECK:   %[[OK:.*]] = llvm.extractvalue %[[PAIR]][1]
+  // CHECK:   llvm.cond_br %[[OK]], ^[[DONE]](%[[NEW]] : !llvm.ptr), ^[[LOST:.*]]
+  // CHECK: ^[[LOST]]:
+  // CHECK:   llvm.call @gpuStreamDestroy(%[[NEW]]) : (!llvm.ptr) -> ()
+  // CHECK:   %[[OLD:.*]] = llvm.extractvalue %[[PAIR]][0]
+  // CHECK:   llvm.br ^[[DONE]](%[[OLD]] : !llvm.ptr)
+  // CHECK: ^[[DONE]](%[[RES:.*]]: !llvm.ptr):
+  // CHECK:   llvm.return %[[RES]] : !llvm.ptr
+
+  // CHECK: llvm.func internal @imex_gpux_module_stream_dtor() {
+  // CHECK:   llvm.load %{{.*}} atomic acquire {alignment = 8 : i64}
+  // CHECK:   llvm.call @gpuStreamDestroy
+  // CHECK:   llvm.store %{{.*}}, %{{.*}} atomic release {alignment = 8 : i64}
+  // CHECK: llvm.mlir.global_dtors {dtors = [@imex_gpux_module_stream_dtor], priorities = [65535 : i32]}
+  // CHECK-NOT: @imex_gpux_get_module_stream() -> !llvm.ptr {
+}
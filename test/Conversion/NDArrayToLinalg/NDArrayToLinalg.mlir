@@ -1,4 +1,5 @@
 // RUN: imex-opt --split-input-file --convert-ndarray-to-linalg %s -verify-diagnostics -o -| FileCheck %s
+// RUN: imex-opt --split-input-file --convert-ndarray-to-linalg=parallel-copy=true %s -verify-diagnostics -o -| FileCheck %s --check-prefix=PAR
 
 // -----
 func.func @test_subview(%arg0: !ndarray.ndarray<?xi64>) -> !ndarray.ndarray<?xi64> {
@@ -162,6 +163,50 @@ func.func @test_ewbin_3d(%arg0: !ndarray.ndarray<?x?x?xi64>) -> !ndarray.ndarray
 // CHECK: arith.addi
 // CHECK: return %{{.+}} : memref<?x?x?xi64, strided<[?, ?, ?], offset: ?>>
 
+// -----
+func.func @test_ewbin_bcast_row_col(%arg0: !ndarray.ndarray<?x1xi64>, %arg1: !ndarray.ndarray<1x?xi64>) -> !ndarray.ndarray<?x?xi64> {
+    %0 = ndarray.ewbin %arg0, %arg1 {op = 0 : i32} : (!ndarray.ndarray<?x1xi64>, !ndarray.ndarray<1x?xi64>) -> !ndarray.ndarray<?x?xi64>
+    return %0 : !ndarray.ndarray<?x?xi64>
+}
+// CHECK-DAG: [[LMAP:#map[0-9]*]] = affine_map<(d0, d1) -> (d0, 0)>
+// CHECK-DAG: [[RMAP:#map[0-9]*]] = affine_map<(d0, d1) -> (0, d1)>
+// CHECK-LABEL: @test_ewbin_bcast_row_col
+// CHECK-NOT: memref.reinterpret_cast
+// CHECK: tensor.empty
+// CHECK: linalg.generic {indexing_maps = {{\[}}[[LMAP]], [[RMAP]], #map{{[0-9]*}}]
+// CHECK: arith.addi
+
+// -----
+func.func @test_ewbin_bcast_rank(%arg0: !ndarray.ndarray<16xi64>, %arg1: !ndarray.ndarray<4x16xi64>) -> !ndarray.ndarray<4x16xi64> {
+    %0 = ndarray.ewbin %arg0, %arg1 {op = 0 : i32} : (!ndarray.ndarray<16xi64>, !ndarray.ndarray<4x16xi64>) -> !ndarray.ndarray<4x16xi64>
+    return %0 : !ndarray.ndarray<4x16xi64>
+}
+// CHECK-DAG: [[LMAP:#map[0-9]*]] = affine_map<(d0, d1) -> (d1)>
+// CHECK-LABEL: @test_ewbin_bcast_rank
+// CHECK: tensor.empty() : tensor<4x16xi64>
+// CHECK: linalg.generic {indexing_maps = {{\[}}[[LMAP]], #map{{[0-9]*}}, #map{{[0-9]*}}]
+
+// -----
+func.func @test_ewbin_bcast_dyn(%arg0: !ndarray.ndarray<?x?xi64>, %arg1: !ndarray.ndarray<?xi64>) -> !ndarray.ndarray<?x?xi64> {
+    %0 = ndarray.ewbin %arg0, %arg1 {op = 0 : i32} : (!ndarray.ndarray<?x?xi64>, !ndarray.ndarray<?xi64>) -> !ndarray.ndarray<?x?xi64>
+    return %0 : !ndarray.ndarray<?x?xi64>
+}
+// CHECK-LABEL: @test_ewbin_bcast_dyn
+// CHECK: arith.ori
+// CHECK: arith.maxui
+// CHECK-NEXT: arith.select
+// CHECK: memref.extract_strided_metadata
+// CHECK: arith.select
+// CHECK: [[LV:%.*]] = memref.reinterpret_cast
+// CHECK: [[LT:%.*]] = bufferization.to_tensor [[LV]]
+// CHECK: memref.extract_strided_metadata
+// CHECK: [[RV:%.*]] = memref.reinterpret_cast
+// CHECK-SAME: to memref<?x?xi64, strided<[?, ?], offset: ?>>
+// CHECK: [[RT:%.*]] = bufferization.to_tensor [[RV]]
+// CHECK: [[E:%.*]] = tensor.empty
+// CHECK: linalg.generic {indexing_maps = [#map, #map, #map]{{.*}} ins([[LT]], [[RT]] : {{.*}}) outs([[E]]
+// CHECK-NOT: tensor.expand_shape
+
 // -----
 func.func @test_reduction(%arg0: !ndarray.ndarray<?xi64>) -> i64 {
     %0 = ndarray.reduction %arg0 {op = 4 : i32} : !ndarray.ndarray<?xi64> -> !ndarray.ndarray<i64>
@@ -184,6 +229,44 @@ func.func @test_reduction_3d(%arg0: !ndarray.ndarray<?x?x?xi64>) -> i64 {
 // CHECK: linalg.generic{{.*}}["reduction", "reduction", "reduction"]}{{.*}}outs([[C0]]
 // CHECK: return %{{.}} : i64
 
+// -----
+func.func @test_matmul(%arg0: !ndarray.ndarray<4x8xf32>, %arg1: !ndarray.ndarray<8x16xf32>) -> !ndarray.ndarray<4x16xf32> {
+    %0 = ndarray.matmul %arg0, %arg1 : (!ndarray.ndarray<4x8xf32>, !ndarray.ndarray<8x16xf32>) -> !ndarray.ndarray<4x16xf32>
+    return %0 : !ndarray.ndarray<4x16xf32>
+}
+// CHECK-LABEL: @test_matmul
+// CHECK: [[E:%.*]] = tensor.empty() : tensor<4x16xf32>
+// CHECK: [[F:%.*]] = linalg.fill ins(%{{.*}} : f32) outs([[E]] : tensor<4x16xf32>)
+// CHECK: linalg.matmul ins(%{{.*}}, %{{.*}} : tensor<4x8xf32>, tensor<8x16xf32>) outs([[F]] : tensor<4x16xf32>)
+
+// -----
+func.func @test_batch_matmul(%arg0: !ndarray.ndarray<2x?x8xf32>, %arg1: !ndarray.ndarray<2x8x16xf32>) -> !ndarray.ndarray<2x?x16xf32> {
+    %0 = ndarray.matmul %arg0, %arg1 : (!ndarray.ndarray<2x?x8xf32>, !ndarray.ndarray<2x8x16xf32>) -> !ndarray.ndarray<2x?x16xf32>
+    return %0 : !ndarray.ndarray<2x?x16xf32>
+}
+// CHECK-LABEL: @test_batch_matmul
+// CHECK: tensor.dim
+// CHECK: [[E:%.*]] = tensor.empty(%{{.*}}) : tensor<2x?x16xf32>
+// CHECK: [[F:%.*]] = linalg.fill
+// CHECK: linalg.batch_matmul ins(%{{.*}}, %{{.*}} : tensor<2x?x8xf32>, tensor<2x8x16xf32>) outs([[F]] : tensor<2x?x16xf32>)
+
+// -----
+func.func @test_matmul_transposed(%arg0: !ndarray.ndarray<8x4xf16>, %arg1: !ndarray.ndarray<16x8xf16>) -> !ndarray.ndarray<4x16xf32> {
+    %0 = ndarray.matmul %arg0, %arg1 {transpose_lhs, transpose_rhs} : (!ndarray.ndarray<8x4xf16>, !ndarray.ndarray<16x8xf16>) -> !ndarray.ndarray<4x16xf32>
+    return %0 : !ndarray.ndarray<4x16xf32>
+}
+// CHECK: #[[LHS:.*]] = affine_map<(d0, d1, d2) -> (d2, d0)>
+// CHECK: #[[RHS:.*]] = affine_map<(d0, d1, d2) -> (d1, d2)>
+// CHECK: #[[RES:.*]] = affine_map<(d0, d1, d2) -> (d0, d1)>
+// CHECK-LABEL: @test_matmul_transposed
+// CHECK: [[F:%.*]] = linalg.fill
+// CHECK: linalg.generic {indexing_maps = [#[[LHS]], #[[RHS]], #[[RES]]], iterator_types = ["parallel", "parallel", "reduction"]}
+// CHECK-SAME: outs([[F]] : tensor<4x16xf32>)
+// CHECK: arith.extf
+// CHECK: arith.extf
+// CHECK: arith.mulf
+// CHECK: arith.addf
+
 // -----
 func.func @test_insert_slice(%arg0: !ndarray.ndarray<?xi64>, %arg1: !ndarray.ndarray<?xi64>) {
     %i0 = arith.constant 0 : index
@@ -239,6 +322,62 @@ func.func @test_immutable_insert_slice(%arg0: !ndarray.ndarray<?xi64>, %arg1: !n
 // CHECK-NEXT: [[V0:%.*]] = tensor.insert_slice [[A1]] into [[A0]][%c0] [%c3] [%c1] : tensor<?xi64> into tensor<?xi64>
 // CHECK-NEXT: [[V1:%.*]] = bufferization.to_memref [[V0]]
 
+// -----
+func.func @test_immutable_insert_slice_inplace(%arg0: !ndarray.ndarray<16xi64>) -> !ndarray.ndarray<16xi64> {
+    %i0 = arith.constant 0 : index
+    %i1 = arith.constant 1 : index
+    %i14 = arith.constant 14 : index
+    %0 = ndarray.ewbin %arg0, %arg0 {op = 0 : i32} : (!ndarray.ndarray<16xi64>, !ndarray.ndarray<16xi64>) -> !ndarray.ndarray<16xi64>
+    %1 = ndarray.extract_slice %0[%i0][%i14][%i1] : !ndarray.ndarray<16xi64> to !ndarray.ndarray<?xi64>
+    %2 = ndarray.ewbin %1, %1 {op = 0 : i32} : (!ndarray.ndarray<?xi64>, !ndarray.ndarray<?xi64>) -> !ndarray.ndarray<?xi64>
+    %3 = ndarray.immutable_insert_slice %2 into %0[%i1] [%i14] [%i1] : !ndarray.ndarray<?xi64> into !ndarray.ndarray<16xi64>
+    return %3 : !ndarray.ndarray<16xi64>
+}
+// CHECK-LABEL: @test_immutable_insert_slice_inplace
+// CHECK-NOT: tensor.insert_slice
+// CHECK: [[S:%.*]] = bufferization.to_memref
+// CHECK-NEXT: [[D:%.*]] = bufferization.to_memref
+// CHECK-NEXT: [[SV:%.*]] = memref.subview [[D]][%c1] [%c14] [%c1]
+// CHECK-NEXT: memref.copy [[S]], [[SV]]
+// CHECK-NEXT: bufferization.to_tensor [[D]]
+// CHECK-NOT: tensor.insert_slice
+
+// -----
+func.func @test_immutable_insert_slice_live(%arg0: !ndarray.ndarray<16xi64>) -> (!ndarray.ndarray<16xi64>, !ndarray.ndarray<16xi64>) {
+    %i0 = arith.constant 0 : index
+    %i1 = arith.constant 1 : index
+    %i14 = arith.constant 14 : index
+    %0 = ndarray.ewbin %arg0, %arg0 {op = 0 : i32} : (!ndarray.ndarray<16xi64>, !ndarray.ndarray<16xi64>) -> !ndarray.ndarray<16xi64>
+    %1 = ndarray.extract_slice %0[%i0][%i14][%i1] : !ndarray.ndarray<16xi64> to !ndarray.ndarray<?xi64>
+    %2 = ndarray.immutable_insert_slice %1 into %0[%i1] [%i14] [%i1] : !ndarray.ndarray<?xi64> into !ndarray.ndarray<16xi64>
+    return %0, %2 : !ndarray.ndarray<16xi64>, !ndarray.ndarray<16xi64>
+}
+// CHECK-LABEL: @test_immutable_insert_slice_live
+// CHECK: tensor.insert_slice
+// CHECK-NOT: memref.copy
+
+// -----
+func.func @test_immutable_insert_slice_loop(%arg0: !ndarray.ndarray<16xi64>, %arg1: index) -> !ndarray.ndarray<16xi64> {
+    %i0 = arith.constant 0 : index
+    %i1 = arith.constant 1 : index
+    %i14 = arith.constant 14 : index
+    %0 = ndarray.ewbin %arg0, %arg0 {op = 0 : i32} : (!ndarray.ndarray<16xi64>, !ndarray.ndarray<16xi64>) -> !ndarray.ndarray<16xi64>
+    %1 = scf.for %i = %i0 to %arg1 step %i1 iter_args(%a = %0) -> (!ndarray.ndarray<16xi64>) {
+        %2 = ndarray.extract_slice %a[%i0][%i14][%i1] : !ndarray.ndarray<16xi64> to !ndarray.ndarray<?xi64>
+        %3 = ndarray.ewbin %2, %2 {op = 0 : i32} : (!ndarray.ndarray<?xi64>, !ndarray.ndarray<?xi64>) -> !ndarray.ndarray<?xi64>
+        %4 = ndarray.immutable_insert_slice %3 into %a[%i1] [%i14] [%i1] : !ndarray.ndarray<?xi64> into !ndarray.ndarray<16xi64>
+        scf.yield %4 : !ndarray.ndarray<16xi64>
+    }
+    return %1 : !ndarray.ndarray<16xi64>
+}
+// CHECK-LABEL: @test_immutable_insert_slice_loop
+// CHECK: scf.for
+// CHECK-NOT: tensor.insert_slice
+// CHECK: memref.subview
+// CHECK-NEXT: memref.copy
+// CHECK-NEXT: bufferization.to_tensor
+// CHECK: scf.yield
+
 // -----
 func.func @test_dim(%arg0: !ndarray.ndarray<?xi64>) -> index {
     %c0 = arith.constant 0 : index
@@ -379,6 +518,15 @@ func.func @test_copy(%a: !ndarray.ndarray<?xi64>) -> !ndarray.ndarray<?xi64> {
 // CHECK-NEXT: bufferization.to_tensor
 // CHECK-NEXT: return
 // CHECK-SAME: memref<?xi64, strided<[?], offset: ?>>
+// PAR-LABEL: func.func @test_copy
+// PAR: region.env_region "protect_copy_op"
+// PAR-NEXT: linalg.generic
+// PAR-SAME: iterator_types = ["parallel"]
+// PAR-NOT: memref.copy
+// PAR: region.env_region "protect_copy_op"
+// PAR-NEXT: memref.copy
+// PAR: region.env_region "protect_copy_op"
+// PAR-NEXT: memref.copy
 
 // -----
 func.func @test_delete(%arg0: !ndarray.ndarray<?xi64>) {
@@ -0,0 +1,41 @@
+// RUN: imex-opt --split-input-file --convert-ndarray-to-linalg="use-xetile=true" %s -verify-diagnostics -o -| FileCheck %s
+
+func.func @test_matmul_xetile(%arg0: !ndarray.ndarray<64x128xf16, #region.gpu_env<device = "g">>, %arg1: !ndarray.ndarray<128x64xf16, #region.gpu_env<device = "g">>) -> !ndarray.ndarray<64x64xf32, #region.gpu_env<device = "g">> {
+    %0 = region.env_region #region.gpu_env<device = "g"> -> !ndarray.ndarray<64x64xf32, #region.gpu_env<device = "g">> {
+        %1 = ndarray.matmul %arg0, %arg1 : (!ndarray.ndarray<64x128xf16, #region.gpu_env<device = "g">>, !ndarray.ndarray<128x64xf16, #region.gpu_env<device = "g">>) -> !ndarray.ndarray<64x64xf32, #region.gpu_env<device = "g">>
+        region.env_region_yield %1 : !ndarray.ndarray<64x64xf32, #region.gpu_env<device = "g">>
+    }
+    return %0 : !ndarray.ndarray<64x64xf32, #region.gpu_env<device = "g">>
+}
+// CHECK-LABEL: @test_matmul_xetile
+// CHECK: region.env_region #region.gpu_env<device = "g">
+// CHECK: [[C:%.*]] = memref.alloc() : memref<64x64xf32>
+// CHECK: [[C4:%.*]] = arith.constant 4 : index
+// CHECK: [[C2:%.*]] = arith.constant 2 : index
+// CHECK: gpu.launch blocks({{.*}}) in ({{.*}} = [[C4]], {{.*}} = [[C2]], {{.*}}) threads
+// CHECK: xetile.init_tile [[C]]{{.*}} -> !xetile.tile<16x32xf32>
+// CHECK: xetile.init_tile {{.*}} -> !xetile.tile<16x32xf16>
+// CHECK: xetile.init_tile {{.*}} -> !xetile.tile<32x32xf16>
+// CHECK: scf.for
+// CHECK: xetile.load_tile
+// CHECK: xetile.load_tile
+// CHECK: xetile.tile_mma
+// CHECK: xetile.update_tile_offset
+// CHECK: xetile.update_tile_offset
+// CHECK: scf.yield
+// CHECK: xetile.store_tile
+// CHECK: gpu.terminator
+// CHECK: bufferization.to_tensor [[C]]
+
+// -----
+// Shapes not divisible by the tile shape fall back to linalg
+func.func @test_matmul_fallback(%arg0: !ndarray.ndarray<8x128xf16, #region.gpu_env<device = "g">>, %arg1: !ndarray.ndarray<128x64xf16, #region.gpu_env<device = "g">>) -> !ndarray.ndarray<8x64xf32, #region.gpu_env<device = "g">> {
+    %0 = region.env_region #region.gpu_env<device = "g"> -> !ndarray.ndarray<8x64xf32, #region.gpu_env<device = "g">> {
+        %1 = ndarray.matmul %arg0, %arg1 : (!ndarray.ndarray<8x128xf16, #region.gpu_env<device = "g">>, !ndarray.ndarray<128x64xf16, #region.gpu_env<device = "g">>) -> !ndarray.ndarray<8x64xf32, #region.gpu_env<device = "g">>
+        region.env_region_yield %1 : !ndarray.ndarray<8x64xf32, #region.gpu_env<device = "g">>
+    }
+    return %0 : !ndarray.ndarray<8x64xf32, #region.gpu_env<device = "g">>
+}
+// CHECK-LABEL: @test_matmul_fallback
+// CHECK-NOT: gpu.launch
+// CHECK: linalg.matmul
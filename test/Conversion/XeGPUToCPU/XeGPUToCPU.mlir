@@ -0,0 +1,79 @@
+// RUN: imex-opt -convert-xegpu-to-cpu %s | FileCheck %s
+// RUN: imex-opt -convert-xegpu-to-cpu='profile=true' %s | FileCheck %s --check-prefix=PROFILE
+
+// CHECK-NOT: gpu.container_module
+// PROFILE: memref.global "private" @__xegpu_cpu_profile : memref<10xi64> = dense<0>
+// PROFILE: func.func private @printXeGPUProfile(memref<*xi64>) attributes {llvm.emit_c_interface}
+module @gemm attributes {gpu.container_module} {
+  // CHECK-LABEL: func.func @test
+  // CHECK: %[[A:.*]] = memref.alloc() : memref<8x16xf16>
+  // CHECK: memref.copy
+  // CHECK: %[[B:.*]] = memref.alloc() : memref<16x16xf16>
+  // CHECK: %[[C:.*]] = memref.alloc() : memref<8x16xf32>
+  // CHECK: scf.for %[[BX:.*]] = %{{.*}} to %{{.*}} step
+  // CHECK: scf.for %[[BY:.*]] =
+  // CHECK: scf.for %[[BZ:.*]] =
+  // CHECK: scf.for %[[TX:.*]] =
+  // CHECK: scf.for %[[TY:.*]] =
+  // CHECK: scf.for %[[TZ:.*]] =
+  // CHECK: func.call @test_kernel_test_kernel(%[[A]], %[[B]], %[[C]], %[[BX]], %[[BY]], %[[BZ]], %[[TX]], %[[TY]], %[[TZ]]
+  // CHECK: memref.dealloc %[[A]]
+  // PROFILE: scf.for
+  // PROFILE: func.call @test_kernel_test_kernel
+  // PROFILE: %[[COUNTERS:.*]] = memref.get_global @__xegpu_cpu_profile : memref<10xi64>
+  // PROFILE: %[[CAST:.*]] = memref.cast %[[COUNTERS]] : memref<10xi64> to memref<*xi64>
+  // PROFILE: call @printXeGPUProfile(%[[CAST]]) : (memref<*xi64>) -> ()
+  func.func @test(%arg0: memref<8x16xf16>, %arg1: memref<16x16xf16>) -> memref<8x16xf32> attributes {llvm.emit_c_interface} {
+    %c1 = arith.constant 1 : index
+    %memref = gpu.alloc  host_shared () : memref<8x16xf16>
+    memref.copy %arg0, %memref : memref<8x16xf16> to memref<8x16xf16>
+    %memref_0 = gpu.alloc  host_shared () : memref<16x16xf16>
+    memref.copy %arg1, %memref_0 : memref<16x16xf16> to memref<16x16xf16>
+    %memref_1 = gpu.alloc  host_shared () : memref<8x16xf32>
+    gpu.launch_func  @test_kernel::@test_kernel blocks in (%c1, %c1, %c1) threads in (%c1, %c1, %c1) args(%memref : memref<8x16xf16>, %memref_0 : memref<16x16xf16>, %memref_1 : memref<8x16xf32>)
+    gpu.dealloc  %memref : memref<8x16xf16>
+    gpu.dealloc  %memref_0 : memref<16x16xf16>
+    return %memref_1 : memref<8x16xf32>
+  }
+
+  // CHECK-NOT: gpu.module
+  // CHECK-LABEL: func.func private @test_kernel_test_kernel
+  // CHECK-SAME: (%[[ARG0:.*]]: memref<8x16xf16>, %[[ARG1:.*]]: memref<16x16xf16>, %[[ARG2:.*]]: memref<8x16xf32>
+  // CHECK: memref.cast %[[ARG0]] : memref<8x16xf16> to memref<?x?xf16, strided<[?, ?], offset: ?>>
+  // CHECK: memref.alloca_scope
+  // CHECK: memref.alloca()
+  // CHECK: scf.if
+  // CHECK: memref.load
+  // CHECK: vector.load
+  // CHECK: vector.transpose
+  // CHECK: vector.contract
+  // CHECK-SAME: into vector<8x16xf32>
+  // CHECK: memref.alloca_scope
+  // CHECK: memref.store
+  // CHECK: return
+  // PROFILE-LABEL: func.func private @test_kernel_test_kernel
+  // PROFILE: memref.get_global @__xegpu_cpu_profile
+  // PROFILE: memref.load
+  // PROFILE: arith.addi
+  // PROFILE: memref.store
+  gpu.module @test_kernel attributes {spirv.target_env = #spirv.target_env<#spirv.vce<v1.4, [Addresses, Float16Buffer, Int64, Int16, Int8, Kernel, Linkage, Vector16, GenericPointer, Groups, Float16, Float64, AtomicFloat32AddEXT, ExpectAssumeKHR, SubgroupDispatch, VectorComputeINTEL, VectorAnyINTEL], [SPV_EXT_shader_atomic_float_add, SPV_KHR_expect_assume, SPV_INTEL_vector_compute]>, api=OpenCL, #spirv.resource_limits<>>} {
+    gpu.func @test_kernel(%arg0: memref<8x16xf16>, %arg1: memref<16x16xf16>, %arg2: memref<8x16xf32>) kernel attributes {VectorComputeFunctionINTEL, spirv.entry_point_abi = #spirv.entry_point_abi<>} {
+      %c0 = arith.constant 0 : index
+      %bid = gpu.block_id x
+      %0 = xegpu.create_nd_tdesc %arg0[0, 0] {mode = vc}
+      : memref<8x16xf16> -> !xegpu.tensor_desc<8x16xf16>
+      %1 = xegpu.create_nd_tdesc %arg1[0, 0] {mode = vc}
+      : memref<16x16xf16> -> !xegpu.tensor_desc<16x16xf16>
+      %2 = xegpu.create_nd_tdesc %arg2[0, 0] {mode = vc}
+      : memref<8x16xf32> -> !xegpu.tensor_desc<8x16xf32>
+      xegpu.prefetch_nd %0 {mode = vc} : !xegpu.tensor_desc<8x16xf16>
+      %3 = xegpu.load_nd %0 {mode = vc, vnni_axis = 1} : !xegpu.tensor_desc<8x16xf16> -> vector<8x8x2xf16>
+      %4 = xegpu.load_nd %1  {mode = vc, vnni_axis = 0} : !xegpu.tensor_desc<16x16xf16> -> vector<8x16x2xf16>
+      %5 = xegpu.load_nd %2  {mode = vc} : !xegpu.tensor_desc<8x16xf32> -> vector<8x16xf32>
+      %6 = xegpu.dpas %3, %4, %5 : vector<8x8x2xf16>, vector<8x16x2xf16>, vector<8x16xf32> -> vector<8x16xf32>
+      %7 = xegpu.update_nd_offset %2, [%bid, %c0] {mode = vc} : !xegpu.tensor_desc<8x16xf32> -> !xegpu.tensor_desc<8x16xf32>
+      xegpu.store_nd %6, %7 {mode = vc} : vector<8x16xf32>, !xegpu.tensor_desc<8x16xf32>
+      gpu.return
+    }
+  }
+}
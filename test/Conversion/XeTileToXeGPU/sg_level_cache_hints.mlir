@@ -0,0 +1,83 @@
+// RUN: imex-opt --split-input-file --convert-xetile-to-xegpu --remove-dead-values %s -verify-diagnostics -o -| FileCheck %s
+
+// CHECK-LABEL: func @sglevel_cache_hints_gemm
+func.func @sglevel_cache_hints_gemm(%a: memref<1024x1024xf16>, %b: memref<1024x1024xf16>, %c: memref<1024x1024xf32>) {
+  %c0 = arith.constant 0 : index
+  %c16 = arith.constant 16 : index
+  %c1024 = arith.constant 1024 : index
+  %a_tile = xetile.init_tile %a[0, 0] : memref<1024x1024xf16> -> !xetile.tile<1x1x8x16xf16>
+  %b_tile = xetile.init_tile %b[0, 0] : memref<1024x1024xf16> -> !xetile.tile<1x1x16x16xf16>
+  %c_tile = xetile.init_tile %c[0, 0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+  // the C tile is loaded and stored again, so it stays cached.
+  // CHECK: xegpu.load_nd {{.*}} {mode = vc, l1_hint = cached, l2_hint = cached, l3_hint = cached} : !xegpu.tensor_desc<8x16xf32>
+  %c_value = xetile.load_tile %c_tile : !xetile.tile<1x1x8x16xf32> -> vector<1x1x8x16xf32>
+  %out:3 = scf.for %k = %c0 to %c1024 step %c16
+    iter_args(%a_iter = %a_tile, %b_iter = %b_tile, %c_iter = %c_value)
+    -> (!xetile.tile<1x1x8x16xf16>, !xetile.tile<1x1x16x16xf16>, vector<1x1x8x16xf32>) {
+    // A is advanced every iteration and not prefetched: streamed.
+    // CHECK: xegpu.load_nd {{.*}} {mode = vc, vnni_axis = 1, l1_hint = streaming, l2_hint = cached, l3_hint = cached} : !xegpu.tensor_desc<8x16xf16>
+    %a_value = xetile.load_tile %a_iter : !xetile.tile<1x1x8x16xf16> -> vector<1x1x8x16xf16>
+    // B is advanced every iteration but prefetched: cached.
+    // CHECK: xegpu.prefetch_nd {{.*}} {mode = vc, l1_hint = cached, l2_hint = cached, l3_hint = cached} : !xegpu.tensor_desc<16x16xf16>
+    // CHECK: xegpu.load_nd {{.*}} {mode = vc, vnni_axis = 0, l1_hint = cached, l2_hint = cached, l3_hint = cached} : !xegpu.tensor_desc<16x16xf16>
+    xetile.prefetch_tile %b_iter : !xetile.tile<1x1x16x16xf16>
+    %b_value = xetile.load_tile %b_iter : !xetile.tile<1x1x16x16xf16> -> vector<1x1x16x16xf16>
+    %c_new = xetile.tile_mma %a_value, %b_value, %c_iter : vector<1x1x8x16xf16>, vector<1x1x16x16xf16>, vector<1x1x8x16xf32> -> vector<1x1x8x16xf32>
+    %a_next = xetile.update_tile_offset %a_iter, [%c0, %c16] : !xetile.tile<1x1x8x16xf16>, index, index -> !xetile.tile<1x1x8x16xf16>
+    %b_next = xetile.update_tile_offset %b_iter, [%c16, %c0] : !xetile.tile<1x1x16x16xf16>, index, index -> !xetile.tile<1x1x16x16xf16>
+    scf.yield %a_next, %b_next, %c_new : !xetile.tile<1x1x8x16xf16>, !xetile.tile<1x1x16x16xf16>, vector<1x1x8x16xf32>
+  }
+  // CHECK: xegpu.store_nd {{.*}} {mode = vc, l1_hint = write_back, l2_hint = write_back, l3_hint = write_back} : vector<8x16xf32>, !xegpu.tensor_desc<8x16xf32>
+  xetile.store_tile %out#2, %c_tile : vector<1x1x8x16xf32>, !xetile.tile<1x1x8x16xf32>
+  return
+}
+
+// -----
+// CHECK-LABEL: func @sglevel_cache_hints_epilogue
+func.func @sglevel_cache_hints_epilogue(%a: memref<1024x1024xf32>, %b: memref<1024x1024xf32>) {
+  %a_tile = xetile.init_tile %a[0, 0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+  %b_tile = xetile.init_tile %b[0, 0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+  // single-use accesses outside of loops are streamed.
+  // CHECK: xegpu.load_nd {{.*}} {mode = vc, l1_hint = streaming, l2_hint = cached, l3_hint = cached}
+  %value = xetile.load_tile %a_tile : !xetile.tile<1x1x8x16xf32> -> vector<1x1x8x16xf32>
+  // CHECK: xegpu.store_nd {{.*}} {mode = vc, l1_hint = streaming, l2_hint = write_back, l3_hint = write_back}
+  xetile.store_tile %value, %b_tile : vector<1x1x8x16xf32>, !xetile.tile<1x1x8x16xf32>
+  return
+}
+
+// -----
+// CHECK-LABEL: func @sglevel_cache_hints_override
+func.func @sglevel_cache_hints_override(%a: memref<1024x1024xf32>, %b: memref<1024x1024xf32>) {
+  %a_tile = xetile.init_tile %a[0, 0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+  %b_tile = xetile.init_tile %b[0, 0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+  // CHECK: xegpu.load_nd {{.*}} {mode = vc, l1_hint = cached, l2_hint = cached, l3_hint = cached}
+  %value = xetile.load_tile %a_tile { cache_hint = #xetile.cache_hint<cached> } : !xetile.tile<1x1x8x16xf32> -> vector<1x1x8x16xf32>
+  // CHECK: xegpu.store_nd {{.*}} {mode = vc, l1_hint = uncached, l2_hint = uncached, l3_hint = uncached}
+  xetile.store_tile %value, %b_tile {cache_hint = #xetile.cache_hint<uncached>} : vector<1x1x8x16xf32>, !xetile.tile<1x1x8x16xf32>
+  return
+}
+
+// -----
+// CHECK-LABEL: func @sglevel_cache_hints_init_in_loop
+func.func @sglevel_cache_hints_init_in_loop(%a: memref<1024x1024xf32>, %b: memref<1024x1024xf32>) {
+  %c0 = arith.constant 0 : index
+  %c8 = arith.constant 8 : index
+  %c1024 = arith.constant 1024 : index
+  scf.for %k = %c0 to %c1024 step %c8 {
+    // tiles created at offsets depending on the induction variable are
+    // accessed once: streamed.
+    %row = arith.addi %k, %c0 : index
+    %a_tile = xetile.init_tile %a[%row, %c0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+    %b_tile = xetile.init_tile %b[%k, %c0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+    // CHECK: xegpu.load_nd {{.*}} {mode = vc, l1_hint = streaming, l2_hint = cached, l3_hint = cached}
+    %value = xetile.load_tile %a_tile : !xetile.tile<1x1x8x16xf32> -> vector<1x1x8x16xf32>
+    // CHECK: xegpu.store_nd {{.*}} {mode = vc, l1_hint = streaming, l2_hint = write_back, l3_hint = write_back}
+    xetile.store_tile %value, %b_tile : vector<1x1x8x16xf32>, !xetile.tile<1x1x8x16xf32>
+    // the same tile is loaded in every iteration: cached.
+    %c_tile = xetile.init_tile %a[0, 0] : memref<1024x1024xf32> -> !xetile.tile<1x1x8x16xf32>
+    // CHECK: xegpu.load_nd {{.*}} {mode = vc, l1_hint = cached, l2_hint = cached, l3_hint = cached}
+    %c_value = xetile.load_tile %c_tile : !xetile.tile<1x1x8x16xf32> -> vector<1x1x8x16xf32>
+    xetile.store_tile %c_value, %b_tile : vector<1x1x8x16xf32>, !xetile.tile<1x1x8x16xf32>
+  }
+  return
+}
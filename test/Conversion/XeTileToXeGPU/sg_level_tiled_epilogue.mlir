@@ -0,0 +1,59 @@
+// RUN: imex-opt --split-input-file --convert-xetile-to-xegpu --remove-dead-values %s -verify-diagnostics -o -| FileCheck %s
+
+// bias add, ReLU and bf16 downcast of a blocked tile_mma result are lowered
+// per 8x16 block between the dpas and the store.
+// CHECK-LABEL: func @sglevel_tiled_epilogue
+func.func @sglevel_tiled_epilogue(%a: memref<1024x1024xf16>, %b: memref<1024x1024xf16>, %bias: memref<1024x1024xf32>, %c: memref<1024x1024xbf16>) {
+    %a_tile = xetile.init_tile %a[0, 0] : memref<1024x1024xf16> -> !xetile.tile<1x1x8x16xf16>
+    %b_tile = xetile.init_tile %b[0, 0] : memref<1024x1024xf16> -> !xetile.tile<1x2x16x16xf16>
+    %bias_tile = xetile.init_tile %bias[0, 0] : memref<1024x1024xf32> -> !xetile.tile<1x2x8x16xf32>
+    %c_tile = xetile.init_tile %c[0, 0] : memref<1024x1024xbf16> -> !xetile.tile<1x2x8x16xbf16>
+    %a_value = xetile.load_tile %a_tile : !xetile.tile<1x1x8x16xf16> -> vector<1x1x8x16xf16>
+    %b_value = xetile.load_tile %b_tile : !xetile.tile<1x2x16x16xf16> -> vector<1x2x16x16xf16>
+    %bias_value = xetile.load_tile %bias_tile : !xetile.tile<1x2x8x16xf32> -> vector<1x2x8x16xf32>
+    %zero = arith.constant dense<0.0> : vector<1x2x8x16xf32>
+
+    //CHECK:      %[[D0:.*]] = xegpu.dpas {{.*}} -> vector<8x16xf32>
+    //CHECK-NEXT: %[[D1:.*]] = xegpu.dpas {{.*}} -> vector<8x16xf32>
+    %mma = xetile.tile_mma %a_value, %b_value : vector<1x1x8x16xf16>, vector<1x2x16x16xf16> -> vector<1x2x8x16xf32>
+
+    //CHECK-NEXT: %[[A0:.*]] = arith.addf %[[D0]], %{{.*}} : vector<8x16xf32>
+    //CHECK-NEXT: %[[A1:.*]] = arith.addf %[[D1]], %{{.*}} : vector<8x16xf32>
+    %biased = arith.addf %mma, %bias_value : vector<1x2x8x16xf32>
+
+    //CHECK-NEXT: %[[R0:.*]] = arith.maximumf %[[A0]], %{{.*}} : vector<8x16xf32>
+    //CHECK-NEXT: %[[R1:.*]] = arith.maximumf %[[A1]], %{{.*}} : vector<8x16xf32>
+    %relu = arith.maximumf %biased, %zero : vector<1x2x8x16xf32>
+
+    //CHECK:      arith.bitcast %[[R0]] : vector<8x16xf32> to vector<8x16xi32>
+    //CHECK:      %[[T0:.*]] = arith.trunci {{.*}} : vector<8x16xi32> to vector<8x16xi16>
+    //CHECK-NEXT: %[[B0:.*]] = arith.bitcast %[[T0]] : vector<8x16xi16> to vector<8x16xbf16>
+    //CHECK:      arith.bitcast %[[R1]] : vector<8x16xf32> to vector<8x16xi32>
+    //CHECK:      %[[T1:.*]] = arith.trunci {{.*}} : vector<8x16xi32> to vector<8x16xi16>
+    //CHECK-NEXT: %[[B1:.*]] = arith.bitcast %[[T1]] : vector<8x16xi16> to vector<8x16xbf16>
+    %result = arith.truncf %relu : vector<1x2x8x16xf32> to vector<1x2x8x16xbf16>
+
+    //CHECK-NEXT: xegpu.store_nd %[[B0]], {{.*}} : vector<8x16xbf16>, !xegpu.tensor_desc<8x16xbf16>
+    //CHECK-NEXT: xegpu.store_nd %[[B1]], {{.*}} : vector<8x16xbf16>, !xegpu.tensor_desc<8x16xbf16>
+    xetile.store_tile %result, %c_tile : vector<1x2x8x16xbf16>, !xetile.tile<1x2x8x16xbf16>
+    return
+}
+
+// -----
+// CHECK-LABEL: func @sglevel_tiled_epilogue_f16
+func.func @sglevel_tiled_epilogue_f16(%a: memref<1024x1024xf16>, %b: memref<1024x1024xf16>, %c: memref<1024x1024xf16>) {
+    %a_tile = xetile.init_tile %a[0, 0] : memref<1024x1024xf16> -> !xetile.tile<1x1x8x16xf16>
+    %b_tile = xetile.init_tile %b[0, 0] : memref<1024x1024xf16> -> !xetile.tile<1x1x16x16xf16>
+    %c_tile = xetile.init_tile %c[0, 0] : memref<1024x1024xf16> -> !xetile.tile<1x1x8x16xf16>
+    %a_value = xetile.load_tile %a_tile : !xetile.tile<1x1x8x16xf16> -> vector<1x1x8x16xf16>
+    %b_value = xetile.load_tile %b_tile : !xetile.tile<1x1x16x16xf16> -> vector<1x1x16x16xf16>
+    //CHECK:      %[[D:.*]] = xegpu.dpas {{.*}} -> vector<8x16xf32>
+    %mma = xetile.tile_mma %a_value, %b_value : vector<1x1x8x16xf16>, vector<1x1x16x16xf16> -> vector<1x1x8x16xf32>
+    //CHECK-NEXT: %[[E:.*]] = math.tanh %[[D]] : vector<8x16xf32>
+    %act = math.tanh %mma : vector<1x1x8x16xf32>
+    //CHECK-NEXT: %[[T:.*]] = arith.truncf %[[E]] : vector<8x16xf32> to vector<8x16xf16>
+    %result = arith.truncf %act : vector<1x1x8x16xf32> to vector<1x1x8x16xf16>
+    //CHECK-NEXT: xegpu.store_nd %[[T]], {{.*}} : vector<8x16xf16>, !xegpu.tensor_desc<8x16xf16>
+    xetile.store_tile %result, %c_tile : vector<1x1x8x16xf16>, !xetile.tile<1x1x8x16xf16>
+    return
+}
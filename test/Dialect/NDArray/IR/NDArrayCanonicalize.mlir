@@ -195,3 +195,57 @@ func.func @test_linspace() -> !ndarray.ndarray<?xi64> {
 // CHECK-SAME: !ndarray.ndarray<4xi64>
 // CHECK-NEXT: ndarray.cast
 // CHECK-SAME: !ndarray.ndarray<?xi64>
+
+func.func @test_cast_elemtype_roundtrip(%arg0: !ndarray.ndarray<16xf16>) -> !ndarray.ndarray<16xf16> {
+    %0 = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xf16> to !ndarray.ndarray<16xf32>
+    %1 = ndarray.cast_elemtype %0 : !ndarray.ndarray<16xf32> to !ndarray.ndarray<16xf16>
+    return %1 : !ndarray.ndarray<16xf16>
+}
+// CHECK-LABEL: @test_cast_elemtype_roundtrip
+// CHECK-NEXT: return %arg0 : !ndarray.ndarray<16xf16>
+
+func.func @test_cast_elemtype_chain(%arg0: !ndarray.ndarray<16xi32>) -> !ndarray.ndarray<16xf64> {
+    %0 = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xi32> to !ndarray.ndarray<16xi64>
+    %1 = ndarray.cast_elemtype %0 : !ndarray.ndarray<16xi64> to !ndarray.ndarray<16xf64>
+    return %1 : !ndarray.ndarray<16xf64>
+}
+// CHECK-LABEL: @test_cast_elemtype_chain
+// CHECK-NEXT: [[V0:%.*]] = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xi32> to !ndarray.ndarray<16xf64>
+// CHECK-NEXT: return [[V0]] : !ndarray.ndarray<16xf64>
+
+func.func @test_cast_elemtype_lossy(%arg0: !ndarray.ndarray<16xf32>) -> !ndarray.ndarray<16xf32> {
+    %0 = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xf32> to !ndarray.ndarray<16xf16>
+    %1 = ndarray.cast_elemtype %0 : !ndarray.ndarray<16xf16> to !ndarray.ndarray<16xf32>
+    return %1 : !ndarray.ndarray<16xf32>
+}
+// CHECK-LABEL: @test_cast_elemtype_lossy
+// CHECK-NEXT: ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xf32> to !ndarray.ndarray<16xf16>
+// CHECK-NEXT: ndarray.cast_elemtype
+
+func.func @test_cast_elemtype_chain_bf16(%arg0: !ndarray.ndarray<16xf16>) -> !ndarray.ndarray<16xbf16> {
+    %0 = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xf16> to !ndarray.ndarray<16xf32>
+    %1 = ndarray.cast_elemtype %0 : !ndarray.ndarray<16xf32> to !ndarray.ndarray<16xbf16>
+    return %1 : !ndarray.ndarray<16xbf16>
+}
+// CHECK-LABEL: @test_cast_elemtype_chain_bf16
+// CHECK-NEXT: [[V0:%.*]] = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xf16> to !ndarray.ndarray<16xf32>
+// CHECK-NEXT: [[V1:%.*]] = ndarray.cast_elemtype [[V0]] : !ndarray.ndarray<16xf32> to !ndarray.ndarray<16xbf16>
+// CHECK-NEXT: return [[V1]] : !ndarray.ndarray<16xbf16>
+
+func.func @test_ewbin_cast_elemtype(%arg0: !ndarray.ndarray<16xf16>, %arg1: !ndarray.ndarray<16xf32>) -> !ndarray.ndarray<16xf32> {
+    %0 = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xf16> to !ndarray.ndarray<16xf32>
+    %1 = ndarray.ewbin %0, %arg1 {op = 0 : i32} : (!ndarray.ndarray<16xf32>, !ndarray.ndarray<16xf32>) -> !ndarray.ndarray<16xf32>
+    return %1 : !ndarray.ndarray<16xf32>
+}
+// CHECK-LABEL: @test_ewbin_cast_elemtype
+// CHECK-NEXT: [[V0:%.*]] = ndarray.ewbin %arg0, %arg1 {op = 0 : i32} : (!ndarray.ndarray<16xf16>, !ndarray.ndarray<16xf32>) -> !ndarray.ndarray<16xf32>
+// CHECK-NEXT: return [[V0]] : !ndarray.ndarray<16xf32>
+
+func.func @test_ewbin_cast_elemtype_tosa(%arg0: !ndarray.ndarray<16xi32>, %arg1: !ndarray.ndarray<16xi64>) -> !ndarray.ndarray<16xi64> {
+    %0 = ndarray.cast_elemtype %arg0 : !ndarray.ndarray<16xi32> to !ndarray.ndarray<16xi64>
+    %1 = ndarray.ewbin %0, %arg1 {op = 2 : i32} : (!ndarray.ndarray<16xi64>, !ndarray.ndarray<16xi64>) -> !ndarray.ndarray<16xi64>
+    return %1 : !ndarray.ndarray<16xi64>
+}
+// CHECK-LABEL: @test_ewbin_cast_elemtype_tosa
+// CHECK-NEXT: ndarray.cast_elemtype
+// CHECK-NEXT: ndarray.ewbin
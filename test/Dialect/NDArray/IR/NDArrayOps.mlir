@@ -157,6 +157,16 @@ func.func @test_reduction(%arg0: !ndarray.ndarray<?xi64>) -> si64 {
 // CHECK-LABEL: @test_reduction
 // CHECK-NEXT: ndarray.reduction %arg0 {op = 4 : i32} : !ndarray.ndarray<?xi64> -> !ndarray.ndarray<si64>
 
+// -----
+func.func @test_matmul(%arg0: !ndarray.ndarray<?x?xf32>, %arg1: !ndarray.ndarray<3x?x4xf32>) -> (!ndarray.ndarray<?x?xf32>, !ndarray.ndarray<3x?x?xf32>) {
+    %0 = ndarray.matmul %arg0, %arg0 : (!ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>) -> !ndarray.ndarray<?x?xf32>
+    %1 = ndarray.matmul %arg1, %arg1 {transpose_rhs} : (!ndarray.ndarray<3x?x4xf32>, !ndarray.ndarray<3x?x4xf32>) -> !ndarray.ndarray<3x?x?xf32>
+    return %0, %1 : !ndarray.ndarray<?x?xf32>, !ndarray.ndarray<3x?x?xf32>
+}
+// CHECK-LABEL: @test_matmul
+// CHECK-NEXT: ndarray.matmul %arg0, %arg0 : (!ndarray.ndarray<?x?xf32>, !ndarray.ndarray<?x?xf32>) -> !ndarray.ndarray<?x?xf32>
+// CHECK-NEXT: ndarray.matmul %arg1, %arg1 {transpose_rhs} : (!ndarray.ndarray<3x?x4xf32>, !ndarray.ndarray<3x?x4xf32>) -> !ndarray.ndarray<3x?x?xf32>
+
 // -----
 func.func @test_dim(%arg0: !ndarray.ndarray<?xi64>) -> index {
     %c0 = arith.constant 0 : index
@@ -0,0 +1,133 @@
+// RUN: imex-opt %s -allow-unregistered-dialect --region-coalesce=report=true --split-input-file --verify-diagnostics | FileCheck %s
+
+// A host ndarray op between two gpu regions reading and producing arrays is
+// placed on the gpu, its result gets the gpu environment and the regions get
+// merged.
+
+// expected-remark @+1 {{env_region transfers before 3, after 1}}
+func.func @test_place() -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> {
+  %0 = region.env_region #region.gpu_env<device = "XeGPU"> -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> {
+    %3 = "test.create"() : () -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+    region.env_region_yield %3 : !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+  }
+  %1 = ndarray.ewuny %0 {op = 30 : i32} : !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> -> !ndarray.ndarray<16xf64>
+  %2 = region.env_region #region.gpu_env<device = "XeGPU"> -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> {
+    %3 = ndarray.ewbin %1, %0 {op = 0 : i32} : (!ndarray.ndarray<16xf64>, !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>) -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+    region.env_region_yield %3 : !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+  }
+  return %2 : !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+}
+// CHECK-LABEL: func.func @test_place
+// CHECK-NEXT: %[[R:.*]] = region.env_region #region.gpu_env<device = "XeGPU"> -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> {
+// CHECK-NEXT: %[[C:.*]] = "test.create"()
+// CHECK-NEXT: %[[N:.*]] = ndarray.ewuny %[[C]] {op = 30 : i32} : !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+// CHECK-NEXT: %[[E:.*]] = ndarray.ewbin %[[N]], %[[C]]
+// CHECK-NEXT: region.env_region_yield %[[E]]
+// CHECK-NEXT: }
+// CHECK-NEXT: return %[[R]]
+
+// -----
+
+// Moving the host op would not save a transfer, it stays on the host.
+
+// expected-remark @+1 {{env_region transfers before 1, after 1}}
+func.func @test_keep() -> !ndarray.ndarray<16xf64> {
+  %0 = region.env_region #region.gpu_env<device = "XeGPU"> -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> {
+    %3 = "test.create"() : () -> !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+    region.env_region_yield %3 : !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">>
+  }
+  %1 = ndarray.ewuny %0 {op = 30 : i32} : !ndarray.ndarray<16xf64, #region.gpu_env<device = "XeGPU">> -> !ndarray.ndarray<16xf64>
+  %2 = ndarray.ewbin %1, %1 {op = 0 : i32} : (!ndarray.ndarray<16xf64>, !ndarray.ndarray<16xf64>) -> !ndarray.ndarray<16xf64>
+  return %2 : !ndarray.ndarray<16xf64>
+}
+// CHECK-LABEL: func.func @test_keep
+// CHECK: region.env_region_yield
+// CHECK-NEXT: }
+// CHECK-NEXT: ndarray.ewuny
+// CHECK-NEXT: ndarray.ewbin
+// CHECK-NEXT: return
+
+// -----
+
+// Only ops add-gpu-regions handles are placed, other host ops stay even if
+// moving them would save transfers.
+
+// expected-remark @+1 {{env_region transfers before 3, after 3}}
+func.func @test_unhandled() -> tensor<16xf64> {
+  %0 = region.env_region #region.gpu_env<device = "XeGPU"> -> tensor<16xf64> {
+    %3 = "test.create"() : () -> tensor<16xf64>
+    region.env_region_yield %3 : tensor<16xf64>
+  }
+  %1 = "test.neg"(%0) : (tensor<16xf64>) -> tensor<16xf64>
+  %2 = region.env_region #region.gpu_env<device = "XeGPU"> -> tensor<16xf64> {
+    %3 = "test.ewbin"(%1, %0) : (tensor<16xf64>, tensor<16xf64>) -> tensor<16xf64>
+    region.env_region_yield %3 : tensor<16xf64>
+  }
+  return %2 : tensor<16xf64>
+}
+// CHECK-LABEL: func.func @test_unhandled
+// CHECK: region.env_region_yield
+// CHECK-NEXT: }
+// CHECK-NEXT: "test.neg"
+// CHECK-NEXT: region.env_region
+// CHECK-NEXT: "test.ewbin"
+
+// -----
+
+// Cheap scalar ops between compatible regions are moved into the first one,
+// a scalar result used on the host is yielded.
+
+// expected-remark @+1 {{env_region transfers before 1, after 1}}
+func.func @test_cheap(%arg0: index) -> (index, tensor<16xf64>) {
+  %0 = region.env_region #region.gpu_env<device = "XeGPU"> -> tensor<16xf64> {
+    %4 = "test.create"() : () -> tensor<16xf64>
+    region.env_region_yield %4 : tensor<16xf64>
+  }
+  %c1 = arith.constant 1 : index
+  %1 = arith.addi %arg0, %c1 : index
+  %2 = region.env_region #region.gpu_env<device = "XeGPU"> -> tensor<16xf64> {
+    %4 = "test.ewbin"(%0, %1) : (tensor<16xf64>, index) -> tensor<16xf64>
+    region.env_region_yield %4 : tensor<16xf64>
+  }
+  return %1, %2 : index, tensor<16xf64>
+}
+// CHECK-LABEL: func.func @test_cheap
+// CHECK-NEXT: %[[R:.*]]:2 = region.env_region #region.gpu_env<device = "XeGPU"> -> {{.*}}index, tensor<16xf64>
+// CHECK-NEXT: %[[C:.*]] = "test.create"()
+// CHECK-NEXT: %[[C1:.*]] = arith.constant 1 : index
+// CHECK-NEXT: %[[A:.*]] = arith.addi %arg0, %[[C1]]
+// CHECK-NEXT: %[[E:.*]] = "test.ewbin"(%[[C]], %[[A]])
+// CHECK-NEXT: region.env_region_yield %[[A]], %[[E]] : index, tensor<16xf64>
+// CHECK-NEXT: }
+// CHECK-NEXT: return %[[R]]#0, %[[R]]#1
+
+// -----
+
+// Ops with side effects and regions of other environments are not crossed.
+
+// expected-remark @+1 {{env_region transfers before 0, after 0}}
+func.func @test_barrier() {
+  region.env_region #region.gpu_env<device = "XeGPU"> {
+    "test.op1"() : () -> ()
+  }
+  "test.effect"() : () -> ()
+  region.env_region #region.gpu_env<device = "XeGPU"> {
+    "test.op2"() : () -> ()
+  }
+  region.env_region #region.gpu_env<device = "other"> {
+    "test.op3"() : () -> ()
+  }
+  return
+}
+// CHECK-LABEL: func.func @test_barrier
+// CHECK-NEXT: region.env_region
+// CHECK-NEXT: "test.op1"
+// CHECK-NEXT: }
+// CHECK-NEXT: "test.effect"
+// CHECK-NEXT: region.env_region #region.gpu_env<device = "XeGPU">
+// CHECK-NEXT: "test.op2"
+// CHECK-NEXT: }
+// CHECK-NEXT: region.env_region #region.gpu_env<device = "other">
+// CHECK-NEXT: "test.op3"
+// CHECK-NEXT: }
+// CHECK-NEXT: return
@@ -0,0 +1,115 @@
+// RUN: imex-opt --split-input-file --xegpu-perf-model %s -o /dev/null | FileCheck %s
+
+// CHECK: "device": "pvc"
+// CHECK: "name": "test_gemm_vc_bf16"
+// CHECK-NEXT: "subgroups": 1
+// CHECK-NEXT: "dynamic_trip_counts": false
+// CHECK-NEXT: "dpas": {
+// CHECK-NEXT: "count": 524288
+// CHECK-NEXT: "flops": 2147483648
+// CHECK-NEXT: "utilization": 1
+// CHECK: "load_2d": {
+// CHECK-NEXT: "count": 1048576
+// CHECK-NEXT: "bytes": 402653184
+// CHECK: "store_2d": {
+// CHECK-NEXT: "count": 8192
+// CHECK-NEXT: "bytes": 4194304
+// CHECK: "prefetch_2d": {
+// CHECK-NEXT: "count": 0
+// CHECK: "barriers": 0
+// CHECK: "bound": "compute"
+func.func @test_gemm_vc_bf16(%a : memref<1024x1024xbf16>, %b: memref<1024x1024xbf16>, %c: memref<1024x1024xf32>) {
+  %c0 = arith.constant 0 : index
+  %c8 = arith.constant 8 : index
+  %c16 = arith.constant 16 : index
+  %c1024 = arith.constant 1024 : index
+  scf.for %i= %c0 to %c1024 step %c8 {
+    scf.for %j= %c0 to %c1024 step %c16 {
+      %1 = xegpu.create_nd_tdesc %a[%i, %c0] {mode = vc} : memref<1024x1024xbf16> -> !xegpu.tensor_desc<8x16xbf16>
+      %2 = xegpu.create_nd_tdesc %b[%c0, %j] {mode = vc} : memref<1024x1024xbf16> -> !xegpu.tensor_desc<16x16xbf16>
+      %3 = arith.constant dense<0.0> : vector<8x16xf32>
+      %tmp0, %tmp1, %result = scf.for %k= %c0 to %c1024 step %c16
+                                iter_args(%subA = %1, %subB = %2, %subC = %3)
+                                  -> (!xegpu.tensor_desc<8x16xbf16>, !xegpu.tensor_desc<16x16xbf16>, vector<8x16xf32>) {
+        %4 = xegpu.load_nd %subA {mode = vc, vnni_axis = 1} : !xegpu.tensor_desc<8x16xbf16> -> vector<8x8x2xbf16>
+        %5 = xegpu.load_nd %subB {mode = vc, vnni_axis = 0} : !xegpu.tensor_desc<16x16xbf16> -> vector<8x16x2xbf16>
+        %6 = xegpu.dpas %4, %5, %subC {mode = vc} : vector<8x8x2xbf16>, vector<8x16x2xbf16>, vector<8x16xf32> -> vector<8x16xf32>
+        %7 = xegpu.update_nd_offset %subA, [%c0, %c16] {mode = vc} : !xegpu.tensor_desc<8x16xbf16> -> !xegpu.tensor_desc<8x16xbf16>
+        %8 = xegpu.update_nd_offset %subB, [%c16, %c0] {mode = vc} : !xegpu.tensor_desc<16x16xbf16> -> !xegpu.tensor_desc<16x16xbf16>
+        scf.yield %7, %8, %6: !xegpu.tensor_desc<8x16xbf16>, !xegpu.tensor_desc<16x16xbf16>, vector<8x16xf32>
+      }
+      %9 = xegpu.create_nd_tdesc %c[%i, %j] {mode = vc} : memref<1024x1024xf32> -> !xegpu.tensor_desc<8x16xf32>
+      xegpu.store_nd %result, %9 {mode = vc}: vector<8x16xf32>, !xegpu.tensor_desc<8x16xf32>
+    }
+  }
+  return
+}
+
+// -----
+
+// CHECK: "name": "test_kernel::test_kernel"
+// CHECK-NEXT: "subgroups": 8
+// CHECK-NEXT: "dynamic_trip_counts": false
+// CHECK-NEXT: "dpas": {
+// CHECK-NEXT: "count": 0
+// CHECK: "gather": {
+// CHECK-NEXT: "count": 32
+// CHECK-NEXT: "bytes": 2048
+// CHECK: "barriers": 32
+// CHECK: "bound": "compute"
+module attributes {gpu.container_module} {
+  func.func @test(%src: ui64) {
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    %c4 = arith.constant 4 : index
+    gpu.launch_func @test_kernel::@test_kernel blocks in (%c4, %c2, %c1) threads in (%c1, %c1, %c1) args(%src : ui64)
+    return
+  }
+  gpu.module @test_kernel {
+    gpu.func @test_kernel(%src: ui64) kernel {
+      %c0 = arith.constant 0 : index
+      %c1 = arith.constant 1 : index
+      %c4 = arith.constant 4 : index
+      %offsets = arith.constant dense<0> : vector<16xindex>
+      %mask = arith.constant dense<1> : vector<16xi1>
+      %1 = xegpu.create_tdesc %src, %offsets {mode = vc} : ui64, vector<16xindex> -> !xegpu.tensor_desc<16xf32, #xegpu.scattered>
+      scf.for %i = %c0 to %c4 step %c1 {
+        %2 = xegpu.load %1, %mask {mode = vc} : !xegpu.tensor_desc<16xf32, #xegpu.scattered>, vector<16xi1> -> vector<16xf32>
+        gpu.barrier
+      }
+      gpu.return
+    }
+  }
+}
+
+// -----
+
+// CHECK: "name": "test_dynamic_loop"
+// CHECK-NEXT: "subgroups": 1
+// CHECK-NEXT: "dynamic_trip_counts": true
+// CHECK: "load_2d": {
+// CHECK-NEXT: "count": 1
+// CHECK-NEXT: "bytes": 512
+// CHECK: "bound": "{{compute|memory}}"
+func.func @test_dynamic_loop(%a : memref<1024x1024xf32>, %n : index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %1 = xegpu.create_nd_tdesc %a[%c0, %c0] {mode = vc} : memref<1024x1024xf32> -> !xegpu.tensor_desc<8x16xf32>
+  scf.for %i = %c0 to %n step %c1 {
+    %2 = xegpu.load_nd %1 {mode = vc} : !xegpu.tensor_desc<8x16xf32> -> vector<8x16xf32>
+  }
+  return
+}
+
+// -----
+
+// A kernel with only a barrier and no XeGPU ops is not reported.
+// CHECK-NOT: "name": "barrier_only::barrier_only"
+module attributes {gpu.container_module} {
+  gpu.module @barrier_only {
+    gpu.func @barrier_only() kernel {
+      gpu.barrier
+      gpu.return
+    }
+  }
+}
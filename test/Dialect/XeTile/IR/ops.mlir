@@ -160,6 +160,12 @@ func.func @test_load_tile(%src: !xetile.tile<64x32xf16>, %src1 : !xetile.tile<12
   %8 = xetile.load_tile %src3 : !xetile.tile<64x32xf16, #tile_attr_w_order>
     -> vector<64x32xf16>
 
+  // CHECK: xetile.load_tile
+  // CHECK-SAME: { padding = 0.000000e+00 : f32, cache_hint = #xetile.cache_hint<streaming> }
+  // CHECK-SAME: !xetile.tile<64x32xf16> -> vector<64x32xf16>
+  %9 = xetile.load_tile %src { cache_hint = #xetile.cache_hint<streaming> }
+    : !xetile.tile<64x32xf16> -> vector<64x32xf16>
+
   return
 }
 
@@ -187,6 +193,10 @@ func.func @test_store_tile(%value1 : vector<64x32xf16>,
   // CHECK-SAME: vector<64x32xf16>, !xetile.tile<64x32xf16, #xetile.tile_attr<order = [0, 1]>>
   xetile.store_tile %value1, %dst3 : vector<64x32xf16>, !xetile.tile<64x32xf16, #tile_attr_w_order>
 
+  // CHECK: xetile.store_tile
+  // CHECK-SAME: {cache_hint = #xetile.cache_hint<uncached>} : vector<64x32xf16>, !xetile.tile<64x32xf16>
+  xetile.store_tile %value1, %dst {cache_hint = #xetile.cache_hint<uncached>} : vector<64x32xf16>, !xetile.tile<64x32xf16>
+
   return
 }
 
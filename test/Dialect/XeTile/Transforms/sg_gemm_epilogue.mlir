@@ -0,0 +1,48 @@
+// RUN: imex-opt --xetile-tiling %s | FileCheck %s
+
+// The elementwise epilogue on the tile_mma result is blocked in the same
+// layout as the result so it can be fused before the store.
+// CHECK-LABEL: func @test_gemm_epilogue({{.*}}) {
+func.func @test_gemm_epilogue(%A: memref<1024x1024xf16>, %B: memref<1024x1024xf16>, %Bias: memref<1024x1024xf32>, %C: memref<1024x1024xbf16>) {
+  %c0 = arith.constant 0 : index
+  %c32 = arith.constant 32 : index
+  %c1024 = arith.constant 1024 : index
+  %block_id_x = gpu.block_id x
+  %block_id_y = gpu.block_id y
+  %m = arith.muli %block_id_x, %c32 : index
+  %n = arith.muli %block_id_y, %c32 : index
+  // CHECK: arith.constant dense<0.000000e+00> : vector<4x2x8x16xf32>
+  %cst = arith.constant dense<0.0> : vector<32x32xf32>
+  %a_init_tile = xetile.init_tile %A[%m, %c0] : memref<1024x1024xf16> -> !xetile.tile<32x32xf16>
+  %b_init_tile = xetile.init_tile %B[%c0, %n] : memref<1024x1024xf16> -> !xetile.tile<32x32xf16>
+  %out:3 = scf.for %k = %c0 to %c1024 step %c32
+    iter_args(%a_tile = %a_init_tile, %b_tile = %b_init_tile, %c_value = %cst)
+    -> (!xetile.tile<32x32xf16>, !xetile.tile<32x32xf16>, vector<32x32xf32>) {
+    %a_value = xetile.load_tile %a_tile : !xetile.tile<32x32xf16> -> vector<32x32xf16>
+    %b_value = xetile.load_tile %b_tile : !xetile.tile<32x32xf16> -> vector<32x32xf16>
+    %c_new_value = xetile.tile_mma %a_value, %b_value, %c_value
+      : vector<32x32xf16>, vector<32x32xf16>, vector<32x32xf32> -> vector<32x32xf32>
+    %a_next_tile = xetile.update_tile_offset %a_tile, [%c0, %c32]
+      : !xetile.tile<32x32xf16>, index, index -> !xetile.tile<32x32xf16>
+    %b_next_tile = xetile.update_tile_offset %b_tile, [%c32, %c0]
+      : !xetile.tile<32x32xf16>, index, index -> !xetile.tile<32x32xf16>
+    scf.yield %a_next_tile, %b_next_tile, %c_new_value
+      : !xetile.tile<32x32xf16>, !xetile.tile<32x32xf16>, vector<32x32xf32>
+  }
+  // CHECK: xetile.load_tile
+  // CHECK-SAME: !xetile.tile<4x2x8x16xf32> -> vector<4x2x8x16xf32>
+  %bias_tile = xetile.init_tile %Bias[%m, %n] : memref<1024x1024xf32> -> !xetile.tile<32x32xf32>
+  %bias = xetile.load_tile %bias_tile : !xetile.tile<32x32xf32> -> vector<32x32xf32>
+  // CHECK: arith.addf {{.*}} : vector<4x2x8x16xf32>
+  %biased = arith.addf %out#2, %bias : vector<32x32xf32>
+  // CHECK: arith.maximumf {{.*}} : vector<4x2x8x16xf32>
+  %zero = arith.constant dense<0.0> : vector<32x32xf32>
+  %relu = arith.maximumf %biased, %zero : vector<32x32xf32>
+  // CHECK: arith.truncf {{.*}} : vector<4x2x8x16xf32> to vector<4x2x8x16xbf16>
+  %result = arith.truncf %relu : vector<32x32xf32> to vector<32x32xbf16>
+  // CHECK: xetile.store_tile
+  // CHECK-SAME: vector<4x2x8x16xbf16>, !xetile.tile<4x2x8x16xbf16>
+  %c_tile = xetile.init_tile %C[%m, %n] : memref<1024x1024xbf16> -> !xetile.tile<32x32xbf16>
+  xetile.store_tile %result, %c_tile : vector<32x32xbf16>, !xetile.tile<32x32xbf16>
+  return
+}
@@ -1,4 +1,5 @@
 builtin.module(
+    canonicalize
     convert-ndarray-to-linalg
     func.func(
         tosa-to-linalg
@@ -0,0 +1,101 @@
+// RUN: %python_executable %imex_runner -i %s --pass-pipeline-file=%p/xegpu-to-cpu.pp \
+// RUN:                                       --runner imex-cpu-runner -e main \
+// RUN:                                       --entry-point-result=void \
+// RUN:                                       --shared-libs=%irunner_utils,%mlir_runner_utils,%mlir_c_runner_utils --filecheck
+// RUN: %python_executable %imex_runner -i %s --pass-pipeline-file=%p/xegpu-to-cpu-profile.pp \
+// RUN:                                       --runner imex-cpu-runner -e main \
+// RUN:                                       --entry-point-result=void \
+// RUN:                                       --shared-libs=%irunner_utils,%mlir_runner_utils,%mlir_c_runner_utils --filecheck --check-prefix=PROFILE
+module @gemm attributes {gpu.container_module} {
+  memref.global "private" @__constant_16x16xf16 : memref<16x16xf16> = dense<1.0>
+  memref.global "private" @__constant_16x16xf16_0 : memref<16x16xf16> = dense<1.0>
+  memref.global "private" @__constant_16x16xf32 : memref<16x16xf32> = dense<0.0>
+
+  func.func @test(%arg0: memref<16x16xf16>, %arg1: memref<16x16xf16>) -> memref<16x16xf32> attributes {llvm.emit_c_interface} {
+    %c1 = arith.constant 1 : index
+    %c2 = arith.constant 2 : index
+    %memref = gpu.alloc  host_shared () : memref<16x16xf16>
+    memref.copy %arg0, %memref : memref<16x16xf16> to memref<16x16xf16>
+    %memref_0 = gpu.alloc  host_shared () : memref<16x16xf16>
+    memref.copy %arg1, %memref_0 : memref<16x16xf16> to memref<16x16xf16>
+    %memref_1 = gpu.alloc  host_shared () : memref<16x16xf32>
+    gpu.launch_func  @test_kernel::@test_kernel blocks in (%c2, %c1, %c1) threads in (%c1, %c1, %c1) args(%memref : memref<16x16xf16>, %memref_0 : memref<16x16xf16>, %memref_1 : memref<16x16xf32>)
+    gpu.dealloc  %memref : memref<16x16xf16>
+    gpu.dealloc  %memref_0 : memref<16x16xf16>
+    return %memref_1 : memref<16x16xf32>
+  }
+
+  gpu.module @test_kernel attributes {spirv.target_env = #spirv.target_env<#spirv.vce<v1.4, [Addresses, Float16Buffer, Int64, Int16, Int8, Kernel, Linkage, Vector16, GenericPointer, Groups, Float16, Float64, AtomicFloat32AddEXT, ExpectAssumeKHR, SubgroupDispatch, VectorComputeINTEL, VectorAnyINTEL], [SPV_EXT_shader_atomic_float_add, SPV_KHR_expect_assume, SPV_INTEL_vector_compute]>, api=OpenCL, #spirv.resource_limits<>>} {
+    gpu.func @test_kernel(%arg0: memref<16x16xf16>, %arg1: memref<16x16xf16>, %arg2: memref<16x16xf32>) kernel attributes {VectorComputeFunctionINTEL, spirv.entry_point_abi = #spirv.entry_point_abi<>} {
+      // Each work-group computes its own 8x16 tile of C from a zero
+      // accumulator, so C is never read.
+      %c0 = arith.constant 0 : index
+      %c8 = arith.constant 8 : index
+      %bid = gpu.block_id x
+      %row = arith.muli %bid, %c8 : index
+      %0 = xegpu.create_nd_tdesc %arg0[0, 0] {mode = vc}
+      : memref<16x16xf16> -> !xegpu.tensor_desc<8x16xf16>
+      %1 = xegpu.update_nd_offset %0, [%row, %c0] {mode = vc} : !xegpu.tensor_desc<8x16xf16> -> !xegpu.tensor_desc<8x16xf16>
+      %2 = xegpu.create_nd_tdesc %arg1[0, 0] {mode = vc}
+      : memref<16x16xf16> -> !xegpu.tensor_desc<16x16xf16>
+      %3 = xegpu.create_nd_tdesc %arg2[0, 0] {mode = vc}
+      : memref<16x16xf32> -> !xegpu.tensor_desc<8x16xf32>
+      %4 = xegpu.update_nd_offset %3, [%row, %c0] {mode = vc} : !xegpu.tensor_desc<8x16xf32> -> !xegpu.tensor_desc<8x16xf32>
+      %5 = xegpu.load_nd %1 {mode = vc, vnni_axis = 1} : !xegpu.tensor_desc<8x16xf16> -> vector<8x8x2xf16>
+      %6 = xegpu.load_nd %2  {mode = vc, vnni_axis = 0} : !xegpu.tensor_desc<16x16xf16> -> vector<8x16x2xf16>
+      %zero = arith.constant dense<0.0> : vector<8x16xf32>
+      %7 = xegpu.dpas %5, %6, %zero : vector<8x8x2xf16>, vector<8x16x2xf16>, vector<8x16xf32> -> vector<8x16xf32>
+      xegpu.store_nd %7, %4 {mode = vc} : vector<8x16xf32>, !xegpu.tensor_desc<8x16xf32>
+      gpu.return
+    }
+  }
+  func.func @main() attributes {llvm.emit_c_interface} {
+    %0 = memref.get_global @__constant_16x16xf16 : memref<16x16xf16>
+    %1 = memref.get_global @__constant_16x16xf16_0 : memref<16x16xf16>
+    %ref = memref.get_global @__constant_16x16xf32 : memref<16x16xf32>
+
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %c16 = arith.constant 16 : index
+
+    // A[i, j] = i + j, B[i, j] = i - j, both small enough to be exact in f16.
+    scf.for %arg0 = %c0 to %c16 step %c1 {
+      scf.for %arg1 = %c0 to %c16 step %c1 {
+        %i = arith.index_cast %arg0 : index to i32
+        %j = arith.index_cast %arg1 : index to i32
+        %sum = arith.addi %i, %j : i32
+        %diff = arith.subi %i, %j : i32
+        %a = arith.sitofp %sum : i32 to f16
+        %b = arith.sitofp %diff : i32 to f16
+        memref.store %a, %0[%arg0, %arg1] : memref<16x16xf16>
+        memref.store %b, %1[%arg0, %arg1] : memref<16x16xf16>
+      }
+    }
+    // calculate the result C matrix
+    scf.for %arg0 = %c0 to %c16 step %c1 {
+      scf.for %arg1 = %c0 to %c16 step %c1 {
+        %acc = memref.load %ref[%arg0, %arg1] : memref<16x16xf32>
+        %res = scf.for %arg2 = %c0 to %c16 step %c1 iter_args(%arg3 = %acc) -> f32 {
+          %a = memref.load %0[%arg0, %arg2] : memref<16x16xf16>
+          %b = memref.load %1[%arg2, %arg1] : memref<16x16xf16>
+          %aa = arith.extf %a : f16 to f32
+          %bb = arith.extf %b : f16 to f32
+          %c = arith.mulf %aa, %bb : f32
+          %cc = arith.addf %c, %arg3 : f32
+          scf.yield %cc : f32
+        }
+        memref.store %res, %ref[%arg0, %arg1] : memref<16x16xf32>
+      }
+    }
+
+    %cast_ref = memref.cast %ref : memref<16x16xf32> to memref<*xf32>
+    // PROFILE: xegpu-cpu profile: load_nd 4, store_nd 2, prefetch_nd 0, dpas 2, update_nd_offset 4, load 0, store 0, prefetch 0, atomic_rmw 0, barrier 0
+    %2 = call @test(%0, %1) : (memref<16x16xf16>, memref<16x16xf16>) -> memref<16x16xf32>
+    %cast = memref.cast %2 : memref<16x16xf32> to memref<*xf32>
+    // CHECK:   [ALLCLOSE: TRUE]
+    // PROFILE: [ALLCLOSE: TRUE]
+    call @printAllcloseF32(%cast, %cast_ref) : (memref<*xf32>, memref<*xf32>) -> ()
+    return
+  }
+  func.func private @printAllcloseF32(memref<*xf32>, memref<*xf32>) attributes {llvm.emit_c_interface}
+}
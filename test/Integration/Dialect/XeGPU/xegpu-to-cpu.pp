@@ -0,0 +1,18 @@
+// xegpu dialect to llvm lowering pipeline emulating the kernels on the CPU.
+// Ready for imex-cpu-runner without any GPU runtime.
+builtin.module(
+    convert-xegpu-to-cpu
+    func.func(llvm-request-c-wrappers)
+    convert-vector-to-scf
+    lower-affine
+    convert-scf-to-cf
+    convert-cf-to-llvm
+    convert-vector-to-llvm
+    convert-index-to-llvm
+    convert-arith-to-llvm
+    convert-func-to-llvm
+    convert-math-to-llvm
+    expand-strided-metadata
+    finalize-memref-to-llvm
+    reconcile-unrealized-casts)
+// End
@@ -16,6 +16,8 @@ builtin.module(convert-tensor-to-linalg
           convert-parallel-loops-to-gpu)
 // insert-gpu-allocs pass can have client-api = opencl or vulkan args
     func.func(insert-gpu-allocs{client-api=opencl})
+// gpu-buffer-residency removes the copies between host functions
+    gpu-buffer-residency{closed-module=1}
     canonicalize
     normalize-memrefs
 // Unstride memrefs does not seem to be needed.
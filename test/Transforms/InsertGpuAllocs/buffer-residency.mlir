@@ -0,0 +1,105 @@
+// RUN: imex-opt --pass-pipeline='builtin.module(func.func(insert-gpu-allocs{client-api=opencl}),gpu-buffer-residency)' %s | FileCheck %s
+// RUN: imex-opt --pass-pipeline='builtin.module(func.func(insert-gpu-allocs{client-api=opencl}),gpu-buffer-residency)' --mlir-pass-statistics %s 2>&1 | FileCheck %s --check-prefix=STATS
+// RUN: imex-opt --pass-pipeline='builtin.module(func.func(insert-gpu-allocs{client-api=opencl}),gpu-buffer-residency{closed-module=1})' %s | FileCheck %s --check-prefix=CLOSED
+
+// STATS: GPUBufferResidency
+// STATS: (S) 3 num-copies-removed
+// STATS: (S) 1 num-allocs-promoted
+
+// The buffer updated by @step in every iteration stays in host shared memory,
+// the result of @produce is returned without a host copy.
+
+// CHECK-LABEL: func.func @main
+func.func @main() {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %cst = arith.constant 1.000000e+00 : f32
+  // CHECK: %[[BUF:.*]] = gpu.alloc  host_shared () : memref<8xf32>
+  %0 = memref.alloc() : memref<8xf32>
+  // CHECK: memref.store %{{.*}}, %[[BUF]][%{{.*}}] : memref<8xf32>
+  memref.store %cst, %0[%c0] : memref<8xf32>
+  // CHECK: scf.for
+  // CHECK-NEXT: call @step(%[[BUF]]) : (memref<8xf32>) -> ()
+  scf.for %i = %c0 to %c4 step %c1 {
+    func.call @step(%0) : (memref<8xf32>) -> ()
+  }
+  // CHECK: %[[RES:.*]] = call @produce() : () -> memref<8xf32>
+  %1 = func.call @produce() : () -> memref<8xf32>
+  %2 = memref.load %1[%c0] : memref<8xf32>
+  // CHECK: gpu.dealloc  %[[BUF]] : memref<8xf32>
+  // CHECK: gpu.dealloc  %[[RES]] : memref<8xf32>
+  memref.dealloc %0 : memref<8xf32>
+  memref.dealloc %1 : memref<8xf32>
+  return
+}
+
+// CHECK-LABEL: func.func private @step
+// CHECK-SAME: (%[[ARG:.*]]: memref<8xf32>)
+// CHECK-NOT: gpu.alloc
+// CHECK-NOT: memref.copy
+// CHECK: gpu.launch
+// CHECK: memref.load %[[ARG]]
+// CHECK: memref.store %{{.*}}, %[[ARG]]
+// CHECK-NOT: memref.copy
+// CHECK-NOT: gpu.dealloc
+// CHECK: return
+func.func private @step(%arg0: memref<8xf32>) {
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %cst = arith.constant 2.000000e+00 : f32
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c8, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c1, %sy = %c1, %sz = %c1) {
+    %0 = memref.load %arg0[%bx] : memref<8xf32>
+    %1 = arith.mulf %0, %cst : f32
+    memref.store %1, %arg0[%bx] : memref<8xf32>
+    gpu.terminator
+  }
+  return
+}
+
+// CHECK-LABEL: func.func private @produce
+// CHECK: %[[OUT:.*]] = gpu.alloc  host_shared () : memref<8xf32>
+// CHECK: gpu.launch
+// CHECK-NOT: memref.copy
+// CHECK-NOT: gpu.dealloc
+// CHECK: return %[[OUT]] : memref<8xf32>
+func.func private @produce() -> memref<8xf32> {
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %cst = arith.constant 3.000000e+00 : f32
+  %0 = memref.alloc() : memref<8xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c8, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c1, %sy = %c1, %sz = %c1) {
+    memref.store %cst, %0[%bx] : memref<8xf32>
+    gpu.terminator
+  }
+  return %0 : memref<8xf32>
+}
+
+// Public functions may be called from outside of the module and keep their
+// copies unless the module is closed.
+
+// CHECK-LABEL: func.func @public_step
+// CHECK-SAME: (%[[ARG:.*]]: memref<8xf32>)
+// CHECK: %[[MIRROR:.*]] = gpu.alloc  host_shared () : memref<8xf32>
+// CHECK: memref.copy %[[ARG]], %[[MIRROR]]
+// CHECK: memref.copy %[[MIRROR]], %[[ARG]]
+// CLOSED-LABEL: func.func @public_step
+// CLOSED-NOT: memref.copy
+// CLOSED: return
+func.func @public_step(%arg0: memref<8xf32>) {
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c8, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c1, %sy = %c1, %sz = %c1) {
+    %0 = memref.load %arg0[%bx] : memref<8xf32>
+    memref.store %0, %arg0[%bx] : memref<8xf32>
+    gpu.terminator
+  }
+  return
+}
+
+func.func @call_public() {
+  %0 = gpu.alloc host_shared () : memref<8xf32>
+  func.call @public_step(%0) : (memref<8xf32>) -> ()
+  gpu.dealloc %0 : memref<8xf32>
+  return
+}
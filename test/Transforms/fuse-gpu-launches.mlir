@@ -0,0 +1,229 @@
+// RUN: imex-opt --split-input-file --imex-fuse-gpu-launches %s | FileCheck %s
+
+// CHECK-LABEL: func.func @producer_consumer
+// CHECK-NOT: memref.alloc
+// CHECK: gpu.launch
+// CHECK: %[[V0:.*]] = memref.load %arg0[%{{.*}}, %{{.*}}]
+// CHECK-NEXT: %[[V1:.*]] = math.log %[[V0]] : f32
+// CHECK-NEXT: %[[V2:.*]] = memref.load %arg0[%{{.*}}, %{{.*}}]
+// CHECK-NEXT: %[[V3:.*]] = arith.addf %[[V1]], %[[V2]] : f32
+// CHECK-NEXT: memref.store %[[V3]], %arg1[%{{.*}}, %{{.*}}]
+// CHECK-NEXT: gpu.terminator
+// CHECK-NOT: gpu.launch
+// CHECK-NOT: memref.dealloc
+func.func @producer_consumer(%arg0: memref<512x1024xf32>, %arg1: memref<512x1024xf32>) {
+  %c1 = arith.constant 1 : index
+  %c512 = arith.constant 512 : index
+  %c1024 = arith.constant 1024 : index
+  %0 = memref.alloc() : memref<512x1024xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c512, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c1024, %sy = %c1, %sz = %c1) {
+    %1 = memref.load %arg0[%bx, %tx] : memref<512x1024xf32>
+    %2 = math.log %1 : f32
+    memref.store %2, %0[%bx, %tx] : memref<512x1024xf32>
+    gpu.terminator
+  }
+  %c1_0 = arith.constant 1 : index
+  %c512_0 = arith.constant 512 : index
+  %c1024_0 = arith.constant 1024 : index
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c512_0, %gy = %c1_0, %gz = %c1_0) threads(%tx, %ty, %tz) in (%sx = %c1024_0, %sy = %c1_0, %sz = %c1_0) {
+    %1 = memref.load %0[%bx, %tx] : memref<512x1024xf32>
+    %2 = memref.load %arg0[%bx, %tx] : memref<512x1024xf32>
+    %3 = arith.addf %1, %2 : f32
+    memref.store %3, %arg1[%bx, %tx] : memref<512x1024xf32>
+    gpu.terminator
+  }
+  memref.dealloc %0 : memref<512x1024xf32>
+  return
+}
+
+// -----
+
+// Two independent launches followed by their consumer, with the linear id
+// delinearized in every kernel.
+
+// CHECK-LABEL: func.func @horizontal
+// CHECK-NOT: memref.alloc
+// CHECK: gpu.launch
+// CHECK: math.log
+// CHECK: math.absf
+// CHECK: arith.addf
+// CHECK: memref.store %{{.*}}, %arg1
+// CHECK-NOT: memref.store
+// CHECK: gpu.terminator
+// CHECK-NOT: gpu.launch
+func.func @horizontal(%arg0: memref<512x1024xf32>, %arg1: memref<512x1024xf32>) {
+  %c1 = arith.constant 1 : index
+  %c256 = arith.constant 256 : index
+  %c1024 = arith.constant 1024 : index
+  %c2048 = arith.constant 2048 : index
+  %0 = memref.alloc() : memref<512x1024xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2048, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %l = arith.muli %bx, %c256 : index
+    %id = arith.addi %l, %tx : index
+    %i = arith.divui %id, %c1024 : index
+    %j = arith.remui %id, %c1024 : index
+    %1 = memref.load %arg0[%i, %j] : memref<512x1024xf32>
+    %2 = math.log %1 : f32
+    memref.store %2, %0[%i, %j] : memref<512x1024xf32>
+    gpu.terminator
+  }
+  %3 = memref.alloc() : memref<512x1024xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2048, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %l = arith.muli %bx, %c256 : index
+    %id = arith.addi %l, %tx : index
+    %i = arith.divui %id, %c1024 : index
+    %j = arith.remui %id, %c1024 : index
+    %1 = memref.load %arg0[%i, %j] : memref<512x1024xf32>
+    %2 = math.absf %1 : f32
+    memref.store %2, %3[%i, %j] : memref<512x1024xf32>
+    gpu.terminator
+  }
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2048, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %l = arith.muli %bx, %c256 : index
+    %id = arith.addi %l, %tx : index
+    %i = arith.divui %id, %c1024 : index
+    %j = arith.remui %id, %c1024 : index
+    %1 = memref.load %0[%i, %j] : memref<512x1024xf32>
+    %2 = memref.load %3[%i, %j] : memref<512x1024xf32>
+    %4 = arith.addf %1, %2 : f32
+    memref.store %4, %arg1[%i, %j] : memref<512x1024xf32>
+    gpu.terminator
+  }
+  return
+}
+
+// -----
+
+// The consumer reads elements written by other work items.
+
+// CHECK-LABEL: func.func @transposed
+// CHECK: memref.alloc
+// CHECK-COUNT-2: gpu.launch
+func.func @transposed(%arg0: memref<512x512xf32>, %arg1: memref<512x512xf32>) {
+  %c1 = arith.constant 1 : index
+  %c512 = arith.constant 512 : index
+  %0 = memref.alloc() : memref<512x512xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c512, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c512, %sy = %c1, %sz = %c1) {
+    %1 = memref.load %arg0[%bx, %tx] : memref<512x512xf32>
+    memref.store %1, %0[%bx, %tx] : memref<512x512xf32>
+    gpu.terminator
+  }
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c512, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c512, %sy = %c1, %sz = %c1) {
+    %1 = memref.load %0[%tx, %bx] : memref<512x512xf32>
+    memref.store %1, %arg1[%bx, %tx] : memref<512x512xf32>
+    gpu.terminator
+  }
+  return
+}
+
+// -----
+
+// All threads of a block write the same element.
+
+// CHECK-LABEL: func.func @not_distinct
+// CHECK-COUNT-2: gpu.launch
+func.func @not_distinct(%arg0: memref<512xf32>, %arg1: memref<512xf32>) {
+  %c1 = arith.constant 1 : index
+  %c512 = arith.constant 512 : index
+  %0 = memref.alloc() : memref<512xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c512, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c512, %sy = %c1, %sz = %c1) {
+    %1 = memref.load %arg0[%tx] : memref<512xf32>
+    memref.store %1, %0[%bx] : memref<512xf32>
+    gpu.terminator
+  }
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c512, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c512, %sy = %c1, %sz = %c1) {
+    %1 = memref.load %0[%bx] : memref<512xf32>
+    memref.store %1, %arg1[%tx] : memref<512xf32>
+    gpu.terminator
+  }
+  return
+}
+
+// -----
+
+// Every thread writes elements other threads write as well: the id
+// %bx + %tx isn't injective and %id remui 256 drops %bx.
+
+// CHECK-LABEL: func.func @not_injective
+// CHECK-COUNT-2: gpu.launch
+func.func @not_injective(%arg0: memref<512xf32>, %arg1: memref<512xf32>) {
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %c256 = arith.constant 256 : index
+  %0 = memref.alloc() : memref<512xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %id = arith.addi %bx, %tx : index
+    %1 = memref.load %arg0[%id] : memref<512xf32>
+    memref.store %1, %0[%id] : memref<512xf32>
+    gpu.terminator
+  }
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %id = arith.addi %bx, %tx : index
+    %1 = memref.load %0[%id] : memref<512xf32>
+    memref.store %1, %arg1[%id] : memref<512xf32>
+    gpu.terminator
+  }
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func.func @not_injective_rem
+// CHECK-COUNT-2: gpu.launch
+func.func @not_injective_rem(%arg0: memref<512xf32>, %arg1: memref<512xf32>) {
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %c256 = arith.constant 256 : index
+  %2 = memref.alloc() : memref<256xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %l = arith.muli %bx, %c256 : index
+    %id = arith.addi %l, %tx : index
+    %j = arith.remui %id, %c256 : index
+    %1 = memref.load %arg0[%id] : memref<512xf32>
+    memref.store %1, %2[%j] : memref<256xf32>
+    gpu.terminator
+  }
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %l = arith.muli %bx, %c256 : index
+    %id = arith.addi %l, %tx : index
+    %j = arith.remui %id, %c256 : index
+    %1 = memref.load %2[%j] : memref<256xf32>
+    memref.store %1, %arg1[%id] : memref<512xf32>
+    gpu.terminator
+  }
+  return
+}
+
+// -----
+
+// Different launch sizes, and a launch separated by a memref.copy.
+
+// CHECK-LABEL: func.func @incompatible
+// CHECK-COUNT-3: gpu.launch
+func.func @incompatible(%arg0: memref<512xf32>, %arg1: memref<512xf32>, %arg2: memref<512xf32>) {
+  %c1 = arith.constant 1 : index
+  %c2 = arith.constant 2 : index
+  %c256 = arith.constant 256 : index
+  %c512 = arith.constant 512 : index
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c1, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c512, %sy = %c1, %sz = %c1) {
+    %1 = memref.load %arg0[%tx] : memref<512xf32>
+    memref.store %1, %arg1[%tx] : memref<512xf32>
+    gpu.terminator
+  }
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %l = arith.muli %bx, %c256 : index
+    %id = arith.addi %l, %tx : index
+    %1 = memref.load %arg1[%id] : memref<512xf32>
+    memref.store %1, %arg0[%id] : memref<512xf32>
+    gpu.terminator
+  }
+  memref.copy %arg0, %arg2 : memref<512xf32> to memref<512xf32>
+  gpu.launch blocks(%bx, %by, %bz) in (%gx = %c2, %gy = %c1, %gz = %c1) threads(%tx, %ty, %tz) in (%sx = %c256, %sy = %c1, %sz = %c1) {
+    %l = arith.muli %bx, %c256 : index
+    %id = arith.addi %l, %tx : index
+    %1 = memref.load %arg2[%id] : memref<512xf32>
+    memref.store %1, %arg1[%id] : memref<512xf32>
+    gpu.terminator
+  }
+  return
+}
@@ -0,0 +1,79 @@
+// RUN: imex-opt --split-input-file --verify-diagnostics --imex-plan-buffer-reuse=report=true %s | FileCheck %s
+
+// A chain of temporaries which are only deallocated at the end. The third
+// buffer reuses the slab of the first one.
+
+// CHECK-LABEL: func.func @chain
+// CHECK: %[[ARENA:.*]] = memref.alloc() {alignment = 64 : i64} : memref<8192xi8>
+// CHECK: %[[C0:.*]] = arith.constant 0 : index
+// CHECK: memref.view %[[ARENA]][%[[C0]]][] : memref<8192xi8> to memref<32x32xf32>
+// CHECK: %[[C4096:.*]] = arith.constant 4096 : index
+// CHECK: memref.view %[[ARENA]][%[[C4096]]][] : memref<8192xi8> to memref<32x32xf32>
+// CHECK: %[[C0_0:.*]] = arith.constant 0 : index
+// CHECK: memref.view %[[ARENA]][%[[C0_0]]][] : memref<8192xi8> to memref<32x32xf32>
+// CHECK-NOT: memref.alloc
+// CHECK: memref.dealloc %[[ARENA]] : memref<8192xi8>
+// CHECK-NOT: memref.dealloc
+// CHECK: return
+// expected-remark @+1 {{naive peak bytes 12288, planned bytes 8192}}
+func.func @chain(%arg0: memref<32x32xf32>, %arg1: memref<32x32xf32>) {
+  %0 = memref.alloc() {alignment = 64 : i64} : memref<32x32xf32>
+  memref.copy %arg0, %0 : memref<32x32xf32> to memref<32x32xf32>
+  %1 = memref.alloc() {alignment = 64 : i64} : memref<32x32xf32>
+  memref.copy %0, %1 : memref<32x32xf32> to memref<32x32xf32>
+  %2 = memref.alloc() {alignment = 64 : i64} : memref<32x32xf32>
+  memref.copy %1, %2 : memref<32x32xf32> to memref<32x32xf32>
+  memref.copy %2, %arg1 : memref<32x32xf32> to memref<32x32xf32>
+  memref.dealloc %0 : memref<32x32xf32>
+  memref.dealloc %1 : memref<32x32xf32>
+  memref.dealloc %2 : memref<32x32xf32>
+  return
+}
+
+// -----
+
+// A smaller buffer reuses a larger slab, uses in loops and of subviews
+// extend the lifetime to the enclosing top-level op.
+
+// CHECK-LABEL: func.func @smaller
+// CHECK: %[[ARENA:.*]] = memref.alloc() {alignment = 64 : i64} : memref<4160xi8>
+// CHECK: memref.view %[[ARENA]][%{{.*}}][] : memref<4160xi8> to memref<1024xf32>
+// CHECK: memref.view %[[ARENA]][%{{.*}}][] : memref<4160xi8> to memref<16xf32>
+// CHECK: memref.view %[[ARENA]][%{{.*}}][] : memref<4160xi8> to memref<512xf32>
+// expected-remark @+1 {{naive peak bytes 6208, planned bytes 4160}}
+func.func @smaller(%arg0: memref<1024xf32>, %arg1: memref<512xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c16 = arith.constant 16 : index
+  %0 = memref.alloc() : memref<1024xf32>
+  %1 = memref.alloc() : memref<16xf32>
+  memref.copy %arg0, %0 : memref<1024xf32> to memref<1024xf32>
+  %sv = memref.subview %0[0] [16] [1] : memref<1024xf32> to memref<16xf32, strided<[1]>>
+  scf.for %i = %c0 to %c16 step %c1 {
+    %v = memref.load %sv[%i] : memref<16xf32, strided<[1]>>
+    memref.store %v, %1[%i] : memref<16xf32>
+  }
+  %2 = memref.alloc() : memref<512xf32>
+  scf.for %i = %c0 to %c16 step %c1 {
+    %v = memref.load %1[%i] : memref<16xf32>
+    memref.store %v, %2[%i] : memref<512xf32>
+  }
+  memref.copy %2, %arg1 : memref<512xf32> to memref<512xf32>
+  return
+}
+
+// -----
+
+// Returned buffers and buffers with dynamic shapes are not planned.
+
+// CHECK-LABEL: func.func @escape
+// CHECK-NOT: memref.view
+// CHECK: memref.alloc() : memref<16xf32>
+// CHECK: memref.alloc(%{{.*}}) : memref<?xf32>
+func.func @escape(%arg0: memref<16xf32>, %arg1: index) -> memref<16xf32> {
+  %0 = memref.alloc() : memref<16xf32>
+  memref.copy %arg0, %0 : memref<16xf32> to memref<16xf32>
+  %1 = memref.alloc(%arg1) : memref<?xf32>
+  memref.dealloc %1 : memref<?xf32>
+  return %0 : memref<16xf32>
+}
@@ -0,0 +1,115 @@
+// RUN: imex-opt --pass-pipeline='builtin.module(gpu.module(imex-promote-to-slm))' %s | FileCheck %s
+
+gpu.module @kernels {
+  // The reads of a transpose are strided across the lanes, the tile is read
+  // coalesced and then accessed transposed in shared local memory.
+  // CHECK-LABEL: gpu.func @transpose
+  // CHECK-SAME: (%[[IN:.*]]: memref<256x256xf32>, %[[OUT:.*]]: memref<256x256xf32>)
+  gpu.func @transpose(%arg0: memref<256x256xf32>, %arg1: memref<256x256xf32>) kernel
+    attributes {gpu.known_block_size = array<i32: 16, 16, 1>} {
+    %c16 = arith.constant 16 : index
+    %0 = gpu.block_id x
+    %1 = gpu.block_id y
+    %2 = gpu.thread_id x
+    %3 = gpu.thread_id y
+    // CHECK: %[[BX:.*]] = arith.muli
+    // CHECK: %[[BY:.*]] = arith.muli
+    %4 = arith.muli %0, %c16 : index
+    %5 = arith.muli %1, %c16 : index
+    %6 = arith.addi %4, %2 : index
+    %7 = arith.addi %5, %3 : index
+    // CHECK: %[[TILE:.*]] = memref.alloc() : memref<16x17xf32, 3>
+    // CHECK: %[[TZ:.*]] = gpu.thread_id z
+    // CHECK: %[[TY:.*]] = gpu.thread_id y
+    // CHECK: %[[TX:.*]] = gpu.thread_id x
+    // CHECK: %[[LIN:.*]] = arith.addi %{{.*}}, %[[TX]] : index
+    // CHECK: scf.for %[[K:.*]] = %[[LIN]] to %c256{{.*}} step %c256{{.*}} {
+    // CHECK: %[[COL:.*]] = arith.remui %[[K]], %c16{{.*}} : index
+    // CHECK: %[[ROW:.*]] = arith.divui %[[K]], %c16{{.*}} : index
+    // CHECK: scf.if %{{.*}} {
+    // CHECK-NEXT: %[[V:.*]] = memref.load %[[IN]][%{{.*}}, %{{.*}}] : memref<256x256xf32>
+    // CHECK-NEXT: memref.store %[[V]], %[[TILE]][%[[ROW]], %[[COL]]] : memref<16x17xf32, 3>
+    // CHECK: gpu.barrier
+    // CHECK: %[[T:.*]] = memref.load %[[TILE]][%{{.*}}, %{{.*}}] : memref<16x17xf32, 3>
+    // CHECK-NOT: memref.load %[[IN]]
+    // CHECK: memref.store %[[T]], %[[OUT]]
+    %8 = memref.load %arg0[%6, %7] : memref<256x256xf32>
+    memref.store %8, %arg1[%7, %6] : memref<256x256xf32>
+    gpu.return
+  }
+
+  // The neighbours read by a stencil are loaded once per work group.
+  // CHECK-LABEL: gpu.func @stencil
+  // CHECK: memref.alloc() : memref<66xf32, 3>
+  // CHECK: gpu.barrier
+  // CHECK-COUNT-3: memref.load %{{.*}}[%{{.*}}] : memref<66xf32, 3>
+  gpu.func @stencil(%arg0: memref<1024xf32>, %arg1: memref<1024xf32>) kernel
+    attributes {gpu.known_block_size = array<i32: 64, 1, 1>} {
+    %c64 = arith.constant 64 : index
+    %c1 = arith.constant 1 : index
+    %cm1 = arith.constant -1 : index
+    %0 = gpu.block_id x
+    %1 = gpu.thread_id x
+    %2 = arith.muli %0, %c64 : index
+    %3 = arith.addi %2, %1 : index
+    %4 = arith.addi %3, %cm1 : index
+    %5 = arith.addi %3, %c1 : index
+    %6 = memref.load %arg0[%4] : memref<1024xf32>
+    %7 = memref.load %arg0[%3] : memref<1024xf32>
+    %8 = memref.load %arg0[%5] : memref<1024xf32>
+    %9 = arith.addf %6, %7 : f32
+    %10 = arith.addf %9, %8 : f32
+    memref.store %10, %arg1[%3] : memref<1024xf32>
+    gpu.return
+  }
+
+  // Arguments which are written, or read without reuse, stay in global
+  // memory.
+  // CHECK-LABEL: gpu.func @no_reuse
+  // CHECK-NOT: memref.alloc
+  // CHECK-NOT: gpu.barrier
+  gpu.func @no_reuse(%arg0: memref<1024xf32>, %arg1: memref<1024xf32>) kernel
+    attributes {gpu.known_block_size = array<i32: 64, 1, 1>} {
+    %c64 = arith.constant 64 : index
+    %c1 = arith.constant 1 : index
+    %0 = gpu.block_id x
+    %1 = gpu.thread_id x
+    %2 = arith.muli %0, %c64 : index
+    %3 = arith.addi %2, %1 : index
+    %4 = arith.addi %3, %c1 : index
+    %5 = memref.load %arg0[%3] : memref<1024xf32>
+    %6 = memref.load %arg1[%3] : memref<1024xf32>
+    %7 = memref.load %arg1[%4] : memref<1024xf32>
+    %8 = arith.addf %5, %6 : f32
+    %9 = arith.addf %8, %7 : f32
+    memref.store %9, %arg1[%3] : memref<1024xf32>
+    gpu.return
+  }
+
+  // The stencil reads are outside of the entry block, there is no point at
+  // the top level of the kernel for the copy in.
+  // CHECK-LABEL: gpu.func @multi_block
+  // CHECK-NOT: memref.alloc
+  // CHECK-NOT: gpu.barrier
+  gpu.func @multi_block(%arg0: memref<1024xf32>, %arg1: memref<1024xf32>) kernel
+    attributes {gpu.known_block_size = array<i32: 64, 1, 1>} {
+    %c64 = arith.constant 64 : index
+    %c1 = arith.constant 1 : index
+    %cm1 = arith.constant -1 : index
+    %0 = gpu.block_id x
+    %1 = gpu.thread_id x
+    %2 = arith.muli %0, %c64 : index
+    %3 = arith.addi %2, %1 : index
+    %4 = arith.addi %3, %cm1 : index
+    %5 = arith.addi %3, %c1 : index
+    cf.br ^bb1
+  ^bb1:
+    %6 = memref.load %arg0[%4] : memref<1024xf32>
+    %7 = memref.load %arg0[%3] : memref<1024xf32>
+    %8 = memref.load %arg0[%5] : memref<1024xf32>
+    %9 = arith.addf %6, %7 : f32
+    %10 = arith.addf %9, %8 : f32
+    memref.store %10, %arg1[%3] : memref<1024xf32>
+    gpu.return
+  }
+}
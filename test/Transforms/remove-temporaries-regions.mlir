@@ -0,0 +1,124 @@
+// RUN: imex-opt -imex-remove-temporaries %s | FileCheck %s
+// RUN: imex-opt -imex-remove-temporaries -mlir-pass-statistics %s 2>&1 >/dev/null | FileCheck %s --check-prefix=STATS
+
+// STATS: (S) 3 num-removed-copies
+
+#map = affine_map<(d0) -> (d0)>
+#map2 = affine_map<(d0, d1) -> (d0, d1)>
+module {
+  func.func @ewbinop_env_region(%arg0: memref<64xi64, strided<[?], offset: ?>>, %arg1: memref<64xi64, strided<[?], offset: ?>>, %arg2: memref<64xi64, strided<[?], offset: ?>>) {
+    %alloc = memref.alloc() {alignment = 64 : i64} : memref<64xi64>
+    region.env_region #region.gpu_env<device = "XeGPU"> {
+      linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%arg0, %arg1 : memref<64xi64, strided<[?], offset: ?>>, memref<64xi64, strided<[?], offset: ?>>) outs(%alloc : memref<64xi64>) {
+      ^bb0(%in: i64, %in_0: i64, %out: i64):
+        %0 = arith.addi %in, %in_0 : i64
+        linalg.yield %0 : i64
+      }
+      memref.copy %alloc, %arg2 : memref<64xi64> to memref<64xi64, strided<[?], offset: ?>>
+    }
+    memref.dealloc %alloc : memref<64xi64>
+    return
+    // CHECK-LABEL: func @ewbinop_env_region
+    // CHECK-NEXT:  region.env_region
+    // CHECK-NEXT:  linalg.generic
+    // CHECK-SAME:  outs(%arg2
+    // CHECK:       linalg.yield
+    // CHECK-NEXT:  }
+    // CHECK-NEXT:  }
+    // CHECK-NEXT:  return
+  }
+  func.func @ewbinop_env_region_dst_read(%arg0: memref<64xi64>, %arg1: memref<64xi64>, %arg2: memref<64xi64>) {
+    %alloc = memref.alloc() {alignment = 64 : i64} : memref<64xi64>
+    region.env_region #region.gpu_env<device = "XeGPU"> {
+      linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]} ins(%arg0 : memref<64xi64>) outs(%alloc : memref<64xi64>) {
+      ^bb0(%in: i64, %out: i64):
+        %0 = arith.addi %in, %in : i64
+        linalg.yield %0 : i64
+      }
+      memref.copy %arg2, %arg1 : memref<64xi64> to memref<64xi64>
+      memref.copy %alloc, %arg2 : memref<64xi64> to memref<64xi64>
+    }
+    memref.dealloc %alloc : memref<64xi64>
+    return
+    // CHECK-LABEL: func @ewbinop_env_region_dst_read
+    // CHECK:       memref.alloc
+    // CHECK:       region.env_region
+    // CHECK-NEXT:  linalg.generic
+    // CHECK-SAME:  outs(%alloc
+    // CHECK:       memref.copy %arg2, %arg1
+    // CHECK-NEXT:  memref.copy %alloc, %arg2
+  }
+  func.func @ewbinop_loop(%arg0: memref<64xi64>, %arg1: index) {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %alloc = memref.alloc() {alignment = 64 : i64} : memref<64xi64>
+    scf.for %i = %c0 to %arg1 step %c1 {
+      linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%arg0, %arg0 : memref<64xi64>, memref<64xi64>) outs(%alloc : memref<64xi64>) {
+      ^bb0(%in: i64, %in_0: i64, %out: i64):
+        %0 = arith.addi %in, %in_0 : i64
+        linalg.yield %0 : i64
+      }
+      memref.copy %alloc, %arg0 : memref<64xi64> to memref<64xi64>
+    }
+    memref.dealloc %alloc : memref<64xi64>
+    return
+    // NOTE: the loop-carried value is updated in place
+    // CHECK-LABEL: func @ewbinop_loop
+    // CHECK-NOT:   memref.alloc
+    // CHECK:       scf.for
+    // CHECK-NEXT:  linalg.generic
+    // CHECK-SAME:  outs(%arg0
+    // CHECK:       linalg.yield
+    // CHECK-NEXT:  }
+    // CHECK-NEXT:  }
+    // CHECK-NEXT:  return
+  }
+  func.func @ewbinop_loop_dst_read(%arg0: memref<64xi64>, %arg1: memref<64xi64>, %arg2: index) {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %alloc = memref.alloc() {alignment = 64 : i64} : memref<64xi64>
+    scf.for %i = %c0 to %arg2 step %c1 {
+      linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%arg0, %arg0 : memref<64xi64>, memref<64xi64>) outs(%alloc : memref<64xi64>) {
+      ^bb0(%in: i64, %in_0: i64, %out: i64):
+        %0 = arith.addi %in, %in_0 : i64
+        linalg.yield %0 : i64
+      }
+      memref.copy %arg0, %arg1 : memref<64xi64> to memref<64xi64>
+      memref.copy %alloc, %arg0 : memref<64xi64> to memref<64xi64>
+    }
+    memref.dealloc %alloc : memref<64xi64>
+    return
+    // NOTE: dst is read between the write to the temporary and the copy, no change
+    // CHECK-LABEL: func @ewbinop_loop_dst_read
+    // CHECK:       memref.alloc
+    // CHECK:       scf.for
+    // CHECK-NEXT:  linalg.generic
+    // CHECK-SAME:  outs(%alloc
+    // CHECK:       memref.copy %arg0, %arg1
+    // CHECK-NEXT:  memref.copy %alloc, %arg0
+  }
+  func.func @ewbinop_dst_before_alloc(%arg0: memref<16x16xi64>) {
+    %c1_i64 = arith.constant 1 : i64
+    %subview = memref.subview %arg0[2, 1] [14, 10] [1, 1] : memref<16x16xi64> to memref<14x10xi64, strided<[16, 1], offset: 33>>
+    %subview_0 = memref.subview %arg0[0, 1] [16, 10] [1, 1] : memref<16x16xi64> to memref<16x10xi64, strided<[16, 1], offset: 1>>
+    %subview_1 = memref.subview %subview_0[2, 0] [14, 10] [1, 1] : memref<16x10xi64, strided<[16, 1], offset: 1>> to memref<14x10xi64, strided<[16, 1], offset: 33>>
+    %alloc = memref.alloc() {alignment = 64 : i64} : memref<14x10xi64>
+    linalg.generic {indexing_maps = [#map2, #map2], iterator_types = ["parallel", "parallel"]} ins(%subview_1 : memref<14x10xi64, strided<[16, 1], offset: 33>>) outs(%alloc : memref<14x10xi64>) {
+    ^bb0(%in: i64, %out: i64):
+      %0 = arith.addi %in, %c1_i64 : i64
+      linalg.yield %0 : i64
+    }
+    memref.copy %alloc, %subview : memref<14x10xi64> to memref<14x10xi64, strided<[16, 1], offset: 33>>
+    memref.dealloc %alloc : memref<14x10xi64>
+    return
+    // NOTE: dst dominates the temporary, the subview chains are an exact alias
+    // CHECK-LABEL: func @ewbinop_dst_before_alloc
+    // CHECK:       %[[SV:.*]] = memref.subview %arg0[2, 1]
+    // CHECK-NEXT:  memref.subview
+    // CHECK-NEXT:  memref.subview
+    // CHECK-NEXT:  linalg.generic
+    // CHECK-SAME:  outs(%[[SV]]
+    // CHECK-NOT:   memref.copy
+    // CHECK:       return
+  }
+}
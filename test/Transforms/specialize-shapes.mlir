@@ -0,0 +1,77 @@
+// RUN: imex-opt --split-input-file --verify-diagnostics --imex-specialize-shapes=max-specializations=2 %s | FileCheck %s
+
+// Two specializations of a memref function, the non-shaped argument is not
+// part of the shapes. Dims in the clones fold to constants.
+
+// CHECK-LABEL: func.func @add(
+// CHECK-SAME: %[[A:.*]]: memref<?x?xf32>, %[[B:.*]]: index
+// CHECK-NOT: imex.specialize_shapes
+// CHECK: %[[D0:.*]] = memref.dim %[[A]], %c0
+// CHECK: arith.cmpi eq, %[[D0]], %c16
+// CHECK: %[[D1:.*]] = memref.dim %[[A]], %c1
+// CHECK: arith.cmpi eq, %[[D1]], %c16
+// CHECK: %[[M:.*]] = arith.andi
+// CHECK: %[[R:.*]] = scf.if %[[M]] -> (index) {
+// CHECK: %[[S:.*]] = memref.cast %[[A]] : memref<?x?xf32> to memref<16x16xf32>
+// CHECK: call @add_spec0(%[[S]], %[[B]])
+// CHECK: } else {
+// CHECK: scf.if
+// CHECK: memref.cast %[[A]] : memref<?x?xf32> to memref<8x32xf32>
+// CHECK: call @add_spec1(
+// CHECK: } else {
+// CHECK: call @add_generic(%[[A]], %[[B]])
+// CHECK: return %[[R]] : index
+
+// CHECK-LABEL: func.func private @add_spec0(
+// CHECK-SAME: memref<16x16xf32>
+// CHECK-NOT: memref.dim
+// CHECK: %[[C256:.*]] = arith.constant 256 : index
+// CHECK: return %[[C256]]
+
+// CHECK-LABEL: func.func private @add_spec1(
+// CHECK-SAME: memref<8x32xf32>
+
+// CHECK-LABEL: func.func private @add_generic(
+// CHECK-SAME: memref<?x?xf32>
+// CHECK: memref.dim
+// CHECK: memref.dim
+func.func @add(%arg0: memref<?x?xf32>, %arg1: index) -> index
+    attributes {imex.specialize_shapes = [[array<i64: 16, 16>], [array<i64: 8, 32>]]} {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %d0 = memref.dim %arg0, %c0 : memref<?x?xf32>
+  %d1 = memref.dim %arg0, %c1 : memref<?x?xf32>
+  %n = arith.muli %d0, %d1 : index
+  return %n : index
+}
+
+// -----
+
+// Tensor arguments, only the dynamic dims are checked. Entries beyond
+// max-specializations are dropped.
+
+// CHECK-LABEL: func.func @tensor(
+// CHECK: tensor.dim %arg0, %c1
+// CHECK-NOT: tensor.dim
+// CHECK: tensor.cast %arg0 : tensor<4x?xf32> to tensor<4x8xf32>
+// CHECK: call @tensor_spec0(
+// CHECK: call @tensor_spec1(
+// CHECK-NOT: @tensor_spec2
+// CHECK: call @tensor_generic(
+// CHECK-LABEL: func.func private @tensor_spec0(
+// CHECK-SAME: tensor<4x8xf32>
+// CHECK-SAME: tensor<2xf32>
+// CHECK-NOT: @tensor_spec2
+// CHECK-LABEL: func.func private @tensor_generic(
+func.func @tensor(%arg0: tensor<4x?xf32>, %arg1: tensor<2xf32>) -> tensor<4x?xf32>
+    attributes {imex.specialize_shapes = [[array<i64: 4, 8>, array<i64: 2>], [array<i64: 4, 16>, array<i64: 2>], [array<i64: 4, 32>, array<i64: 2>]]} {
+  return %arg0 : tensor<4x?xf32>
+}
+
+// -----
+
+// expected-error @+1 {{imex.specialize_shapes has a shape incompatible with argument 0}}
+func.func @bad(%arg0: memref<4x?xf32>)
+    attributes {imex.specialize_shapes = [[array<i64: 8, 8>]]} {
+  return
+}
@@ -0,0 +1,157 @@
+// RUN: imex-opt --split-input-file --imex-stream-chunks=chunk-size=4 %s | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// Both inputs are double-buffered and loaded asynchronously, the output is
+// only stored and gets a single staging buffer.
+
+// CHECK-LABEL: func.func @add(
+// CHECK-SAME: %[[A:.*]]: memref<?x8xf32>, %[[B:.*]]: memref<?x8xf32>, %[[C:.*]]: memref<?x8xf32>
+// CHECK: %[[N:.*]] = memref.dim %[[C]], %c0
+// CHECK: %[[A0:.*]] = memref.alloc() : memref<4x8xf32>
+// CHECK: %[[A1:.*]] = memref.alloc() : memref<4x8xf32>
+// CHECK: %[[B0:.*]] = memref.alloc() : memref<4x8xf32>
+// CHECK: %[[B1:.*]] = memref.alloc() : memref<4x8xf32>
+// CHECK: %[[C0:.*]] = memref.alloc() : memref<4x8xf32>
+// CHECK-NOT: memref.alloc
+// CHECK: %[[T0:.*]] = async.execute {
+// CHECK: memref.subview %[[A]][0, 0]
+// CHECK: memref.subview %[[A0]][0, 0]
+// CHECK: memref.copy
+// CHECK: memref.subview %[[B]][0, 0]
+// CHECK: memref.subview %[[B0]][0, 0]
+// CHECK: memref.copy
+// CHECK: async.yield
+// CHECK: %[[TL:.*]] = scf.for %[[I:.*]] = %c0 to %[[N]] step %c4 iter_args(%[[T:.*]] = %[[T0]]) -> (!async.token) {
+// CHECK: %[[ODD:.*]] = arith.cmpi eq
+// CHECK: %[[CA:.*]] = arith.select %[[ODD]], %[[A1]], %[[A0]]
+// CHECK: %[[NA:.*]] = arith.select %[[ODD]], %[[A0]], %[[A1]]
+// CHECK: %[[CB:.*]] = arith.select %[[ODD]], %[[B1]], %[[B0]]
+// CHECK: %[[NB:.*]] = arith.select %[[ODD]], %[[B0]], %[[B1]]
+// CHECK: %[[NEXT:.*]] = arith.addi %[[I]], %c4
+// CHECK: %[[TN:.*]] = async.execute {
+// CHECK: scf.if
+// CHECK: memref.subview %[[A]][%[[NEXT]], 0]
+// CHECK: memref.subview %[[NA]][0, 0]
+// CHECK: memref.copy
+// CHECK: memref.subview %[[B]][%[[NEXT]], 0]
+// CHECK: memref.subview %[[NB]][0, 0]
+// CHECK: memref.copy
+// CHECK: }
+// CHECK: async.yield
+// CHECK: }
+// CHECK: async.await %[[T]] : !async.token
+// CHECK: %[[SZ:.*]] = arith.minui
+// CHECK: %[[VA:.*]] = memref.subview %[[CA]][0, 0] [%[[SZ]], 8]
+// CHECK: %[[VB:.*]] = memref.subview %[[CB]][0, 0] [%[[SZ]], 8]
+// CHECK: %[[VC:.*]] = memref.subview %[[C0]][0, 0] [%[[SZ]], 8]
+// CHECK: linalg.generic
+// CHECK-SAME: ins(%[[VA]], %[[VB]]
+// CHECK-SAME: outs(%[[VC]]
+// CHECK: %[[OC:.*]] = memref.subview %[[C]][%[[I]], 0] [%[[SZ]], 8]
+// CHECK: memref.copy %[[VC]], %[[OC]]
+// CHECK: scf.yield %[[TN]] : !async.token
+// CHECK: }
+// CHECK: async.await %[[TL]] : !async.token
+// CHECK: memref.dealloc %[[A0]]
+// CHECK: memref.dealloc %[[A1]]
+// CHECK: memref.dealloc %[[B0]]
+// CHECK: memref.dealloc %[[B1]]
+// CHECK: memref.dealloc %[[C0]]
+func.func @add(%arg0: memref<?x8xf32>, %arg1: memref<?x8xf32>, %arg2: memref<?x8xf32>) {
+  linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]} ins(%arg0, %arg1 : memref<?x8xf32>, memref<?x8xf32>) outs(%arg2 : memref<?x8xf32>) {
+  ^bb0(%in: f32, %in_0: f32, %out: f32):
+    %0 = arith.addf %in, %in_0 : f32
+    linalg.yield %0 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#map1 = affine_map<(d0, d1) -> (d1)>
+#map2 = affine_map<(d0, d1) -> (d0)>
+
+// A row-wise reduction with a broadcasted input. The accumulator is read and
+// therefore loaded like an input, the broadcasted input is used whole.
+
+// CHECK-LABEL: func.func @rowsum(
+// CHECK-SAME: %[[A:.*]]: memref<16x?xf32>, %[[V:.*]]: memref<?xf32>, %[[R:.*]]: memref<16xf32>
+// CHECK: %[[D:.*]] = memref.dim %[[A]], %c1
+// CHECK: memref.alloc(%[[D]]) : memref<4x?xf32>
+// CHECK: memref.alloc(%{{.*}}) : memref<4x?xf32>
+// CHECK: %[[R0:.*]] = memref.alloc() : memref<4xf32>
+// CHECK: %[[R1:.*]] = memref.alloc() : memref<4xf32>
+// CHECK: scf.for
+// CHECK: %[[CR:.*]] = arith.select %{{.*}}, %[[R1]], %[[R0]]
+// CHECK: scf.if
+// CHECK: %[[VR:.*]] = memref.subview %[[CR]][0] [%{{.*}}] [1]
+// CHECK: linalg.generic
+// CHECK-SAME: ins(%{{.*}}, %[[V]] :
+// CHECK-SAME: outs(%[[VR]]
+// CHECK: memref.copy %[[VR]]
+func.func @rowsum(%arg0: memref<16x?xf32>, %arg1: memref<?xf32>, %arg2: memref<16xf32>) {
+  linalg.generic {indexing_maps = [#map, #map1, #map2], iterator_types = ["parallel", "reduction"]} ins(%arg0, %arg1 : memref<16x?xf32>, memref<?xf32>) outs(%arg2 : memref<16xf32>) {
+  ^bb0(%in: f32, %in_0: f32, %out: f32):
+    %0 = arith.mulf %in, %in_0 : f32
+    %1 = arith.addf %0, %out : f32
+    linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0) -> (d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+#map2 = affine_map<(d0, d1) -> (d1, d0)>
+
+// Static leading loops of at most chunk-size rows, tensors and transposed
+// accesses are not streamed.
+
+// CHECK-LABEL: func.func @not_streamed(
+// CHECK-NOT: scf.for
+// CHECK: linalg.generic
+// CHECK: linalg.generic
+// CHECK: linalg.generic
+// CHECK-NOT: scf.for
+func.func @not_streamed(%arg0: memref<4xf32>, %arg1: tensor<?xf32>, %arg2: memref<?x?xf32>) -> tensor<?xf32> {
+  linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]} ins(%arg0 : memref<4xf32>) outs(%arg0 : memref<4xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    %0 = arith.negf %in : f32
+    linalg.yield %0 : f32
+  }
+  %0 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]} ins(%arg1 : tensor<?xf32>) outs(%arg1 : tensor<?xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    %1 = arith.negf %in : f32
+    linalg.yield %1 : f32
+  } -> tensor<?xf32>
+  linalg.generic {indexing_maps = [#map2, #map1], iterator_types = ["parallel", "parallel"]} ins(%arg2 : memref<?x?xf32>) outs(%arg2 : memref<?x?xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    linalg.yield %in : f32
+  }
+  return %0 : tensor<?xf32>
+}
+
+// -----
+
+#map = affine_map<(d0) -> (d0)>
+
+// Indices of the leading loop are shifted by the chunk offset.
+
+// CHECK-LABEL: func.func @iota(
+// CHECK: scf.for %[[I:.*]] = %c0 to %{{.*}} step %c4
+// CHECK: linalg.generic
+// CHECK: %[[IDX:.*]] = linalg.index 0 : index
+// CHECK-NEXT: %[[G:.*]] = arith.addi %[[IDX]], %[[I]] : index
+// CHECK-NEXT: arith.index_cast %[[G]] : index to i64
+func.func @iota(%arg0: memref<?xi64>) {
+  linalg.generic {indexing_maps = [#map], iterator_types = ["parallel"]} outs(%arg0 : memref<?xi64>) {
+  ^bb0(%out: i64):
+    %0 = linalg.index 0 : index
+    %1 = arith.index_cast %0 : index to i64
+    linalg.yield %1 : i64
+  }
+  return
+}
@@ -0,0 +1,68 @@
+// RUN: imex-opt --pass-pipeline='builtin.module(gpu.module(imex-subgroup-block-io))' %s | FileCheck %s
+// RUN: imex-opt --pass-pipeline='builtin.module(gpu.module(imex-subgroup-block-io{subgroup-size=16}))' %s | FileCheck %s --check-prefix=OPTION
+
+module attributes {
+  gpu.container_module,
+  spirv.target_env = #spirv.target_env<#spirv.vce<v1.0, [Addresses, Int64, Kernel], []>, #spirv.resource_limits<>>
+} {
+  // CHECK: gpu.module @kernels attributes {spirv.target_env = #spirv.target_env<#spirv.vce<v1.0, [Addresses, Int64, Kernel, SubgroupBufferBlockIOINTEL], [SPV_INTEL_subgroups]>
+  gpu.module @kernels {
+    // CHECK-LABEL: gpu.func @relu
+    gpu.func @relu(%arg0: memref<4096xf32>, %arg1: memref<4096xf32>, %arg2: index) kernel
+      attributes {gpu.known_block_size = array<i32: 64, 1, 1>, spirv.entry_point_abi = #spirv.entry_point_abi<subgroup_size = 16>} {
+      %cst = arith.constant 0.000000e+00 : f32
+      %c64 = arith.constant 64 : index
+      %c2 = arith.constant 2 : index
+      %0 = gpu.block_id x
+      %1 = gpu.thread_id x
+      %2 = arith.muli %0, %c64 : index
+      %3 = arith.addi %2, %1 : index
+      // CHECK: memref.load %{{.*}}[%{{.*}}] {imex.subgroup_block_io} : memref<4096xf32>
+      %4 = memref.load %arg0[%3] : memref<4096xf32>
+      %5 = arith.maximumf %4, %cst : f32
+      // CHECK: memref.store %{{.*}}, %{{.*}}[%{{.*}}] {imex.subgroup_block_io} : memref<4096xf32>
+      memref.store %5, %arg1[%3] : memref<4096xf32>
+
+      // Strided accesses stay per lane.
+      // CHECK: memref.load %{{.*}}[%{{.*}}] : memref<4096xf32>
+      %6 = arith.muli %1, %c2 : index
+      %7 = memref.load %arg0[%6] : memref<4096xf32>
+
+      // So do accesses whose first lane isn't provably aligned to the
+      // subgroup.
+      // CHECK: memref.load %{{.*}}[%{{.*}}] : memref<4096xf32>
+      // CHECK: memref.load %{{.*}}[%{{.*}}] : memref<4096xf32>
+      %9 = arith.addi %arg2, %1 : index
+      %10 = memref.load %arg0[%9] : memref<4096xf32>
+      %c8 = arith.constant 8 : index
+      %11 = arith.addi %2, %c8 : index
+      %12 = arith.addi %11, %1 : index
+      %13 = memref.load %arg0[%12] : memref<4096xf32>
+
+      // So do accesses under divergent control flow.
+      // CHECK: scf.if
+      // CHECK-NEXT: memref.store %{{.*}}, %{{.*}}[%{{.*}}] : memref<4096xf32>
+      %8 = arith.cmpi ult, %3, %arg2 : index
+      scf.if %8 {
+        memref.store %7, %arg1[%3] : memref<4096xf32>
+      }
+      gpu.return
+    }
+
+    // Without a known subgroup size the lanes of a subgroup are unknown.
+    // CHECK-LABEL: gpu.func @no_subgroup_size
+    // CHECK-NOT: imex.subgroup_block_io
+    // OPTION-LABEL: gpu.func @no_subgroup_size
+    // OPTION: memref.load %{{.*}}[%{{.*}}] {imex.subgroup_block_io} : memref<4096xf16>
+    gpu.func @no_subgroup_size(%arg0: memref<4096xf16>) kernel
+      attributes {gpu.known_block_size = array<i32: 32, 1, 1>} {
+      %c32 = arith.constant 32 : index
+      %0 = gpu.block_id x
+      %1 = gpu.thread_id x
+      %2 = arith.muli %0, %c32 : index
+      %3 = arith.addi %1, %2 : index
+      %4 = memref.load %arg0[%3] : memref<4096xf16>
+      gpu.return
+    }
+  }
+}
@@ -0,0 +1,139 @@
+// RUN: imex-opt --split-input-file --imex-tune-launch-config='work-group-size=64 work-per-thread=2' %s | FileCheck %s
+// RUN: imex-opt --split-input-file --imex-tune-launch-config='device=generic' %s | FileCheck %s --check-prefix=AUTO
+// RUN: imex-opt --split-input-file --imex-tune-launch-config='work-group-size=64 vector-width=4' %s | FileCheck %s --check-prefix=VEC
+
+// CHECK-LABEL: func.func @relu
+// CHECK: scf.parallel (%[[G:.*]]) = (%c0) to (%c16) step (%c1) {
+// CHECK-NEXT: scf.parallel (%[[L:.*]]) = (%c0) to (%c64) step (%c1) {
+// CHECK-NEXT: scf.for %[[I:.*]] = %c0 to %c2 step %c1 {
+// CHECK: %[[M0:.*]] = arith.muli %[[G]], %c2 : index
+// CHECK: %[[A0:.*]] = arith.addi %[[M0]], %[[I]] : index
+// CHECK: %[[M1:.*]] = arith.muli %[[A0]], %c64 : index
+// CHECK: %[[LIN:.*]] = arith.addi %[[M1]], %[[L]] : index
+// CHECK-NOT: scf.if
+// CHECK: %{{.*}} = arith.remui %[[LIN]], %c32 : index
+// CHECK: %{{.*}} = arith.divui %[[LIN]], %c32 : index
+// CHECK: memref.load %{{.*}}[%{{.*}}, %{{.*}}] : memref<64x32xf32>
+// CHECK-NOT: scf.parallel
+// CHECK: return
+
+// AUTO-LABEL: func.func @relu
+// AUTO: scf.parallel (%{{.*}}) = (%{{.*}}) to (%{{.*}}) step
+// AUTO-NEXT: scf.parallel (%{{.*}}) = (%{{.*}}) to (%{{.*}}) step
+// AUTO-NOT: scf.for
+// AUTO: return
+
+// VEC-LABEL: func.func @relu
+// VEC: scf.parallel (%{{.*}}) = (%{{.*}}) to (%c8) step
+// VEC-NEXT: scf.parallel (%{{.*}}) = (%{{.*}}) to (%c64) step
+// VEC: %[[LIN:.*]] = arith.addi
+// VEC: %[[ELEM:.*]] = arith.muli %[[LIN]], %c4 : index
+// VEC: arith.remui %[[ELEM]], %c32 : index
+// VEC: %[[V:.*]] = vector.load %arg0[%[[I:.*]], %[[J:.*]]] : memref<64x32xf32>, vector<4xf32>
+// VEC: %[[ZERO:.*]] = vector.broadcast %{{.*}} : f32 to vector<4xf32>
+// VEC: %[[MAX:.*]] = arith.maximumf %[[V]], %[[ZERO]] : vector<4xf32>
+// VEC: vector.store %[[MAX]], %arg1[%[[I]], %[[J]]] : memref<64x32xf32>, vector<4xf32>
+// VEC-NOT: memref.load
+func.func @relu(%arg0: memref<64x32xf32>, %arg1: memref<64x32xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c32 = arith.constant 32 : index
+  %c64 = arith.constant 64 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  scf.parallel (%i, %j) = (%c0, %c0) to (%c64, %c32) step (%c1, %c1) {
+    %0 = memref.load %arg0[%i, %j] : memref<64x32xf32>
+    %1 = arith.maximumf %0, %cst : f32
+    memref.store %1, %arg1[%i, %j] : memref<64x32xf32>
+    scf.yield
+  }
+  return
+}
+
+// -----
+
+// 200 iterations are not a multiple of any work-group size, the tail is
+// guarded.
+// AUTO-LABEL: func.func @tail
+// AUTO: scf.parallel (%{{.*}}) = (%{{.*}}) to (%c2) step
+// AUTO-NEXT: scf.parallel (%{{.*}}) = (%{{.*}}) to (%c128) step
+// AUTO: %[[IN:.*]] = arith.cmpi slt, %{{.*}}, %c200 : index
+// AUTO: scf.if %[[IN]] {
+// AUTO: memref.store
+func.func @tail(%arg0: memref<10x20xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c10 = arith.constant 10 : index
+  %c20 = arith.constant 20 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  scf.parallel (%i, %j) = (%c0, %c0) to (%c10, %c20) step (%c1, %c1) {
+    memref.store %cst, %arg0[%i, %j] : memref<10x20xf32>
+    scf.yield
+  }
+  return
+}
+
+// -----
+
+// The attribute of the loop takes precedence over the options.
+// AUTO-LABEL: func.func @attr
+// AUTO: scf.parallel (%{{.*}}) = (%{{.*}}) to (%{{.*}}) step
+// AUTO-NEXT: scf.parallel (%{{.*}}) = (%{{.*}}) to (%c32) step
+// AUTO-NEXT: scf.for %{{.*}} = %{{.*}} to %c4 step
+func.func @attr(%arg0: memref<1024xf32>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c1024 = arith.constant 1024 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  scf.parallel (%i) = (%c0) to (%c1024) step (%c1) {
+    memref.store %cst, %arg0[%i] : memref<1024xf32>
+    scf.yield
+  } {imex.launch_config = {work_group_size = 32 : i64, work_per_thread = 4 : i64}}
+  return
+}
+
+// -----
+
+// Loops with dynamic bounds or already distributed loops are left alone.
+// CHECK-LABEL: func.func @skip
+// CHECK: scf.parallel (%{{.*}}) = (%{{.*}}) to (%{{.*}}) step
+// CHECK-NEXT: memref.store
+// CHECK: scf.parallel (%{{.*}}) = (%{{.*}}) to (%{{.*}}) step
+// CHECK-NEXT: scf.parallel
+// CHECK-NEXT: memref.store
+func.func @skip(%arg0: memref<?xf32>, %n: index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c8 = arith.constant 8 : index
+  %cst = arith.constant 0.000000e+00 : f32
+  scf.parallel (%i) = (%c0) to (%n) step (%c1) {
+    memref.store %cst, %arg0[%i] : memref<?xf32>
+    scf.yield
+  }
+  scf.parallel (%i) = (%c0) to (%c8) step (%c1) {
+    scf.parallel (%j) = (%c0) to (%c8) step (%c1) {
+      memref.store %cst, %arg0[%j] : memref<?xf32>
+      scf.yield
+    }
+    scf.yield
+  }
+  return
+}
+
+// -----
+
+// Induction variables used outside of memory accesses prevent the
+// vectorization, the loop is distributed per element.
+// VEC-LABEL: func.func @iota
+// VEC-NOT: vector.
+// VEC: memref.store
+func.func @iota(%arg0: memref<256xi64>) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c256 = arith.constant 256 : index
+  scf.parallel (%i) = (%c0) to (%c256) step (%c1) {
+    %0 = arith.index_cast %i : index to i64
+    memref.store %0, %arg0[%i] : memref<256xi64>
+    scf.yield
+  }
+  return
+}
@@ -0,0 +1,67 @@
+// RUN: %python_executable %imex_xetile_tuner -i %s --top=3 | FileCheck %s
+// RUN: %python_executable %imex_xetile_tuner -i %s --param TM=16 --param TN=32 --param TK=32 | FileCheck %s --check-prefix=SINGLE
+
+// TUNE: TM = [8, 16, 32]
+// TUNE: TN = [16, 32, 64]
+// TUNE: TK = [16, 32]
+// TUNE-CONSTRAINT: TM * TN <= 1024
+
+// CHECK: candidates: 16, legal: {{[0-9]+}}, illegal: {{[0-9]+}}
+// CHECK-NEXT: #1 cost={{[0-9.e+-]+}} TK={{[0-9]+}} TM={{[0-9]+}} TN={{[0-9]+}}
+// CHECK-NEXT: #2 cost={{[0-9.e+-]+}} TK={{[0-9]+}} TM={{[0-9]+}} TN={{[0-9]+}}
+// CHECK-NEXT: #3 cost={{[0-9.e+-]+}} TK={{[0-9]+}} TM={{[0-9]+}} TN={{[0-9]+}}
+// CHECK-NOT: #4
+
+// SINGLE: candidates: 1, legal: 1, illegal: 0
+// SINGLE-NEXT: #1 cost={{[0-9.e+-]+}} TK=32 TM=16 TN=32
+
+module @gemm attributes {gpu.container_module} {
+  func.func @test(%A: memref<1024x1024xf16>, %B: memref<1024x1024xf16>, %C: memref<1024x1024xf32>) -> memref<1024x1024xf32> attributes {llvm.emit_c_interface} {
+    %c1 = arith.constant 1 : index
+    %grid_x = arith.constant ${1024 // TM} : index
+    %grid_y = arith.constant ${1024 // TN} : index
+    %A_gpu = gpu.alloc  host_shared () : memref<1024x1024xf16>
+    memref.copy %A, %A_gpu : memref<1024x1024xf16> to memref<1024x1024xf16>
+    %B_gpu = gpu.alloc  host_shared () : memref<1024x1024xf16>
+    memref.copy %B, %B_gpu : memref<1024x1024xf16> to memref<1024x1024xf16>
+    %C_gpu = gpu.alloc  host_shared () : memref<1024x1024xf32>
+    memref.copy %C, %C_gpu : memref<1024x1024xf32> to memref<1024x1024xf32>
+    gpu.launch_func  @test_kernel::@test_kernel blocks in (%grid_x, %grid_y, %c1) threads in (%c1, %c1, %c1) args(%A_gpu : memref<1024x1024xf16>, %B_gpu : memref<1024x1024xf16>, %C_gpu : memref<1024x1024xf32>)
+    gpu.dealloc  %A_gpu : memref<1024x1024xf16>
+    gpu.dealloc  %B_gpu : memref<1024x1024xf16>
+    return %C_gpu : memref<1024x1024xf32>
+  }
+  gpu.module @test_kernel attributes {spirv.target_env = #spirv.target_env<#spirv.vce<v1.4, [Addresses, Float16Buffer, Int64, Int16, Int8, Kernel, Linkage, Vector16, GenericPointer, Groups, Float16, Float64, AtomicFloat32AddEXT, ExpectAssumeKHR, SubgroupDispatch, VectorComputeINTEL, VectorAnyINTEL], [SPV_EXT_shader_atomic_float_add, SPV_KHR_expect_assume, SPV_INTEL_vector_compute]>, api=OpenCL, #spirv.resource_limits<>>} {
+    gpu.func @test_kernel(%A: memref<1024x1024xf16>, %B: memref<1024x1024xf16>, %C: memref<1024x1024xf32>) kernel attributes {VectorComputeFunctionINTEL, spirv.entry_point_abi = #spirv.entry_point_abi<>} {
+      %c0 = arith.constant 0 : index
+      %c1024 = arith.constant 1024 : index
+      %tm = arith.constant ${TM} : index
+      %tn = arith.constant ${TN} : index
+      %tk = arith.constant ${TK} : index
+      %block_id_x = gpu.block_id x
+      %block_id_y = gpu.block_id y
+      %m = arith.muli %block_id_x, %tm : index
+      %n = arith.muli %block_id_y, %tn : index
+      %c_init_tile = xetile.init_tile %C[%m, %n] : memref<1024x1024xf32> -> !xetile.tile<${TM}x${TN}xf32>
+      %c_init_value = xetile.load_tile %c_init_tile  : !xetile.tile<${TM}x${TN}xf32> -> vector<${TM}x${TN}xf32>
+      %a_init_tile = xetile.init_tile %A[%m, %c0] : memref<1024x1024xf16> -> !xetile.tile<${TM}x${TK}xf16>
+      %b_init_tile = xetile.init_tile %B[%c0, %n] : memref<1024x1024xf16> -> !xetile.tile<${TK}x${TN}xf16>
+      %out:3 = scf.for %k = %c0 to %c1024 step %tk
+        iter_args(%a_tile = %a_init_tile, %b_tile = %b_init_tile, %c_value = %c_init_value)
+        -> (!xetile.tile<${TM}x${TK}xf16>, !xetile.tile<${TK}x${TN}xf16>, vector<${TM}x${TN}xf32>) {
+        %a_value = xetile.load_tile %a_tile  : !xetile.tile<${TM}x${TK}xf16> -> vector<${TM}x${TK}xf16>
+        %b_value = xetile.load_tile %b_tile  : !xetile.tile<${TK}x${TN}xf16> -> vector<${TK}x${TN}xf16>
+        %c_new_value = xetile.tile_mma %a_value, %b_value, %c_value
+          : vector<${TM}x${TK}xf16>, vector<${TK}x${TN}xf16>, vector<${TM}x${TN}xf32> -> vector<${TM}x${TN}xf32>
+        %a_next_tile = xetile.update_tile_offset %a_tile, [%c0, %tk]
+          : !xetile.tile<${TM}x${TK}xf16>, index, index -> !xetile.tile<${TM}x${TK}xf16>
+        %b_next_tile = xetile.update_tile_offset %b_tile, [%tk, %c0]
+          : !xetile.tile<${TK}x${TN}xf16>, index, index -> !xetile.tile<${TK}x${TN}xf16>
+        scf.yield %a_next_tile, %b_next_tile, %c_new_value
+          : !xetile.tile<${TM}x${TK}xf16>, !xetile.tile<${TK}x${TN}xf16>, vector<${TM}x${TN}xf32>
+      }
+      xetile.store_tile %out#2, %c_init_tile: vector<${TM}x${TN}xf32>, !xetile.tile<${TM}x${TN}xf32>
+      gpu.return
+    }
+  }
+}
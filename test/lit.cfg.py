@@ -38,6 +38,7 @@ config.substitutions.append(('%mlir_c_runner_utils', config.mlir_c_runner_utils)
 if config.enable_vulkan_runner:
     config.substitutions.append(('%vulkan_runtime_wrappers', config.vulkan_runtime_wrappers))
 config.substitutions.append(('%imex_runner', config.imex_runner))
+config.substitutions.append(('%imex_xetile_tuner', config.imex_xetile_tuner))
 config.substitutions.append(('%python_executable', config.python_executable))
 if config.imex_enable_sycl_runtime:
     config.substitutions.append(('%sycl_runtime', config.sycl_runtime))